@@ -0,0 +1,596 @@
+#include "char-utils.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(CHARUTIL_PARALLEL)
+#include <unistd.h>
+#endif
+
+/* Microbenchmark for every macro against its _GROKKABLE / FAST_ / <ctype.h> twin
+ *
+ * Usage: bench [bytes] [repetitions]
+ *        bench_parallel [bytes] [repetitions] [max threads] (see Parallel Scaling)
+ * Prints one CSV row per (distribution, macro, variant):
+ *   opt,distribution,macro,variant,bytes,ns,bytes_per_ns
+ * where ns is the best of the repetitions. `make bench` builds this at every
+ * optimisation level in BENCH_OPTS and collects the rows into bench.csv */
+
+#ifndef BENCH_OPT
+#define BENCH_OPT "default"
+#endif
+
+typedef uint64_t (*bench_fn)(const unsigned char *buf, size_t n);
+
+typedef struct
+{
+    const char *macro;
+    const char *variant;
+    bench_fn fn;
+} bench_entry;
+
+static volatile uint64_t bench_sink;
+static unsigned char bench_scratch[2 * (1 << 22) + 1];
+
+/// Defines a function summing EXPR over every byte (as ch) so the result cannot be optimised out
+#define BENCH_MAP(fn_name, EXPR)                                                                                                                                                                       \
+    static uint64_t fn_name(const unsigned char *buf, size_t n)                                                                                                                                        \
+    {                                                                                                                                                                                                  \
+        uint64_t sum = 0;                                                                                                                                                                              \
+        for (size_t i = 0; i < n; i++)                                                                                                                                                                 \
+        {                                                                                                                                                                                              \
+            const unsigned char ch = buf[i];                                                                                                                                                           \
+            sum += (uint64_t)(EXPR);                                                                                                                                                                   \
+        }                                                                                                                                                                                              \
+        return sum;                                                                                                                                                                                    \
+    }
+
+/* Character Type Checks */
+BENCH_MAP(is_binary_macro, IS_BINARY(ch))
+BENCH_MAP(is_binary_grokkable, IS_BINARY_GROKKABLE(ch))
+BENCH_MAP(is_binary_table, CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_BINARY))
+BENCH_MAP(is_octal_macro, IS_OCTAL(ch))
+BENCH_MAP(is_octal_grokkable, IS_OCTAL_GROKKABLE(ch))
+BENCH_MAP(is_octal_table, CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_OCTAL))
+BENCH_MAP(is_digit_macro, IS_DIGIT(ch))
+BENCH_MAP(is_digit_grokkable, IS_DIGIT_GROKKABLE(ch))
+BENCH_MAP(is_digit_table, CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_DIGIT))
+BENCH_MAP(is_digit_ctype, isdigit(ch) != 0)
+BENCH_MAP(is_lower_macro, IS_LOWER(ch))
+BENCH_MAP(is_lower_grokkable, IS_LOWER_GROKKABLE(ch))
+BENCH_MAP(is_lower_table, CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_LOWER))
+BENCH_MAP(is_lower_ctype, islower(ch) != 0)
+BENCH_MAP(is_upper_macro, IS_UPPER(ch))
+BENCH_MAP(is_upper_grokkable, IS_UPPER_GROKKABLE(ch))
+BENCH_MAP(is_upper_table, CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_UPPER))
+BENCH_MAP(is_upper_ctype, isupper(ch) != 0)
+BENCH_MAP(is_alpha_macro, IS_ALPHA(ch))
+BENCH_MAP(is_alpha_grokkable, IS_ALPHA_GROKKABLE(ch))
+BENCH_MAP(is_alpha_table, CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_ALPHA))
+BENCH_MAP(is_alpha_ctype, isalpha(ch) != 0)
+BENCH_MAP(is_alnum_macro, IS_ALNUM(ch))
+BENCH_MAP(is_alnum_grokkable, IS_ALNUM_GROKKABLE(ch))
+BENCH_MAP(is_alnum_table, CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_ALNUM))
+BENCH_MAP(is_alnum_ctype, isalnum(ch) != 0)
+BENCH_MAP(is_hex_digit_macro, IS_HEX_DIGIT(ch))
+BENCH_MAP(is_hex_digit_grokkable, IS_HEX_DIGIT_GROKKABLE(ch))
+BENCH_MAP(is_hex_digit_table, CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_HEX_DIGIT))
+BENCH_MAP(is_hex_digit_ctype, isxdigit(ch) != 0)
+BENCH_MAP(is_printable_macro, IS_PRINTABLE(ch))
+BENCH_MAP(is_printable_grokkable, IS_PRINTABLE_GROKKABLE(ch))
+BENCH_MAP(is_printable_table, CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_PRINTABLE))
+BENCH_MAP(is_printable_ctype, isprint(ch) != 0)
+BENCH_MAP(is_ascii_macro, IS_ASCII(ch))
+BENCH_MAP(is_space_macro, IS_SPACE(ch))
+BENCH_MAP(is_space_table, CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_SPACE))
+BENCH_MAP(is_space_ctype, isspace(ch) != 0)
+BENCH_MAP(is_punct_macro, IS_PUNCT(ch))
+BENCH_MAP(is_punct_table, CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_PUNCT))
+BENCH_MAP(is_punct_ctype, ispunct(ch) != 0)
+BENCH_MAP(is_bracket_macro, IS_BRACKET(ch))
+BENCH_MAP(is_bracket_table, CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_BRACKET))
+BENCH_MAP(is_symbol_macro, IS_SYMBOL(ch))
+BENCH_MAP(is_symbol_table, CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_SYMBOL))
+
+/* Character Case Conversion */
+BENCH_MAP(to_upper_macro, TO_UPPER(ch))
+BENCH_MAP(to_upper_fast, FAST_TO_UPPER(ch))
+BENCH_MAP(to_upper_ctype, toupper(ch))
+BENCH_MAP(to_lower_macro, TO_LOWER(ch))
+BENCH_MAP(to_lower_fast, FAST_TO_LOWER(ch))
+BENCH_MAP(to_lower_ctype, tolower(ch))
+BENCH_MAP(toggle_case_macro, TOGGLE_CASE(ch))
+BENCH_MAP(toggle_case_fast, FAST_TOGGLE_CASE(ch))
+
+/* Digit & Hex Conversions */
+BENCH_MAP(ascii_to_binary_macro, ASCII_TO_BINARY(ch, 0))
+BENCH_MAP(ascii_to_binary_fast, FAST_ASCII_TO_BINARY(ch))
+BENCH_MAP(ascii_to_octal_macro, ASCII_TO_OCTAL(ch, 0))
+BENCH_MAP(ascii_to_octal_fast, FAST_ASCII_TO_OCTAL(ch))
+BENCH_MAP(ascii_to_digit_macro, ASCII_TO_DIGIT(ch))
+BENCH_MAP(ascii_to_digit_fast, FAST_ASCII_TO_DIGIT(ch))
+BENCH_MAP(digit_to_ascii_macro, DIGIT_TO_ASCII(ch, 0))
+BENCH_MAP(digit_to_ascii_fast, FAST_DIGIT_TO_ASCII(ch))
+BENCH_MAP(hex_to_int_macro, HEX_TO_INT(ch, 0))
+BENCH_MAP(hex_to_int_fast, FAST_UPPERCASE_HEX_TO_INT(ch))
+BENCH_MAP(nibble_to_hex_macro, NIBBLE_TO_UPPERCASE_HEX(LOW_NIBBLE(ch), 0))
+BENCH_MAP(nibble_to_hex_fast, FAST_NIBBLE_TO_UPPERCASE_HEX(LOW_NIBBLE(ch)))
+
+/* Bulk buffer functions against their scalar paths */
+static uint64_t hex_to_int_fused(const unsigned char *buf, size_t n)
+{
+    uint64_t sum = 0;
+    uint64_t err = 0;
+    for (size_t i = 0; i + 16 <= n; i += 16)
+    {
+        sum += charutil_hex_decode_u64((const char *)buf + i, &err);
+    }
+    return sum + err;
+}
+
+static uint64_t hex_encode_bulk(const unsigned char *buf, size_t n)
+{
+    return charutil_hex_encode((char *)bench_scratch, buf, n, CHARUTIL_HEX_UPPERCASE) + bench_scratch[n];
+}
+
+static uint64_t hex_encode_scalar(const unsigned char *buf, size_t n)
+{
+    return charutil_hex_encode_scalar((char *)bench_scratch, buf, n, CHARUTIL_HEX_UPPERCASE) + bench_scratch[n];
+}
+
+static uint64_t base64_encode_bulk(const unsigned char *buf, size_t n)
+{
+    return charutil_base64_encode((char *)bench_scratch, buf, n, CHARUTIL_BASE64_STANDARD) + bench_scratch[n];
+}
+
+static uint64_t base64_encode_scalar(const unsigned char *buf, size_t n)
+{
+    return charutil_base64_encode_scalar((char *)bench_scratch, buf, n, CHARUTIL_BASE64_STANDARD) + bench_scratch[n];
+}
+
+static uint64_t class_counts_bulk(const unsigned char *buf, size_t n)
+{
+    charutil_class_counts_t counts;
+    charutil_class_counts(buf, n, &counts, NULL);
+    return counts.classes[0] + counts.classes[CHARUTIL_CLASS_COUNT - 1];
+}
+
+static uint64_t class_counts_histogram(const unsigned char *buf, size_t n)
+{
+    charutil_class_counts_t counts;
+    uint64_t histogram[256];
+    charutil_class_counts(buf, n, &counts, histogram);
+    return counts.classes[0] + histogram[n & 0xFF];
+}
+
+static uint64_t escape_json_bulk(const unsigned char *buf, size_t n)
+{
+    return charutil_escape_json((char *)bench_scratch, sizeof(bench_scratch), buf, n) + bench_scratch[n / 2];
+}
+
+static uint64_t percent_encode_bulk(const unsigned char *buf, size_t n)
+{
+    return charutil_percent_encode((char *)bench_scratch, sizeof(bench_scratch), buf, n, NULL, CHARUTIL_PERCENT_DEFAULT) + bench_scratch[n / 2];
+}
+
+/// Formats every 16 bytes of buf as a UUID and, with parse, reads it back
+static uint64_t uuid_bench(const unsigned char *buf, size_t n, size_t (*format)(char *, const uint8_t *, charutil_hex_case_t), int (*parse)(uint8_t *, const char *))
+{
+    uint64_t acc = 0;
+    for (size_t i = 0; i + 16 <= n; i += 16)
+    {
+        char *text = (char *)bench_scratch + (i / 16 % 1024) * CHARUTIL_UUID_TEXT_LEN;
+        format(text, buf + i, CHARUTIL_HEX_LOWERCASE);
+        acc += parse ? (uint64_t)parse(bench_scratch + sizeof(bench_scratch) - 16, text) : (unsigned char)text[i % CHARUTIL_UUID_TEXT_LEN];
+    }
+    return acc;
+}
+
+static int uuid_parse_public(uint8_t *uuid, const char *src)
+{
+    return (int)charutil_uuid_parse(uuid, src, CHARUTIL_UUID_TEXT_LEN);
+}
+
+static uint64_t uuid_format_bulk(const unsigned char *buf, size_t n)
+{
+    return uuid_bench(buf, n, charutil_uuid_format, NULL);
+}
+
+static uint64_t uuid_format_scalar(const unsigned char *buf, size_t n)
+{
+    return uuid_bench(buf, n, charutil_uuid_format_scalar, NULL);
+}
+
+static uint64_t uuid_round_trip_bulk(const unsigned char *buf, size_t n)
+{
+    return uuid_bench(buf, n, charutil_uuid_format, uuid_parse_public);
+}
+
+static uint64_t uuid_round_trip_swar(const unsigned char *buf, size_t n)
+{
+    return uuid_bench(buf, n, charutil_uuid_format_scalar, charutil_uuid_parse_swar);
+}
+
+static int hexdump_line_sink(const char *line, size_t len, void *user)
+{
+    *(uint64_t *)user += len + (unsigned char)line[len / 2];
+    return 0;
+}
+
+static uint64_t hexdump_lines_bulk(const unsigned char *buf, size_t n)
+{
+    uint64_t acc = 0;
+    charutil_hexdump_lines(buf, n, NULL, hexdump_line_sink, &acc);
+    return acc;
+}
+
+static uint64_t to_lower_buf_bulk(const unsigned char *buf, size_t n)
+{
+    charutil_to_lower_buf((char *)bench_scratch, (const char *)buf, n);
+    return bench_scratch[n / 2];
+}
+
+static uint64_t to_lower_buf_scalar(const unsigned char *buf, size_t n)
+{
+    charutil_case_buf_scalar((char *)bench_scratch, (const char *)buf, n, CHARUTIL_CASE_LOWER);
+    return bench_scratch[n / 2];
+}
+
+/// Counts class members with repeated span calls so a match and a miss both cost one call
+static uint64_t span_alnum_bulk(const unsigned char *buf, size_t n)
+{
+    uint64_t sum = 0;
+    size_t i = 0;
+    while (i < n)
+    {
+        const size_t run = charutil_span_class((const char *)buf + i, n - i, CHARUTIL_CLASS_ALNUM);
+        sum += run;
+        i += run + 1;
+    }
+    return sum;
+}
+
+static uint64_t span_alnum_scalar(const unsigned char *buf, size_t n)
+{
+    uint64_t sum = 0;
+    size_t i = 0;
+    while (i < n)
+    {
+        const size_t run = charutil_span_class_scalar((const char *)buf + i, n - i, CHARUTIL_CLASS_ALNUM);
+        sum += run;
+        i += run + 1;
+    }
+    return sum;
+}
+
+/// Validates 4 KiB windows so random input, which fails within a few bytes, still walks the whole buffer
+static uint64_t utf8_validate_bulk(const unsigned char *buf, size_t n)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i += 4096)
+    {
+        sum += charutil_utf8_validate(buf + i, (n - i < 4096) ? n - i : 4096);
+    }
+    return sum;
+}
+
+/// Counts fields split on a user defined set, one cspan call per field
+static const charutil_set_t bench_delims = CHARUTIL_SET_LITERAL(",;:| \t\n");
+
+static uint64_t set_cspan_bulk(const unsigned char *buf, size_t n)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        const size_t run = charutil_set_cspan((const char *)buf + i, n - i, &bench_delims);
+        sum += run;
+        i += run;
+    }
+    return sum;
+}
+
+static uint64_t set_cspan_scalar(const unsigned char *buf, size_t n)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        const size_t run = charutil_set_scan_scalar((const char *)buf + i, n - i, &bench_delims, 0);
+        sum += run;
+        i += run;
+    }
+    return sum;
+}
+
+static const bench_entry bench_entries[] = {
+    {"IS_BINARY", "macro", is_binary_macro},
+    {"IS_BINARY", "grokkable", is_binary_grokkable},
+    {"IS_BINARY", "table", is_binary_table},
+    {"IS_OCTAL", "macro", is_octal_macro},
+    {"IS_OCTAL", "grokkable", is_octal_grokkable},
+    {"IS_OCTAL", "table", is_octal_table},
+    {"IS_DIGIT", "macro", is_digit_macro},
+    {"IS_DIGIT", "grokkable", is_digit_grokkable},
+    {"IS_DIGIT", "table", is_digit_table},
+    {"IS_DIGIT", "ctype", is_digit_ctype},
+    {"IS_LOWER", "macro", is_lower_macro},
+    {"IS_LOWER", "grokkable", is_lower_grokkable},
+    {"IS_LOWER", "table", is_lower_table},
+    {"IS_LOWER", "ctype", is_lower_ctype},
+    {"IS_UPPER", "macro", is_upper_macro},
+    {"IS_UPPER", "grokkable", is_upper_grokkable},
+    {"IS_UPPER", "table", is_upper_table},
+    {"IS_UPPER", "ctype", is_upper_ctype},
+    {"IS_ALPHA", "macro", is_alpha_macro},
+    {"IS_ALPHA", "grokkable", is_alpha_grokkable},
+    {"IS_ALPHA", "table", is_alpha_table},
+    {"IS_ALPHA", "ctype", is_alpha_ctype},
+    {"IS_ALNUM", "macro", is_alnum_macro},
+    {"IS_ALNUM", "grokkable", is_alnum_grokkable},
+    {"IS_ALNUM", "table", is_alnum_table},
+    {"IS_ALNUM", "ctype", is_alnum_ctype},
+    {"IS_HEX_DIGIT", "macro", is_hex_digit_macro},
+    {"IS_HEX_DIGIT", "grokkable", is_hex_digit_grokkable},
+    {"IS_HEX_DIGIT", "table", is_hex_digit_table},
+    {"IS_HEX_DIGIT", "ctype", is_hex_digit_ctype},
+    {"IS_PRINTABLE", "macro", is_printable_macro},
+    {"IS_PRINTABLE", "grokkable", is_printable_grokkable},
+    {"IS_PRINTABLE", "table", is_printable_table},
+    {"IS_PRINTABLE", "ctype", is_printable_ctype},
+    {"IS_ASCII", "macro", is_ascii_macro},
+    {"IS_SPACE", "macro", is_space_macro},
+    {"IS_SPACE", "table", is_space_table},
+    {"IS_SPACE", "ctype", is_space_ctype},
+    {"IS_PUNCT", "macro", is_punct_macro},
+    {"IS_PUNCT", "table", is_punct_table},
+    {"IS_PUNCT", "ctype", is_punct_ctype},
+    {"IS_BRACKET", "macro", is_bracket_macro},
+    {"IS_BRACKET", "table", is_bracket_table},
+    {"IS_SYMBOL", "macro", is_symbol_macro},
+    {"IS_SYMBOL", "table", is_symbol_table},
+    {"TO_UPPER", "macro", to_upper_macro},
+    {"TO_UPPER", "fast", to_upper_fast},
+    {"TO_UPPER", "ctype", to_upper_ctype},
+    {"TO_LOWER", "macro", to_lower_macro},
+    {"TO_LOWER", "fast", to_lower_fast},
+    {"TO_LOWER", "ctype", to_lower_ctype},
+    {"TOGGLE_CASE", "macro", toggle_case_macro},
+    {"TOGGLE_CASE", "fast", toggle_case_fast},
+    {"ASCII_TO_BINARY", "macro", ascii_to_binary_macro},
+    {"ASCII_TO_BINARY", "fast", ascii_to_binary_fast},
+    {"ASCII_TO_OCTAL", "macro", ascii_to_octal_macro},
+    {"ASCII_TO_OCTAL", "fast", ascii_to_octal_fast},
+    {"ASCII_TO_DIGIT", "macro", ascii_to_digit_macro},
+    {"ASCII_TO_DIGIT", "fast", ascii_to_digit_fast},
+    {"DIGIT_TO_ASCII", "macro", digit_to_ascii_macro},
+    {"DIGIT_TO_ASCII", "fast", digit_to_ascii_fast},
+    {"HEX_TO_INT", "macro", hex_to_int_macro},
+    {"HEX_TO_INT", "fast", hex_to_int_fast},
+    {"HEX_TO_INT", "fused", hex_to_int_fused},
+    {"NIBBLE_TO_UPPERCASE_HEX", "macro", nibble_to_hex_macro},
+    {"NIBBLE_TO_UPPERCASE_HEX", "fast", nibble_to_hex_fast},
+    {"charutil_hex_encode", "bulk", hex_encode_bulk},
+    {"charutil_hex_encode", "scalar", hex_encode_scalar},
+    {"charutil_base64_encode", "bulk", base64_encode_bulk},
+    {"charutil_base64_encode", "scalar", base64_encode_scalar},
+    {"charutil_hexdump_lines", "bulk", hexdump_lines_bulk},
+    {"charutil_uuid_format", "bulk", uuid_format_bulk},
+    {"charutil_uuid_format", "scalar", uuid_format_scalar},
+    {"charutil_uuid_format+parse", "bulk", uuid_round_trip_bulk},
+    {"charutil_uuid_format+parse", "swar", uuid_round_trip_swar},
+    {"charutil_escape_json", "bulk", escape_json_bulk},
+    {"charutil_percent_encode", "bulk", percent_encode_bulk},
+    {"charutil_class_counts", "bulk", class_counts_bulk},
+    {"charutil_class_counts", "histogram", class_counts_histogram},
+    {"charutil_to_lower_buf", "bulk", to_lower_buf_bulk},
+    {"charutil_to_lower_buf", "scalar", to_lower_buf_scalar},
+    {"charutil_span_alnum", "bulk", span_alnum_bulk},
+    {"charutil_span_alnum", "scalar", span_alnum_scalar},
+    {"charutil_set_cspan", "bulk", set_cspan_bulk},
+    {"charutil_set_cspan", "scalar", set_cspan_scalar},
+    {"charutil_utf8_validate", "bulk", utf8_validate_bulk},
+};
+
+/* ==========================
+ * Input Distributions
+ * ========================== */
+
+static uint64_t bench_rand_state = 0x9E3779B97F4A7C15ull;
+static uint64_t bench_rand(void)
+{
+    bench_rand_state ^= bench_rand_state << 13;
+    bench_rand_state ^= bench_rand_state >> 7;
+    bench_rand_state ^= bench_rand_state << 17;
+    return bench_rand_state;
+}
+
+/// Uniformly random bytes
+static void fill_random(unsigned char *buf, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        buf[i] = (unsigned char)bench_rand();
+    }
+}
+
+/// Log line like ASCII text: words, numbers, punctuation and line breaks
+static void fill_text(unsigned char *buf, size_t n)
+{
+    static const char *words[] = {"the", "Request", "id", "=", "0x1F3A", "GET", "/index.html", "HTTP/1.1", "200", "user-agent:", "Mozilla/5.0", "(X11;", "Linux)", "latency_ms", "12.5", "[INFO]", "ok,"};
+    size_t i = 0;
+    while (i < n)
+    {
+        const uint64_t r = bench_rand();
+        const char *word = words[r % (sizeof(words) / sizeof(words[0]))];
+        for (size_t j = 0; word[j] != '\0' && i < n; j++)
+        {
+            buf[i++] = (unsigned char)word[j];
+        }
+        if (i < n)
+        {
+            buf[i++] = (r >> 32) % 12 == 0 ? '\n' : ' ';
+        }
+    }
+}
+
+/// Binary structure like data: mostly zero and small values with some 0xFF padding
+static void fill_binary(unsigned char *buf, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        const uint64_t r = bench_rand();
+        const unsigned pick = (unsigned)(r % 10);
+        buf[i] = (pick < 5) ? 0x00 : (pick < 7) ? (unsigned char)((r >> 8) & 0x0F) : (pick < 8) ? 0xFF : (unsigned char)(r >> 16);
+    }
+}
+
+/* ==========================
+ * Timing
+ * ========================== */
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+#if defined(CHARUTIL_PARALLEL)
+/* ==========================
+ * Parallel Scaling
+ * ========================== */
+// Built with CHARUTIL_PARALLEL (make bench_parallel) the benchmark times the
+// *_parallel() front ends instead, over a large text buffer, for pools of 1, 2,
+// 4, ... threads up to max_threads. The variant column is the thread count.
+
+static void bench_parallel(size_t n, int reps, unsigned max_threads)
+{
+    static const char *const names[] = {"hex_encode_parallel", "hex_decode_parallel", "to_lower_parallel", "class_counts_parallel", "diagnostics_escape_parallel"};
+    unsigned char *src = (unsigned char *)malloc(n);
+    char *hex = (char *)malloc(2 * n);
+    if (!src || !hex)
+    {
+        fprintf(stderr, "cannot allocate %zu bytes\n", 3 * n);
+        exit(1);
+    }
+    fill_text(src, n);
+    charutil_hex_encode(hex, src, n, CHARUTIL_HEX_LOWERCASE);
+    const size_t escaped_len = charutil_diagnostics_escape(NULL, 0, src, n);
+    char *dst = (char *)malloc((2 * n > escaped_len ? 2 * n : escaped_len) + 1);
+    if (!dst)
+    {
+        fprintf(stderr, "cannot allocate output\n");
+        exit(1);
+    }
+
+    for (unsigned threads = 1;; threads = (2 * threads < max_threads) ? 2 * threads : max_threads)
+    {
+        charutil_pool_t *pool = charutil_pool_create(threads);
+        for (size_t f = 0; f < sizeof(names) / sizeof(names[0]); f++)
+        {
+            double best = 0;
+            for (int r = 0; r <= reps; r++)
+            {
+                charutil_class_counts_t counts;
+                size_t err_pos;
+                const double start = now_ns();
+                switch (f)
+                {
+                    case 0:
+                        bench_sink += charutil_hex_encode_parallel(pool, dst, src, n, CHARUTIL_HEX_LOWERCASE);
+                        break;
+                    case 1:
+                        bench_sink += charutil_hex_decode_parallel(pool, dst, hex, 2 * n, &err_pos);
+                        break;
+                    case 2:
+                        charutil_case_buf_parallel(pool, dst, (const char *)src, n, CHARUTIL_CASE_LOWER);
+                        bench_sink += (unsigned char)dst[n / 2];
+                        break;
+                    case 3:
+                        charutil_class_counts_parallel(pool, src, n, &counts, NULL);
+                        bench_sink += counts.classes[0];
+                        break;
+                    default:
+                        bench_sink += charutil_diagnostics_escape_parallel(pool, dst, escaped_len + 1, src, n);
+                        break;
+                }
+                const double elapsed = now_ns() - start;
+                // The first run warms up the pool and the pages
+                if (r == 1 || (r > 1 && elapsed < best))
+                {
+                    best = elapsed;
+                }
+            }
+            printf("%s,text,%s,threads_%u,%zu,%.0f,%.4f\n", BENCH_OPT, names[f], charutil_pool_size(pool), n, best, (double)n / best);
+        }
+        charutil_pool_destroy(pool);
+        if (threads >= max_threads)
+        {
+            break;
+        }
+    }
+
+    free(src);
+    free(hex);
+    free(dst);
+}
+#endif
+
+int main(int argc, char **argv)
+{
+#if defined(CHARUTIL_PARALLEL)
+    const size_t parallel_n = (argc > 1) ? (size_t)strtoull(argv[1], NULL, 10) : (128u << 20);
+    const int parallel_reps = (argc > 2) ? atoi(argv[2]) : 3;
+    const long cpus = (argc > 3) ? atol(argv[3]) : sysconf(_SC_NPROCESSORS_ONLN);
+    if (parallel_n == 0 || parallel_reps <= 0 || cpus <= 0)
+    {
+        fprintf(stderr, "usage: %s [bytes > 0] [repetitions > 0] [max threads > 0]\n", argv[0]);
+        return 1;
+    }
+    bench_parallel(parallel_n, parallel_reps, (unsigned)cpus);
+    return 0;
+#endif
+    const size_t n = (argc > 1) ? (size_t)strtoull(argv[1], NULL, 10) : (1u << 20);
+    const int reps = (argc > 2) ? atoi(argv[2]) : 5;
+    static const struct
+    {
+        const char *name;
+        void (*fill)(unsigned char *buf, size_t n);
+    } distributions[] = {{"random", fill_random}, {"text", fill_text}, {"binary", fill_binary}};
+
+    if (n == 0 || 2 * n + 1 > sizeof(bench_scratch) || reps <= 0)
+    {
+        fprintf(stderr, "usage: %s [bytes <= %zu] [repetitions > 0]\n", argv[0], (sizeof(bench_scratch) - 1) / 2);
+        return 1;
+    }
+
+    unsigned char *buf = (unsigned char *)malloc(n);
+    if (!buf)
+    {
+        return 1;
+    }
+
+    for (size_t d = 0; d < sizeof(distributions) / sizeof(distributions[0]); d++)
+    {
+        distributions[d].fill(buf, n);
+        for (size_t e = 0; e < sizeof(bench_entries) / sizeof(bench_entries[0]); e++)
+        {
+            double best = 0;
+            bench_sink += bench_entries[e].fn(buf, n); // warm up
+            for (int r = 0; r < reps; r++)
+            {
+                const double start = now_ns();
+                bench_sink += bench_entries[e].fn(buf, n);
+                const double elapsed = now_ns() - start;
+                if (r == 0 || elapsed < best)
+                {
+                    best = elapsed;
+                }
+            }
+            printf("%s,%s,%s,%s,%zu,%.0f,%.4f\n", BENCH_OPT, distributions[d].name, bench_entries[e].macro, bench_entries[e].variant, n, best, (double)n / best);
+        }
+    }
+
+    free(buf);
+    return 0;
+}
@@ -42,6 +42,94 @@
  *
  * */
 
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* ==========================
+ * SIMD Selection
+ * ========================== */
+// Bulk buffer functions pick the widest kernel the compiler is targeting.
+// Define CHARUTIL_NO_SIMD to force the portable scalar path everywhere.
+// Define CHARUTIL_RUNTIME_DISPATCH to pick the kernel from the running CPU
+// instead (see Runtime Dispatch at the end of this file). On x86 the AVX2
+// kernels are then built even when the compiler is not targeting AVX2.
+
+#if !defined(CHARUTIL_NO_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CHARUTIL_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(CHARUTIL_HAVE_SSE2) && defined(__PCLMUL__)
+#define CHARUTIL_HAVE_PCLMUL 1 ///< Carry-less multiply, only used when the compiler targets it
+#include <wmmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define CHARUTIL_HAVE_AVX2 1
+#include <immintrin.h>
+#elif defined(CHARUTIL_RUNTIME_DISPATCH) && defined(CHARUTIL_HAVE_SSE2) && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#define CHARUTIL_HAVE_AVX2 1
+#if defined(__GNUC__) || defined(__clang__)
+#define CHARUTIL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define CHARUTIL_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
+
+#if !defined(CHARUTIL_TARGET_AVX2)
+#define CHARUTIL_TARGET_AVX2 ///< Marks AVX2 kernels, which only need a target attribute when built for runtime dispatch
+#endif
+
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined(_M_X64) || defined(_M_IX86) || defined(_M_ARM64)
+#define CHARUTIL_LITTLE_ENDIAN 1 ///< SWAR kernels that depend on the first byte landing in the low bits of a word need this
+#endif
+
+/// Index of the lowest set bit. x must be non zero.
+static inline unsigned charutil_ctz32(uint32_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctz(x);
+#else
+    unsigned n = 0;
+    while (!(x & 1u))
+    {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/// Index of the lowest set bit. x must be non zero.
+static inline unsigned charutil_ctz64(uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctzll(x);
+#else
+    return ((uint32_t)x) ? charutil_ctz32((uint32_t)x) : 32 + charutil_ctz32((uint32_t)(x >> 32));
+#endif
+}
+
+/// Number of leading zero bits. x must be non zero.
+static inline unsigned charutil_clz64(uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_clzll(x);
+#else
+    unsigned n = 0;
+    while (!(x & 0x8000000000000000ull))
+    {
+        x <<= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
 /* ==========================
  * Set Sizes
  * ========================== */
@@ -83,13 +171,84 @@
 /* Grokkable Version (Slower but more understandable. Fast if compiler optimisation is enabled) */
 #define IS_BINARY_GROKKABLE(ch) ((ch) == '0' || (ch) == '1')
 #define IS_OCTAL_GROKKABLE(ch) ((ch) >= '0' && (ch) <= '7')
-#define IS_DIGIT_GROKKABLE(ch) ('0' <= (ch) && (ch) <= '9')                                                                     ///< Equivalent to isdigit() from <ctype.h>
-#define IS_LOWER_GROKKABLE(ch) ('a' <= (ch) && (ch) <= 'z')                                                                     ///< Equivalent to islower() from <ctype.h>
-#define IS_UPPER_GROKKABLE(ch) ('A' <= (ch) && (ch) <= 'Z')                                                                     ///< Equivalent to isupper() from <ctype.h>
-#define IS_ALPHA_GROKKABLE(ch) (('a' <= (ch) && (ch) <= 'z') || ('A' <= (ch) && (ch) <= 'Z'))                                   ///< Equivalent to isalpha() from <ctype.h>
-#define IS_ALNUM_GROKKABLE(ch) (('0' <= (ch) && (ch) <= '9') || ('a' <= (ch) && (ch) <= 'z') || ('A' <= (ch) && (ch) <= 'Z'))   ///< Equivalent to isalnum() from <ctype.h>
-#define IS_HEX_DIGIT_GROKKABLE(ch) ('0' <= (ch) && (ch) <= '9') || ('a' <= (ch) && (ch) <= 'f') || ('A' <= (ch) && (ch) <= 'F') ///< Equivalent to isxdigit() from <ctype.h>
-#define IS_PRINTABLE_GROKKABLE(ch) (' ' <= (ch) && (ch) <= '~')                                                                 ///< Equivalent to isprint() from <ctype.h>
+#define IS_DIGIT_GROKKABLE(ch) ('0' <= (ch) && (ch) <= '9')                                                                       ///< Equivalent to isdigit() from <ctype.h>
+#define IS_LOWER_GROKKABLE(ch) ('a' <= (ch) && (ch) <= 'z')                                                                       ///< Equivalent to islower() from <ctype.h>
+#define IS_UPPER_GROKKABLE(ch) ('A' <= (ch) && (ch) <= 'Z')                                                                       ///< Equivalent to isupper() from <ctype.h>
+#define IS_ALPHA_GROKKABLE(ch) (('a' <= (ch) && (ch) <= 'z') || ('A' <= (ch) && (ch) <= 'Z'))                                     ///< Equivalent to isalpha() from <ctype.h>
+#define IS_ALNUM_GROKKABLE(ch) (('0' <= (ch) && (ch) <= '9') || ('a' <= (ch) && (ch) <= 'z') || ('A' <= (ch) && (ch) <= 'Z'))     ///< Equivalent to isalnum() from <ctype.h>
+#define IS_HEX_DIGIT_GROKKABLE(ch) (('0' <= (ch) && (ch) <= '9') || ('a' <= (ch) && (ch) <= 'f') || ('A' <= (ch) && (ch) <= 'F')) ///< Equivalent to isxdigit() from <ctype.h>
+#define IS_PRINTABLE_GROKKABLE(ch) (' ' <= (ch) && (ch) <= '~')                                                                   ///< Equivalent to isprint() from <ctype.h>
+
+/* Class Table Version (Opt-in with CHARUTIL_USE_CLASS_TABLE. One load-and-mask per check instead of a chain of compares)
+ * The table only covers ASCII as every class above is a subset of it, and each
+ * entry is the OR of the CHARUTIL_CLASS_* bits whose arithmetic macro accepts
+ * that value. */
+#define CHARUTIL_CLASS_BINARY (1u << 0)
+#define CHARUTIL_CLASS_OCTAL (1u << 1)
+#define CHARUTIL_CLASS_DIGIT (1u << 2)
+#define CHARUTIL_CLASS_LOWER (1u << 3)
+#define CHARUTIL_CLASS_UPPER (1u << 4)
+#define CHARUTIL_CLASS_ALPHA (1u << 5)
+#define CHARUTIL_CLASS_ALNUM (1u << 6)
+#define CHARUTIL_CLASS_HEX_DIGIT (1u << 7)
+#define CHARUTIL_CLASS_PRINTABLE (1u << 8)
+#define CHARUTIL_CLASS_SPACE (1u << 9)
+#define CHARUTIL_CLASS_PUNCT (1u << 10)
+#define CHARUTIL_CLASS_BRACKET (1u << 11)
+#define CHARUTIL_CLASS_SYMBOL (1u << 12)
+#define CHARUTIL_CLASS_ASCII (1u << 13)
+
+#if defined(__cplusplus)
+#define CHARUTIL_TABLE_CONST constexpr ///< Lets char-utils.hpp read the tables in constant expressions
+#else
+#define CHARUTIL_TABLE_CONST const
+#endif
+
+// Each entry is computed here from the arithmetic macros above, before CHARUTIL_USE_CLASS_TABLE redefines them below,
+// so the table cannot drift from them.
+#define CHARUTIL_CLASS_BITS(ch)                                                                                                           \
+    ((IS_BINARY(ch) ? CHARUTIL_CLASS_BINARY : 0u) | (IS_OCTAL(ch) ? CHARUTIL_CLASS_OCTAL : 0u) | (IS_DIGIT(ch) ? CHARUTIL_CLASS_DIGIT : 0u) | \
+     (IS_LOWER(ch) ? CHARUTIL_CLASS_LOWER : 0u) | (IS_UPPER(ch) ? CHARUTIL_CLASS_UPPER : 0u) | (IS_ALPHA(ch) ? CHARUTIL_CLASS_ALPHA : 0u) | \
+     (IS_ALNUM(ch) ? CHARUTIL_CLASS_ALNUM : 0u) | (IS_HEX_DIGIT(ch) ? CHARUTIL_CLASS_HEX_DIGIT : 0u) |                                     \
+     (IS_PRINTABLE(ch) ? CHARUTIL_CLASS_PRINTABLE : 0u) | (IS_SPACE(ch) ? CHARUTIL_CLASS_SPACE : 0u) | (IS_PUNCT(ch) ? CHARUTIL_CLASS_PUNCT : 0u) | \
+     (IS_BRACKET(ch) ? CHARUTIL_CLASS_BRACKET : 0u) | (IS_SYMBOL(ch) ? CHARUTIL_CLASS_SYMBOL : 0u) | (IS_ASCII(ch) ? CHARUTIL_CLASS_ASCII : 0u))
+#define CHARUTIL_CLASS_BITS4(ch) CHARUTIL_CLASS_BITS(ch), CHARUTIL_CLASS_BITS((ch) + 1), CHARUTIL_CLASS_BITS((ch) + 2), CHARUTIL_CLASS_BITS((ch) + 3)
+#define CHARUTIL_CLASS_BITS16(ch) CHARUTIL_CLASS_BITS4(ch), CHARUTIL_CLASS_BITS4((ch) + 4), CHARUTIL_CLASS_BITS4((ch) + 8), CHARUTIL_CLASS_BITS4((ch) + 12)
+
+static CHARUTIL_TABLE_CONST uint16_t charutil_class_table[128] = {
+    CHARUTIL_CLASS_BITS16(0),  CHARUTIL_CLASS_BITS16(16), CHARUTIL_CLASS_BITS16(32), CHARUTIL_CLASS_BITS16(48),
+    CHARUTIL_CLASS_BITS16(64), CHARUTIL_CLASS_BITS16(80), CHARUTIL_CLASS_BITS16(96), CHARUTIL_CLASS_BITS16(112)};
+
+#define CHARUTIL_IS_CLASS(ch, mask) (IS_ASCII(ch) & ((charutil_class_table[(ch) & 0x7F] & (mask)) != 0)) ///< single unsigned cmp and one table load, no branches for speed.
+
+#if defined(CHARUTIL_USE_CLASS_TABLE)
+#undef IS_BINARY
+#undef IS_OCTAL
+#undef IS_DIGIT
+#undef IS_LOWER
+#undef IS_UPPER
+#undef IS_ALPHA
+#undef IS_ALNUM
+#undef IS_HEX_DIGIT
+#undef IS_PRINTABLE
+#undef IS_SPACE
+#undef IS_PUNCT
+#undef IS_BRACKET
+#undef IS_SYMBOL
+#define IS_BINARY(ch) CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_BINARY)
+#define IS_OCTAL(ch) CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_OCTAL)
+#define IS_DIGIT(ch) CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_DIGIT)
+#define IS_LOWER(ch) CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_LOWER)
+#define IS_UPPER(ch) CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_UPPER)
+#define IS_ALPHA(ch) CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_ALPHA)
+#define IS_ALNUM(ch) CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_ALNUM)
+#define IS_HEX_DIGIT(ch) CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_HEX_DIGIT)
+#define IS_PRINTABLE(ch) CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_PRINTABLE)
+#define IS_SPACE(ch) CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_SPACE)
+#define IS_PUNCT(ch) CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_PUNCT)
+#define IS_BRACKET(ch) CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_BRACKET)
+#define IS_SYMBOL(ch) CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_SYMBOL)
+#endif
 
 /* ==========================
  * Character Case Conversion
@@ -144,24 +303,5310 @@
 /* ==========================
  * ASCII Diagnostic
  * ========================== */
+// Fixed width slots (longest token "[0x80]" plus NUL) rather than an array of
+// pointers: no per entry pointer or relocation, and 1792 bytes in total
+static CHARUTIL_TABLE_CONST char charutil_diagnostics_slots[256][7] = {
+    "[NUL]",  "[SOH]",  "[STX]",  "[ETX]",  "[EOT]",  "[ENQ]",  "[ACK]",  "[BEL]",  "[BS]",   "[TAB]",  "[LF]",   "[VT]",   "[FF]",   "[CR]",   "[SO]",   "[SI]",   "[DLE]",  "[DC1]",  "[DC2]",
+    "[DC3]",  "[DC4]",  "[NAK]",  "[SYN]",  "[ETB]",  "[CAN]",  "[EM]",   "[SUB]",  "[ESC]",  "[FS]",   "[GS]",   "[RS]",   "[US]",   " ",      "!",      "\"",     "#",      "$",      "%",
+    "&",      "'",      "(",      ")",      "*",      "+",      ",",      "-",      ".",      "/",      "0",      "1",      "2",      "3",      "4",      "5",      "6",      "7",      "8",
+    "9",      ":",      ";",      "<",      "=",      ">",      "?",      "@",      "A",      "B",      "C",      "D",      "E",      "F",      "G",      "H",      "I",      "J",      "K",
+    "L",      "M",      "N",      "O",      "P",      "Q",      "R",      "S",      "T",      "U",      "V",      "W",      "X",      "Y",      "Z",      "[",      "\\",     "]",      "^",
+    "_",      "`",      "a",      "b",      "c",      "d",      "e",      "f",      "g",      "h",      "i",      "j",      "k",      "l",      "m",      "n",      "o",      "p",      "q",
+    "r",      "s",      "t",      "u",      "v",      "w",      "x",      "y",      "z",      "{",      "|",      "}",      "~",      "[DEL]",  "[0x80]", "[0x81]", "[0x82]", "[0x83]", "[0x84]",
+    "[0x85]", "[0x86]", "[0x87]", "[0x88]", "[0x89]", "[0x8A]", "[0x8B]", "[0x8C]", "[0x8D]", "[0x8E]", "[0x8F]", "[0x90]", "[0x91]", "[0x92]", "[0x93]", "[0x94]", "[0x95]", "[0x96]", "[0x97]",
+    "[0x98]", "[0x99]", "[0x9A]", "[0x9B]", "[0x9C]", "[0x9D]", "[0x9E]", "[0x9F]", "[0xA0]", "[0xA1]", "[0xA2]", "[0xA3]", "[0xA4]", "[0xA5]", "[0xA6]", "[0xA7]", "[0xA8]", "[0xA9]", "[0xAA]",
+    "[0xAB]", "[0xAC]", "[0xAD]", "[0xAE]", "[0xAF]", "[0xB0]", "[0xB1]", "[0xB2]", "[0xB3]", "[0xB4]", "[0xB5]", "[0xB6]", "[0xB7]", "[0xB8]", "[0xB9]", "[0xBA]", "[0xBB]", "[0xBC]", "[0xBD]",
+    "[0xBE]", "[0xBF]", "[0xC0]", "[0xC1]", "[0xC2]", "[0xC3]", "[0xC4]", "[0xC5]", "[0xC6]", "[0xC7]", "[0xC8]", "[0xC9]", "[0xCA]", "[0xCB]", "[0xCC]", "[0xCD]", "[0xCE]", "[0xCF]", "[0xD0]",
+    "[0xD1]", "[0xD2]", "[0xD3]", "[0xD4]", "[0xD5]", "[0xD6]", "[0xD7]", "[0xD8]", "[0xD9]", "[0xDA]", "[0xDB]", "[0xDC]", "[0xDD]", "[0xDE]", "[0xDF]", "[0xE0]", "[0xE1]", "[0xE2]", "[0xE3]",
+    "[0xE4]", "[0xE5]", "[0xE6]", "[0xE7]", "[0xE8]", "[0xE9]", "[0xEA]", "[0xEB]", "[0xEC]", "[0xED]", "[0xEE]", "[0xEF]", "[0xF0]", "[0xF1]", "[0xF2]", "[0xF3]", "[0xF4]", "[0xF5]", "[0xF6]",
+    "[0xF7]", "[0xF8]", "[0xF9]", "[0xFA]", "[0xFB]", "[0xFC]", "[0xFD]", "[0xFE]", "[0xFF]"};
+
 static inline const char *ascii_to_diagnostics(unsigned char ch)
 {
-    static const char *ascii_lut[256] = {
-        "[NUL]",  "[SOH]",  "[STX]",  "[ETX]",  "[EOT]",  "[ENQ]",  "[ACK]",  "[BEL]",  "[BS]",   "[TAB]",  "[LF]",   "[VT]",   "[FF]",   "[CR]",   "[SO]",   "[SI]",   "[DLE]",  "[DC1]",  "[DC2]",
-        "[DC3]",  "[DC4]",  "[NAK]",  "[SYN]",  "[ETB]",  "[CAN]",  "[EM]",   "[SUB]",  "[ESC]",  "[FS]",   "[GS]",   "[RS]",   "[US]",   " ",      "!",      "\"",     "#",      "$",      "%",
-        "&",      "'",      "(",      ")",      "*",      "+",      ",",      "-",      ".",      "/",      "0",      "1",      "2",      "3",      "4",      "5",      "6",      "7",      "8",
-        "9",      ":",      ";",      "<",      "=",      ">",      "?",      "@",      "A",      "B",      "C",      "D",      "E",      "F",      "G",      "H",      "I",      "J",      "K",
-        "L",      "M",      "N",      "O",      "P",      "Q",      "R",      "S",      "T",      "U",      "V",      "W",      "X",      "Y",      "Z",      "[",      "\\",     "]",      "^",
-        "_",      "`",      "a",      "b",      "c",      "d",      "e",      "f",      "g",      "h",      "i",      "j",      "k",      "l",      "m",      "n",      "o",      "p",      "q",
-        "r",      "s",      "t",      "u",      "v",      "w",      "x",      "y",      "z",      "{",      "|",      "}",      "~",      "[DEL]",  "[0x80]", "[0x81]", "[0x82]", "[0x83]", "[0x84]",
-        "[0x85]", "[0x86]", "[0x87]", "[0x88]", "[0x89]", "[0x8A]", "[0x8B]", "[0x8C]", "[0x8D]", "[0x8E]", "[0x8F]", "[0x90]", "[0x91]", "[0x92]", "[0x93]", "[0x94]", "[0x95]", "[0x96]", "[0x97]",
-        "[0x98]", "[0x99]", "[0x9A]", "[0x9B]", "[0x9C]", "[0x9D]", "[0x9E]", "[0x9F]", "[0xA0]", "[0xA1]", "[0xA2]", "[0xA3]", "[0xA4]", "[0xA5]", "[0xA6]", "[0xA7]", "[0xA8]", "[0xA9]", "[0xAA]",
-        "[0xAB]", "[0xAC]", "[0xAD]", "[0xAE]", "[0xAF]", "[0xB0]", "[0xB1]", "[0xB2]", "[0xB3]", "[0xB4]", "[0xB5]", "[0xB6]", "[0xB7]", "[0xB8]", "[0xB9]", "[0xBA]", "[0xBB]", "[0xBC]", "[0xBD]",
-        "[0xBE]", "[0xBF]", "[0xC0]", "[0xC1]", "[0xC2]", "[0xC3]", "[0xC4]", "[0xC5]", "[0xC6]", "[0xC7]", "[0xC8]", "[0xC9]", "[0xCA]", "[0xCB]", "[0xCC]", "[0xCD]", "[0xCE]", "[0xCF]", "[0xD0]",
-        "[0xD1]", "[0xD2]", "[0xD3]", "[0xD4]", "[0xD5]", "[0xD6]", "[0xD7]", "[0xD8]", "[0xD9]", "[0xDA]", "[0xDB]", "[0xDC]", "[0xDD]", "[0xDE]", "[0xDF]", "[0xE0]", "[0xE1]", "[0xE2]", "[0xE3]",
-        "[0xE4]", "[0xE5]", "[0xE6]", "[0xE7]", "[0xE8]", "[0xE9]", "[0xEA]", "[0xEB]", "[0xEC]", "[0xED]", "[0xEE]", "[0xEF]", "[0xF0]", "[0xF1]", "[0xF2]", "[0xF3]", "[0xF4]", "[0xF5]", "[0xF6]",
-        "[0xF7]", "[0xF8]", "[0xF9]", "[0xFA]", "[0xFB]", "[0xFC]", "[0xFD]", "[0xFE]", "[0xFF]"};
-    return ascii_lut[ch];
+    return charutil_diagnostics_slots[ch];
+}
+
+/* ==========================
+ * Bulk Class Span
+ * ========================== */
+// charutil_span_class() returns the length of the prefix of p whose bytes all
+// belong to any of the CHARUTIL_CLASS_* bits in mask, i.e. the index of the
+// first byte that does not. The SIMD kernels test whole blocks at once and
+// the scalar path (CHARUTIL_IS_CLASS) finishes the tail.
+
+static inline size_t charutil_span_class_scalar(const char *p, size_t n, unsigned mask)
+{
+    size_t i = 0;
+    while (i < n && CHARUTIL_IS_CLASS((unsigned char)p[i], mask))
+    {
+        i++;
+    }
+    return i;
+}
+
+#if defined(CHARUTIL_HAVE_SSE2)
+static inline __m128i charutil_range_sse2(__m128i c, char lo, char hi)
+{
+    const __m128i offset = _mm_sub_epi8(c, _mm_set1_epi8(lo));
+    return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8((char)(hi - lo))), offset);
+}
+
+/// Sets each byte to 0xFF if it belongs to any class in mask
+static inline __m128i charutil_class_match_sse2(__m128i c, unsigned mask)
+{
+    const __m128i folded = _mm_or_si128(c, _mm_set1_epi8(1 << 5));
+    __m128i m = _mm_setzero_si128();
+    if (mask & CHARUTIL_CLASS_BINARY)
+    {
+        m = _mm_or_si128(m, charutil_range_sse2(c, '0', '1'));
+    }
+    if (mask & CHARUTIL_CLASS_OCTAL)
+    {
+        m = _mm_or_si128(m, charutil_range_sse2(c, '0', '7'));
+    }
+    if (mask & (CHARUTIL_CLASS_DIGIT | CHARUTIL_CLASS_ALNUM | CHARUTIL_CLASS_HEX_DIGIT))
+    {
+        m = _mm_or_si128(m, charutil_range_sse2(c, '0', '9'));
+    }
+    if (mask & CHARUTIL_CLASS_LOWER)
+    {
+        m = _mm_or_si128(m, charutil_range_sse2(c, 'a', 'z'));
+    }
+    if (mask & CHARUTIL_CLASS_UPPER)
+    {
+        m = _mm_or_si128(m, charutil_range_sse2(c, 'A', 'Z'));
+    }
+    if (mask & (CHARUTIL_CLASS_ALPHA | CHARUTIL_CLASS_ALNUM))
+    {
+        m = _mm_or_si128(m, charutil_range_sse2(folded, 'a', 'z'));
+    }
+    if (mask & CHARUTIL_CLASS_HEX_DIGIT)
+    {
+        m = _mm_or_si128(m, charutil_range_sse2(folded, 'a', 'f'));
+    }
+    if (mask & CHARUTIL_CLASS_PRINTABLE)
+    {
+        m = _mm_or_si128(m, charutil_range_sse2(c, ' ', '~'));
+    }
+    if (mask & CHARUTIL_CLASS_SPACE)
+    {
+        m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')), charutil_range_sse2(c, '\t', '\r')));
+    }
+    if (mask & (CHARUTIL_CLASS_PUNCT | CHARUTIL_CLASS_BRACKET | CHARUTIL_CLASS_SYMBOL))
+    {
+        // '[' and ']' fold onto '{' and '}'
+        const __m128i alnum = _mm_or_si128(charutil_range_sse2(c, '0', '9'), charutil_range_sse2(folded, 'a', 'z'));
+        const __m128i punct = _mm_andnot_si128(alnum, charutil_range_sse2(c, '!', '~'));
+        const __m128i bracket = _mm_or_si128(charutil_range_sse2(c, '(', ')'), _mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')), _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))));
+        if (mask & CHARUTIL_CLASS_PUNCT)
+        {
+            m = _mm_or_si128(m, punct);
+        }
+        if (mask & CHARUTIL_CLASS_BRACKET)
+        {
+            m = _mm_or_si128(m, bracket);
+        }
+        if (mask & CHARUTIL_CLASS_SYMBOL)
+        {
+            m = _mm_or_si128(m, _mm_andnot_si128(bracket, punct));
+        }
+    }
+    if (mask & CHARUTIL_CLASS_ASCII)
+    {
+        m = _mm_or_si128(m, _mm_cmpgt_epi8(c, _mm_set1_epi8(-1)));
+    }
+    return m;
+}
+
+static inline size_t charutil_span_class_sse2(const char *p, size_t n, unsigned mask)
+{
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i m = charutil_class_match_sse2(_mm_loadu_si128((const __m128i *)(p + i)), mask);
+        const uint32_t miss = ~(uint32_t)_mm_movemask_epi8(m) & 0xFFFFu;
+        if (miss)
+        {
+            return i + charutil_ctz32(miss);
+        }
+    }
+    return i + charutil_span_class_scalar(p + i, n - i, mask);
+}
+#endif
+
+#if defined(CHARUTIL_HAVE_AVX2)
+static inline CHARUTIL_TARGET_AVX2 __m256i charutil_range_avx2(__m256i c, char lo, char hi)
+{
+    const __m256i offset = _mm256_sub_epi8(c, _mm256_set1_epi8(lo));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8((char)(hi - lo))), offset);
+}
+
+static inline CHARUTIL_TARGET_AVX2 __m256i charutil_class_match_avx2(__m256i c, unsigned mask)
+{
+    const __m256i folded = _mm256_or_si256(c, _mm256_set1_epi8(1 << 5));
+    __m256i m = _mm256_setzero_si256();
+    if (mask & CHARUTIL_CLASS_BINARY)
+    {
+        m = _mm256_or_si256(m, charutil_range_avx2(c, '0', '1'));
+    }
+    if (mask & CHARUTIL_CLASS_OCTAL)
+    {
+        m = _mm256_or_si256(m, charutil_range_avx2(c, '0', '7'));
+    }
+    if (mask & (CHARUTIL_CLASS_DIGIT | CHARUTIL_CLASS_ALNUM | CHARUTIL_CLASS_HEX_DIGIT))
+    {
+        m = _mm256_or_si256(m, charutil_range_avx2(c, '0', '9'));
+    }
+    if (mask & CHARUTIL_CLASS_LOWER)
+    {
+        m = _mm256_or_si256(m, charutil_range_avx2(c, 'a', 'z'));
+    }
+    if (mask & CHARUTIL_CLASS_UPPER)
+    {
+        m = _mm256_or_si256(m, charutil_range_avx2(c, 'A', 'Z'));
+    }
+    if (mask & (CHARUTIL_CLASS_ALPHA | CHARUTIL_CLASS_ALNUM))
+    {
+        m = _mm256_or_si256(m, charutil_range_avx2(folded, 'a', 'z'));
+    }
+    if (mask & CHARUTIL_CLASS_HEX_DIGIT)
+    {
+        m = _mm256_or_si256(m, charutil_range_avx2(folded, 'a', 'f'));
+    }
+    if (mask & CHARUTIL_CLASS_PRINTABLE)
+    {
+        m = _mm256_or_si256(m, charutil_range_avx2(c, ' ', '~'));
+    }
+    if (mask & CHARUTIL_CLASS_SPACE)
+    {
+        m = _mm256_or_si256(m, _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')), charutil_range_avx2(c, '\t', '\r')));
+    }
+    if (mask & (CHARUTIL_CLASS_PUNCT | CHARUTIL_CLASS_BRACKET | CHARUTIL_CLASS_SYMBOL))
+    {
+        const __m256i alnum = _mm256_or_si256(charutil_range_avx2(c, '0', '9'), charutil_range_avx2(folded, 'a', 'z'));
+        const __m256i punct = _mm256_andnot_si256(alnum, charutil_range_avx2(c, '!', '~'));
+        const __m256i bracket = _mm256_or_si256(charutil_range_avx2(c, '(', ')'), _mm256_or_si256(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}'))));
+        if (mask & CHARUTIL_CLASS_PUNCT)
+        {
+            m = _mm256_or_si256(m, punct);
+        }
+        if (mask & CHARUTIL_CLASS_BRACKET)
+        {
+            m = _mm256_or_si256(m, bracket);
+        }
+        if (mask & CHARUTIL_CLASS_SYMBOL)
+        {
+            m = _mm256_or_si256(m, _mm256_andnot_si256(bracket, punct));
+        }
+    }
+    if (mask & CHARUTIL_CLASS_ASCII)
+    {
+        m = _mm256_or_si256(m, _mm256_cmpgt_epi8(c, _mm256_set1_epi8(-1)));
+    }
+    return m;
+}
+
+static inline CHARUTIL_TARGET_AVX2 size_t charutil_span_class_avx2(const char *p, size_t n, unsigned mask)
+{
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        const __m256i m = charutil_class_match_avx2(_mm256_loadu_si256((const __m256i *)(p + i)), mask);
+        const uint32_t miss = ~(uint32_t)_mm256_movemask_epi8(m);
+        if (miss)
+        {
+            return i + charutil_ctz32(miss);
+        }
+    }
+    return i + charutil_span_class_scalar(p + i, n - i, mask);
+}
+#endif
+
+#if defined(CHARUTIL_HAVE_NEON)
+static inline uint8x16_t charutil_range_neon(uint8x16_t c, uint8_t lo, uint8_t hi)
+{
+    return vcleq_u8(vsubq_u8(c, vdupq_n_u8(lo)), vdupq_n_u8((uint8_t)(hi - lo)));
+}
+
+static inline uint8x16_t charutil_class_match_neon(uint8x16_t c, unsigned mask)
+{
+    const uint8x16_t folded = vorrq_u8(c, vdupq_n_u8(1 << 5));
+    uint8x16_t m = vdupq_n_u8(0);
+    if (mask & CHARUTIL_CLASS_BINARY)
+    {
+        m = vorrq_u8(m, charutil_range_neon(c, '0', '1'));
+    }
+    if (mask & CHARUTIL_CLASS_OCTAL)
+    {
+        m = vorrq_u8(m, charutil_range_neon(c, '0', '7'));
+    }
+    if (mask & (CHARUTIL_CLASS_DIGIT | CHARUTIL_CLASS_ALNUM | CHARUTIL_CLASS_HEX_DIGIT))
+    {
+        m = vorrq_u8(m, charutil_range_neon(c, '0', '9'));
+    }
+    if (mask & CHARUTIL_CLASS_LOWER)
+    {
+        m = vorrq_u8(m, charutil_range_neon(c, 'a', 'z'));
+    }
+    if (mask & CHARUTIL_CLASS_UPPER)
+    {
+        m = vorrq_u8(m, charutil_range_neon(c, 'A', 'Z'));
+    }
+    if (mask & (CHARUTIL_CLASS_ALPHA | CHARUTIL_CLASS_ALNUM))
+    {
+        m = vorrq_u8(m, charutil_range_neon(folded, 'a', 'z'));
+    }
+    if (mask & CHARUTIL_CLASS_HEX_DIGIT)
+    {
+        m = vorrq_u8(m, charutil_range_neon(folded, 'a', 'f'));
+    }
+    if (mask & CHARUTIL_CLASS_PRINTABLE)
+    {
+        m = vorrq_u8(m, charutil_range_neon(c, ' ', '~'));
+    }
+    if (mask & CHARUTIL_CLASS_SPACE)
+    {
+        m = vorrq_u8(m, vorrq_u8(vceqq_u8(c, vdupq_n_u8(' ')), charutil_range_neon(c, '\t', '\r')));
+    }
+    if (mask & (CHARUTIL_CLASS_PUNCT | CHARUTIL_CLASS_BRACKET | CHARUTIL_CLASS_SYMBOL))
+    {
+        const uint8x16_t alnum = vorrq_u8(charutil_range_neon(c, '0', '9'), charutil_range_neon(folded, 'a', 'z'));
+        const uint8x16_t punct = vbicq_u8(charutil_range_neon(c, '!', '~'), alnum);
+        const uint8x16_t bracket = vorrq_u8(charutil_range_neon(c, '(', ')'), vorrq_u8(vceqq_u8(folded, vdupq_n_u8('{')), vceqq_u8(folded, vdupq_n_u8('}'))));
+        if (mask & CHARUTIL_CLASS_PUNCT)
+        {
+            m = vorrq_u8(m, punct);
+        }
+        if (mask & CHARUTIL_CLASS_BRACKET)
+        {
+            m = vorrq_u8(m, bracket);
+        }
+        if (mask & CHARUTIL_CLASS_SYMBOL)
+        {
+            m = vorrq_u8(m, vbicq_u8(punct, bracket));
+        }
+    }
+    if (mask & CHARUTIL_CLASS_ASCII)
+    {
+        m = vorrq_u8(m, vcltq_u8(c, vdupq_n_u8(0x80)));
+    }
+    return m;
+}
+
+/// NEON has no movemask; narrow each byte to a nibble so a 64 bit ctz / 4 gives the byte index
+static inline uint64_t charutil_nibble_mask_neon(uint8x16_t m)
+{
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+}
+
+static inline size_t charutil_span_class_neon(const char *p, size_t n, unsigned mask)
+{
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const uint8x16_t m = charutil_class_match_neon(vld1q_u8((const uint8_t *)p + i), mask);
+        const uint64_t miss = charutil_nibble_mask_neon(vmvnq_u8(m));
+        if (miss)
+        {
+            return i + charutil_ctz64(miss) / 4;
+        }
+    }
+    return i + charutil_span_class_scalar(p + i, n - i, mask);
+}
+#endif
+
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+static inline size_t charutil_dispatch_span_class(const char *p, size_t n, unsigned mask);
+#endif
+
+static inline size_t charutil_span_class(const char *p, size_t n, unsigned mask)
+{
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+    return charutil_dispatch_span_class(p, n, mask);
+#elif defined(CHARUTIL_HAVE_AVX2)
+    return charutil_span_class_avx2(p, n, mask);
+#elif defined(CHARUTIL_HAVE_SSE2)
+    return charutil_span_class_sse2(p, n, mask);
+#elif defined(CHARUTIL_HAVE_NEON)
+    return charutil_span_class_neon(p, n, mask);
+#else
+    return charutil_span_class_scalar(p, n, mask);
+#endif
+}
+
+/// Defines charutil_span_<name>() returning the matching prefix length and
+/// charutil_find_first_not_<name>() returning a pointer to the first non matching byte (or p + n)
+#define CHARUTIL_DEFINE_SPAN(name, mask)                                                                                                                                                               \
+    static inline size_t charutil_span_##name(const char *p, size_t n)                                                                                                                                 \
+    {                                                                                                                                                                                                  \
+        return charutil_span_class(p, n, mask);                                                                                                                                                        \
+    }                                                                                                                                                                                                  \
+    static inline const char *charutil_find_first_not_##name(const char *p, size_t n)                                                                                                                  \
+    {                                                                                                                                                                                                  \
+        return p + charutil_span_class(p, n, mask);                                                                                                                                                    \
+    }
+
+CHARUTIL_DEFINE_SPAN(binary, CHARUTIL_CLASS_BINARY)
+CHARUTIL_DEFINE_SPAN(octal, CHARUTIL_CLASS_OCTAL)
+CHARUTIL_DEFINE_SPAN(digit, CHARUTIL_CLASS_DIGIT)
+CHARUTIL_DEFINE_SPAN(lower, CHARUTIL_CLASS_LOWER)
+CHARUTIL_DEFINE_SPAN(upper, CHARUTIL_CLASS_UPPER)
+CHARUTIL_DEFINE_SPAN(alpha, CHARUTIL_CLASS_ALPHA)
+CHARUTIL_DEFINE_SPAN(alnum, CHARUTIL_CLASS_ALNUM)
+CHARUTIL_DEFINE_SPAN(hex_digit, CHARUTIL_CLASS_HEX_DIGIT)
+CHARUTIL_DEFINE_SPAN(printable, CHARUTIL_CLASS_PRINTABLE)
+CHARUTIL_DEFINE_SPAN(space, CHARUTIL_CLASS_SPACE)
+CHARUTIL_DEFINE_SPAN(punct, CHARUTIL_CLASS_PUNCT)
+CHARUTIL_DEFINE_SPAN(bracket, CHARUTIL_CLASS_BRACKET)
+CHARUTIL_DEFINE_SPAN(symbol, CHARUTIL_CLASS_SYMBOL)
+CHARUTIL_DEFINE_SPAN(ascii, CHARUTIL_CLASS_ASCII)
+
+/* ==========================
+ * Character Sets
+ * ========================== */
+// charutil_set_t is a 256 bit membership bitmap for any set of byte values,
+// for the delimiter and token sets a parser needs beyond the built in classes.
+// Bits are laid out as the two 16 byte tables of a nibble lookup: byte
+// rows[ch >> 7][ch & 0x0F] holds bit (ch >> 4) & 7. A single table load
+// answers charutil_set_contains(), and the SIMD kernels test 16 or 32 bytes
+// with two byte shuffles (pshufb / vqtbl1q), so an arbitrary set scans as fast
+// as a built in class.
+// CHARUTIL_SET_LITERAL("...") builds the bitmap as a constant initializer from
+// a string literal of up to 32 characters. Static initializers need the
+// compiler to fold string literal subscripts (GCC and Clang do). At function
+// scope any C99 compiler accepts it. Otherwise use the charutil_set_add_*()
+// functions.
+
+typedef struct
+{
+    uint8_t rows[2][16]; ///< Nibble lookup tables, the only representation so every access is well defined in C and C++
+} charutil_set_t;
+
+#define CHARUTIL_SET_ROW_BYTE(ch) ((((ch) >> 7) << 4) | ((ch) & 0x0F)) ///< Index into the flattened rows
+#define CHARUTIL_SET_ROW_BIT(ch) (((ch) >> 4) & 7)                     ///< Bit within that byte
+#define CHARUTIL_SET_CHAR(s, i) ((unsigned char)(s)[((i) < sizeof(s) - 1) ? (i) : 0])
+#define CHARUTIL_SET_TERM(s, i, r) ((((i) < sizeof(s) - 1) && CHARUTIL_SET_ROW_BYTE(CHARUTIL_SET_CHAR(s, i)) == (r)) ? 1u << CHARUTIL_SET_ROW_BIT(CHARUTIL_SET_CHAR(s, i)) : 0u)
+#define CHARUTIL_SET_BYTE(s, r) (CHARUTIL_SET_TERM(s, 0, r) | CHARUTIL_SET_TERM(s, 1, r) | CHARUTIL_SET_TERM(s, 2, r) | CHARUTIL_SET_TERM(s, 3, r) | CHARUTIL_SET_TERM(s, 4, r) | CHARUTIL_SET_TERM(s, 5, r) | CHARUTIL_SET_TERM(s, 6, r) | CHARUTIL_SET_TERM(s, 7, r) | CHARUTIL_SET_TERM(s, 8, r) | CHARUTIL_SET_TERM(s, 9, r) | CHARUTIL_SET_TERM(s, 10, r) | CHARUTIL_SET_TERM(s, 11, r) | CHARUTIL_SET_TERM(s, 12, r) | CHARUTIL_SET_TERM(s, 13, r) | CHARUTIL_SET_TERM(s, 14, r) | CHARUTIL_SET_TERM(s, 15, r) | CHARUTIL_SET_TERM(s, 16, r) | CHARUTIL_SET_TERM(s, 17, r) | CHARUTIL_SET_TERM(s, 18, r) | CHARUTIL_SET_TERM(s, 19, r) | CHARUTIL_SET_TERM(s, 20, r) | CHARUTIL_SET_TERM(s, 21, r) | CHARUTIL_SET_TERM(s, 22, r) | CHARUTIL_SET_TERM(s, 23, r) | CHARUTIL_SET_TERM(s, 24, r) | CHARUTIL_SET_TERM(s, 25, r) | CHARUTIL_SET_TERM(s, 26, r) | CHARUTIL_SET_TERM(s, 27, r) | CHARUTIL_SET_TERM(s, 28, r) | CHARUTIL_SET_TERM(s, 29, r) | CHARUTIL_SET_TERM(s, 30, r) | CHARUTIL_SET_TERM(s, 31, r))
+#define CHARUTIL_SET_LITERAL(s) {{{CHARUTIL_SET_BYTE(s, 0) | 0 * sizeof(char[(sizeof(s) <= 33) ? 1 : -1]), CHARUTIL_SET_BYTE(s, 1), CHARUTIL_SET_BYTE(s, 2), CHARUTIL_SET_BYTE(s, 3), CHARUTIL_SET_BYTE(s, 4), CHARUTIL_SET_BYTE(s, 5), CHARUTIL_SET_BYTE(s, 6), CHARUTIL_SET_BYTE(s, 7), CHARUTIL_SET_BYTE(s, 8), CHARUTIL_SET_BYTE(s, 9), CHARUTIL_SET_BYTE(s, 10), CHARUTIL_SET_BYTE(s, 11), CHARUTIL_SET_BYTE(s, 12), CHARUTIL_SET_BYTE(s, 13), CHARUTIL_SET_BYTE(s, 14), CHARUTIL_SET_BYTE(s, 15)}, \
+                                  {CHARUTIL_SET_BYTE(s, 16), CHARUTIL_SET_BYTE(s, 17), CHARUTIL_SET_BYTE(s, 18), CHARUTIL_SET_BYTE(s, 19), CHARUTIL_SET_BYTE(s, 20), CHARUTIL_SET_BYTE(s, 21), CHARUTIL_SET_BYTE(s, 22), CHARUTIL_SET_BYTE(s, 23), CHARUTIL_SET_BYTE(s, 24), CHARUTIL_SET_BYTE(s, 25), CHARUTIL_SET_BYTE(s, 26), CHARUTIL_SET_BYTE(s, 27), CHARUTIL_SET_BYTE(s, 28), CHARUTIL_SET_BYTE(s, 29), CHARUTIL_SET_BYTE(s, 30), CHARUTIL_SET_BYTE(s, 31)}}} ///< Fails to compile past 32 characters
+/// Constant initializer from the 32 bytes of rows[0] then rows[1], for sets with ranges that CHARUTIL_SET_LITERAL() cannot spell
+#define CHARUTIL_SET_ROWS(r0, r1, r2, r3, r4, r5, r6, r7, r8, r9, r10, r11, r12, r13, r14, r15, r16, r17, r18, r19, r20, r21, r22, r23, r24, r25, r26, r27, r28, r29, r30, r31) \
+    {{{r0, r1, r2, r3, r4, r5, r6, r7, r8, r9, r10, r11, r12, r13, r14, r15}, {r16, r17, r18, r19, r20, r21, r22, r23, r24, r25, r26, r27, r28, r29, r30, r31}}}
+
+static inline void charutil_set_clear(charutil_set_t *set)
+{
+    memset(set, 0, sizeof(*set));
+}
+
+static inline int charutil_set_contains(const charutil_set_t *set, unsigned char ch)
+{
+    return (set->rows[ch >> 7][ch & 0x0F] >> CHARUTIL_SET_ROW_BIT(ch)) & 1;
+}
+
+static inline void charutil_set_add(charutil_set_t *set, unsigned char ch)
+{
+    set->rows[ch >> 7][ch & 0x0F] |= (uint8_t)(1u << CHARUTIL_SET_ROW_BIT(ch));
+}
+
+static inline void charutil_set_add_chars(charutil_set_t *set, const char *chars, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        charutil_set_add(set, (unsigned char)chars[i]);
+    }
+}
+
+/// Adds every byte value from lo to hi inclusive
+static inline void charutil_set_add_range(charutil_set_t *set, unsigned char lo, unsigned char hi)
+{
+    for (unsigned ch = lo; ch <= hi; ch++)
+    {
+        charutil_set_add(set, (unsigned char)ch);
+    }
+}
+
+/// Adds every member of the CHARUTIL_CLASS_* bits in mask
+static inline void charutil_set_add_class(charutil_set_t *set, unsigned mask)
+{
+    for (unsigned ch = 0; ch < 128; ch++)
+    {
+        if (CHARUTIL_IS_CLASS(ch, mask))
+        {
+            charutil_set_add(set, (unsigned char)ch);
+        }
+    }
+}
+
+static inline void charutil_set_invert(charutil_set_t *set)
+{
+    for (size_t i = 0; i < 16; i++)
+    {
+        set->rows[0][i] = (uint8_t)~set->rows[0][i];
+        set->rows[1][i] = (uint8_t)~set->rows[1][i];
+    }
+}
+
+/// Index of the first byte whose membership differs from member (1 or 0), or n
+static inline size_t charutil_set_scan_scalar(const char *p, size_t n, const charutil_set_t *set, int member)
+{
+    size_t i = 0;
+    while (i < n && charutil_set_contains(set, (unsigned char)p[i]) == member)
+    {
+        i++;
+    }
+    return i;
+}
+
+#if defined(CHARUTIL_HAVE_AVX2)
+/// Sets each byte to 0xFF if it is in the set. rows0/rows1 hold set->rows broadcast to both lanes.
+static inline CHARUTIL_TARGET_AVX2 __m256i charutil_set_match_avx2(__m256i c, __m256i rows0, __m256i rows1)
+{
+    const __m256i bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const __m256i lo = _mm256_and_si256(c, _mm256_set1_epi8(0x0F));
+    const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(c, 4), _mm256_set1_epi8(0x0F));
+    const __m256i row = _mm256_blendv_epi8(_mm256_shuffle_epi8(rows0, lo), _mm256_shuffle_epi8(rows1, lo), c);
+    const __m256i bit = _mm256_shuffle_epi8(bits, hi);
+    return _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit);
+}
+
+static inline CHARUTIL_TARGET_AVX2 size_t charutil_set_scan_avx2(const char *p, size_t n, const charutil_set_t *set, int member)
+{
+    const __m256i rows0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)set->rows[0]));
+    const __m256i rows1 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)set->rows[1]));
+    const uint32_t flip = member ? 0xFFFFFFFFu : 0;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        const uint32_t miss = (uint32_t)_mm256_movemask_epi8(charutil_set_match_avx2(_mm256_loadu_si256((const __m256i *)(p + i)), rows0, rows1)) ^ flip;
+        if (miss)
+        {
+            return i + charutil_ctz32(miss);
+        }
+    }
+    return i + charutil_set_scan_scalar(p + i, n - i, set, member);
+}
+#endif
+
+#if defined(CHARUTIL_HAVE_NEON) && defined(__aarch64__)
+static inline uint8x16_t charutil_set_match_neon(uint8x16_t c, uint8x16_t rows0, uint8x16_t rows1)
+{
+    static const uint8_t bits[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t lo = vandq_u8(c, vdupq_n_u8(0x0F));
+    const uint8x16_t high_half = vreinterpretq_u8_s8(vshrq_n_s8(vreinterpretq_s8_u8(c), 7));
+    const uint8x16_t row = vbslq_u8(high_half, vqtbl1q_u8(rows1, lo), vqtbl1q_u8(rows0, lo));
+    return vtstq_u8(row, vqtbl1q_u8(vld1q_u8(bits), vshrq_n_u8(c, 4)));
+}
+
+static inline size_t charutil_set_scan_neon(const char *p, size_t n, const charutil_set_t *set, int member)
+{
+    const uint8x16_t rows0 = vld1q_u8(set->rows[0]);
+    const uint8x16_t rows1 = vld1q_u8(set->rows[1]);
+    const uint64_t flip = member ? UINT64_MAX : 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const uint64_t miss = charutil_nibble_mask_neon(charutil_set_match_neon(vld1q_u8((const uint8_t *)p + i), rows0, rows1)) ^ flip;
+        if (miss)
+        {
+            return i + charutil_ctz64(miss) / 4;
+        }
+    }
+    return i + charutil_set_scan_scalar(p + i, n - i, set, member);
+}
+#endif
+
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+static inline size_t charutil_dispatch_set_scan(const char *p, size_t n, const charutil_set_t *set, int member);
+#endif
+
+static inline size_t charutil_set_scan(const char *p, size_t n, const charutil_set_t *set, int member)
+{
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+    return charutil_dispatch_set_scan(p, n, set, member);
+#elif defined(CHARUTIL_HAVE_AVX2)
+    return charutil_set_scan_avx2(p, n, set, member);
+#elif defined(CHARUTIL_HAVE_NEON) && defined(__aarch64__)
+    return charutil_set_scan_neon(p, n, set, member);
+#else
+    return charutil_set_scan_scalar(p, n, set, member);
+#endif
+}
+
+/// Length of the leading run of p whose bytes are all in set (like strspn)
+static inline size_t charutil_set_span(const char *p, size_t n, const charutil_set_t *set)
+{
+    return charutil_set_scan(p, n, set, 1);
+}
+
+/// Length of the leading run of p whose bytes are all outside set (like strcspn)
+static inline size_t charutil_set_cspan(const char *p, size_t n, const charutil_set_t *set)
+{
+    return charutil_set_scan(p, n, set, 0);
+}
+
+/// Pointer to the first byte of p that is in set, or p + n if there is none
+static inline const char *charutil_set_find(const char *p, size_t n, const charutil_set_t *set)
+{
+    return p + charutil_set_scan(p, n, set, 0);
+}
+
+/* ==========================
+ * Class Counts & Histogram
+ * ========================== */
+// charutil_class_counts() tallies how many bytes of a buffer fall into each
+// CHARUTIL_CLASS_* class in one pass, for content sniffing (text or binary,
+// hex or base64) without a separate loop per IS_* macro.
+// The SIMD kernels subtract class masks from byte lane counters (a match is
+// 0xFF, i.e. -1) and widen the lanes with a horizontal sum every 255 blocks
+// before they can wrap. Without a
+// kernel, or when the caller also wants the 256 bin histogram, the buffer is
+// histogrammed instead and the class counts folded out of the bins with
+// charutil_class_table. The histogram spreads consecutive bytes over four
+// sub histograms so runs of the same byte do not stall on incrementing the
+// counter just stored to.
+
+#define CHARUTIL_CLASS_COUNT 14 ///< Number of CHARUTIL_CLASS_* bits
+
+typedef struct
+{
+    uint64_t total;                         ///< Bytes counted
+    uint64_t classes[CHARUTIL_CLASS_COUNT]; ///< classes[i] counts the bytes in class (1u << i)
+} charutil_class_counts_t;
+
+/// Count of one CHARUTIL_CLASS_* class, e.g. charutil_class_count(&counts, CHARUTIL_CLASS_PRINTABLE)
+static inline uint64_t charutil_class_count(const charutil_class_counts_t *counts, unsigned class_bit)
+{
+    return counts->classes[charutil_ctz32(class_bit)];
+}
+
+/// Adds the byte values of src to histogram[256]
+static inline void charutil_byte_histogram_add(const void *src, size_t n, uint64_t *histogram)
+{
+    const unsigned char *p = (const unsigned char *)src;
+    size_t i = 0;
+    if (n >= 1024)
+    {
+        uint32_t sub[4][256];
+        while (n - i >= 4)
+        {
+            // Each bin sees at most a quarter of a chunk, far below 2^32
+            const size_t end = i + ((n - i < ((size_t)1 << 30)) ? n - i : ((size_t)1 << 30)) / 4 * 4;
+            memset(sub, 0, sizeof(sub));
+            for (; i < end; i += 4)
+            {
+                sub[0][p[i]]++;
+                sub[1][p[i + 1]]++;
+                sub[2][p[i + 2]]++;
+                sub[3][p[i + 3]]++;
+            }
+            for (int b = 0; b < 256; b++)
+            {
+                histogram[b] += (uint64_t)sub[0][b] + sub[1][b] + sub[2][b] + sub[3][b];
+            }
+        }
+    }
+    for (; i < n; i++)
+    {
+        histogram[p[i]]++;
+    }
+}
+
+/// Adds the class counts of the bytes tallied in histogram[256]
+static inline void charutil_class_counts_from_histogram(const uint64_t *histogram, charutil_class_counts_t *counts)
+{
+    for (int b = 0; b < 128; b++)
+    {
+        for (unsigned bits = charutil_class_table[b]; bits; bits &= bits - 1)
+        {
+            counts->classes[charutil_ctz32(bits)] += histogram[b];
+        }
+    }
+}
+
+// The block kernels only count eleven independent classes and derive the rest
+// when widening: alpha = lower + upper, alnum = alpha + digit, hex digit =
+// digit + 'a'..'f' folded, printable = alnum + punct + ' ' and symbol =
+// punct - bracket. That keeps every byte lane counter in a register.
+enum
+{
+    CHARUTIL_CLASS_RAW_BINARY,
+    CHARUTIL_CLASS_RAW_OCTAL,
+    CHARUTIL_CLASS_RAW_DIGIT,
+    CHARUTIL_CLASS_RAW_LOWER,
+    CHARUTIL_CLASS_RAW_UPPER,
+    CHARUTIL_CLASS_RAW_HEX_ALPHA,
+    CHARUTIL_CLASS_RAW_BLANK,
+    CHARUTIL_CLASS_RAW_SPACE,
+    CHARUTIL_CLASS_RAW_PUNCT,
+    CHARUTIL_CLASS_RAW_BRACKET,
+    CHARUTIL_CLASS_RAW_ASCII,
+    CHARUTIL_CLASS_RAW_COUNT
+};
+
+/// Adds the classes derived from the raw block kernel counts
+static inline void charutil_class_count_fold(uint64_t *classes, const uint64_t *raw)
+{
+    const uint64_t alpha = raw[CHARUTIL_CLASS_RAW_LOWER] + raw[CHARUTIL_CLASS_RAW_UPPER];
+    const uint64_t alnum = alpha + raw[CHARUTIL_CLASS_RAW_DIGIT];
+    classes[0] += raw[CHARUTIL_CLASS_RAW_BINARY];
+    classes[1] += raw[CHARUTIL_CLASS_RAW_OCTAL];
+    classes[2] += raw[CHARUTIL_CLASS_RAW_DIGIT];
+    classes[3] += raw[CHARUTIL_CLASS_RAW_LOWER];
+    classes[4] += raw[CHARUTIL_CLASS_RAW_UPPER];
+    classes[5] += alpha;
+    classes[6] += alnum;
+    classes[7] += raw[CHARUTIL_CLASS_RAW_DIGIT] + raw[CHARUTIL_CLASS_RAW_HEX_ALPHA];
+    classes[8] += alnum + raw[CHARUTIL_CLASS_RAW_PUNCT] + raw[CHARUTIL_CLASS_RAW_BLANK];
+    classes[9] += raw[CHARUTIL_CLASS_RAW_SPACE];
+    classes[10] += raw[CHARUTIL_CLASS_RAW_PUNCT];
+    classes[11] += raw[CHARUTIL_CLASS_RAW_BRACKET];
+    classes[12] += raw[CHARUTIL_CLASS_RAW_PUNCT] - raw[CHARUTIL_CLASS_RAW_BRACKET];
+    classes[13] += raw[CHARUTIL_CLASS_RAW_ASCII];
+}
+
+#if defined(CHARUTIL_HAVE_SSE2)
+static inline uint64_t charutil_lane_sum_sse2(__m128i acc)
+{
+    const __m128i sum = _mm_sad_epu8(acc, _mm_setzero_si128());
+    return (uint64_t)_mm_cvtsi128_si32(sum) + (uint64_t)_mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+}
+
+static inline size_t charutil_class_count_sse2(const unsigned char *p, size_t n, uint64_t *classes)
+{
+    size_t i = 0;
+    while (n - i >= 16)
+    {
+        const size_t blocks = ((n - i) / 16 < 255) ? (n - i) / 16 : 255;
+        __m128i binary = _mm_setzero_si128(), octal = binary, digit = binary, lower = binary, upper = binary, hex_alpha = binary;
+        __m128i blank = binary, space = binary, punct = binary, bracket = binary, ascii = binary;
+        for (size_t end = i + 16 * blocks; i < end; i += 16)
+        {
+            const __m128i c = _mm_loadu_si128((const __m128i *)(p + i));
+            const __m128i folded = _mm_or_si128(c, _mm_set1_epi8(1 << 5));
+            const __m128i is_digit = charutil_range_sse2(c, '0', '9');
+            const __m128i is_blank = _mm_cmpeq_epi8(c, _mm_set1_epi8(' '));
+            binary = _mm_sub_epi8(binary, charutil_range_sse2(c, '0', '1'));
+            octal = _mm_sub_epi8(octal, charutil_range_sse2(c, '0', '7'));
+            digit = _mm_sub_epi8(digit, is_digit);
+            lower = _mm_sub_epi8(lower, charutil_range_sse2(c, 'a', 'z'));
+            upper = _mm_sub_epi8(upper, charutil_range_sse2(c, 'A', 'Z'));
+            hex_alpha = _mm_sub_epi8(hex_alpha, charutil_range_sse2(folded, 'a', 'f'));
+            blank = _mm_sub_epi8(blank, is_blank);
+            space = _mm_sub_epi8(space, _mm_or_si128(is_blank, charutil_range_sse2(c, '\t', '\r')));
+            punct = _mm_sub_epi8(punct, _mm_andnot_si128(_mm_or_si128(is_digit, charutil_range_sse2(folded, 'a', 'z')), charutil_range_sse2(c, '!', '~')));
+            bracket = _mm_sub_epi8(bracket, _mm_or_si128(charutil_range_sse2(c, '(', ')'), _mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')), _mm_cmpeq_epi8(folded, _mm_set1_epi8('}')))));
+            ascii = _mm_sub_epi8(ascii, _mm_cmpgt_epi8(c, _mm_set1_epi8(-1)));
+        }
+        const uint64_t raw[CHARUTIL_CLASS_RAW_COUNT] = {charutil_lane_sum_sse2(binary), charutil_lane_sum_sse2(octal), charutil_lane_sum_sse2(digit), charutil_lane_sum_sse2(lower),
+                                                        charutil_lane_sum_sse2(upper), charutil_lane_sum_sse2(hex_alpha), charutil_lane_sum_sse2(blank), charutil_lane_sum_sse2(space),
+                                                        charutil_lane_sum_sse2(punct), charutil_lane_sum_sse2(bracket), charutil_lane_sum_sse2(ascii)};
+        charutil_class_count_fold(classes, raw);
+    }
+    return i;
+}
+#endif
+
+#if defined(CHARUTIL_HAVE_AVX2)
+static inline CHARUTIL_TARGET_AVX2 uint64_t charutil_lane_sum_avx2(__m256i acc)
+{
+    const __m256i sum = _mm256_sad_epu8(acc, _mm256_setzero_si256());
+    const __m128i half = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    return (uint64_t)_mm_cvtsi128_si32(half) + (uint64_t)_mm_cvtsi128_si32(_mm_srli_si128(half, 8));
+}
+
+static inline CHARUTIL_TARGET_AVX2 size_t charutil_class_count_avx2(const unsigned char *p, size_t n, uint64_t *classes)
+{
+    size_t i = 0;
+    while (n - i >= 32)
+    {
+        const size_t blocks = ((n - i) / 32 < 255) ? (n - i) / 32 : 255;
+        __m256i binary = _mm256_setzero_si256(), octal = binary, digit = binary, lower = binary, upper = binary, hex_alpha = binary;
+        __m256i blank = binary, space = binary, punct = binary, bracket = binary, ascii = binary;
+        for (size_t end = i + 32 * blocks; i < end; i += 32)
+        {
+            const __m256i c = _mm256_loadu_si256((const __m256i *)(p + i));
+            const __m256i folded = _mm256_or_si256(c, _mm256_set1_epi8(1 << 5));
+            const __m256i is_digit = charutil_range_avx2(c, '0', '9');
+            const __m256i is_blank = _mm256_cmpeq_epi8(c, _mm256_set1_epi8(' '));
+            binary = _mm256_sub_epi8(binary, charutil_range_avx2(c, '0', '1'));
+            octal = _mm256_sub_epi8(octal, charutil_range_avx2(c, '0', '7'));
+            digit = _mm256_sub_epi8(digit, is_digit);
+            lower = _mm256_sub_epi8(lower, charutil_range_avx2(c, 'a', 'z'));
+            upper = _mm256_sub_epi8(upper, charutil_range_avx2(c, 'A', 'Z'));
+            hex_alpha = _mm256_sub_epi8(hex_alpha, charutil_range_avx2(folded, 'a', 'f'));
+            blank = _mm256_sub_epi8(blank, is_blank);
+            space = _mm256_sub_epi8(space, _mm256_or_si256(is_blank, charutil_range_avx2(c, '\t', '\r')));
+            punct = _mm256_sub_epi8(punct, _mm256_andnot_si256(_mm256_or_si256(is_digit, charutil_range_avx2(folded, 'a', 'z')), charutil_range_avx2(c, '!', '~')));
+            bracket = _mm256_sub_epi8(bracket, _mm256_or_si256(charutil_range_avx2(c, '(', ')'), _mm256_or_si256(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}')))));
+            ascii = _mm256_sub_epi8(ascii, _mm256_cmpgt_epi8(c, _mm256_set1_epi8(-1)));
+        }
+        const uint64_t raw[CHARUTIL_CLASS_RAW_COUNT] = {charutil_lane_sum_avx2(binary), charutil_lane_sum_avx2(octal), charutil_lane_sum_avx2(digit), charutil_lane_sum_avx2(lower),
+                                                        charutil_lane_sum_avx2(upper), charutil_lane_sum_avx2(hex_alpha), charutil_lane_sum_avx2(blank), charutil_lane_sum_avx2(space),
+                                                        charutil_lane_sum_avx2(punct), charutil_lane_sum_avx2(bracket), charutil_lane_sum_avx2(ascii)};
+        charutil_class_count_fold(classes, raw);
+    }
+    return i;
+}
+#endif
+
+#if defined(CHARUTIL_HAVE_NEON)
+static inline uint64_t charutil_lane_sum_neon(uint8x16_t acc)
+{
+    const uint64x2_t sum = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(acc)));
+    return vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1);
+}
+
+static inline size_t charutil_class_count_neon(const unsigned char *p, size_t n, uint64_t *classes)
+{
+    size_t i = 0;
+    while (n - i >= 16)
+    {
+        const size_t blocks = ((n - i) / 16 < 255) ? (n - i) / 16 : 255;
+        uint8x16_t binary = vdupq_n_u8(0), octal = binary, digit = binary, lower = binary, upper = binary, hex_alpha = binary;
+        uint8x16_t blank = binary, space = binary, punct = binary, bracket = binary, ascii = binary;
+        for (size_t end = i + 16 * blocks; i < end; i += 16)
+        {
+            const uint8x16_t c = vld1q_u8(p + i);
+            const uint8x16_t folded = vorrq_u8(c, vdupq_n_u8(1 << 5));
+            const uint8x16_t is_digit = charutil_range_neon(c, '0', '9');
+            const uint8x16_t is_blank = vceqq_u8(c, vdupq_n_u8(' '));
+            binary = vsubq_u8(binary, charutil_range_neon(c, '0', '1'));
+            octal = vsubq_u8(octal, charutil_range_neon(c, '0', '7'));
+            digit = vsubq_u8(digit, is_digit);
+            lower = vsubq_u8(lower, charutil_range_neon(c, 'a', 'z'));
+            upper = vsubq_u8(upper, charutil_range_neon(c, 'A', 'Z'));
+            hex_alpha = vsubq_u8(hex_alpha, charutil_range_neon(folded, 'a', 'f'));
+            blank = vsubq_u8(blank, is_blank);
+            space = vsubq_u8(space, vorrq_u8(is_blank, charutil_range_neon(c, '\t', '\r')));
+            punct = vsubq_u8(punct, vbicq_u8(charutil_range_neon(c, '!', '~'), vorrq_u8(is_digit, charutil_range_neon(folded, 'a', 'z'))));
+            bracket = vsubq_u8(bracket, vorrq_u8(charutil_range_neon(c, '(', ')'), vorrq_u8(vceqq_u8(folded, vdupq_n_u8('{')), vceqq_u8(folded, vdupq_n_u8('}')))));
+            ascii = vsubq_u8(ascii, vcltq_u8(c, vdupq_n_u8(0x80)));
+        }
+        const uint64_t raw[CHARUTIL_CLASS_RAW_COUNT] = {charutil_lane_sum_neon(binary), charutil_lane_sum_neon(octal), charutil_lane_sum_neon(digit), charutil_lane_sum_neon(lower),
+                                                        charutil_lane_sum_neon(upper), charutil_lane_sum_neon(hex_alpha), charutil_lane_sum_neon(blank), charutil_lane_sum_neon(space),
+                                                        charutil_lane_sum_neon(punct), charutil_lane_sum_neon(bracket), charutil_lane_sum_neon(ascii)};
+        charutil_class_count_fold(classes, raw);
+    }
+    return i;
+}
+#endif
+
+/// Block kernel stand-in when there is no SIMD kernel: consumes nothing
+static inline size_t charutil_class_count_none(const unsigned char *p, size_t n, uint64_t *classes)
+{
+    (void)p;
+    (void)n;
+    (void)classes;
+    return 0;
+}
+
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+static inline size_t charutil_dispatch_class_count(const unsigned char *p, size_t n, uint64_t *classes);
+#endif
+
+/// Runs the widest class count kernel over whole blocks, returns the number of bytes consumed
+static inline size_t charutil_class_count_blocks(const unsigned char *p, size_t n, uint64_t *classes)
+{
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+    return charutil_dispatch_class_count(p, n, classes);
+#elif defined(CHARUTIL_HAVE_AVX2)
+    return charutil_class_count_avx2(p, n, classes);
+#elif defined(CHARUTIL_HAVE_SSE2)
+    return charutil_class_count_sse2(p, n, classes);
+#elif defined(CHARUTIL_HAVE_NEON)
+    return charutil_class_count_neon(p, n, classes);
+#else
+    return charutil_class_count_none(p, n, classes);
+#endif
+}
+
+/// Adds the class counts of src to counts, and its byte values to histogram[256] unless histogram is NULL.
+/// Call it once per chunk to tally a stream.
+static inline void charutil_class_counts_add(const void *src, size_t n, charutil_class_counts_t *counts, uint64_t *histogram)
+{
+    const unsigned char *p = (const unsigned char *)src;
+    const size_t done = histogram ? 0 : charutil_class_count_blocks(p, n, counts->classes);
+    counts->total += n;
+    if (!histogram && n - done < 256)
+    {
+        // A block kernel tail or a short token: cheaper byte by byte than zeroing and folding 256 bins
+        for (size_t i = done; i < n; i++)
+        {
+            for (unsigned bits = (p[i] < 128) ? charutil_class_table[p[i]] : 0; bits; bits &= bits - 1)
+            {
+                counts->classes[charutil_ctz32(bits)]++;
+            }
+        }
+        return;
+    }
+    uint64_t bins[256] = {0};
+    charutil_byte_histogram_add(p + done, n - done, bins);
+    charutil_class_counts_from_histogram(bins, counts);
+    if (histogram)
+    {
+        for (int b = 0; b < 256; b++)
+        {
+            histogram[b] += bins[b];
+        }
+    }
+}
+
+/// Sets counts to the class counts of src, and histogram[256] (unless NULL) to its byte value counts
+static inline void charutil_class_counts(const void *src, size_t n, charutil_class_counts_t *counts, uint64_t *histogram)
+{
+    memset(counts, 0, sizeof(*counts));
+    if (histogram)
+    {
+        memset(histogram, 0, 256 * sizeof(histogram[0]));
+    }
+    charutil_class_counts_add(src, n, counts, histogram);
+}
+
+/* ==========================
+ * Bulk Case Conversion
+ * ========================== */
+// Buffer versions of TO_LOWER, TO_UPPER and TOGGLE_CASE. Only ASCII letters
+// change, every other byte (including >= 0x80) is copied through exactly as
+// the macros do. dst may equal src for in place conversion.
+// Without SIMD the 64 bit SWAR kernel is used: per byte range checks are done
+// on the low 7 bits so no carry crosses a byte, then masked by the ascii bit.
+
+typedef enum
+{
+    CHARUTIL_CASE_LOWER = 0,
+    CHARUTIL_CASE_UPPER = 1,
+    CHARUTIL_CASE_TOGGLE = 2
+} charutil_case_op_t;
+
+static inline unsigned char charutil_case_byte(unsigned char ch, charutil_case_op_t op)
+{
+    switch (op)
+    {
+        case CHARUTIL_CASE_LOWER:
+            return (unsigned char)TO_LOWER(ch);
+        case CHARUTIL_CASE_UPPER:
+            return (unsigned char)TO_UPPER(ch);
+        default:
+            return (unsigned char)TOGGLE_CASE(ch);
+    }
+}
+
+static inline void charutil_case_buf_scalar(char *dst, const char *src, size_t n, charutil_case_op_t op)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        dst[i] = (char)charutil_case_byte((unsigned char)src[i], op);
+    }
+}
+
+/// Applies op to the 8 bytes packed in x
+static inline uint64_t charutil_case_swar(uint64_t x, charutil_case_op_t op)
+{
+    const uint64_t ones = 0x0101010101010101ull;
+    const uint64_t high = 0x80 * ones;
+    const uint64_t heptets = x & (0x7F * ones);
+    const uint64_t ascii = ~x & high;
+    const uint64_t upper = ascii & (heptets + (0x80 - 'A') * ones) & ~(heptets + (0x7F - 'Z') * ones);
+    const uint64_t lower = ascii & (heptets + (0x80 - 'a') * ones) & ~(heptets + (0x7F - 'z') * ones);
+    switch (op)
+    {
+        case CHARUTIL_CASE_LOWER:
+            return x | ((upper & high) >> 2);
+        case CHARUTIL_CASE_UPPER:
+            return x & ~((lower & high) >> 2);
+        default:
+            return x ^ (((upper | lower) & high) >> 2);
+    }
+}
+
+static inline void charutil_case_buf_swar(char *dst, const char *src, size_t n, charutil_case_op_t op)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        uint64_t x;
+        memcpy(&x, src + i, 8);
+        x = charutil_case_swar(x, op);
+        memcpy(dst + i, &x, 8);
+    }
+    charutil_case_buf_scalar(dst + i, src + i, n - i, op);
+}
+
+#if defined(CHARUTIL_HAVE_SSE2)
+static inline __m128i charutil_case_sse2(__m128i c, charutil_case_op_t op)
+{
+    const __m128i bit5 = _mm_set1_epi8(1 << 5);
+    switch (op)
+    {
+        case CHARUTIL_CASE_LOWER:
+            return _mm_or_si128(c, _mm_and_si128(charutil_range_sse2(c, 'A', 'Z'), bit5));
+        case CHARUTIL_CASE_UPPER:
+            return _mm_andnot_si128(_mm_and_si128(charutil_range_sse2(c, 'a', 'z'), bit5), c);
+        default:
+            return _mm_xor_si128(c, _mm_and_si128(charutil_range_sse2(_mm_or_si128(c, bit5), 'a', 'z'), bit5));
+    }
+}
+
+static inline void charutil_case_buf_sse2(char *dst, const char *src, size_t n, charutil_case_op_t op)
+{
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        _mm_storeu_si128((__m128i *)(dst + i), charutil_case_sse2(_mm_loadu_si128((const __m128i *)(src + i)), op));
+    }
+    charutil_case_buf_scalar(dst + i, src + i, n - i, op);
+}
+#endif
+
+#if defined(CHARUTIL_HAVE_AVX2)
+static inline CHARUTIL_TARGET_AVX2 __m256i charutil_case_avx2(__m256i c, charutil_case_op_t op)
+{
+    const __m256i bit5 = _mm256_set1_epi8(1 << 5);
+    switch (op)
+    {
+        case CHARUTIL_CASE_LOWER:
+            return _mm256_or_si256(c, _mm256_and_si256(charutil_range_avx2(c, 'A', 'Z'), bit5));
+        case CHARUTIL_CASE_UPPER:
+            return _mm256_andnot_si256(_mm256_and_si256(charutil_range_avx2(c, 'a', 'z'), bit5), c);
+        default:
+            return _mm256_xor_si256(c, _mm256_and_si256(charutil_range_avx2(_mm256_or_si256(c, bit5), 'a', 'z'), bit5));
+    }
+}
+
+static inline CHARUTIL_TARGET_AVX2 void charutil_case_buf_avx2(char *dst, const char *src, size_t n, charutil_case_op_t op)
+{
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        _mm256_storeu_si256((__m256i *)(dst + i), charutil_case_avx2(_mm256_loadu_si256((const __m256i *)(src + i)), op));
+    }
+    charutil_case_buf_scalar(dst + i, src + i, n - i, op);
+}
+#endif
+
+#if defined(CHARUTIL_HAVE_NEON)
+static inline uint8x16_t charutil_case_neon(uint8x16_t c, charutil_case_op_t op)
+{
+    const uint8x16_t bit5 = vdupq_n_u8(1 << 5);
+    switch (op)
+    {
+        case CHARUTIL_CASE_LOWER:
+            return vorrq_u8(c, vandq_u8(charutil_range_neon(c, 'A', 'Z'), bit5));
+        case CHARUTIL_CASE_UPPER:
+            return vbicq_u8(c, vandq_u8(charutil_range_neon(c, 'a', 'z'), bit5));
+        default:
+            return veorq_u8(c, vandq_u8(charutil_range_neon(vorrq_u8(c, bit5), 'a', 'z'), bit5));
+    }
+}
+
+static inline void charutil_case_buf_neon(char *dst, const char *src, size_t n, charutil_case_op_t op)
+{
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        vst1q_u8((uint8_t *)dst + i, charutil_case_neon(vld1q_u8((const uint8_t *)src + i), op));
+    }
+    charutil_case_buf_scalar(dst + i, src + i, n - i, op);
+}
+#endif
+
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+static inline void charutil_dispatch_case_buf(char *dst, const char *src, size_t n, charutil_case_op_t op);
+#endif
+
+static inline void charutil_case_buf(char *dst, const char *src, size_t n, charutil_case_op_t op)
+{
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+    charutil_dispatch_case_buf(dst, src, n, op);
+#elif defined(CHARUTIL_HAVE_AVX2)
+    charutil_case_buf_avx2(dst, src, n, op);
+#elif defined(CHARUTIL_HAVE_SSE2)
+    charutil_case_buf_sse2(dst, src, n, op);
+#elif defined(CHARUTIL_HAVE_NEON)
+    charutil_case_buf_neon(dst, src, n, op);
+#else
+    charutil_case_buf_swar(dst, src, n, op);
+#endif
+}
+
+static inline void charutil_to_lower_buf(char *dst, const char *src, size_t n)
+{
+    charutil_case_buf(dst, src, n, CHARUTIL_CASE_LOWER);
+}
+
+static inline void charutil_to_upper_buf(char *dst, const char *src, size_t n)
+{
+    charutil_case_buf(dst, src, n, CHARUTIL_CASE_UPPER);
+}
+
+static inline void charutil_toggle_case_buf(char *dst, const char *src, size_t n)
+{
+    charutil_case_buf(dst, src, n, CHARUTIL_CASE_TOGGLE);
+}
+
+static inline void charutil_to_lower_inplace(char *buf, size_t n)
+{
+    charutil_case_buf(buf, buf, n, CHARUTIL_CASE_LOWER);
+}
+
+static inline void charutil_to_upper_inplace(char *buf, size_t n)
+{
+    charutil_case_buf(buf, buf, n, CHARUTIL_CASE_UPPER);
+}
+
+static inline void charutil_toggle_case_inplace(char *buf, size_t n)
+{
+    charutil_case_buf(buf, buf, n, CHARUTIL_CASE_TOGGLE);
+}
+
+/// ASCII case insensitive compare of n bytes. Returns <0, 0 or >0 comparing TO_LOWER() of each byte as unsigned char
+static inline int charutil_casecmp(const char *a, const char *b, size_t n)
+{
+    size_t i = 0;
+#if defined(CHARUTIL_HAVE_SSE2)
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i la = charutil_case_sse2(_mm_loadu_si128((const __m128i *)(a + i)), CHARUTIL_CASE_LOWER);
+        const __m128i lb = charutil_case_sse2(_mm_loadu_si128((const __m128i *)(b + i)), CHARUTIL_CASE_LOWER);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(la, lb)) != 0xFFFF)
+        {
+            break;
+        }
+    }
+#else
+    for (; i + 8 <= n; i += 8)
+    {
+        uint64_t wa;
+        uint64_t wb;
+        memcpy(&wa, a + i, 8);
+        memcpy(&wb, b + i, 8);
+        if (charutil_case_swar(wa, CHARUTIL_CASE_LOWER) != charutil_case_swar(wb, CHARUTIL_CASE_LOWER))
+        {
+            break;
+        }
+    }
+#endif
+    for (; i < n; i++)
+    {
+        const int ca = TO_LOWER((unsigned char)a[i]);
+        const int cb = TO_LOWER((unsigned char)b[i]);
+        if (ca != cb)
+        {
+            return ca - cb;
+        }
+    }
+    return 0;
+}
+
+/// ASCII case insensitive 64 bit hash: equal under charutil_casecmp() implies equal hash.
+/// Folds 8 lowercased bytes per step so the value depends on byte order and is not stable across endianness.
+static inline uint64_t charutil_casehash(const char *p, size_t n)
+{
+    const uint64_t k = 0x9E3779B97F4A7C15ull;
+    uint64_t h = n * k;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        uint64_t w;
+        memcpy(&w, p + i, 8);
+        h = (h ^ charutil_case_swar(w, CHARUTIL_CASE_LOWER)) * k;
+        h ^= h >> 32;
+    }
+    if (i < n)
+    {
+        uint64_t w = 0;
+        memcpy(&w, p + i, n - i);
+        h = (h ^ charutil_case_swar(w, CHARUTIL_CASE_LOWER)) * k;
+        h ^= h >> 32;
+    }
+    h *= k;
+    return h ^ (h >> 29);
+}
+
+/* ==========================
+ * Natural Sort
+ * ========================== */
+// Orders strings so that runs of digits compare by value: "file9" < "file10"
+// and "1.2.9" < "1.2.10". Other bytes compare as unsigned char, folded with
+// TO_LOWER under CHARUTIL_NATURAL_FOLD_CASE. Where a digit run meets another
+// byte the digit's own byte value is used. Digit runs of equal value are
+// ordered by their count of leading zeros, fewest first, so "1" < "01" and
+// the order stays total.
+//
+// charutil_natural_sortkey() encodes a string once into a binary key whose
+// memcmp() order is charutil_natural_cmp() order. A sort then costs one key
+// per string plus plain memcmp() calls instead of re-parsing digit runs on
+// every comparison. The key ends in a 0x00 byte that no earlier byte can
+// match at the same position, so memcmp() over the shorter of two key
+// lengths already decides, and only equal keys compare equal. Layout:
+//   other byte b  b + 1 for b <= 0xFD, else 0xFF 0x01 (0xFE) or 0xFF 0x02 (0xFF)
+//   digit run     0x31 (between '/' + 1 and ':' + 1), significant digit count,
+//                 the significant digits two per byte, leading zero count
+//   counts        one byte below 255, else 0xFF and 8 bytes big endian
+//   end           0x00
+
+#define CHARUTIL_NATURAL_SORTKEY_MAX(n) ((n) * 4 + 1) ///< A lone digit takes 4 bytes, plus the end byte
+
+typedef enum
+{
+    CHARUTIL_NATURAL_DEFAULT = 0,  ///< Non digit bytes compare as unsigned char
+    CHARUTIL_NATURAL_FOLD_CASE = 1 ///< Non digit bytes compare as TO_LOWER()
+} charutil_natural_flags_t;
+
+/// Length of the digit run at p: *zeros leading '0' characters, then *sig significant digits
+static inline void charutil_natural_run(const char *p, size_t n, size_t *zeros, size_t *sig)
+{
+    size_t z = 0;
+    while (z < n && p[z] == '0')
+    {
+        z++;
+    }
+    size_t s = z;
+    while (s < n && IS_DIGIT((unsigned char)p[s]))
+    {
+        s++;
+    }
+    *zeros = z;
+    *sig = s - z;
+}
+
+/// Natural order compare of a[0..an) and b[0..bn). Returns <0, 0 or >0.
+static inline int charutil_natural_cmp(const char *a, size_t an, const char *b, size_t bn, unsigned flags)
+{
+    size_t i = 0;
+    size_t j = 0;
+    while (i < an && j < bn)
+    {
+        const unsigned char ca = (unsigned char)a[i];
+        const unsigned char cb = (unsigned char)b[j];
+        if (IS_DIGIT(ca) && IS_DIGIT(cb))
+        {
+            size_t za, sa, zb, sb;
+            charutil_natural_run(a + i, an - i, &za, &sa);
+            charutil_natural_run(b + j, bn - j, &zb, &sb);
+            if (sa != sb)
+            {
+                return sa < sb ? -1 : 1;
+            }
+            // Equal length significant digits compare by value as text
+            const int order = memcmp(a + i + za, b + j + zb, sa);
+            if (order)
+            {
+                return order;
+            }
+            if (za != zb)
+            {
+                return za < zb ? -1 : 1;
+            }
+            i += za + sa;
+            j += zb + sb;
+            continue;
+        }
+        const int fa = (flags & CHARUTIL_NATURAL_FOLD_CASE) ? TO_LOWER(ca) : ca;
+        const int fb = (flags & CHARUTIL_NATURAL_FOLD_CASE) ? TO_LOWER(cb) : cb;
+        if (fa != fb)
+        {
+            return fa - fb;
+        }
+        i++;
+        j++;
+    }
+    return (i < an) - (j < bn);
+}
+
+/// Appends count to a natural sort key at *out, clipped to cap
+static inline void charutil_natural_put_count(unsigned char *dst, size_t cap, size_t *out, uint64_t count)
+{
+    size_t o = *out;
+    if (count < 0xFF)
+    {
+        if (o < cap)
+        {
+            dst[o] = (unsigned char)count;
+        }
+        *out = o + 1;
+        return;
+    }
+    if (o < cap)
+    {
+        dst[o] = 0xFF;
+    }
+    for (int shift = 56; shift >= 0; shift -= 8)
+    {
+        o++;
+        if (o < cap)
+        {
+            dst[o] = (unsigned char)(count >> shift);
+        }
+    }
+    *out = o + 1;
+}
+
+/// Writes the natural sort key of src[0..n) into dst, at most dst_cap bytes (CHARUTIL_NATURAL_SORTKEY_MAX(n) always fits).
+/// Returns the full key length, so (NULL, 0) sizes it. Compare two keys with memcmp() over the shorter length.
+static inline size_t charutil_natural_sortkey(void *dst, size_t dst_cap, const char *src, size_t n, unsigned flags)
+{
+    unsigned char *d = (unsigned char *)dst;
+    size_t out = 0;
+    size_t i = 0;
+    while (i < n)
+    {
+        const unsigned char ch = (unsigned char)src[i];
+        if (!IS_DIGIT(ch))
+        {
+            const unsigned char folded = (unsigned char)((flags & CHARUTIL_NATURAL_FOLD_CASE) ? TO_LOWER(ch) : ch);
+            if (folded < 0xFE)
+            {
+                if (out < dst_cap)
+                {
+                    d[out] = (unsigned char)(folded + 1);
+                }
+                out++;
+            }
+            else
+            {
+                if (out < dst_cap)
+                {
+                    d[out] = 0xFF;
+                }
+                if (out + 1 < dst_cap)
+                {
+                    d[out + 1] = (unsigned char)(folded - 0xFD);
+                }
+                out += 2;
+            }
+            i++;
+            continue;
+        }
+        size_t zeros, sig;
+        charutil_natural_run(src + i, n - i, &zeros, &sig);
+        if (out < dst_cap)
+        {
+            d[out] = '0' + 1;
+        }
+        out++;
+        charutil_natural_put_count(d, dst_cap, &out, sig);
+        const char *digits = src + i + zeros;
+        for (size_t k = 0; k < sig; k += 2)
+        {
+            const unsigned hi = (unsigned)ASCII_TO_DIGIT(digits[k]);
+            const unsigned lo = (k + 1 < sig) ? (unsigned)ASCII_TO_DIGIT(digits[k + 1]) : 0;
+            if (out < dst_cap)
+            {
+                d[out] = (unsigned char)(hi << 4 | lo);
+            }
+            out++;
+        }
+        charutil_natural_put_count(d, dst_cap, &out, zeros);
+        i += zeros + sig;
+    }
+    if (out < dst_cap)
+    {
+        d[out] = 0;
+    }
+    return out + 1;
+}
+
+/* ==========================
+ * Bulk Hex Encode/Decode
+ * ========================== */
+// Buffer versions of NIBBLE_TO_*_HEX and HEX_TO_INT. The scalar path is built
+// from those macros, the SIMD kernels only handle whole blocks and hand the
+// tail (or a block containing a bad character) back to the SWAR path, which
+// in turn leaves anything short of 8 characters to the scalar loop.
+
+typedef enum
+{
+    CHARUTIL_HEX_LOWERCASE = 0,
+    CHARUTIL_HEX_UPPERCASE = 1
+} charutil_hex_case_t;
+
+/// Writes 2*n hex characters (no NUL terminator) into dst. Returns 2*n.
+static inline size_t charutil_hex_encode_scalar(char *dst, const void *src, size_t n, charutil_hex_case_t hex_case)
+{
+    const unsigned char *s = (const unsigned char *)src;
+    if (hex_case == CHARUTIL_HEX_UPPERCASE)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            dst[2 * i] = (char)FAST_NIBBLE_TO_UPPERCASE_HEX(HIGH_NIBBLE(s[i]));
+            dst[2 * i + 1] = (char)FAST_NIBBLE_TO_UPPERCASE_HEX(LOW_NIBBLE(s[i]));
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            dst[2 * i] = (char)FAST_NIBBLE_TO_LOWERCASE_HEX(HIGH_NIBBLE(s[i]));
+            dst[2 * i + 1] = (char)FAST_NIBBLE_TO_LOWERCASE_HEX(LOW_NIBBLE(s[i]));
+        }
+    }
+    return 2 * n;
+}
+
+/// Decodes n hex characters into n/2 bytes and returns the number of bytes written.
+/// err_pos (optional) receives the index of the first invalid character, or n if the whole input decoded cleanly.
+/// An odd length input whose characters are all hex digits stops at its dangling last digit, so err_pos == n - 1
+/// with a hex digit at src[n - 1] means truncated input, and any other err_pos < n points at a non hex character.
+static inline size_t charutil_hex_decode_scalar(void *dst, const char *src, size_t n, size_t *err_pos)
+{
+    unsigned char *d = (unsigned char *)dst;
+    size_t i = 0;
+    for (; i + 1 < n; i += 2)
+    {
+        const int hi = HEX_TO_INT(src[i], -1);
+        const int lo = HEX_TO_INT(src[i + 1], -1);
+        if ((hi | lo) < 0)
+        {
+            if (err_pos)
+            {
+                *err_pos = i + (hi >= 0);
+            }
+            return i / 2;
+        }
+        d[i / 2] = (unsigned char)((hi << 4) | lo);
+    }
+    if (err_pos)
+    {
+        *err_pos = i;
+    }
+    return i / 2;
+}
+
+// Fused validate and decode for fixed width hex fields (IDs, MAC addresses,
+// UUIDs). Up to 8 characters are checked and converted at once with SWAR
+// range tests instead of an IS_HEX_DIGIT() then HEX_TO_INT() per character.
+// Letters are case folded with the FAST_TO_LOWER() bit 5 trick. Rather than
+// branching per call, each function ORs a non-zero mask into *err when any
+// character is not a hex digit, so a run of fields is checked once at the end:
+//
+//     uint64_t err = 0;
+//     const uint32_t time_low = charutil_hex_decode_u32(uuid, &err);
+//     const uint8_t node0 = charutil_hex_pair_to_byte(uuid + 24, &err);
+//     ...
+//     if (err) { /* not a UUID */ }
+
+/// Nibble value of each of the 8 characters in x, first character in the low byte.
+/// Bytes that are not hex digits set their high bit in *err.
+static inline uint64_t charutil_hex_swar_nibbles(uint64_t x, uint64_t *err)
+{
+    const uint64_t ones = 0x0101010101010101ull;
+    const uint64_t high = 0x80 * ones;
+    const uint64_t heptets = x & (0x7F * ones);
+    const uint64_t folded = heptets | (0x20 * ones);
+    const uint64_t digit = (heptets + (0x80 - '0') * ones) & ~(heptets + (0x7F - '9') * ones);
+    const uint64_t alpha = (folded + (0x80 - 'a') * ones) & ~(folded + (0x7F - 'f') * ones);
+    *err |= (~(digit | alpha) | x) & high;
+    return (x & (0x0F * ones)) + ((alpha & high) >> 7) * 9;
+}
+
+/// Joins the 8 nibbles of charutil_hex_swar_nibbles() into 4 bytes, first byte in the low bits
+static inline uint32_t charutil_hex_swar_join(uint64_t nibbles)
+{
+    uint64_t x = ((nibbles << 4) | (nibbles >> 8)) & 0x00FF00FF00FF00FFull;
+    x = (x | (x >> 8)) & 0x0000FFFF0000FFFFull;
+    return (uint32_t)(x | (x >> 16));
+}
+
+/// The 8 characters at src as a word, first character in the low byte
+static inline uint64_t charutil_hex_swar_load(const char *src)
+{
+    uint64_t x;
+#if defined(CHARUTIL_LITTLE_ENDIAN)
+    memcpy(&x, src, 8);
+#else
+    x = 0;
+    for (int k = 0; k < 8; k++)
+    {
+        x |= (uint64_t)(unsigned char)src[k] << (8 * k);
+    }
+#endif
+    return x;
+}
+
+/// Decodes the 2 hex characters at src (either case) into a byte. *err is ORed with a non-zero mask if either is not a hex digit.
+static inline uint8_t charutil_hex_pair_to_byte(const char *src, uint64_t *err)
+{
+    // Unused lanes are filled with '0'
+    const uint64_t x = 0x3030303030300000ull | (uint64_t)(unsigned char)src[0] | ((uint64_t)(unsigned char)src[1] << 8);
+    return (uint8_t)charutil_hex_swar_join(charutil_hex_swar_nibbles(x, err));
+}
+
+/// Decodes the 8 hex characters at src (either case), most significant first. *err is ORed with a non-zero mask on a bad character.
+static inline uint32_t charutil_hex_decode_u32(const char *src, uint64_t *err)
+{
+    const uint32_t bytes = charutil_hex_swar_join(charutil_hex_swar_nibbles(charutil_hex_swar_load(src), err));
+    return (bytes << 24) | ((bytes & 0xFF00) << 8) | ((bytes >> 8) & 0xFF00) | (bytes >> 24);
+}
+
+/// Decodes the 16 hex characters at src (either case), most significant first. *err is ORed with a non-zero mask on a bad character.
+static inline uint64_t charutil_hex_decode_u64(const char *src, uint64_t *err)
+{
+    return ((uint64_t)charutil_hex_decode_u32(src, err) << 32) | charutil_hex_decode_u32(src + 8, err);
+}
+
+/// charutil_hex_decode_scalar() taking 8 characters per step on little endian targets
+static inline size_t charutil_hex_decode_swar(void *dst, const char *src, size_t n, size_t *err_pos)
+{
+    unsigned char *d = (unsigned char *)dst;
+    size_t i = 0;
+#if defined(CHARUTIL_LITTLE_ENDIAN)
+    for (; i + 8 <= n; i += 8)
+    {
+        uint64_t err = 0;
+        const uint32_t bytes = charutil_hex_swar_join(charutil_hex_swar_nibbles(charutil_hex_swar_load(src + i), &err));
+        if (err)
+        {
+            break;
+        }
+        memcpy(d + i / 2, &bytes, 4);
+    }
+#endif
+    const size_t written = charutil_hex_decode_scalar(d + i / 2, src + i, n - i, err_pos);
+    if (err_pos)
+    {
+        *err_pos += i;
+    }
+    return i / 2 + written;
+}
+
+#if defined(CHARUTIL_HAVE_SSE2)
+static inline __m128i charutil_hex_ascii_sse2(__m128i nibbles, __m128i alpha_offset)
+{
+    const __m128i is_alpha = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+    return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), _mm_and_si128(is_alpha, alpha_offset));
+}
+
+/// Converts 16 hex characters to nibble values, clearing bits in *valid for bad characters.
+static inline __m128i charutil_hex_nibbles_sse2(__m128i c, int *valid)
+{
+    const __m128i digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    const __m128i alpha = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(1 << 5)), _mm_set1_epi8('a'));
+    const __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    const __m128i is_alpha = _mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8(5)), alpha);
+    *valid &= _mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha));
+    return _mm_or_si128(_mm_and_si128(is_digit, digit), _mm_and_si128(is_alpha, _mm_add_epi8(alpha, _mm_set1_epi8(10))));
+}
+
+/// Joins nibble pairs into bytes, leaving each result in the low byte of a 16-bit lane.
+static inline __m128i charutil_hex_join_sse2(__m128i nibbles)
+{
+    const __m128i hi = _mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00FF)), 4);
+    return _mm_or_si128(hi, _mm_srli_epi16(nibbles, 8));
+}
+
+static inline size_t charutil_hex_encode_sse2(char *dst, const void *src, size_t n, charutil_hex_case_t hex_case)
+{
+    const unsigned char *s = (const unsigned char *)src;
+    const __m128i alpha_offset = _mm_set1_epi8(hex_case == CHARUTIL_HEX_UPPERCASE ? 'A' - '0' - 10 : 'a' - '0' - 10);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        const __m128i hi = charutil_hex_ascii_sse2(_mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F)), alpha_offset);
+        const __m128i lo = charutil_hex_ascii_sse2(_mm_and_si128(v, _mm_set1_epi8(0x0F)), alpha_offset);
+        _mm_storeu_si128((__m128i *)(dst + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i *)(dst + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    charutil_hex_encode_scalar(dst + 2 * i, s + i, n - i, hex_case);
+    return 2 * n;
+}
+
+static inline size_t charutil_hex_decode_sse2(void *dst, const char *src, size_t n, size_t *err_pos)
+{
+    unsigned char *d = (unsigned char *)dst;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        int valid = 0xFFFF;
+        const __m128i a = charutil_hex_nibbles_sse2(_mm_loadu_si128((const __m128i *)(src + i)), &valid);
+        const __m128i b = charutil_hex_nibbles_sse2(_mm_loadu_si128((const __m128i *)(src + i + 16)), &valid);
+        if (valid != 0xFFFF)
+        {
+            break;
+        }
+        _mm_storeu_si128((__m128i *)(d + i / 2), _mm_packus_epi16(charutil_hex_join_sse2(a), charutil_hex_join_sse2(b)));
+    }
+    const size_t written = charutil_hex_decode_swar(d + i / 2, src + i, n - i, err_pos);
+    if (err_pos)
+    {
+        *err_pos += i;
+    }
+    return i / 2 + written;
+}
+#endif
+
+#if defined(CHARUTIL_HAVE_AVX2)
+static inline CHARUTIL_TARGET_AVX2 __m256i charutil_hex_ascii_avx2(__m256i nibbles, __m256i alpha_offset)
+{
+    const __m256i is_alpha = _mm256_cmpgt_epi8(nibbles, _mm256_set1_epi8(9));
+    return _mm256_add_epi8(_mm256_add_epi8(nibbles, _mm256_set1_epi8('0')), _mm256_and_si256(is_alpha, alpha_offset));
+}
+
+static inline CHARUTIL_TARGET_AVX2 __m256i charutil_hex_nibbles_avx2(__m256i c, unsigned *valid)
+{
+    const __m256i digit = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+    const __m256i alpha = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(1 << 5)), _mm256_set1_epi8('a'));
+    const __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+    const __m256i is_alpha = _mm256_cmpeq_epi8(_mm256_min_epu8(alpha, _mm256_set1_epi8(5)), alpha);
+    *valid &= (unsigned)_mm256_movemask_epi8(_mm256_or_si256(is_digit, is_alpha));
+    return _mm256_or_si256(_mm256_and_si256(is_digit, digit), _mm256_and_si256(is_alpha, _mm256_add_epi8(alpha, _mm256_set1_epi8(10))));
+}
+
+static inline CHARUTIL_TARGET_AVX2 __m256i charutil_hex_join_avx2(__m256i nibbles)
+{
+    const __m256i hi = _mm256_slli_epi16(_mm256_and_si256(nibbles, _mm256_set1_epi16(0x00FF)), 4);
+    return _mm256_or_si256(hi, _mm256_srli_epi16(nibbles, 8));
+}
+
+static inline CHARUTIL_TARGET_AVX2 size_t charutil_hex_encode_avx2(char *dst, const void *src, size_t n, charutil_hex_case_t hex_case)
+{
+    const unsigned char *s = (const unsigned char *)src;
+    const __m256i alpha_offset = _mm256_set1_epi8(hex_case == CHARUTIL_HEX_UPPERCASE ? 'A' - '0' - 10 : 'a' - '0' - 10);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        const __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+        const __m256i hi = charutil_hex_ascii_avx2(_mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F)), alpha_offset);
+        const __m256i lo = charutil_hex_ascii_avx2(_mm256_and_si256(v, _mm256_set1_epi8(0x0F)), alpha_offset);
+        const __m256i first = _mm256_unpacklo_epi8(hi, lo);  // bytes 0-7 | 16-23
+        const __m256i second = _mm256_unpackhi_epi8(hi, lo); // bytes 8-15 | 24-31
+        _mm256_storeu_si256((__m256i *)(dst + 2 * i), _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256((__m256i *)(dst + 2 * i + 32), _mm256_permute2x128_si256(first, second, 0x31));
+    }
+    charutil_hex_encode_scalar(dst + 2 * i, s + i, n - i, hex_case);
+    return 2 * n;
+}
+
+static inline CHARUTIL_TARGET_AVX2 size_t charutil_hex_decode_avx2(void *dst, const char *src, size_t n, size_t *err_pos)
+{
+    unsigned char *d = (unsigned char *)dst;
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64)
+    {
+        unsigned valid = 0xFFFFFFFFu;
+        const __m256i a = charutil_hex_nibbles_avx2(_mm256_loadu_si256((const __m256i *)(src + i)), &valid);
+        const __m256i b = charutil_hex_nibbles_avx2(_mm256_loadu_si256((const __m256i *)(src + i + 32)), &valid);
+        if (valid != 0xFFFFFFFFu)
+        {
+            break;
+        }
+        const __m256i packed = _mm256_packus_epi16(charutil_hex_join_avx2(a), charutil_hex_join_avx2(b));
+        _mm256_storeu_si256((__m256i *)(d + i / 2), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    const size_t written = charutil_hex_decode_swar(d + i / 2, src + i, n - i, err_pos);
+    if (err_pos)
+    {
+        *err_pos += i;
+    }
+    return i / 2 + written;
+}
+#endif
+
+#if defined(CHARUTIL_HAVE_NEON)
+static inline uint8x16_t charutil_hex_ascii_neon(uint8x16_t nibbles, uint8x16_t alpha_offset)
+{
+    const uint8x16_t is_alpha = vcgtq_u8(nibbles, vdupq_n_u8(9));
+    return vaddq_u8(vaddq_u8(nibbles, vdupq_n_u8('0')), vandq_u8(is_alpha, alpha_offset));
+}
+
+static inline uint8x16_t charutil_hex_nibbles_neon(uint8x16_t c, uint8x16_t *valid)
+{
+    const uint8x16_t digit = vsubq_u8(c, vdupq_n_u8('0'));
+    const uint8x16_t alpha = vsubq_u8(vorrq_u8(c, vdupq_n_u8(1 << 5)), vdupq_n_u8('a'));
+    const uint8x16_t is_digit = vcleq_u8(digit, vdupq_n_u8(9));
+    const uint8x16_t is_alpha = vcleq_u8(alpha, vdupq_n_u8(5));
+    *valid = vandq_u8(*valid, vorrq_u8(is_digit, is_alpha));
+    return vbslq_u8(is_digit, digit, vaddq_u8(alpha, vdupq_n_u8(10)));
+}
+
+static inline size_t charutil_hex_encode_neon(char *dst, const void *src, size_t n, charutil_hex_case_t hex_case)
+{
+    const unsigned char *s = (const unsigned char *)src;
+    const uint8x16_t alpha_offset = vdupq_n_u8(hex_case == CHARUTIL_HEX_UPPERCASE ? 'A' - '0' - 10 : 'a' - '0' - 10);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const uint8x16_t v = vld1q_u8(s + i);
+        uint8x16x2_t out;
+        out.val[0] = charutil_hex_ascii_neon(vshrq_n_u8(v, 4), alpha_offset);
+        out.val[1] = charutil_hex_ascii_neon(vandq_u8(v, vdupq_n_u8(0x0F)), alpha_offset);
+        vst2q_u8((uint8_t *)dst + 2 * i, out);
+    }
+    charutil_hex_encode_scalar(dst + 2 * i, s + i, n - i, hex_case);
+    return 2 * n;
+}
+
+static inline size_t charutil_hex_decode_neon(void *dst, const char *src, size_t n, size_t *err_pos)
+{
+    unsigned char *d = (unsigned char *)dst;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        const uint8x16x2_t c = vld2q_u8((const uint8_t *)src + i);
+        uint8x16_t valid = vdupq_n_u8(0xFF);
+        const uint8x16_t hi = charutil_hex_nibbles_neon(c.val[0], &valid);
+        const uint8x16_t lo = charutil_hex_nibbles_neon(c.val[1], &valid);
+        const uint64x2_t valid64 = vreinterpretq_u64_u8(valid);
+        if ((vgetq_lane_u64(valid64, 0) & vgetq_lane_u64(valid64, 1)) != UINT64_MAX)
+        {
+            break;
+        }
+        vst1q_u8(d + i / 2, vorrq_u8(vshlq_n_u8(hi, 4), lo));
+    }
+    const size_t written = charutil_hex_decode_swar(d + i / 2, src + i, n - i, err_pos);
+    if (err_pos)
+    {
+        *err_pos += i;
+    }
+    return i / 2 + written;
+}
+#endif
+
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+static inline size_t charutil_dispatch_hex_encode(char *dst, const void *src, size_t n, charutil_hex_case_t hex_case);
+static inline size_t charutil_dispatch_hex_decode(void *dst, const char *src, size_t n, size_t *err_pos);
+#endif
+
+/// Hex encode n bytes into 2*n characters (no NUL terminator). Returns 2*n.
+static inline size_t charutil_hex_encode(char *dst, const void *src, size_t n, charutil_hex_case_t hex_case)
+{
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+    return charutil_dispatch_hex_encode(dst, src, n, hex_case);
+#elif defined(CHARUTIL_HAVE_AVX2)
+    return charutil_hex_encode_avx2(dst, src, n, hex_case);
+#elif defined(CHARUTIL_HAVE_SSE2)
+    return charutil_hex_encode_sse2(dst, src, n, hex_case);
+#elif defined(CHARUTIL_HAVE_NEON)
+    return charutil_hex_encode_neon(dst, src, n, hex_case);
+#else
+    return charutil_hex_encode_scalar(dst, src, n, hex_case);
+#endif
+}
+
+/// Hex decode n characters (either case) into n/2 bytes. Returns bytes written.
+/// err_pos (optional) receives the index of the first invalid character, or n on success. A dangling last digit of an
+/// odd length input is reported as err_pos == n - 1 with IS_HEX_DIGIT(src[n - 1]) true, see charutil_hex_decode_scalar().
+static inline size_t charutil_hex_decode(void *dst, const char *src, size_t n, size_t *err_pos)
+{
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+    return charutil_dispatch_hex_decode(dst, src, n, err_pos);
+#elif defined(CHARUTIL_HAVE_AVX2)
+    return charutil_hex_decode_avx2(dst, src, n, err_pos);
+#elif defined(CHARUTIL_HAVE_SSE2)
+    return charutil_hex_decode_sse2(dst, src, n, err_pos);
+#elif defined(CHARUTIL_HAVE_NEON)
+    return charutil_hex_decode_neon(dst, src, n, err_pos);
+#else
+    return charutil_hex_decode_swar(dst, src, n, err_pos);
+#endif
+}
+
+/* ==========================
+ * Base64/Base32/Ascii85
+ * ========================== */
+// Binary to text codecs next to the hex ones. Digits are mapped with the
+// same compare and add arithmetic as NIBBLE_TO_*_HEX and HEX_TO_INT instead
+// of lookup tables. Base64 has AVX2 and NEON kernels for whole blocks, base32
+// and ascii85 are scalar only.
+// Decoders are strict (no whitespace, no "<~ ~>" delimiters) and accept input
+// with or without '=' padding, but padding that is present must be complete.
+// Each decoder keeps its state in a struct, so input can be fed in chunks of
+// any size. Every update call writes at most CHARUTIL_*_DECODED_MAX(n) bytes.
+
+#define CHARUTIL_BASE64_ENCODED_MAX(n) (((n) + 2) / 3 * 4)  ///< Exact when padded
+#define CHARUTIL_BASE64_DECODED_MAX(n) (((n) + 3) / 4 * 3)  ///< Also bounds one streaming update of n characters
+#define CHARUTIL_BASE32_ENCODED_MAX(n) (((n) + 4) / 5 * 8)  ///< Exact when padded
+#define CHARUTIL_BASE32_DECODED_MAX(n) (((n) + 7) / 8 * 5)  ///< Also bounds one streaming update of n characters
+#define CHARUTIL_ASCII85_ENCODED_MAX(n) (((n) + 3) / 4 * 5) ///< All zero groups shrink to a single 'z'
+#define CHARUTIL_ASCII85_DECODED_MAX(n) ((n) * 4)           ///< Each 'z' expands to 4 bytes
+
+typedef enum
+{
+    CHARUTIL_BASE64_STANDARD = 0, ///< '+' and '/' for 62 and 63, padded with '='
+    CHARUTIL_BASE64_URL = 1,      ///< '-' and '_' for 62 and 63 (RFC 4648 section 5)
+    CHARUTIL_BASE64_NOPAD = 2     ///< Encoder leaves out the '=' padding
+} charutil_base64_flags_t;
+
+/// Base64 digit for v in 0..63. c62 and c63 are the last two characters of the alphabet.
+static inline char charutil_base64_digit(int v, char c62, char c63)
+{
+    return (char)(v + 'A' + (v > 25) * 6 - (v > 51) * 75 + (v == 62) * (c62 - 58) + (v == 63) * (c63 - 59));
+}
+
+/// Value of a base64 character, or -1 if it is not in the alphabet
+static inline int charutil_base64_value(unsigned char ch, char c62, char c63)
+{
+    return IS_UPPER(ch) * (ch - 'A' + 1) + IS_LOWER(ch) * (ch - 'a' + 27) + IS_DIGIT(ch) * (ch - '0' + 53) + (ch == (unsigned char)c62) * 63 + (ch == (unsigned char)c63) * 64 - 1;
+}
+
+/// Base32 digit for v in 0..31 (RFC 4648 alphabet A-Z 2-7)
+static inline char charutil_base32_digit(int v)
+{
+    return (char)(v + 'A' - (v > 25) * ('A' - '2' + 26));
+}
+
+/// Value of a base32 character in either case, or -1 if it is not in the alphabet
+static inline int charutil_base32_value(unsigned char ch)
+{
+    return IS_UPPER(ch) * (ch - 'A' + 1) + IS_LOWER(ch) * (ch - 'a' + 1) + ((unsigned)(ch - '2') < 6) * (ch - '2' + 27) - 1;
+}
+
+/// Encodes n bytes, returns the number of characters written (see CHARUTIL_BASE64_ENCODED_MAX)
+static inline size_t charutil_base64_encode_scalar(char *dst, const void *src, size_t n, unsigned flags)
+{
+    const unsigned char *s = (const unsigned char *)src;
+    const char c62 = (flags & CHARUTIL_BASE64_URL) ? '-' : '+';
+    const char c63 = (flags & CHARUTIL_BASE64_URL) ? '_' : '/';
+    size_t out = 0;
+    size_t i = 0;
+    for (; i + 3 <= n; i += 3)
+    {
+        const uint32_t w = ((uint32_t)s[i] << 16) | ((uint32_t)s[i + 1] << 8) | s[i + 2];
+        dst[out++] = charutil_base64_digit((int)(w >> 18), c62, c63);
+        dst[out++] = charutil_base64_digit((int)(w >> 12) & 0x3F, c62, c63);
+        dst[out++] = charutil_base64_digit((int)(w >> 6) & 0x3F, c62, c63);
+        dst[out++] = charutil_base64_digit((int)w & 0x3F, c62, c63);
+    }
+    if (i < n)
+    {
+        const size_t rest = n - i;
+        const uint32_t w = ((uint32_t)s[i] << 16) | ((rest > 1) ? (uint32_t)s[i + 1] << 8 : 0);
+        dst[out++] = charutil_base64_digit((int)(w >> 18), c62, c63);
+        dst[out++] = charutil_base64_digit((int)(w >> 12) & 0x3F, c62, c63);
+        if (rest > 1)
+        {
+            dst[out++] = charutil_base64_digit((int)(w >> 6) & 0x3F, c62, c63);
+        }
+        while (!(flags & CHARUTIL_BASE64_NOPAD) && (out & 3))
+        {
+            dst[out++] = '=';
+        }
+    }
+    return out;
+}
+
+/// Block kernel stand-in when there is no SIMD kernel: consumes nothing
+static inline size_t charutil_base64_encode_none(char *dst, const unsigned char *src, size_t n, char c62, char c63)
+{
+    (void)dst;
+    (void)src;
+    (void)n;
+    (void)c62;
+    (void)c63;
+    return 0;
+}
+
+static inline size_t charutil_base64_decode_none(unsigned char *dst, const char *src, size_t n, char c62, char c63)
+{
+    (void)dst;
+    (void)src;
+    (void)n;
+    (void)c62;
+    (void)c63;
+    return 0;
+}
+
+#if defined(CHARUTIL_HAVE_AVX2)
+/// Maps 6 bit values to base64 digits with the same arithmetic as charutil_base64_digit()
+static inline CHARUTIL_TARGET_AVX2 __m256i charutil_base64_digits_avx2(__m256i v, char c62, char c63)
+{
+    __m256i offset = _mm256_set1_epi8('A');
+    offset = _mm256_add_epi8(offset, _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(25)), _mm256_set1_epi8(6)));
+    offset = _mm256_sub_epi8(offset, _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(51)), _mm256_set1_epi8(75)));
+    offset = _mm256_add_epi8(offset, _mm256_and_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(62)), _mm256_set1_epi8((char)(c62 - 58))));
+    offset = _mm256_add_epi8(offset, _mm256_and_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(63)), _mm256_set1_epi8((char)(c63 - 59))));
+    return _mm256_add_epi8(v, offset);
+}
+
+/// Maps base64 characters to 6 bit values, clearing bits in *valid for characters outside the alphabet
+static inline CHARUTIL_TARGET_AVX2 __m256i charutil_base64_values_avx2(__m256i c, char c62, char c63, unsigned *valid)
+{
+    const __m256i upper = charutil_range_avx2(c, 'A', 'Z');
+    const __m256i lower = charutil_range_avx2(c, 'a', 'z');
+    const __m256i digit = charutil_range_avx2(c, '0', '9');
+    const __m256i is_62 = _mm256_cmpeq_epi8(c, _mm256_set1_epi8(c62));
+    const __m256i is_63 = _mm256_cmpeq_epi8(c, _mm256_set1_epi8(c63));
+    *valid &= (unsigned)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(digit, _mm256_or_si256(is_62, is_63))));
+    __m256i offset = _mm256_and_si256(upper, _mm256_set1_epi8(-'A'));
+    offset = _mm256_or_si256(offset, _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a')));
+    offset = _mm256_or_si256(offset, _mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')));
+    offset = _mm256_or_si256(offset, _mm256_and_si256(is_62, _mm256_set1_epi8((char)(62 - c62))));
+    offset = _mm256_or_si256(offset, _mm256_and_si256(is_63, _mm256_set1_epi8((char)(63 - c63))));
+    return _mm256_add_epi8(c, offset);
+}
+
+/// Encodes whole 24 byte blocks into 32 characters, returns the number of bytes consumed
+static inline CHARUTIL_TARGET_AVX2 size_t charutil_base64_encode_avx2(char *dst, const unsigned char *src, size_t n, char c62, char c63)
+{
+    // Each lane takes 12 bytes and copies every 3 into a 32 bit word as b1 b0 b2 b1, so the
+    // multiplies can move all four 6 bit fields into their own byte (Mula and Lemire)
+    const __m256i spread = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10, 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    size_t i = 0;
+    size_t out = 0;
+    for (; i + 28 <= n; i += 24, out += 32) // The upper lane load reads 4 bytes past the block
+    {
+        const __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(src + i))), _mm_loadu_si128((const __m128i *)(src + i + 12)), 1);
+        const __m256i words = _mm256_shuffle_epi8(in, spread);
+        const __m256i hi = _mm256_mulhi_epu16(_mm256_and_si256(words, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040));
+        const __m256i lo = _mm256_mullo_epi16(_mm256_and_si256(words, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010));
+        _mm256_storeu_si256((__m256i *)(dst + out), charutil_base64_digits_avx2(_mm256_or_si256(hi, lo), c62, c63));
+    }
+    return i;
+}
+
+/// Decodes whole 32 character blocks into 24 bytes up to the first block with a character
+/// outside the alphabet. Returns the number of characters consumed.
+static inline CHARUTIL_TARGET_AVX2 size_t charutil_base64_decode_avx2(unsigned char *dst, const char *src, size_t n, char c62, char c63)
+{
+    const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    size_t i = 0;
+    size_t out = 0;
+    for (; i + 32 <= n; i += 32, out += 24)
+    {
+        unsigned valid = 0xFFFFFFFFu;
+        const __m256i v = charutil_base64_values_avx2(_mm256_loadu_si256((const __m256i *)(src + i)), c62, c63, &valid);
+        if (valid != 0xFFFFFFFFu)
+        {
+            break;
+        }
+        // Merge pairs of 6 bit values into 12 bits, then pairs of those into 24 bits per 32 bit word
+        const __m256i pairs = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+        const __m256i words = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+        const __m256i bytes = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(words, pack), _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        _mm_storeu_si128((__m128i *)(dst + out), _mm256_castsi256_si128(bytes));
+        _mm_storel_epi64((__m128i *)(dst + out + 16), _mm256_extracti128_si256(bytes, 1));
+    }
+    return i;
+}
+#endif
+
+#if defined(CHARUTIL_HAVE_NEON)
+static inline uint8x16_t charutil_base64_digits_neon(uint8x16_t v, char c62, char c63)
+{
+    uint8x16_t offset = vdupq_n_u8('A');
+    offset = vaddq_u8(offset, vandq_u8(vcgtq_u8(v, vdupq_n_u8(25)), vdupq_n_u8(6)));
+    offset = vsubq_u8(offset, vandq_u8(vcgtq_u8(v, vdupq_n_u8(51)), vdupq_n_u8(75)));
+    offset = vaddq_u8(offset, vandq_u8(vceqq_u8(v, vdupq_n_u8(62)), vdupq_n_u8((uint8_t)(c62 - 58))));
+    offset = vaddq_u8(offset, vandq_u8(vceqq_u8(v, vdupq_n_u8(63)), vdupq_n_u8((uint8_t)(c63 - 59))));
+    return vaddq_u8(v, offset);
+}
+
+static inline uint8x16_t charutil_base64_values_neon(uint8x16_t c, char c62, char c63, uint8x16_t *valid)
+{
+    const uint8x16_t upper = charutil_range_neon(c, 'A', 'Z');
+    const uint8x16_t lower = charutil_range_neon(c, 'a', 'z');
+    const uint8x16_t digit = charutil_range_neon(c, '0', '9');
+    const uint8x16_t is_62 = vceqq_u8(c, vdupq_n_u8((uint8_t)c62));
+    const uint8x16_t is_63 = vceqq_u8(c, vdupq_n_u8((uint8_t)c63));
+    *valid = vandq_u8(*valid, vorrq_u8(vorrq_u8(upper, lower), vorrq_u8(digit, vorrq_u8(is_62, is_63))));
+    uint8x16_t offset = vandq_u8(upper, vdupq_n_u8((uint8_t)-'A'));
+    offset = vorrq_u8(offset, vandq_u8(lower, vdupq_n_u8((uint8_t)(26 - 'a'))));
+    offset = vorrq_u8(offset, vandq_u8(digit, vdupq_n_u8((uint8_t)(52 - '0'))));
+    offset = vorrq_u8(offset, vandq_u8(is_62, vdupq_n_u8((uint8_t)(62 - c62))));
+    offset = vorrq_u8(offset, vandq_u8(is_63, vdupq_n_u8((uint8_t)(63 - c63))));
+    return vaddq_u8(c, offset);
+}
+
+/// Encodes whole 48 byte blocks into 64 characters, returns the number of bytes consumed
+static inline size_t charutil_base64_encode_neon(char *dst, const unsigned char *src, size_t n, char c62, char c63)
+{
+    size_t i = 0;
+    size_t out = 0;
+    for (; i + 48 <= n; i += 48, out += 64)
+    {
+        const uint8x16x3_t in = vld3q_u8(src + i);
+        uint8x16x4_t digits;
+        digits.val[0] = charutil_base64_digits_neon(vshrq_n_u8(in.val[0], 2), c62, c63);
+        digits.val[1] = charutil_base64_digits_neon(vorrq_u8(vshlq_n_u8(vandq_u8(in.val[0], vdupq_n_u8(0x03)), 4), vshrq_n_u8(in.val[1], 4)), c62, c63);
+        digits.val[2] = charutil_base64_digits_neon(vorrq_u8(vshlq_n_u8(vandq_u8(in.val[1], vdupq_n_u8(0x0F)), 2), vshrq_n_u8(in.val[2], 6)), c62, c63);
+        digits.val[3] = charutil_base64_digits_neon(vandq_u8(in.val[2], vdupq_n_u8(0x3F)), c62, c63);
+        vst4q_u8((uint8_t *)dst + out, digits);
+    }
+    return i;
+}
+
+/// Decodes whole 64 character blocks into 48 bytes up to the first block with a character
+/// outside the alphabet. Returns the number of characters consumed.
+static inline size_t charutil_base64_decode_neon(unsigned char *dst, const char *src, size_t n, char c62, char c63)
+{
+    size_t i = 0;
+    size_t out = 0;
+    for (; i + 64 <= n; i += 64, out += 48)
+    {
+        const uint8x16x4_t c = vld4q_u8((const uint8_t *)src + i);
+        uint8x16_t valid = vdupq_n_u8(0xFF);
+        const uint8x16_t a = charutil_base64_values_neon(c.val[0], c62, c63, &valid);
+        const uint8x16_t b = charutil_base64_values_neon(c.val[1], c62, c63, &valid);
+        const uint8x16_t d = charutil_base64_values_neon(c.val[2], c62, c63, &valid);
+        const uint8x16_t e = charutil_base64_values_neon(c.val[3], c62, c63, &valid);
+        const uint64x2_t valid64 = vreinterpretq_u64_u8(valid);
+        if ((vgetq_lane_u64(valid64, 0) & vgetq_lane_u64(valid64, 1)) != UINT64_MAX)
+        {
+            break;
+        }
+        uint8x16x3_t bytes;
+        bytes.val[0] = vorrq_u8(vshlq_n_u8(a, 2), vshrq_n_u8(b, 4));
+        bytes.val[1] = vorrq_u8(vshlq_n_u8(b, 4), vshrq_n_u8(d, 2));
+        bytes.val[2] = vorrq_u8(vshlq_n_u8(d, 6), e);
+        vst3q_u8(dst + out, bytes);
+    }
+    return i;
+}
+#endif
+
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+static inline size_t charutil_dispatch_base64_encode(char *dst, const unsigned char *src, size_t n, char c62, char c63);
+static inline size_t charutil_dispatch_base64_decode(unsigned char *dst, const char *src, size_t n, char c62, char c63);
+#endif
+
+/// Runs the widest base64 encode kernel over whole blocks, returns the number of bytes consumed
+static inline size_t charutil_base64_encode_blocks(char *dst, const unsigned char *src, size_t n, char c62, char c63)
+{
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+    return charutil_dispatch_base64_encode(dst, src, n, c62, c63);
+#elif defined(CHARUTIL_HAVE_AVX2)
+    return charutil_base64_encode_avx2(dst, src, n, c62, c63);
+#elif defined(CHARUTIL_HAVE_NEON)
+    return charutil_base64_encode_neon(dst, src, n, c62, c63);
+#else
+    return charutil_base64_encode_none(dst, src, n, c62, c63);
+#endif
+}
+
+/// Runs the widest base64 decode kernel over whole blocks, returns the number of characters consumed
+static inline size_t charutil_base64_decode_blocks(unsigned char *dst, const char *src, size_t n, char c62, char c63)
+{
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+    return charutil_dispatch_base64_decode(dst, src, n, c62, c63);
+#elif defined(CHARUTIL_HAVE_AVX2)
+    return charutil_base64_decode_avx2(dst, src, n, c62, c63);
+#elif defined(CHARUTIL_HAVE_NEON)
+    return charutil_base64_decode_neon(dst, src, n, c62, c63);
+#else
+    return charutil_base64_decode_none(dst, src, n, c62, c63);
+#endif
+}
+
+/// Base64 encode n bytes. Returns the number of characters written (no NUL terminator).
+/// flags is an OR of charutil_base64_flags_t.
+static inline size_t charutil_base64_encode(char *dst, const void *src, size_t n, unsigned flags)
+{
+    const unsigned char *s = (const unsigned char *)src;
+    const size_t i = charutil_base64_encode_blocks(dst, s, n, (flags & CHARUTIL_BASE64_URL) ? '-' : '+', (flags & CHARUTIL_BASE64_URL) ? '_' : '/');
+    return i / 3 * 4 + charutil_base64_encode_scalar(dst + i / 3 * 4, s + i, n - i, flags);
+}
+
+/// Base32 encode n bytes (RFC 4648). Returns the number of characters written (no NUL terminator).
+static inline size_t charutil_base32_encode(char *dst, const void *src, size_t n, int pad)
+{
+    const unsigned char *s = (const unsigned char *)src;
+    size_t out = 0;
+    size_t i = 0;
+    for (; i + 5 <= n; i += 5)
+    {
+        const uint64_t w = ((uint64_t)s[i] << 32) | ((uint64_t)s[i + 1] << 24) | ((uint64_t)s[i + 2] << 16) | ((uint64_t)s[i + 3] << 8) | s[i + 4];
+        for (int k = 0; k < 8; k++)
+        {
+            dst[out++] = charutil_base32_digit((int)(w >> (35 - 5 * k)) & 0x1F);
+        }
+    }
+    if (i < n)
+    {
+        const size_t rest = n - i;
+        uint64_t w = 0;
+        for (size_t k = 0; k < rest; k++)
+        {
+            w |= (uint64_t)s[i + k] << (32 - 8 * k);
+        }
+        // 1, 2, 3 or 4 bytes leave 2, 4, 5 or 7 digits
+        const size_t digits = (rest * 8 + 4) / 5;
+        for (size_t k = 0; k < digits; k++)
+        {
+            dst[out++] = charutil_base32_digit((int)(w >> (35 - 5 * k)) & 0x1F);
+        }
+        while (pad && (out & 7))
+        {
+            dst[out++] = '=';
+        }
+    }
+    return out;
+}
+
+/// Streaming state shared by the base64 and base32 decoders
+typedef struct
+{
+    uint32_t acc;   ///< Decoded bits, the low `bits` of them not written yet
+    uint8_t bits;   ///< ...
+    uint8_t count;  ///< Digits in the current group
+    uint8_t pad;    ///< '=' in the current group
+    uint8_t flags;  ///< charutil_base64_flags_t
+    uint8_t error;  ///< Sticky once an invalid character is seen
+    size_t pos;     ///< Characters fed so far
+    size_t err_pos; ///< Position of the first invalid character, or of a truncated final group
+} charutil_base_decoder_t;
+
+/// True if the bits a final partial group leaves over are not all zero, so the same bytes have another encoding
+static inline int charutil_base_decode_noncanonical(const charutil_base_decoder_t *st)
+{
+    return (st->acc & ((1u << st->bits) - 1)) != 0;
+}
+
+/// Feeds character `at` of the stream, ch, with digit value v (-1 if not a digit). Groups are of `group` digits of
+/// `shift` bits, partial_mask has bit k set if a group may end after k digits. Returns the number of bytes written to d.
+static inline size_t charutil_base_decode_step(charutil_base_decoder_t *st, unsigned char *d, unsigned char ch, int v, unsigned shift, unsigned group, unsigned partial_mask, size_t at)
+{
+    if (v >= 0 && !st->pad)
+    {
+        st->acc = (st->acc << shift) | (uint32_t)v;
+        st->bits = (uint8_t)(st->bits + shift);
+        st->count = (uint8_t)((st->count + 1) % group);
+        if (st->bits >= 8)
+        {
+            st->bits -= 8;
+            *d = (unsigned char)(st->acc >> st->bits);
+            return 1;
+        }
+        return 0;
+    }
+    if (ch == '=' && (st->pad ? (unsigned)(st->count + st->pad) < group : (partial_mask >> st->count) & 1))
+    {
+        if (!st->pad && charutil_base_decode_noncanonical(st))
+        {
+            st->error = 1;
+            st->err_pos = at - 1; // The digit holding the stray bits
+            return 0;
+        }
+        st->pad++;
+        st->bits = 0; // Leftover bits of a partial group are padding
+        return 0;
+    }
+    st->error = 1;
+    st->err_pos = at;
+    return 0;
+}
+
+/// Marks a stream that stops inside a group, or in an unpadded partial group with stray bits, as invalid.
+/// Returns 1 if the stream is valid.
+static inline int charutil_base_decode_finish(charutil_base_decoder_t *st, unsigned group, unsigned partial_mask)
+{
+    if (!st->error && (st->pad ? (unsigned)(st->count + st->pad) != group : !((partial_mask >> st->count) & 1) && st->count))
+    {
+        st->error = 1;
+        st->err_pos = st->pos - st->count - st->pad;
+    }
+    else if (!st->error && !st->pad && st->count && charutil_base_decode_noncanonical(st))
+    {
+        st->error = 1;
+        st->err_pos = st->pos - 1;
+    }
+    return !st->error;
+}
+
+#define CHARUTIL_BASE64_PARTIAL ((1u << 2) | (1u << 3))                         ///< Base64 groups may end after 2 or 3 digits
+#define CHARUTIL_BASE32_PARTIAL ((1u << 2) | (1u << 4) | (1u << 5) | (1u << 7)) ///< Base32 groups may end after 2, 4, 5 or 7 digits
+
+static inline void charutil_base64_decode_init(charutil_base_decoder_t *st, unsigned flags)
+{
+    memset(st, 0, sizeof(*st));
+    st->flags = (uint8_t)flags;
+}
+
+/// Feeds a chunk of base64 text. Returns the number of bytes written, stopping at the first invalid character.
+static inline size_t charutil_base64_decode_update(charutil_base_decoder_t *st, void *dst, const char *src, size_t n)
+{
+    unsigned char *d = (unsigned char *)dst;
+    const char c62 = (st->flags & CHARUTIL_BASE64_URL) ? '-' : '+';
+    const char c63 = (st->flags & CHARUTIL_BASE64_URL) ? '_' : '/';
+    size_t out = 0;
+    size_t i = 0;
+    while (i < n && !st->error)
+    {
+        if (!st->count && !st->pad)
+        {
+            // Whole groups: SIMD blocks, then 4 digits at a time
+            const size_t consumed = charutil_base64_decode_blocks(d + out, src + i, n - i, c62, c63);
+            out += consumed / 4 * 3;
+            i += consumed;
+            for (; i + 4 <= n; i += 4, out += 3)
+            {
+                const int a = charutil_base64_value((unsigned char)src[i], c62, c63);
+                const int b = charutil_base64_value((unsigned char)src[i + 1], c62, c63);
+                const int c = charutil_base64_value((unsigned char)src[i + 2], c62, c63);
+                const int e = charutil_base64_value((unsigned char)src[i + 3], c62, c63);
+                if ((a | b | c | e) < 0)
+                {
+                    break;
+                }
+                const uint32_t w = ((uint32_t)a << 18) | ((uint32_t)b << 12) | ((uint32_t)c << 6) | (uint32_t)e;
+                d[out] = (unsigned char)(w >> 16);
+                d[out + 1] = (unsigned char)(w >> 8);
+                d[out + 2] = (unsigned char)w;
+            }
+            if (i == n)
+            {
+                break;
+            }
+        }
+        const unsigned char ch = (unsigned char)src[i];
+        out += charutil_base_decode_step(st, d + out, ch, charutil_base64_value(ch, c62, c63), 6, 4, CHARUTIL_BASE64_PARTIAL, st->pos + i);
+        i++;
+    }
+    st->pos += i;
+    return out;
+}
+
+/// Returns 1 if everything fed so far is valid base64 ending on a group boundary (padded or not)
+static inline int charutil_base64_decode_finish(charutil_base_decoder_t *st)
+{
+    return charutil_base_decode_finish(st, 4, CHARUTIL_BASE64_PARTIAL);
+}
+
+/// Base64 decode n characters (flags selects the alphabet). Returns bytes written.
+/// err_pos (optional) receives the index of the first invalid character, the start of a
+/// truncated final group, the last digit of a final group whose unused low bits are not zero (so the text is not
+/// the canonical encoding of the bytes), or n if the whole input decoded cleanly.
+static inline size_t charutil_base64_decode(void *dst, const char *src, size_t n, unsigned flags, size_t *err_pos)
+{
+    charutil_base_decoder_t st;
+    charutil_base64_decode_init(&st, flags);
+    const size_t written = charutil_base64_decode_update(&st, dst, src, n);
+    charutil_base64_decode_finish(&st);
+    if (err_pos)
+    {
+        *err_pos = st.error ? st.err_pos : n;
+    }
+    return written;
+}
+
+static inline void charutil_base32_decode_init(charutil_base_decoder_t *st)
+{
+    memset(st, 0, sizeof(*st));
+}
+
+/// Feeds a chunk of base32 text. Returns the number of bytes written, stopping at the first invalid character.
+static inline size_t charutil_base32_decode_update(charutil_base_decoder_t *st, void *dst, const char *src, size_t n)
+{
+    unsigned char *d = (unsigned char *)dst;
+    size_t out = 0;
+    size_t i = 0;
+    while (i < n && !st->error)
+    {
+        if (!st->count && !st->pad)
+        {
+            // Whole groups, 8 digits at a time
+            for (; i + 8 <= n; i += 8, out += 5)
+            {
+                uint64_t w = 0;
+                int bad = 0;
+                for (int k = 0; k < 8; k++)
+                {
+                    const int v = charutil_base32_value((unsigned char)src[i + k]);
+                    bad |= v;
+                    w = (w << 5) | (uint64_t)(v & 0x1F);
+                }
+                if (bad < 0)
+                {
+                    break;
+                }
+                d[out] = (unsigned char)(w >> 32);
+                d[out + 1] = (unsigned char)(w >> 24);
+                d[out + 2] = (unsigned char)(w >> 16);
+                d[out + 3] = (unsigned char)(w >> 8);
+                d[out + 4] = (unsigned char)w;
+            }
+            if (i == n)
+            {
+                break;
+            }
+        }
+        const unsigned char ch = (unsigned char)src[i];
+        out += charutil_base_decode_step(st, d + out, ch, charutil_base32_value(ch), 5, 8, CHARUTIL_BASE32_PARTIAL, st->pos + i);
+        i++;
+    }
+    st->pos += i;
+    return out;
+}
+
+/// Returns 1 if everything fed so far is valid base32 ending on a group boundary (padded or not)
+static inline int charutil_base32_decode_finish(charutil_base_decoder_t *st)
+{
+    return charutil_base_decode_finish(st, 8, CHARUTIL_BASE32_PARTIAL);
+}
+
+/// Base32 decode n characters of either case. Returns bytes written.
+/// err_pos (optional) receives the index of the first invalid character, the start of a
+/// truncated final group, the last digit of a final group whose unused low bits are not zero, or n if the whole
+/// input decoded cleanly.
+static inline size_t charutil_base32_decode(void *dst, const char *src, size_t n, size_t *err_pos)
+{
+    charutil_base_decoder_t st;
+    charutil_base32_decode_init(&st);
+    const size_t written = charutil_base32_decode_update(&st, dst, src, n);
+    charutil_base32_decode_finish(&st);
+    if (err_pos)
+    {
+        *err_pos = st.error ? st.err_pos : n;
+    }
+    return written;
+}
+
+/// Ascii85 encode n bytes (btoa / Adobe alphabet '!' to 'u', 'z' for an all zero group, no delimiters).
+/// Returns the number of characters written (no NUL terminator).
+static inline size_t charutil_ascii85_encode(char *dst, const void *src, size_t n)
+{
+    const unsigned char *s = (const unsigned char *)src;
+    size_t out = 0;
+    for (size_t i = 0; i < n; i += 4)
+    {
+        const size_t rest = (n - i < 4) ? n - i : 4;
+        uint32_t w = 0;
+        for (size_t k = 0; k < 4; k++)
+        {
+            w = (w << 8) | ((k < rest) ? s[i + k] : 0u);
+        }
+        if (w == 0 && rest == 4)
+        {
+            dst[out++] = 'z';
+            continue;
+        }
+        char group[5];
+        for (int k = 4; k >= 0; k--)
+        {
+            group[k] = (char)('!' + w % 85);
+            w /= 85;
+        }
+        // A final group of k bytes keeps its first k + 1 digits
+        memcpy(dst + out, group, rest + 1);
+        out += rest + 1;
+    }
+    return out;
+}
+
+typedef struct
+{
+    uint32_t acc;   ///< Value of the digits in the current group
+    uint8_t count;  ///< Digits in the current group
+    uint8_t error;  ///< Sticky once an invalid character is seen
+    size_t pos;     ///< Characters fed so far
+    size_t err_pos; ///< Position of the first invalid character, or of a bad final group
+} charutil_ascii85_decoder_t;
+
+static inline void charutil_ascii85_decode_init(charutil_ascii85_decoder_t *st)
+{
+    memset(st, 0, sizeof(*st));
+}
+
+static inline void charutil_ascii85_put(unsigned char *d, uint32_t w)
+{
+    d[0] = (unsigned char)(w >> 24);
+    d[1] = (unsigned char)(w >> 16);
+    d[2] = (unsigned char)(w >> 8);
+    d[3] = (unsigned char)w;
+}
+
+/// Feeds a chunk of ascii85 text. Returns the number of bytes written, stopping at the first invalid character.
+/// A final partial group is only written by charutil_ascii85_decode_finish().
+static inline size_t charutil_ascii85_decode_update(charutil_ascii85_decoder_t *st, void *dst, const char *src, size_t n)
+{
+    unsigned char *d = (unsigned char *)dst;
+    size_t out = 0;
+    size_t i = 0;
+    while (i < n && !st->error)
+    {
+        const unsigned char ch = (unsigned char)src[i];
+        const unsigned digit = (unsigned)(ch - '!');
+        if (digit < 85)
+        {
+            const uint64_t v = (uint64_t)st->acc * 85 + digit;
+            st->error = (v > UINT32_MAX);
+            st->acc = (uint32_t)v;
+            if (++st->count == 5 && !st->error)
+            {
+                charutil_ascii85_put(d + out, st->acc);
+                out += 4;
+                st->acc = 0;
+                st->count = 0;
+            }
+        }
+        else if (ch == 'z' && !st->count)
+        {
+            charutil_ascii85_put(d + out, 0);
+            out += 4;
+        }
+        else
+        {
+            st->error = 1;
+        }
+        if (st->error)
+        {
+            st->err_pos = st->pos + i;
+        }
+        i++;
+    }
+    st->pos += i;
+    return out;
+}
+
+/// Writes a final partial group (up to 3 bytes) to dst and its length to *written.
+/// Returns 1 if everything fed was valid ascii85.
+static inline int charutil_ascii85_decode_finish(charutil_ascii85_decoder_t *st, void *dst, size_t *written)
+{
+    *written = 0;
+    if (st->error || !st->count)
+    {
+        return !st->error;
+    }
+    // Pad the group with 'u' (84), which rounds the value up to the bytes actually sent
+    uint64_t v = st->acc;
+    for (unsigned k = st->count; k < 5; k++)
+    {
+        v = v * 85 + 84;
+    }
+    if (st->count == 1 || v > UINT32_MAX)
+    {
+        st->error = 1;
+        st->err_pos = st->pos - st->count;
+        return 0;
+    }
+    unsigned char group[4];
+    charutil_ascii85_put(group, (uint32_t)v);
+    *written = st->count - 1u;
+    memcpy(dst, group, *written);
+    st->acc = 0;
+    st->count = 0;
+    return 1;
+}
+
+/// Ascii85 decode n characters. Returns bytes written (see CHARUTIL_ASCII85_DECODED_MAX).
+/// err_pos (optional) receives the index of the first invalid character, the start of a
+/// bad final group, or n if the whole input decoded cleanly.
+static inline size_t charutil_ascii85_decode(void *dst, const char *src, size_t n, size_t *err_pos)
+{
+    charutil_ascii85_decoder_t st;
+    charutil_ascii85_decode_init(&st);
+    size_t written = charutil_ascii85_decode_update(&st, dst, src, n);
+    size_t tail = 0;
+    charutil_ascii85_decode_finish(&st, (unsigned char *)dst + written, &tail);
+    if (err_pos)
+    {
+        *err_pos = st.error ? st.err_pos : n;
+    }
+    return written + tail;
+}
+
+/* ==========================
+ * Integer Parsing
+ * ========================== */
+// Parses the digits of base 2, 8, 10 or 16 at the start of p. There is no
+// whitespace, sign or prefix handling (e.g. "0x") in the unsigned version, so
+// the caller decides the syntax. Returns the number of characters consumed,
+// or 0 if p does not start with a digit of that base, the base is not
+// supported or the value overflows. *out is only written on success.
+// On little endian targets bases 10, 16 and 2 take 8 characters per step
+// using SWAR validation and combining.
+
+/// Digit value of ch in base 2, 8, 10 or 16, else -1
+static inline int charutil_digit_value(int ch, unsigned base)
+{
+    switch (base)
+    {
+        case 2:
+            return ASCII_TO_BINARY(ch, -1);
+        case 8:
+            return ASCII_TO_OCTAL(ch, -1);
+        case 10:
+            return ASCII_TO_DIGIT(ch);
+        case 16:
+            return HEX_TO_INT(ch, -1);
+        default:
+            return -1;
+    }
+}
+
+/// True if all 8 bytes of x are '0'..'9'
+static inline int charutil_swar_is_8_digits(uint64_t x)
+{
+    return ((x & 0xF0F0F0F0F0F0F0F0ull) | (((x + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) == 0x3333333333333333ull;
+}
+
+/// Value of 8 decimal digits loaded little endian (first char in the low byte)
+static inline uint32_t charutil_swar_parse_8_digits(uint64_t x)
+{
+    x -= 0x3030303030303030ull;
+    x = (x * 10) + (x >> 8);                                                                                             // pairs
+    x = (((x & 0x000000FF000000FFull) * (100 + (1000000ull << 32))) + (((x >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32; // quads to octet
+    return (uint32_t)x;
+}
+
+/// True if all 8 bytes of x are '0' or '1'
+static inline int charutil_swar_is_8_binary(uint64_t x)
+{
+    return (x & ~0x0101010101010101ull) == 0x3030303030303030ull;
+}
+
+/// Value of 8 binary digits loaded little endian (first char in the low byte, most significant bit)
+static inline uint32_t charutil_swar_parse_8_binary(uint64_t x)
+{
+    return (uint32_t)(((x & 0x0101010101010101ull) * 0x8040201008040201ull) >> 56);
+}
+
+static inline size_t charutil_parse_u64(const char *p, size_t n, unsigned base, uint64_t *out)
+{
+    uint64_t value = 0;
+    size_t i = 0;
+
+    if (base != 2 && base != 8 && base != 10 && base != 16)
+    {
+        return 0;
+    }
+
+#if defined(CHARUTIL_LITTLE_ENDIAN)
+    if (base == 10)
+    {
+        for (; i + 8 <= n; i += 8)
+        {
+            uint64_t w;
+            memcpy(&w, p + i, 8);
+            if (!charutil_swar_is_8_digits(w))
+            {
+                break;
+            }
+            const uint32_t eight = charutil_swar_parse_8_digits(w);
+            if (value > (UINT64_MAX - eight) / 100000000u)
+            {
+                return 0;
+            }
+            value = value * 100000000u + eight;
+        }
+    }
+    else if (base == 16)
+    {
+        for (; i + 8 <= n; i += 8)
+        {
+            uint64_t err = 0;
+            const uint32_t eight = charutil_hex_decode_u32(p + i, &err);
+            if (err)
+            {
+                break;
+            }
+            if (value >> 32)
+            {
+                return 0;
+            }
+            value = (value << 32) | eight;
+        }
+    }
+    else if (base == 2)
+    {
+        for (; i + 8 <= n; i += 8)
+        {
+            uint64_t w;
+            memcpy(&w, p + i, 8);
+            if (!charutil_swar_is_8_binary(w))
+            {
+                break;
+            }
+            if (value >> 56)
+            {
+                return 0;
+            }
+            value = (value << 8) | charutil_swar_parse_8_binary(w);
+        }
+    }
+#endif
+
+    const uint64_t cutoff = UINT64_MAX / base;
+    const unsigned cutlim = (unsigned)(UINT64_MAX % base);
+    for (; i < n; i++)
+    {
+        const int digit = charutil_digit_value(p[i], base);
+        if (digit < 0)
+        {
+            break;
+        }
+        if (value > cutoff || (value == cutoff && (unsigned)digit > cutlim))
+        {
+            return 0;
+        }
+        value = value * base + (unsigned)digit;
+    }
+
+    if (i == 0)
+    {
+        return 0;
+    }
+    *out = value;
+    return i;
+}
+
+/// As charutil_parse_u64() but accepts one leading '-' or '+' (counted in the return value)
+static inline size_t charutil_parse_i64(const char *p, size_t n, unsigned base, int64_t *out)
+{
+    const int negative = (n > 0 && p[0] == '-');
+    const size_t sign = (n > 0 && (p[0] == '-' || p[0] == '+'));
+    uint64_t magnitude = 0;
+    const size_t used = charutil_parse_u64(p + sign, n - sign, base, &magnitude);
+    if (used == 0 || magnitude > (uint64_t)INT64_MAX + (uint64_t)negative)
+    {
+        return 0;
+    }
+    *out = negative ? (magnitude ? -(int64_t)(magnitude - 1) - 1 : 0) : (int64_t)magnitude;
+    return used + sign;
+}
+
+/* ==========================
+ * Integer Formatting
+ * ========================== */
+// Writes the digits of v into dst without a NUL terminator and returns the
+// number of characters written. The length is worked out up front from the
+// bit length so digits are written straight into place from the end,
+// decimal two digits per division using a digit pair table.
+
+#define CHARUTIL_U64_DEC_MAX 20 ///< "18446744073709551615"
+#define CHARUTIL_I64_DEC_MAX 20 ///< "-9223372036854775808"
+#define CHARUTIL_U64_HEX_MAX 16
+#define CHARUTIL_U64_OCT_MAX 22
+#define CHARUTIL_U64_BIN_MAX 64
+
+/// Number of significant bits in v, counting 0 as one bit so it still formats as "0"
+static inline unsigned charutil_bit_length(uint64_t v)
+{
+    return 64 - charutil_clz64(v | 1);
+}
+
+/// Number of decimal digits in v
+static inline unsigned charutil_dec_length(uint64_t v)
+{
+    // First entry is 0 so that v == 0 still counts as one digit
+    static const uint64_t pow10[20] = {
+        0, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull,
+        10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull, 100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull};
+    const unsigned t = (charutil_bit_length(v) * 1233) >> 12; // bits * log10(2), then corrected by one compare
+    return t + 1 - (v < pow10[t]);
+}
+
+static inline size_t charutil_format_u64_dec(char *dst, uint64_t v)
+{
+    static const char digit_pairs[201] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+    const size_t len = charutil_dec_length(v);
+    char *p = dst + len;
+    while (v >= 100)
+    {
+        const unsigned pair = (unsigned)(v % 100);
+        v /= 100;
+        p -= 2;
+        memcpy(p, digit_pairs + 2 * pair, 2);
+    }
+    if (v >= 10)
+    {
+        memcpy(p - 2, digit_pairs + 2 * v, 2);
+    }
+    else
+    {
+        p[-1] = (char)FAST_DIGIT_TO_ASCII(v);
+    }
+    return len;
+}
+
+static inline size_t charutil_format_i64_dec(char *dst, int64_t v)
+{
+    if (v < 0)
+    {
+        dst[0] = '-';
+        return 1 + charutil_format_u64_dec(dst + 1, 0 - (uint64_t)v);
+    }
+    return charutil_format_u64_dec(dst, (uint64_t)v);
+}
+
+static inline size_t charutil_format_u64_hex(char *dst, uint64_t v, charutil_hex_case_t hex_case)
+{
+    const size_t len = (charutil_bit_length(v) + 3) / 4;
+    for (size_t i = len; i > 0; i--, v >>= 4)
+    {
+        dst[i - 1] = (char)(hex_case == CHARUTIL_HEX_UPPERCASE ? FAST_NIBBLE_TO_UPPERCASE_HEX(LOW_NIBBLE(v)) : FAST_NIBBLE_TO_LOWERCASE_HEX(LOW_NIBBLE(v)));
+    }
+    return len;
+}
+
+static inline size_t charutil_format_u64_oct(char *dst, uint64_t v)
+{
+    const size_t len = (charutil_bit_length(v) + 2) / 3;
+    for (size_t i = len; i > 0; i--, v >>= 3)
+    {
+        dst[i - 1] = (char)FAST_OCTAL_TO_ASCII(v & 7);
+    }
+    return len;
+}
+
+static inline size_t charutil_format_u64_bin(char *dst, uint64_t v)
+{
+    const size_t len = charutil_bit_length(v);
+    for (size_t i = len; i > 0; i--, v >>= 1)
+    {
+        dst[i - 1] = (char)FAST_BINARY_TO_ASCII(v & 1);
+    }
+    return len;
+}
+
+/* ==========================
+ * Bulk ASCII Diagnostic
+ * ========================== */
+// Writes the ascii_to_diagnostics() token of every byte of src into dst with
+// snprintf() semantics: at most dst_cap - 1 characters plus a NUL terminator
+// are written and the full escaped length (excluding the NUL) is returned.
+// Pass dst = NULL and dst_cap = 0 to size the output first. Runs of printable
+// bytes are their own token so they are found with charutil_span_class() and
+// copied in one go.
+
+/// Copies len bytes to dst + pos, clipped so that room for a NUL terminator remains within cap
+static inline void charutil_copy_clipped(char *dst, size_t cap, size_t pos, const char *src, size_t len)
+{
+    if (pos + 1 < cap)
+    {
+        const size_t room = cap - 1 - pos;
+        memcpy(dst + pos, src, len < room ? len : room);
+    }
+}
+
+/// Escapes src as if out characters had already been written to dst, clipped to dst_cap, without
+/// terminating. Returns out plus the escaped length. Lets separately escaped chunks share one buffer.
+static inline size_t charutil_diagnostics_escape_at(char *dst, size_t dst_cap, size_t out, const void *src, size_t n)
+{
+    const char *s = (const char *)src;
+    size_t i = 0;
+    while (i < n)
+    {
+        const size_t run = charutil_span_class(s + i, n - i, CHARUTIL_CLASS_PRINTABLE);
+        charutil_copy_clipped(dst, dst_cap, out, s + i, run);
+        out += run;
+        i += run;
+        if (i < n)
+        {
+            const char *token = ascii_to_diagnostics((unsigned char)s[i]);
+            const size_t len = strlen(token);
+            charutil_copy_clipped(dst, dst_cap, out, token, len);
+            out += len;
+            i++;
+        }
+    }
+    return out;
+}
+
+static inline size_t charutil_diagnostics_escape(char *dst, size_t dst_cap, const void *src, size_t n)
+{
+    const size_t out = charutil_diagnostics_escape_at(dst, dst_cap, 0, src, n);
+    if (dst_cap > 0)
+    {
+        dst[out < dst_cap ? out : dst_cap - 1] = '\0';
+    }
+    return out;
+}
+
+/* ==========================
+ * Hex Dump
+ * ========================== */
+// xxd style dump, one line per row:
+//   00000010: 666f 7820 6a75 6d70 7320 6f76 6572 2074  fox jumps over t
+// Each row is hex encoded in one charutil_hex_encode() call (so a 16 byte row
+// is a single SSE2/AVX2/NEON step) and the digit pairs are copied out a group
+// at a time. The offset column is 8 hex digits, or 16 if the dump reaches past
+// 4 GiB, and is built from FAST_NIBBLE_TO_*_HEX rather than snprintf().
+
+#define CHARUTIL_HEXDUMP_MAX_WIDTH 64 ///< Most bytes per line
+/// Longest possible line including '\n': offset, hex column, gutter of diagnostic tokens
+#define CHARUTIL_HEXDUMP_LINE_MAX (16 + 2 + 3 * CHARUTIL_HEXDUMP_MAX_WIDTH + 2 + 6 * CHARUTIL_HEXDUMP_MAX_WIDTH + 1)
+
+typedef enum
+{
+    CHARUTIL_HEXDUMP_GUTTER_NONE = 0,       ///< Hex column only
+    CHARUTIL_HEXDUMP_GUTTER_DOTS = 1,       ///< Printable ASCII as is, every other byte as '.'
+    CHARUTIL_HEXDUMP_GUTTER_DIAGNOSTICS = 2 ///< ascii_to_diagnostics() token of every byte
+} charutil_hexdump_gutter_t;
+
+typedef struct
+{
+    size_t width;                     ///< Bytes per line, 0 for 16, clamped to CHARUTIL_HEXDUMP_MAX_WIDTH
+    size_t group;                     ///< Bytes per space separated group in the hex column, 0 for one group
+    charutil_hex_case_t hex_case;     ///< Case of the offset and hex digits
+    charutil_hexdump_gutter_t gutter; ///< What follows the hex column
+    uint64_t offset;                  ///< Offset printed for the first byte
+} charutil_hexdump_opts_t;
+
+#define CHARUTIL_HEXDUMP_DEFAULTS {16, 2, CHARUTIL_HEX_LOWERCASE, CHARUTIL_HEXDUMP_GUTTER_DOTS, 0} ///< Same layout as xxd
+
+/// Called once per line. line is len characters ending in '\n', without a NUL terminator.
+/// Return non zero to stop the dump.
+typedef int (*charutil_hexdump_fn)(const char *line, size_t len, void *user);
+
+/// Writes the dump line for count (at most width) bytes and returns its length
+static inline size_t charutil_hexdump_line(char *line, const unsigned char *row, size_t count, uint64_t offset, unsigned offset_digits, size_t width, const charutil_hexdump_opts_t *opts)
+{
+    char hex[2 * CHARUTIL_HEXDUMP_MAX_WIDTH];
+    const size_t group = (opts->group && opts->group < width) ? opts->group : width;
+    size_t out = 0;
+
+    for (unsigned k = offset_digits; k-- > 0;)
+    {
+        const unsigned nibble = (unsigned)(offset >> (4 * k)) & 0x0F;
+        line[out++] = (char)((opts->hex_case == CHARUTIL_HEX_UPPERCASE) ? FAST_NIBBLE_TO_UPPERCASE_HEX(nibble) : FAST_NIBBLE_TO_LOWERCASE_HEX(nibble));
+    }
+    line[out++] = ':';
+    line[out++] = ' ';
+
+    // A short final row is padded with spaces so the gutter stays aligned
+    charutil_hex_encode(hex, row, count, opts->hex_case);
+    for (size_t i = 0; i < width; i += group)
+    {
+        const size_t len = (group < width - i) ? group : width - i;
+        const size_t have = (i >= count) ? 0 : (count - i < len) ? count - i : len;
+        if (i)
+        {
+            line[out++] = ' ';
+        }
+        memcpy(line + out, hex + 2 * i, 2 * have);
+        memset(line + out + 2 * have, ' ', 2 * (len - have));
+        out += 2 * len;
+    }
+
+    if (opts->gutter == CHARUTIL_HEXDUMP_GUTTER_DOTS)
+    {
+        line[out++] = ' ';
+        line[out++] = ' ';
+        for (size_t i = 0; i < count; i++)
+        {
+            line[out++] = IS_PRINTABLE(row[i]) ? (char)row[i] : '.';
+        }
+    }
+    else if (opts->gutter == CHARUTIL_HEXDUMP_GUTTER_DIAGNOSTICS)
+    {
+        line[out++] = ' ';
+        line[out++] = ' ';
+        out += charutil_diagnostics_escape(line + out, CHARUTIL_HEXDUMP_LINE_MAX - out, row, count);
+    }
+    else
+    {
+        while (line[out - 1] == ' ')
+        {
+            out--;
+        }
+    }
+    line[out++] = '\n';
+    return out;
+}
+
+static inline size_t charutil_hexdump_width(const charutil_hexdump_opts_t *opts)
+{
+    return !opts->width ? 16 : (opts->width < CHARUTIL_HEXDUMP_MAX_WIDTH) ? opts->width : CHARUTIL_HEXDUMP_MAX_WIDTH;
+}
+
+static inline unsigned charutil_hexdump_offset_digits(const charutil_hexdump_opts_t *opts, size_t n)
+{
+    return (opts->offset + n - 1 > 0xFFFFFFFFull) ? 16 : 8;
+}
+
+/// Dumps n bytes into dst with snprintf() semantics: at most dst_cap - 1 characters plus a NUL
+/// terminator are written and the full dump length is returned. opts may be NULL for the xxd layout.
+static inline size_t charutil_hexdump(char *dst, size_t dst_cap, const void *src, size_t n, const charutil_hexdump_opts_t *opts)
+{
+    static const charutil_hexdump_opts_t defaults = CHARUTIL_HEXDUMP_DEFAULTS;
+    const unsigned char *s = (const unsigned char *)src;
+    opts = opts ? opts : &defaults;
+    const size_t width = charutil_hexdump_width(opts);
+    const unsigned offset_digits = charutil_hexdump_offset_digits(opts, n);
+    char line[CHARUTIL_HEXDUMP_LINE_MAX];
+    size_t out = 0;
+    for (size_t i = 0; i < n; i += width)
+    {
+        const size_t count = (n - i < width) ? n - i : width;
+        if (out + CHARUTIL_HEXDUMP_LINE_MAX < dst_cap)
+        {
+            out += charutil_hexdump_line(dst + out, s + i, count, opts->offset + i, offset_digits, width, opts);
+        }
+        else
+        {
+            const size_t len = charutil_hexdump_line(line, s + i, count, opts->offset + i, offset_digits, width, opts);
+            charutil_copy_clipped(dst, dst_cap, out, line, len);
+            out += len;
+        }
+    }
+    if (dst_cap > 0)
+    {
+        dst[out < dst_cap ? out : dst_cap - 1] = '\0';
+    }
+    return out;
+}
+
+/// Dumps n bytes one line at a time through fn. opts may be NULL for the xxd layout.
+/// Returns 0, or the first non zero value returned by fn.
+static inline int charutil_hexdump_lines(const void *src, size_t n, const charutil_hexdump_opts_t *opts, charutil_hexdump_fn fn, void *user)
+{
+    static const charutil_hexdump_opts_t defaults = CHARUTIL_HEXDUMP_DEFAULTS;
+    const unsigned char *s = (const unsigned char *)src;
+    opts = opts ? opts : &defaults;
+    const size_t width = charutil_hexdump_width(opts);
+    const unsigned offset_digits = charutil_hexdump_offset_digits(opts, n);
+    char line[CHARUTIL_HEXDUMP_LINE_MAX];
+    for (size_t i = 0; i < n; i += width)
+    {
+        const size_t count = (n - i < width) ? n - i : width;
+        const int stop = fn(line, charutil_hexdump_line(line, s + i, count, opts->offset + i, offset_digits, width, opts), user);
+        if (stop)
+        {
+            return stop;
+        }
+    }
+    return 0;
+}
+
+/* ==========================
+ * String Escaping
+ * ========================== */
+// C string, JSON string and URL percent encoding. The encoders have
+// snprintf() semantics like charutil_diagnostics_escape(): at most
+// dst_cap - 1 characters plus a NUL terminator are written and the full
+// escaped length is returned, so a first call with dst = NULL and
+// dst_cap = 0 gives the exact size for a single allocation.
+// Runs of bytes that need no escaping are found with charutil_set_cspan()
+// (SIMD nibble lookup) and copied in one go, so mostly clean text costs
+// little more than a memcpy().
+// The decoders write at most n bytes, return the number written and stop at
+// the first malformed escape. err_pos (optional) receives the index where
+// the malformed escape starts, or n on success. Decoded text is never longer
+// than its source, so dst may equal src to decode in place.
+
+/// Writes the escape of ch, returns its length
+static inline size_t charutil_escape_hex_byte(char *out, char lead, unsigned char ch)
+{
+    out[0] = '\\';
+    out[1] = lead;
+    out[2] = (char)FAST_NIBBLE_TO_LOWERCASE_HEX(HIGH_NIBBLE(ch));
+    out[3] = (char)FAST_NIBBLE_TO_LOWERCASE_HEX(LOW_NIBBLE(ch));
+    return 4;
+}
+
+/// Single character escape letter of ch shared by C and JSON (\b \f \n \r \t), else 0
+static inline char charutil_escape_letter(unsigned char ch)
+{
+    switch (ch)
+    {
+        case '\b':
+            return 'b';
+        case '\f':
+            return 'f';
+        case '\n':
+            return 'n';
+        case '\r':
+            return 'r';
+        case '\t':
+            return 't';
+        case '\\':
+            return '\\';
+        case '"':
+            return '"';
+        default:
+            return 0;
+    }
+}
+
+/// Escapes n bytes as the body of a C string literal: \a \b \f \n \r \t \v \\ \" and \xHH for other
+/// control and non ASCII bytes. A hex digit straight after \xHH is also escaped so the escape cannot run on.
+static inline size_t charutil_escape_c(char *dst, size_t dst_cap, const void *src, size_t n)
+{
+    // Control characters (0x03 in every low row byte is 0x00 - 0x1F), '"', '\\' and 0x7F - 0xFF
+    static const charutil_set_t special = CHARUTIL_SET_ROWS(0x03, 0x03, 0x07, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x23, 0x03, 0x03, 0x83, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                                                            0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF);
+    const char *s = (const char *)src;
+    size_t out = 0;
+    size_t i = 0;
+    int after_hex = 0;
+    while (i < n)
+    {
+        const unsigned char ch = (unsigned char)s[i];
+        const size_t run = (after_hex && IS_HEX_DIGIT(ch)) ? 0 : charutil_set_cspan(s + i, n - i, &special);
+        if (run)
+        {
+            charutil_copy_clipped(dst, dst_cap, out, s + i, run);
+            out += run;
+            i += run;
+            after_hex = 0;
+            continue;
+        }
+        char token[4];
+        size_t len = 2;
+        token[0] = '\\';
+        token[1] = (ch == '\a') ? 'a' : (ch == '\v') ? 'v' : charutil_escape_letter(ch);
+        after_hex = !token[1];
+        if (after_hex)
+        {
+            len = charutil_escape_hex_byte(token, 'x', ch);
+        }
+        charutil_copy_clipped(dst, dst_cap, out, token, len);
+        out += len;
+        i++;
+    }
+    if (dst_cap > 0)
+    {
+        dst[out < dst_cap ? out : dst_cap - 1] = '\0';
+    }
+    return out;
+}
+
+/// Escapes n bytes as the body of a JSON string: \" \\ \b \f \n \r \t and \u00XX for other control
+/// characters. Other bytes, including UTF-8 sequences, are copied as is.
+static inline size_t charutil_escape_json(char *dst, size_t dst_cap, const void *src, size_t n)
+{
+    // Control characters, '"' and '\\'
+    static const charutil_set_t special = CHARUTIL_SET_ROWS(0x03, 0x03, 0x07, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x23, 0x03, 0x03, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                                            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00);
+    const char *s = (const char *)src;
+    size_t out = 0;
+    size_t i = 0;
+    while (i < n)
+    {
+        const size_t run = charutil_set_cspan(s + i, n - i, &special);
+        charutil_copy_clipped(dst, dst_cap, out, s + i, run);
+        out += run;
+        i += run;
+        if (i < n)
+        {
+            const unsigned char ch = (unsigned char)s[i];
+            char token[6] = {'\\', charutil_escape_letter(ch), '0', '0'};
+            size_t len = 2;
+            if (!token[1])
+            {
+                len = 2 + charutil_escape_hex_byte(token + 2, '0', ch);
+                token[1] = 'u';
+                token[2] = '0';
+            }
+            charutil_copy_clipped(dst, dst_cap, out, token, len);
+            out += len;
+            i++;
+        }
+    }
+    if (dst_cap > 0)
+    {
+        dst[out < dst_cap ? out : dst_cap - 1] = '\0';
+    }
+    return out;
+}
+
+typedef enum
+{
+    CHARUTIL_PERCENT_DEFAULT = 0,    ///< RFC 3986: every byte outside the kept set becomes %HH
+    CHARUTIL_PERCENT_PLUS_SPACE = 1, ///< application/x-www-form-urlencoded: space is written as '+' and '+' decodes to space
+} charutil_percent_flags_t;
+
+/// RFC 3986 unreserved characters: ALPHA, DIGIT, '-', '.', '_' and '~'
+static const charutil_set_t charutil_url_unreserved = CHARUTIL_SET_ROWS(0xA8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF0, 0x50, 0x50, 0x54, 0xD4, 0x70, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                                                        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00);
+
+/// Percent encodes n bytes as %HH (upper case hex), leaving the bytes in keep as is. keep = NULL keeps
+/// charutil_url_unreserved, e.g. pass a copy with '/' added to encode a path. flags is charutil_percent_flags_t.
+static inline size_t charutil_percent_encode(char *dst, size_t dst_cap, const void *src, size_t n, const charutil_set_t *keep, unsigned flags)
+{
+    const char *s = (const char *)src;
+    charutil_set_t special = keep ? *keep : charutil_url_unreserved;
+    size_t out = 0;
+    size_t i = 0;
+    charutil_set_invert(&special);
+    while (i < n)
+    {
+        const size_t run = charutil_set_cspan(s + i, n - i, &special);
+        charutil_copy_clipped(dst, dst_cap, out, s + i, run);
+        out += run;
+        i += run;
+        if (i < n)
+        {
+            const unsigned char ch = (unsigned char)s[i];
+            const char token[3] = {'%', (char)FAST_NIBBLE_TO_UPPERCASE_HEX(HIGH_NIBBLE(ch)), (char)FAST_NIBBLE_TO_UPPERCASE_HEX(LOW_NIBBLE(ch))};
+            const size_t len = (ch == ' ' && (flags & CHARUTIL_PERCENT_PLUS_SPACE)) ? 1 : 3;
+            charutil_copy_clipped(dst, dst_cap, out, (len == 1) ? "+" : token, len);
+            out += len;
+            i++;
+        }
+    }
+    if (dst_cap > 0)
+    {
+        dst[out < dst_cap ? out : dst_cap - 1] = '\0';
+    }
+    return out;
+}
+
+/// Copies the clean run before the next byte in special, returns its length
+static inline size_t charutil_unescape_run(char *dst, const char *src, size_t n, const charutil_set_t *special)
+{
+    const size_t run = charutil_set_cspan(src, n, special);
+    if (dst != src)
+    {
+        memmove(dst, src, run);
+    }
+    return run;
+}
+
+/// Sets *err_pos (if given) and returns the bytes written so far
+static inline size_t charutil_unescape_result(size_t out, size_t *err_pos, size_t pos)
+{
+    if (err_pos)
+    {
+        *err_pos = pos;
+    }
+    return out;
+}
+
+/// Decodes the body of a C string literal: the escapes written by charutil_escape_c() plus \' \?, octal
+/// \o to \ooo and \x with one or two hex digits. \u, \U and \x values above 0xFF are reported as errors.
+static inline size_t charutil_unescape_c(char *dst, const char *src, size_t n, size_t *err_pos)
+{
+    static const charutil_set_t special = CHARUTIL_SET_LITERAL("\\");
+    size_t out = 0;
+    size_t i = 0;
+    for (;;)
+    {
+        const size_t run = charutil_unescape_run(dst + out, src + i, n - i, &special);
+        out += run;
+        i += run;
+        if (i == n)
+        {
+            return charutil_unescape_result(out, err_pos, n);
+        }
+        if (i + 1 == n)
+        {
+            return charutil_unescape_result(out, err_pos, i);
+        }
+        const unsigned char ch = (unsigned char)src[i + 1];
+        size_t used = 2;
+        int value;
+        switch (ch)
+        {
+            case 'a':
+                value = '\a';
+                break;
+            case 'b':
+                value = '\b';
+                break;
+            case 'f':
+                value = '\f';
+                break;
+            case 'n':
+                value = '\n';
+                break;
+            case 'r':
+                value = '\r';
+                break;
+            case 't':
+                value = '\t';
+                break;
+            case 'v':
+                value = '\v';
+                break;
+            case '\\':
+            case '\'':
+            case '"':
+            case '?':
+                value = ch;
+                break;
+            case 'x':
+                value = 0;
+                while (i + used < n && used < 4 && IS_HEX_DIGIT(src[i + used]))
+                {
+                    value = (value << 4) | HEX_TO_INT(src[i + used], 0);
+                    used++;
+                }
+                if (used == 2 || (i + used < n && IS_HEX_DIGIT(src[i + used])))
+                {
+                    return charutil_unescape_result(out, err_pos, i);
+                }
+                break;
+            default:
+                if (!IS_OCTAL(ch))
+                {
+                    return charutil_unescape_result(out, err_pos, i);
+                }
+                value = 0;
+                used = 1;
+                while (i + used < n && used < 4 && IS_OCTAL(src[i + used]))
+                {
+                    value = (value << 3) | FAST_ASCII_TO_OCTAL(src[i + used]);
+                    used++;
+                }
+                if (value > 0xFF)
+                {
+                    return charutil_unescape_result(out, err_pos, i);
+                }
+                break;
+        }
+        dst[out++] = (char)value;
+        i += used;
+    }
+}
+
+/// Value of the 4 hex digits at p, or -1
+static inline long charutil_parse_hex4(const char *p)
+{
+    uint64_t err = 0;
+    const long value = ((long)charutil_hex_pair_to_byte(p, &err) << 8) | charutil_hex_pair_to_byte(p + 2, &err);
+    return err ? -1 : value;
+}
+
+/// Writes code point cp (at most 0x10FFFF, not a surrogate) as UTF-8, returns the number of bytes
+static inline size_t charutil_utf8_encode(char *dst, uint32_t cp)
+{
+    if (cp < 0x80)
+    {
+        dst[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800)
+    {
+        dst[0] = (char)(0xC0 | (cp >> 6));
+        dst[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000)
+    {
+        dst[0] = (char)(0xE0 | (cp >> 12));
+        dst[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        dst[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    dst[0] = (char)(0xF0 | (cp >> 18));
+    dst[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    dst[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    dst[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+/// Decodes the body of a JSON string to UTF-8. \uXXXX surrogate pairs are combined. A lone surrogate,
+/// an unknown escape, or a raw '"' or control character is reported as an error.
+static inline size_t charutil_unescape_json(char *dst, const char *src, size_t n, size_t *err_pos)
+{
+    static const charutil_set_t special = CHARUTIL_SET_ROWS(0x03, 0x03, 0x07, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x23, 0x03, 0x03, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                                            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00);
+    size_t out = 0;
+    size_t i = 0;
+    for (;;)
+    {
+        const size_t run = charutil_unescape_run(dst + out, src + i, n - i, &special);
+        out += run;
+        i += run;
+        if (i == n)
+        {
+            return charutil_unescape_result(out, err_pos, n);
+        }
+        if (src[i] != '\\' || i + 1 == n)
+        {
+            return charutil_unescape_result(out, err_pos, i);
+        }
+        const char ch = src[i + 1];
+        if (ch == 'u')
+        {
+            long cp = (n - i >= 6) ? charutil_parse_hex4(src + i + 2) : -1;
+            size_t used = 6;
+            if (cp >= 0xD800 && cp <= 0xDBFF)
+            {
+                // A high surrogate must be followed by an escaped low surrogate
+                const long low = (n - i >= 12 && src[i + 6] == '\\' && src[i + 7] == 'u') ? charutil_parse_hex4(src + i + 8) : -1;
+                cp = (low >= 0xDC00 && low <= 0xDFFF) ? 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00) : -1;
+                used = 12;
+            }
+            if (cp < 0 || (cp >= 0xDC00 && cp <= 0xDFFF))
+            {
+                return charutil_unescape_result(out, err_pos, i);
+            }
+            out += charutil_utf8_encode(dst + out, (uint32_t)cp);
+            i += used;
+            continue;
+        }
+        char value;
+        switch (ch)
+        {
+            case '"':
+            case '\\':
+            case '/':
+                value = ch;
+                break;
+            case 'b':
+                value = '\b';
+                break;
+            case 'f':
+                value = '\f';
+                break;
+            case 'n':
+                value = '\n';
+                break;
+            case 'r':
+                value = '\r';
+                break;
+            case 't':
+                value = '\t';
+                break;
+            default:
+                return charutil_unescape_result(out, err_pos, i);
+        }
+        dst[out++] = value;
+        i += 2;
+    }
+}
+
+/// Decodes %HH escapes (either case). flags is charutil_percent_flags_t. A '%' without two hex digits is an error.
+static inline size_t charutil_percent_decode(char *dst, const char *src, size_t n, unsigned flags, size_t *err_pos)
+{
+    static const charutil_set_t percent = CHARUTIL_SET_LITERAL("%");
+    static const charutil_set_t percent_plus = CHARUTIL_SET_LITERAL("%+");
+    const charutil_set_t *special = (flags & CHARUTIL_PERCENT_PLUS_SPACE) ? &percent_plus : &percent;
+    size_t out = 0;
+    size_t i = 0;
+    for (;;)
+    {
+        const size_t run = charutil_unescape_run(dst + out, src + i, n - i, special);
+        out += run;
+        i += run;
+        if (i == n)
+        {
+            return charutil_unescape_result(out, err_pos, n);
+        }
+        if (src[i] == '+')
+        {
+            dst[out++] = ' ';
+            i++;
+            continue;
+        }
+        uint64_t err = n - i < 3;
+        const uint8_t value = err ? 0 : charutil_hex_pair_to_byte(src + i + 1, &err);
+        if (err)
+        {
+            return charutil_unescape_result(out, err_pos, i);
+        }
+        dst[out++] = (char)value;
+        i += 3;
+    }
+}
+
+/* ==========================
+ * UUID, MAC & IP Addresses
+ * ========================== */
+// Parsers and formatters for the fixed text forms of 128-bit UUIDs
+// (8-4-4-4-12 hex digits), 48-bit MAC addresses (6 hex pairs split by ':' or
+// '-') and IPv4/IPv6 addresses. Binary forms are byte arrays in network order.
+// Formatters write no NUL terminator and return the number of characters
+// written, at most the CHARUTIL_*_TEXT_* size. Parsers accept either hex case,
+// write their output only on success and return the number of characters
+// used, or 0 if src does not start with a valid address. Like
+// charutil_parse_u64(), IPv4 octets and IPv6 groups are read greedily, so
+// "1.2.3.456" fails rather than parsing as "1.2.3.45" followed by "6".
+// The fixed length UUID and MAC forms have SSE2 and NEON kernels that gather
+// the hex digits out from between the separators with whole vector byte
+// shifts and masks, then reuse the bulk hex nibble and join steps.
+
+#define CHARUTIL_UUID_TEXT_LEN 36 ///< "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx"
+#define CHARUTIL_MAC_TEXT_LEN 17  ///< "xx:xx:xx:xx:xx:xx"
+#define CHARUTIL_IPV4_TEXT_MAX 15 ///< "255.255.255.255"
+#define CHARUTIL_IPV6_TEXT_MAX 39 ///< "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff"
+
+/// Writes the 36 character form of uuid
+static inline size_t charutil_uuid_format_scalar(char *dst, const uint8_t uuid[16], charutil_hex_case_t hex_case)
+{
+    size_t out = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        if (i == 4 || i == 6 || i == 8 || i == 10)
+        {
+            dst[out++] = '-';
+        }
+        out += charutil_hex_encode_scalar(dst + out, uuid + i, 1, hex_case);
+    }
+    return out;
+}
+
+/// Parses the 36 characters at src, returns 1 on success
+static inline int charutil_uuid_parse_swar(uint8_t uuid[16], const char *src)
+{
+    uint64_t err = (src[8] != '-') | (src[13] != '-') | (src[18] != '-') | (src[23] != '-');
+    const uint32_t time_low = charutil_hex_decode_u32(src, &err);
+    const uint32_t node_low = charutil_hex_decode_u32(src + 28, &err);
+    uint8_t out[16] = {(uint8_t)(time_low >> 24), (uint8_t)(time_low >> 16), (uint8_t)(time_low >> 8), (uint8_t)time_low};
+    out[4] = charutil_hex_pair_to_byte(src + 9, &err);
+    out[5] = charutil_hex_pair_to_byte(src + 11, &err);
+    out[6] = charutil_hex_pair_to_byte(src + 14, &err);
+    out[7] = charutil_hex_pair_to_byte(src + 16, &err);
+    out[8] = charutil_hex_pair_to_byte(src + 19, &err);
+    out[9] = charutil_hex_pair_to_byte(src + 21, &err);
+    out[10] = charutil_hex_pair_to_byte(src + 24, &err);
+    out[11] = charutil_hex_pair_to_byte(src + 26, &err);
+    out[12] = (uint8_t)(node_low >> 24);
+    out[13] = (uint8_t)(node_low >> 16);
+    out[14] = (uint8_t)(node_low >> 8);
+    out[15] = (uint8_t)node_low;
+    if (err)
+    {
+        return 0;
+    }
+    memcpy(uuid, out, 16);
+    return 1;
+}
+
+/// Writes the 17 character form of mac with sep between the pairs
+static inline size_t charutil_mac_format_scalar(char *dst, const uint8_t mac[6], char sep, charutil_hex_case_t hex_case)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        charutil_hex_encode_scalar(dst + 3 * i, mac + i, 1, hex_case);
+        if (i < 5)
+        {
+            dst[3 * i + 2] = sep;
+        }
+    }
+    return CHARUTIL_MAC_TEXT_LEN;
+}
+
+/// Parses the 17 characters at src, returns 1 on success
+static inline int charutil_mac_parse_swar(uint8_t mac[6], const char *src)
+{
+    const char sep = src[2];
+    uint64_t err = (sep != ':' && sep != '-') | (src[5] != sep) | (src[8] != sep) | (src[11] != sep) | (src[14] != sep);
+    uint8_t out[6];
+    for (int i = 0; i < 6; i++)
+    {
+        out[i] = charutil_hex_pair_to_byte(src + 3 * i, &err);
+    }
+    if (err)
+    {
+        return 0;
+    }
+    memcpy(mac, out, 6);
+    return 1;
+}
+
+#if defined(CHARUTIL_HAVE_SSE2)
+static inline size_t charutil_uuid_format_sse2(char *dst, const uint8_t uuid[16], charutil_hex_case_t hex_case)
+{
+    const __m128i alpha_offset = _mm_set1_epi8(hex_case == CHARUTIL_HEX_UPPERCASE ? 'A' - '0' - 10 : 'a' - '0' - 10);
+    const __m128i v = _mm_loadu_si128((const __m128i *)uuid);
+    const __m128i hi = charutil_hex_ascii_sse2(_mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F)), alpha_offset);
+    const __m128i lo = charutil_hex_ascii_sse2(_mm_and_si128(v, _mm_set1_epi8(0x0F)), alpha_offset);
+    const __m128i a = _mm_unpacklo_epi8(hi, lo); // hex digits 0 - 15
+    const __m128i b = _mm_unpackhi_epi8(hi, lo); // hex digits 16 - 31
+    // dst[0..15] = a[0..7] '-' a[8..11] '-' a[12..13]
+    __m128i out = _mm_and_si128(a, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0));
+    out = _mm_or_si128(out, _mm_and_si128(_mm_slli_si128(a, 1), _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 0, -1, -1, -1, -1, 0, 0, 0)));
+    out = _mm_or_si128(out, _mm_and_si128(_mm_slli_si128(a, 2), _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1, -1)));
+    out = _mm_or_si128(out, _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, '-', 0, 0, 0, 0, '-', 0, 0));
+    _mm_storeu_si128((__m128i *)dst, out);
+    // dst[16..19] = a[14..15] '-' b[0], the rest is overwritten by the next store
+    out = _mm_or_si128(_mm_or_si128(_mm_srli_si128(a, 14), _mm_slli_si128(b, 3)), _mm_setr_epi8(0, 0, '-', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0));
+    _mm_storeu_si128((__m128i *)(dst + 16), out);
+    // dst[20..35] = b[1..3] '-' b[4..15]
+    out = _mm_and_si128(_mm_srli_si128(b, 1), _mm_setr_epi8(-1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0));
+    out = _mm_or_si128(out, _mm_and_si128(b, _mm_setr_epi8(0, 0, 0, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)));
+    out = _mm_or_si128(out, _mm_setr_epi8(0, 0, 0, '-', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0));
+    _mm_storeu_si128((__m128i *)(dst + 20), out);
+    return CHARUTIL_UUID_TEXT_LEN;
+}
+
+static inline int charutil_uuid_parse_sse2(uint8_t uuid[16], const char *src)
+{
+    const __m128i a = _mm_loadu_si128((const __m128i *)src);
+    const __m128i b = _mm_loadu_si128((const __m128i *)(src + 16));
+    const __m128i c = _mm_loadu_si128((const __m128i *)(src + 20));
+    const __m128i dash = _mm_set1_epi8('-');
+    const int dashes = (_mm_movemask_epi8(_mm_cmpeq_epi8(a, dash)) & 0x2100) | (_mm_movemask_epi8(_mm_cmpeq_epi8(b, dash)) & 0x0084);
+    // Hex digits 0 - 15 from src[0..7], src[9..12], src[14..17]
+    __m128i h0 = _mm_and_si128(a, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0));
+    h0 = _mm_or_si128(h0, _mm_and_si128(_mm_srli_si128(a, 1), _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, -1, -1, -1, -1, 0, 0, 0, 0)));
+    h0 = _mm_or_si128(h0, _mm_and_si128(_mm_srli_si128(a, 2), _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1, -1, 0, 0)));
+    h0 = _mm_or_si128(h0, _mm_slli_si128(b, 14));
+    // Hex digits 16 - 31 from src[19..22], src[24..35]
+    const __m128i h1 = _mm_or_si128(_mm_and_si128(_mm_srli_si128(b, 3), _mm_setr_epi8(-1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0)),
+                                    _mm_and_si128(c, _mm_setr_epi8(0, 0, 0, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)));
+    int valid = 0xFFFF;
+    const __m128i n0 = charutil_hex_nibbles_sse2(h0, &valid);
+    const __m128i n1 = charutil_hex_nibbles_sse2(h1, &valid);
+    if (valid != 0xFFFF || dashes != 0x2184)
+    {
+        return 0;
+    }
+    _mm_storeu_si128((__m128i *)uuid, _mm_packus_epi16(charutil_hex_join_sse2(n0), charutil_hex_join_sse2(n1)));
+    return 1;
+}
+
+static inline int charutil_mac_parse_sse2(uint8_t mac[6], const char *src)
+{
+    // Each pair starts at a multiple of 3, so src[1..16] lines the low digits up under the high ones
+    const __m128i a = _mm_loadu_si128((const __m128i *)src);
+    const __m128i b = _mm_loadu_si128((const __m128i *)(src + 1));
+    const int seps = _mm_movemask_epi8(_mm_cmpeq_epi8(a, _mm_set1_epi8(src[2]))) & 0x4924;
+    int valid_hi = 0xFFFF;
+    int valid_lo = 0xFFFF;
+    const __m128i hi = charutil_hex_nibbles_sse2(a, &valid_hi);
+    const __m128i lo = charutil_hex_nibbles_sse2(b, &valid_lo);
+    if ((valid_hi & valid_lo & 0x9249) != 0x9249 || seps != 0x4924 || (src[2] != ':' && src[2] != '-'))
+    {
+        return 0;
+    }
+    uint8_t bytes[16];
+    _mm_storeu_si128((__m128i *)bytes, _mm_or_si128(_mm_slli_epi16(hi, 4), lo));
+    for (int i = 0; i < 6; i++)
+    {
+        mac[i] = bytes[3 * i];
+    }
+    return 1;
+}
+#endif
+
+#if defined(CHARUTIL_HAVE_NEON)
+/// Lane masks for the NEON UUID kernels, in the order they are used
+static const uint8_t charutil_uuid_lanes_neon[8][16] = {
+    {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0, 0, 0, 0, 0, 0, 0, 0},          // 0 - 7
+    {0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF, 0xFF, 0xFF, 0, 0, 0, 0},                      // 8 - 11
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF, 0, 0},                            // 12 - 13
+    {0xFF, 0xFF, 0xFF, 0xFF, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},                      // 0 - 3
+    {0, 0, 0, 0, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}, // 4 - 15
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF, 0xFF, 0xFF, 0, 0, 0},                      // 9 - 12
+    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF},                            // 14 - 15
+    {0xFF, 0xFF, 0xFF, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},                         // 0 - 2
+};
+
+static inline size_t charutil_uuid_format_neon(char *dst, const uint8_t uuid[16], charutil_hex_case_t hex_case)
+{
+    const uint8x16_t alpha_offset = vdupq_n_u8(hex_case == CHARUTIL_HEX_UPPERCASE ? 'A' - '0' - 10 : 'a' - '0' - 10);
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t v = vld1q_u8(uuid);
+    const uint8x16x2_t ab = vzipq_u8(charutil_hex_ascii_neon(vshrq_n_u8(v, 4), alpha_offset), charutil_hex_ascii_neon(vandq_u8(v, vdupq_n_u8(0x0F)), alpha_offset));
+    const uint8x16_t a = ab.val[0];
+    const uint8x16_t b = ab.val[1];
+    uint8x16_t out = vandq_u8(a, vld1q_u8(charutil_uuid_lanes_neon[0]));
+    out = vorrq_u8(out, vandq_u8(vextq_u8(zero, a, 15), vld1q_u8(charutil_uuid_lanes_neon[5])));
+    out = vorrq_u8(out, vandq_u8(vextq_u8(zero, a, 14), vld1q_u8(charutil_uuid_lanes_neon[6])));
+    out = vsetq_lane_u8('-', vsetq_lane_u8('-', out, 8), 13);
+    vst1q_u8((uint8_t *)dst, out);
+    out = vorrq_u8(vextq_u8(a, zero, 14), vextq_u8(zero, b, 13));
+    out = vsetq_lane_u8('-', out, 2);
+    vst1q_u8((uint8_t *)dst + 16, out);
+    out = vorrq_u8(vandq_u8(vextq_u8(b, zero, 1), vld1q_u8(charutil_uuid_lanes_neon[7])), vandq_u8(b, vld1q_u8(charutil_uuid_lanes_neon[4])));
+    out = vsetq_lane_u8('-', out, 3);
+    vst1q_u8((uint8_t *)dst + 20, out);
+    return CHARUTIL_UUID_TEXT_LEN;
+}
+
+static inline int charutil_uuid_parse_neon(uint8_t uuid[16], const char *src)
+{
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t a = vld1q_u8((const uint8_t *)src);
+    const uint8x16_t b = vld1q_u8((const uint8_t *)src + 16);
+    const uint8x16_t c = vld1q_u8((const uint8_t *)src + 20);
+    uint8x16_t h0 = vandq_u8(a, vld1q_u8(charutil_uuid_lanes_neon[0]));
+    h0 = vorrq_u8(h0, vandq_u8(vextq_u8(a, zero, 1), vld1q_u8(charutil_uuid_lanes_neon[1])));
+    h0 = vorrq_u8(h0, vandq_u8(vextq_u8(a, zero, 2), vld1q_u8(charutil_uuid_lanes_neon[2])));
+    h0 = vorrq_u8(h0, vextq_u8(zero, b, 2));
+    const uint8x16_t h1 = vorrq_u8(vandq_u8(vextq_u8(b, zero, 3), vld1q_u8(charutil_uuid_lanes_neon[3])), vandq_u8(c, vld1q_u8(charutil_uuid_lanes_neon[4])));
+    uint8x16_t valid = vdupq_n_u8(0xFF);
+    const uint8x16_t n0 = charutil_hex_nibbles_neon(h0, &valid);
+    const uint8x16_t n1 = charutil_hex_nibbles_neon(h1, &valid);
+    const uint64x2_t valid64 = vreinterpretq_u64_u8(valid);
+    if ((vgetq_lane_u64(valid64, 0) & vgetq_lane_u64(valid64, 1)) != UINT64_MAX || src[8] != '-' || src[13] != '-' || src[18] != '-' || src[23] != '-')
+    {
+        return 0;
+    }
+    const uint8x16x2_t pairs = vuzpq_u8(n0, n1);
+    vst1q_u8(uuid, vorrq_u8(vshlq_n_u8(pairs.val[0], 4), pairs.val[1]));
+    return 1;
+}
+
+static inline int charutil_mac_parse_neon(uint8_t mac[6], const char *src)
+{
+    const char sep = src[2];
+    uint8x16_t valid = vdupq_n_u8(0xFF);
+    const uint8x16_t hi = charutil_hex_nibbles_neon(vld1q_u8((const uint8_t *)src), &valid);
+    const uint8x16_t lo = charutil_hex_nibbles_neon(vld1q_u8((const uint8_t *)src + 1), &valid);
+    uint8_t bytes[16];
+    uint8_t ok[16];
+    vst1q_u8(bytes, vorrq_u8(vshlq_n_u8(hi, 4), lo));
+    vst1q_u8(ok, valid);
+    int good = (sep == ':' || sep == '-');
+    for (int i = 0; i < 6; i++)
+    {
+        good &= (ok[3 * i] != 0) & (i == 5 || src[3 * i + 2] == sep);
+    }
+    if (!good)
+    {
+        return 0;
+    }
+    for (int i = 0; i < 6; i++)
+    {
+        mac[i] = bytes[3 * i];
+    }
+    return 1;
+}
+#endif
+
+/// Writes uuid as 36 characters ("123e4567-e89b-12d3-a456-426614174000"), returns CHARUTIL_UUID_TEXT_LEN
+static inline size_t charutil_uuid_format(char *dst, const uint8_t uuid[16], charutil_hex_case_t hex_case)
+{
+#if defined(CHARUTIL_HAVE_SSE2)
+    return charutil_uuid_format_sse2(dst, uuid, hex_case);
+#elif defined(CHARUTIL_HAVE_NEON)
+    return charutil_uuid_format_neon(dst, uuid, hex_case);
+#else
+    return charutil_uuid_format_scalar(dst, uuid, hex_case);
+#endif
+}
+
+/// Parses the 8-4-4-4-12 form at the start of src, returns CHARUTIL_UUID_TEXT_LEN or 0
+static inline size_t charutil_uuid_parse(uint8_t uuid[16], const char *src, size_t n)
+{
+    if (n < CHARUTIL_UUID_TEXT_LEN)
+    {
+        return 0;
+    }
+#if defined(CHARUTIL_HAVE_SSE2)
+    return charutil_uuid_parse_sse2(uuid, src) ? CHARUTIL_UUID_TEXT_LEN : 0;
+#elif defined(CHARUTIL_HAVE_NEON)
+    return charutil_uuid_parse_neon(uuid, src) ? CHARUTIL_UUID_TEXT_LEN : 0;
+#else
+    return charutil_uuid_parse_swar(uuid, src) ? CHARUTIL_UUID_TEXT_LEN : 0;
+#endif
+}
+
+/// Writes mac as 6 hex pairs split by sep (usually ':' or '-'), returns CHARUTIL_MAC_TEXT_LEN
+static inline size_t charutil_mac_format(char *dst, const uint8_t mac[6], char sep, charutil_hex_case_t hex_case)
+{
+    return charutil_mac_format_scalar(dst, mac, sep, hex_case);
+}
+
+/// Parses 6 hex pairs split by all ':' or all '-' at the start of src, returns CHARUTIL_MAC_TEXT_LEN or 0
+static inline size_t charutil_mac_parse(uint8_t mac[6], const char *src, size_t n)
+{
+    if (n < CHARUTIL_MAC_TEXT_LEN)
+    {
+        return 0;
+    }
+#if defined(CHARUTIL_HAVE_SSE2)
+    return charutil_mac_parse_sse2(mac, src) ? CHARUTIL_MAC_TEXT_LEN : 0;
+#elif defined(CHARUTIL_HAVE_NEON)
+    return charutil_mac_parse_neon(mac, src) ? CHARUTIL_MAC_TEXT_LEN : 0;
+#else
+    return charutil_mac_parse_swar(mac, src) ? CHARUTIL_MAC_TEXT_LEN : 0;
+#endif
+}
+
+/// Writes the decimal digits of an octet, returns how many
+static inline size_t charutil_format_octet(char *dst, unsigned v)
+{
+    const size_t len = 1 + (v >= 10) + (v >= 100);
+    dst[len - 1] = (char)('0' + v % 10);
+    if (len > 1)
+    {
+        dst[len - 2] = (char)('0' + v / 10 % 10);
+    }
+    if (len > 2)
+    {
+        dst[0] = (char)('0' + v / 100);
+    }
+    return len;
+}
+
+/// Reads a decimal octet (0 - 255, no leading zeros) at the start of p, returns the digits used or 0
+static inline size_t charutil_parse_octet(const char *p, size_t n, unsigned *value)
+{
+    size_t len = 0;
+    unsigned v = 0;
+    while (len < n && IS_DIGIT(p[len]))
+    {
+        if (len == 3)
+        {
+            return 0;
+        }
+        v = v * 10 + (unsigned)FAST_ASCII_TO_DIGIT(p[len]);
+        len++;
+    }
+    if (len == 0 || v > 255 || (len > 1 && p[0] == '0'))
+    {
+        return 0;
+    }
+    *value = v;
+    return len;
+}
+
+/// Writes addr in dotted decimal ("192.168.0.1"), returns the length
+static inline size_t charutil_ipv4_format(char *dst, const uint8_t addr[4])
+{
+    size_t out = charutil_format_octet(dst, addr[0]);
+    for (int i = 1; i < 4; i++)
+    {
+        dst[out++] = '.';
+        out += charutil_format_octet(dst + out, addr[i]);
+    }
+    return out;
+}
+
+/// Parses a dotted decimal address at the start of src. Octets are 1 to 3 digits without leading zeros.
+static inline size_t charutil_ipv4_parse(uint8_t addr[4], const char *src, size_t n)
+{
+    uint8_t out[4];
+    size_t i = 0;
+    for (int k = 0; k < 4; k++)
+    {
+        unsigned v = 0;
+        if (k > 0 && (i == n || src[i++] != '.'))
+        {
+            return 0;
+        }
+        const size_t used = charutil_parse_octet(src + i, n - i, &v);
+        if (!used)
+        {
+            return 0;
+        }
+        out[k] = (uint8_t)v;
+        i += used;
+    }
+    memcpy(addr, out, 4);
+    return i;
+}
+
+/// Writes addr in the RFC 5952 canonical form: lower case, no leading zeros, the longest run of two or
+/// more zero groups (the first on a tie) shortened to "::", and IPv4 mapped addresses as ::ffff:a.b.c.d
+static inline size_t charutil_ipv6_format(char *dst, const uint8_t addr[16])
+{
+    unsigned groups[8];
+    int best = -1;
+    int best_len = 1;
+    int run = 0;
+    for (int k = 0; k < 8; k++)
+    {
+        groups[k] = ((unsigned)addr[2 * k] << 8) | addr[2 * k + 1];
+        run = groups[k] ? 0 : run + 1;
+        if (run > best_len)
+        {
+            best = k + 1 - run;
+            best_len = run;
+        }
+    }
+
+    size_t out = 0;
+    if (best == 0 && best_len == 5 && groups[5] == 0xFFFF)
+    {
+        memcpy(dst, "::ffff:", 7);
+        return 7 + charutil_ipv4_format(dst + 7, addr + 12);
+    }
+    for (int k = 0; k < 8;)
+    {
+        if (k == best)
+        {
+            dst[out++] = ':';
+            dst[out++] = ':';
+            k += best_len;
+            continue;
+        }
+        if (k > 0 && k != best + best_len)
+        {
+            dst[out++] = ':';
+        }
+        for (int shift = (groups[k] >> 12) ? 12 : (groups[k] >> 8) ? 8 : (groups[k] >> 4) ? 4 : 0; shift >= 0; shift -= 4)
+        {
+            dst[out++] = (char)FAST_NIBBLE_TO_LOWERCASE_HEX((groups[k] >> shift) & 0xF);
+        }
+        k++;
+    }
+    return out;
+}
+
+/// Parses an RFC 4291 address at the start of src: 8 groups of 1 to 4 hex digits, one "::" standing for
+/// one or more zero groups, and optionally dotted decimal for the last 32 bits ("::ffff:10.0.0.1").
+/// Zone ("%eth0") and prefix ("/64") suffixes are not part of the address and stop the parse.
+static inline size_t charutil_ipv6_parse(uint8_t addr[16], const char *src, size_t n)
+{
+    uint8_t out[16] = {0};
+    int count = 0; // 16-bit groups seen
+    int gap = -1;  // Group index of the "::"
+    size_t i = 0;
+
+    if (n >= 2 && src[0] == ':' && src[1] == ':')
+    {
+        gap = 0;
+        i = 2;
+    }
+    while (i < n && IS_HEX_DIGIT(src[i]) && count < 8)
+    {
+        const size_t start = i;
+        unsigned value = 0;
+        for (; i < n && IS_HEX_DIGIT(src[i]); i++)
+        {
+            if (i - start == 4)
+            {
+                return 0;
+            }
+            value = (value << 4) | (unsigned)HEX_TO_INT(src[i], 0);
+        }
+        if (i < n && src[i] == '.')
+        {
+            // Embedded IPv4 fills the last two groups
+            const size_t used = (count <= 6) ? charutil_ipv4_parse(out + 2 * count, src + start, n - start) : 0;
+            if (!used)
+            {
+                return 0;
+            }
+            i = start + used;
+            count += 2;
+            break;
+        }
+        out[2 * count] = (uint8_t)(value >> 8);
+        out[2 * count + 1] = (uint8_t)value;
+        count++;
+        if (i + 1 < n && src[i] == ':' && src[i + 1] == ':' && gap < 0)
+        {
+            gap = count;
+            i += 2;
+        }
+        else if (i + 1 < n && src[i] == ':' && IS_HEX_DIGIT(src[i + 1]) && count < 8)
+        {
+            i++;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (gap < 0 ? count != 8 : count > 7)
+    {
+        return 0;
+    }
+    if (gap >= 0)
+    {
+        // Move the groups after the "::" to the end
+        const int tail = count - gap;
+        memmove(out + 16 - 2 * tail, out + 2 * gap, (size_t)(2 * tail));
+        memset(out + 2 * gap, 0, (size_t)(16 - 2 * count));
+    }
+    memcpy(addr, out, 16);
+    return i;
+}
+
+/* ==========================
+ * Keyword Lookup
+ * ========================== */
+// Perfect hash tables mapping ASCII keywords (HTTP methods and headers, config
+// keys, ...) to an enum value case insensitively. A lookup hashes the token a
+// word at a time with FAST_TO_LOWER applied to 8 bytes at once, reads the slot
+// number for the top hash bits and checks that one slot with a masked compare,
+// whatever the size of the table. Setting bit 5 also merges some non letters
+// (e.g. '\r' with '-'), which only costs hash quality: the slot check keeps
+// bit 5 significant for non letters.
+//
+// Slot 0 is always empty, so unused index entries need no test of their own.
+// Tables are built at start up by charutil_keyword_build(), or ahead of time by
+// `charutil keywords list.txt > list.h`, which writes the enum and static const
+// tables for the keywords in list.txt (one per line).
+
+#define CHARUTIL_KEYWORD_WORDS 4                              ///< Words compared per keyword
+#define CHARUTIL_KEYWORD_MAX_LEN (CHARUTIL_KEYWORD_WORDS * 8) ///< Longest keyword a table holds
+#define CHARUTIL_KEYWORD_MAX_COUNT 65535                      ///< Most keywords a table holds
+#define CHARUTIL_KEYWORD_FOLD 0x2020202020202020ull           ///< FAST_TO_LOWER of 8 bytes at once
+#ifndef CHARUTIL_KEYWORD_SEED_TRIES
+#define CHARUTIL_KEYWORD_SEED_TRIES 65536 ///< Seeds charutil_keyword_build() tries at each index size before doubling it
+#endif
+
+typedef struct
+{
+    uint64_t text[CHARUTIL_KEYWORD_WORDS]; ///< Keyword with letters lower cased, first character in the low byte, zero padded
+    uint64_t fold[CHARUTIL_KEYWORD_WORDS]; ///< 0x20 in each letter byte: a token matches when (word | fold) == text
+    uint32_t len;                          ///< 0 for the empty slot 0
+    int32_t value;                         ///< Returned by charutil_keyword_lookup() on a match
+} charutil_keyword_slot_t;
+
+typedef struct
+{
+    const charutil_keyword_slot_t *slots; ///< Empty slot 0, then one per keyword in the order given
+    const uint16_t *index;                ///< 1 << bits slot numbers, 0 where no keyword hashes
+    uint64_t seed;
+    unsigned bits;
+} charutil_keyword_table_t;
+
+/// Case folded hash of the (n + 7) / 8 words of a keyword or token. The index entry is the top table->bits bits.
+static inline uint64_t charutil_keyword_hash(const uint64_t *words, size_t n, uint64_t seed)
+{
+    const uint64_t k = 0x9E3779B97F4A7C15ull;
+    uint64_t h = seed ^ (n * k);
+    for (size_t i = 0; i * 8 < n; i++)
+    {
+        h = (h ^ (words[i] | CHARUTIL_KEYWORD_FOLD)) * k;
+        h ^= h >> 32;
+    }
+    h *= k;
+    return h ^ (h >> 29);
+}
+
+/// Value of the keyword matching p[0..n) in any letter case, else -1
+static inline int charutil_keyword_lookup(const charutil_keyword_table_t *table, const char *p, size_t n)
+{
+    if (n - 1 >= CHARUTIL_KEYWORD_MAX_LEN)
+    {
+        return -1; // Empty or longer than any keyword
+    }
+    char buf[CHARUTIL_KEYWORD_MAX_LEN] = {0};
+    uint64_t words[CHARUTIL_KEYWORD_WORDS];
+    memcpy(buf, p, n);
+    for (size_t i = 0; i < CHARUTIL_KEYWORD_WORDS; i++)
+    {
+        words[i] = charutil_hex_swar_load(buf + 8 * i);
+    }
+    const charutil_keyword_slot_t *slot = &table->slots[table->index[charutil_keyword_hash(words, n, table->seed) >> (64 - table->bits)]];
+    uint64_t diff = slot->len ^ n;
+    for (size_t i = 0; i * 8 < n; i++)
+    {
+        diff |= (words[i] | slot->fold[i]) ^ slot->text[i];
+    }
+    return diff ? -1 : slot->value;
+}
+
+/// Fills slot for the n characters of keyword at p
+static inline void charutil_keyword_slot_fill(charutil_keyword_slot_t *slot, const char *p, size_t n, int32_t value)
+{
+    memset(slot, 0, sizeof(*slot));
+    for (size_t k = 0; k < n; k++)
+    {
+        const unsigned char ch = (unsigned char)p[k];
+        slot->text[k / 8] |= (uint64_t)TO_LOWER(ch) << (8 * (k % 8));
+        slot->fold[k / 8] |= (uint64_t)(IS_ALPHA(ch) ? 0x20 : 0) << (8 * (k % 8));
+    }
+    slot->len = (uint32_t)n;
+    slot->value = value;
+}
+
+/// Builds a perfect hash table of count NUL terminated keywords: slots needs count + 1 entries and index a power of two
+/// entry count no larger than index_count. The smallest index with at least two entries per keyword is tried first, then
+/// doubled until a seed is found. values gives the value of each keyword, or NULL for its position. Returns 0 if a keyword is
+/// empty, longer than CHARUTIL_KEYWORD_MAX_LEN or a case insensitive duplicate, or if index_count runs out.
+static inline int charutil_keyword_build(charutil_keyword_table_t *table, charutil_keyword_slot_t *slots, uint16_t *index, size_t index_count, const char *const *keywords,
+                                         const int32_t *values, size_t count)
+{
+    if (count > CHARUTIL_KEYWORD_MAX_COUNT)
+    {
+        return 0;
+    }
+    memset(&slots[0], 0, sizeof(slots[0]));
+    for (size_t i = 0; i < count; i++)
+    {
+        const size_t n = strlen(keywords[i]);
+        if (n == 0 || n > CHARUTIL_KEYWORD_MAX_LEN)
+        {
+            return 0;
+        }
+        charutil_keyword_slot_fill(&slots[i + 1], keywords[i], n, values ? values[i] : (int32_t)i);
+    }
+    unsigned bits = 1;
+    while (((size_t)1 << bits) < 2 * count)
+    {
+        bits++;
+    }
+    for (; bits < 32 && ((size_t)1 << bits) <= index_count; bits++)
+    {
+        memset(index, 0, sizeof(*index) << bits);
+        for (uint64_t attempt = 1; attempt <= CHARUTIL_KEYWORD_SEED_TRIES; attempt++)
+        {
+            const uint64_t seed = attempt * 0xD6E8FEB86659FD93ull;
+            size_t placed = 0;
+            for (; placed < count; placed++)
+            {
+                const charutil_keyword_slot_t *slot = &slots[placed + 1];
+                uint16_t *entry = &index[charutil_keyword_hash(slot->text, slot->len, seed) >> (64 - bits)];
+                if (*entry)
+                {
+                    // The same keyword collides under every seed
+                    const charutil_keyword_slot_t *other = &slots[*entry];
+                    if (other->len == slot->len && memcmp(other->text, slot->text, sizeof(slot->text)) == 0 && memcmp(other->fold, slot->fold, sizeof(slot->fold)) == 0)
+                    {
+                        return 0;
+                    }
+                    break;
+                }
+                *entry = (uint16_t)(placed + 1);
+            }
+            if (placed == count)
+            {
+                table->slots = slots;
+                table->index = index;
+                table->seed = seed;
+                table->bits = bits;
+                return 1;
+            }
+            // Clear the entries this seed set
+            while (placed-- > 0)
+            {
+                index[charutil_keyword_hash(slots[placed + 1].text, slots[placed + 1].len, seed) >> (64 - bits)] = 0;
+            }
+        }
+    }
+    return 0;
+}
+
+/* ==========================
+ * Field Splitting
+ * ========================== */
+// Streaming CSV / delimited text tokenizer. charutil_split_update() returns
+// each field as an (offset, length) view into the chunk it was given, so
+// nothing is copied, and it can be fed a file one read() at a time.
+//
+// Each 64 byte block is turned into three bitmasks (quote, delimiter and
+// '\n') by a SIMD compare and movemask, or a byte loop without SIMD.
+// The prefix XOR of the quote mask is set for every byte inside quotes, so
+// delimiters and newlines between quotes are masked off without a branch per
+// byte. Its top bit carries the quote state into the next block and the next
+// chunk. The prefix XOR is a carry-less multiply by all ones: PCLMULQDQ when
+// the compiler targets it, else six shifts. A "" inside quotes toggles out and
+// back in with no structural byte in between, so RFC 4180 escaping needs no
+// special case.
+//
+// A field that runs past the end of a chunk comes back as a fragment with
+// CHARUTIL_FIELD_PARTIAL set, and the next field returned continues it, so a
+// record split between two reads needs no reassembly buffer. Records end at
+// '\n', and the '\r' of a "\r\n" is left out of the field before it. Any other
+// '\r' is field data, so a chunk that ends in '\r' outside quotes leaves that
+// byte unused until the next chunk shows whether a '\n' follows. An empty line
+// is a record of one empty field unless CHARUTIL_SPLIT_SKIP_BLANK_LINES is set.
+// Quoted fields are returned with their quotes. charutil_field_unquote()
+// removes them once a field is whole.
+
+#define CHARUTIL_SPLIT_NO_QUOTE (-1) ///< charutil_split_init() quote for text where no byte quotes
+
+typedef enum
+{
+    CHARUTIL_SPLIT_DEFAULT = 0,
+    CHARUTIL_SPLIT_SKIP_BLANK_LINES = 1 ///< Return nothing for an empty line instead of a record of one empty field
+} charutil_split_flags_t;
+
+typedef enum
+{
+    CHARUTIL_FIELD_END_RECORD = 1, ///< Last field of its record, ended by '\n', "\r\n" or charutil_split_finish()
+    CHARUTIL_FIELD_PARTIAL = 2,    ///< Reached the end of the chunk: the next field returned continues this one
+    CHARUTIL_FIELD_QUOTED = 4      ///< The field so far contains the quote byte, see charutil_field_unquote()
+} charutil_field_flags_t;
+
+typedef struct
+{
+    size_t offset; ///< Start of the field (or fragment) in the chunk passed to charutil_split_update() or charutil_split_finish()
+    size_t len;
+    unsigned flags; ///< CHARUTIL_FIELD_*
+} charutil_field_t;
+
+typedef struct
+{
+    uint8_t delim;
+    uint8_t quote;
+    int quoting;
+    unsigned flags;     ///< CHARUTIL_SPLIT_*
+    uint64_t in_quotes; ///< All ones when the last chunk ended inside quotes
+    int field_open;     ///< A fragment of the current field has been returned
+    int field_quoted;   ///< The current field has a quote byte before the current block
+    int record_open;    ///< The current record has a field or fragment returned
+} charutil_split_t;
+
+/// Quote bits in masks[0], delimiter bits in masks[1] and '\n' bits in masks[2] for the 64 bytes at p
+static inline void charutil_split_masks_scalar(const char *p, size_t blocks, uint8_t quote, uint8_t delim, uint64_t *masks)
+{
+    for (size_t b = 0; b < blocks; b++, p += 64, masks += 3)
+    {
+        masks[0] = masks[1] = masks[2] = 0;
+        for (unsigned k = 0; k < 64; k++)
+        {
+            const unsigned char ch = (unsigned char)p[k];
+            masks[0] |= (uint64_t)(ch == quote) << k;
+            masks[1] |= (uint64_t)(ch == delim) << k;
+            masks[2] |= (uint64_t)(ch == '\n') << k;
+        }
+    }
+}
+
+#if defined(CHARUTIL_HAVE_SSE2)
+static inline void charutil_split_masks_sse2(const char *p, size_t blocks, uint8_t quote, uint8_t delim, uint64_t *masks)
+{
+    const __m128i q = _mm_set1_epi8((char)quote);
+    const __m128i d = _mm_set1_epi8((char)delim);
+    const __m128i lf = _mm_set1_epi8('\n');
+    for (size_t b = 0; b < blocks; b++, p += 64, masks += 3)
+    {
+        masks[0] = masks[1] = masks[2] = 0;
+        for (unsigned k = 0; k < 4; k++)
+        {
+            const __m128i c = _mm_loadu_si128((const __m128i *)(p + 16 * k));
+            masks[0] |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(c, q)) << (16 * k);
+            masks[1] |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(c, d)) << (16 * k);
+            masks[2] |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(c, lf)) << (16 * k);
+        }
+    }
+}
+#endif
+
+#if defined(CHARUTIL_HAVE_AVX2)
+static inline CHARUTIL_TARGET_AVX2 void charutil_split_masks_avx2(const char *p, size_t blocks, uint8_t quote, uint8_t delim, uint64_t *masks)
+{
+    const __m256i q = _mm256_set1_epi8((char)quote);
+    const __m256i d = _mm256_set1_epi8((char)delim);
+    const __m256i lf = _mm256_set1_epi8('\n');
+    for (size_t b = 0; b < blocks; b++, p += 64, masks += 3)
+    {
+        const __m256i lo = _mm256_loadu_si256((const __m256i *)p);
+        const __m256i hi = _mm256_loadu_si256((const __m256i *)(p + 32));
+        masks[0] = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, q)) | (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, q)) << 32;
+        masks[1] = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, d)) | (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, d)) << 32;
+        masks[2] = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, lf)) | (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, lf)) << 32;
+    }
+}
+#endif
+
+#if defined(CHARUTIL_HAVE_NEON) && defined(__aarch64__)
+/// One bit per byte of four 0x00 / 0xFF compare results, first byte of m0 in bit 0
+static inline uint64_t charutil_bitmask64_neon(uint8x16_t m0, uint8x16_t m1, uint8x16_t m2, uint8x16_t m3)
+{
+    static const uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t w = vld1q_u8(weights);
+    uint8x16_t sum = vpaddq_u8(vpaddq_u8(vandq_u8(m0, w), vandq_u8(m1, w)), vpaddq_u8(vandq_u8(m2, w), vandq_u8(m3, w)));
+    sum = vpaddq_u8(sum, sum);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum), 0);
+}
+
+static inline void charutil_split_masks_neon(const char *p, size_t blocks, uint8_t quote, uint8_t delim, uint64_t *masks)
+{
+    const uint8x16_t q = vdupq_n_u8(quote);
+    const uint8x16_t d = vdupq_n_u8(delim);
+    const uint8x16_t lf = vdupq_n_u8('\n');
+    for (size_t b = 0; b < blocks; b++, p += 64, masks += 3)
+    {
+        const uint8x16_t c0 = vld1q_u8((const uint8_t *)p);
+        const uint8x16_t c1 = vld1q_u8((const uint8_t *)p + 16);
+        const uint8x16_t c2 = vld1q_u8((const uint8_t *)p + 32);
+        const uint8x16_t c3 = vld1q_u8((const uint8_t *)p + 48);
+        masks[0] = charutil_bitmask64_neon(vceqq_u8(c0, q), vceqq_u8(c1, q), vceqq_u8(c2, q), vceqq_u8(c3, q));
+        masks[1] = charutil_bitmask64_neon(vceqq_u8(c0, d), vceqq_u8(c1, d), vceqq_u8(c2, d), vceqq_u8(c3, d));
+        masks[2] = charutil_bitmask64_neon(vceqq_u8(c0, lf), vceqq_u8(c1, lf), vceqq_u8(c2, lf), vceqq_u8(c3, lf));
+    }
+}
+#endif
+
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+static inline void charutil_dispatch_split_masks(const char *p, size_t blocks, uint8_t quote, uint8_t delim, uint64_t *masks);
+#endif
+
+static inline void charutil_split_masks(const char *p, size_t blocks, uint8_t quote, uint8_t delim, uint64_t *masks)
+{
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+    charutil_dispatch_split_masks(p, blocks, quote, delim, masks);
+#elif defined(CHARUTIL_HAVE_AVX2)
+    charutil_split_masks_avx2(p, blocks, quote, delim, masks);
+#elif defined(CHARUTIL_HAVE_SSE2)
+    charutil_split_masks_sse2(p, blocks, quote, delim, masks);
+#elif defined(CHARUTIL_HAVE_NEON) && defined(__aarch64__)
+    charutil_split_masks_neon(p, blocks, quote, delim, masks);
+#else
+    charutil_split_masks_scalar(p, blocks, quote, delim, masks);
+#endif
+}
+
+/// Bit i of the result is the XOR of bits 0..i of x
+static inline uint64_t charutil_prefix_xor(uint64_t x)
+{
+#if defined(CHARUTIL_HAVE_PCLMUL)
+    return (uint64_t)_mm_cvtsi128_si64(_mm_clmulepi64_si128(_mm_set_epi64x(0, (int64_t)x), _mm_set1_epi8(-1), 0));
+#else
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+#endif
+}
+
+/// Fields end at delim, '\n' or "\r\n". quote is the byte that quotes fields, or CHARUTIL_SPLIT_NO_QUOTE. flags are CHARUTIL_SPLIT_*.
+static inline void charutil_split_init(charutil_split_t *st, char delim, int quote, unsigned flags)
+{
+    memset(st, 0, sizeof(*st));
+    st->delim = (uint8_t)delim;
+    st->flags = flags;
+    st->quoting = quote != CHARUTIL_SPLIT_NO_QUOTE;
+    // Without quoting any byte other than delim works, as its mask is dropped
+    st->quote = st->quoting ? (uint8_t)quote : (uint8_t)~st->delim;
+}
+
+/// Appends the field p[start..end) to fields unless it is an empty line to skip. Returns the new count.
+static inline size_t charutil_split_emit(charutil_split_t *st, charutil_field_t *fields, size_t count, size_t start, size_t end, unsigned flags)
+{
+    if ((st->flags & CHARUTIL_SPLIT_SKIP_BLANK_LINES) && end == start && (flags & CHARUTIL_FIELD_END_RECORD) && !st->record_open && !st->field_open)
+    {
+        return count;
+    }
+    fields[count].offset = start;
+    fields[count].len = end - start;
+    fields[count].flags = flags | (st->field_quoted ? CHARUTIL_FIELD_QUOTED : 0);
+    st->field_open = (flags & CHARUTIL_FIELD_PARTIAL) != 0;
+    st->field_quoted = st->field_open && st->field_quoted;
+    st->record_open = !(flags & CHARUTIL_FIELD_END_RECORD);
+    return count + 1;
+}
+
+/// Shared body of charutil_split_update() and charutil_split_finish(). last ends the input after p[0..n).
+static inline size_t charutil_split_run(charutil_split_t *st, const char *p, size_t n, charutil_field_t *fields, size_t max_fields, size_t *used, int last)
+{
+    enum
+    {
+        BATCH = 16 ///< Blocks whose masks are built per kernel call
+    };
+    uint64_t masks[3 * BATCH];
+    size_t count = 0;
+    size_t start = 0; // Start of the current field
+    size_t i = 0;
+    if (max_fields == 0)
+    {
+        *used = 0;
+        return 0;
+    }
+    while (i < n)
+    {
+        size_t blocks = (n - i) / 64;
+        blocks = (blocks < BATCH) ? blocks : (size_t)BATCH;
+        if (blocks)
+        {
+            charutil_split_masks(p + i, blocks, st->quote, st->delim, masks);
+        }
+        else
+        {
+            // Pad the tail to a block. Pad bytes may match, so their bits are masked off below.
+            char tail[64] = {0};
+            memcpy(tail, p + i, n - i);
+            charutil_split_masks(tail, 1, st->quote, st->delim, masks);
+            blocks = 1;
+        }
+        for (size_t b = 0; b < blocks; b++)
+        {
+            const size_t base = i + 64 * b;
+            const uint64_t valid = (n - base >= 64) ? UINT64_MAX : (1ull << (n - base)) - 1;
+            const uint64_t quotes = st->quoting ? masks[3 * b] & valid : 0;
+            const uint64_t inside = charutil_prefix_xor(quotes) ^ st->in_quotes;
+            uint64_t structural = (masks[3 * b + 1] | masks[3 * b + 2]) & ~inside & valid;
+            st->in_quotes = (uint64_t)0 - (inside >> 63);
+            while (structural)
+            {
+                const unsigned k = charutil_ctz64(structural);
+                const int newline = (masks[3 * b + 2] >> k) & 1;
+                // Quote bits of this block from the start of the field to k
+                const uint64_t field_bits = (start > base) ? UINT64_MAX << (start - base) : UINT64_MAX;
+                st->field_quoted |= (quotes & field_bits & ((1ull << k) - 1)) != 0;
+                // The '\r' of a "\r\n" belongs to the line ending. It is always in this chunk, see the hold back below.
+                const size_t end = (newline && base + k > start && p[base + k - 1] == '\r') ? base + k - 1 : base + k;
+                count = charutil_split_emit(st, fields, count, start, end, newline ? CHARUTIL_FIELD_END_RECORD : 0);
+                start = base + k + 1;
+                structural &= structural - 1;
+                if (count == max_fields)
+                {
+                    // start follows a delimiter or newline, so it is outside quotes
+                    st->in_quotes = 0;
+                    *used = start;
+                    return count;
+                }
+            }
+            if (start < base + 64)
+            {
+                st->field_quoted |= (quotes & ((start > base) ? UINT64_MAX << (start - base) : UINT64_MAX)) != 0;
+            }
+        }
+        i += 64 * blocks;
+    }
+    // A final '\r' of field data outside quotes may start a "\r\n" that the next chunk completes, so it waits for that
+    // chunk. A '\r' used as the delimiter or quote byte has been handled already.
+    const int held = !last && n > 0 && p[n - 1] == '\r' && !st->in_quotes && st->delim != '\r' && !(st->quoting && st->quote == '\r');
+    const size_t end = held ? n - 1 : n;
+    if (start < end || (last && (st->record_open || st->field_open)))
+    {
+        count = charutil_split_emit(st, fields, count, start, end, last ? CHARUTIL_FIELD_END_RECORD : CHARUTIL_FIELD_PARTIAL);
+    }
+    if (last)
+    {
+        st->in_quotes = 0;
+    }
+    *used = end;
+    return count;
+}
+
+/// Splits the n byte chunk p into at most max_fields fields. Returns the number written to fields and sets *used to the
+/// bytes consumed. That is n unless fields filled up first, or n - 1 when p ends in a '\r' outside quotes: either way
+/// the rest, p + *used, goes at the front of the next chunk.
+static inline size_t charutil_split_update(charutil_split_t *st, const char *p, size_t n, charutil_field_t *fields, size_t max_fields, size_t *used)
+{
+    return charutil_split_run(st, p, n, fields, max_fields, used, 0);
+}
+
+/// As charutil_split_update() for the last n bytes of the input, which may be none, and then ends the last record: its
+/// final field has CHARUTIL_FIELD_END_RECORD even without a newline after it. Call it again on p + *used while it
+/// returns max_fields fields.
+static inline size_t charutil_split_finish(charutil_split_t *st, const char *p, size_t n, charutil_field_t *fields, size_t max_fields, size_t *used)
+{
+    return charutil_split_run(st, p, n, fields, max_fields, used, 1);
+}
+
+/// Copies the n byte field src to dst without its quoting: each quote byte toggles quoting, and a doubled quote inside
+/// quotes is one literal quote. dst may be src. Returns the length written.
+static inline size_t charutil_field_unquote(char *dst, const char *src, size_t n, char quote)
+{
+    size_t out = 0;
+    int inside = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (src[i] != quote)
+        {
+            dst[out++] = src[i];
+        }
+        else if (inside && i + 1 < n && src[i + 1] == quote)
+        {
+            dst[out++] = quote;
+            i++;
+        }
+        else
+        {
+            inside = !inside;
+        }
+    }
+    return out;
+}
+
+/* ==========================
+ * UTF-8 Validation
+ * ========================== */
+// Streaming validator: IS_ASCII is only the first filter, multibyte sequences
+// are checked against RFC 3629 (no overlongs, surrogates or > U+10FFFF) in the
+// same pass. Feed chunks with charutil_utf8_update() and call
+// charutil_utf8_finish() at the end of the stream to reject a truncated tail.
+// ASCII runs are skipped 8/16/32 bytes at a time. With AVX2, or NEON on
+// AArch64, whole blocks of mixed text go through the lookup table validator of
+// Keiser and Lemire ("Validating UTF-8 In Less Than One Instruction Per
+// Byte"). SSE2 has no byte shuffle, so it keeps the scalar path. The scalar
+// state machine handles chunk edges and carries state between chunks.
+
+typedef struct
+{
+    uint8_t need;  ///< Continuation bytes still expected
+    uint8_t lo;    ///< Allowed range of the next continuation byte
+    uint8_t hi;    ///< ...
+    uint8_t error; ///< Sticky once an invalid sequence is seen
+} charutil_utf8_state_t;
+
+static inline void charutil_utf8_init(charutil_utf8_state_t *st)
+{
+    st->need = 0;
+    st->lo = 0x80;
+    st->hi = 0xBF;
+    st->error = 0;
+}
+
+/// Feeds one byte through the state machine
+static inline void charutil_utf8_step(charutil_utf8_state_t *st, unsigned char b)
+{
+    if (st->need)
+    {
+        st->error |= (b < st->lo || b > st->hi);
+        st->need--;
+        st->lo = 0x80;
+        st->hi = 0xBF;
+    }
+    else if (IS_ASCII(b))
+    {
+        return;
+    }
+    else if (b >= 0xC2 && b <= 0xDF)
+    {
+        st->need = 1;
+    }
+    else if (b >= 0xE0 && b <= 0xEF)
+    {
+        st->need = 2;
+        st->lo = (b == 0xE0) ? 0xA0 : 0x80; // overlong
+        st->hi = (b == 0xED) ? 0x9F : 0xBF; // surrogates
+    }
+    else if (b >= 0xF0 && b <= 0xF4)
+    {
+        st->need = 3;
+        st->lo = (b == 0xF0) ? 0x90 : 0x80; // overlong
+        st->hi = (b == 0xF4) ? 0x8F : 0xBF; // > U+10FFFF
+    }
+    else
+    {
+        st->error = 1;
+    }
+}
+
+/// True if all 8 bytes of x are ASCII
+static inline int charutil_swar_is_ascii(uint64_t x)
+{
+    return (x & 0x8080808080808080ull) == 0;
+}
+
+/// Where the scalar state machine resumes after whole blocks up to i: the start of a final sequence cut by the block edge
+static inline size_t charutil_utf8_block_resume(const unsigned char *p, size_t i)
+{
+    for (size_t back = 1; back <= 3 && back <= i; back++)
+    {
+        const unsigned char b = p[i - back];
+        if ((b & 0xC0) != 0x80)
+        {
+            return (b >= 0xC0) ? i - back : i;
+        }
+    }
+    return i;
+}
+
+#if defined(CHARUTIL_HAVE_AVX2)
+static inline CHARUTIL_TARGET_AVX2 __m256i charutil_utf8_prev_avx2(__m256i input, __m256i prev_input, int count)
+{
+    const __m256i shifted_in = _mm256_permute2x128_si256(prev_input, input, 0x21);
+    switch (count)
+    {
+        case 1:
+            return _mm256_alignr_epi8(input, shifted_in, 15);
+        case 2:
+            return _mm256_alignr_epi8(input, shifted_in, 14);
+        default:
+            return _mm256_alignr_epi8(input, shifted_in, 13);
+    }
+}
+
+static inline CHARUTIL_TARGET_AVX2 __m256i charutil_utf8_high_nibble_avx2(__m256i v)
+{
+    return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+}
+
+/// Validates whole 32 byte blocks starting at a sequence boundary. Returns how far the caller
+/// can resume with the scalar state machine (the start of any sequence cut off by the last block)
+static inline CHARUTIL_TARGET_AVX2 size_t charutil_utf8_validate_avx2(const unsigned char *p, size_t n, uint8_t *error)
+{
+    // Error bits, set by the first byte of a pair (high and low nibble) and cleared by the second
+    const char TOO_SHORT = 1 << 0;  // 11______ 0_______ or 11______ 11______
+    const char TOO_LONG = 1 << 1;   // 0_______ 10______
+    const char OVERLONG_3 = 1 << 2; // 11100000 100_____
+    const char TOO_LARGE = 1 << 3;  // 11110100 1001____ and above
+    const char SURROGATE = 1 << 4;  // 11101101 101_____
+    const char OVERLONG_2 = 1 << 5; // 1100000_ 10______
+    const char TOO_LARGE_1000 = 1 << 6;
+    const char OVERLONG_4 = 1 << 6;        // 11110000 1000____
+    const char TWO_CONTS = (char)(1 << 7); // 10______ 10______
+    const char CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+    const __m256i byte_1_high_table = _mm256_setr_epi8(TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+                                                       TOO_SHORT | OVERLONG_2, TOO_SHORT, TOO_SHORT | OVERLONG_3 | SURROGATE, TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4,
+                                                       TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+                                                       TOO_SHORT | OVERLONG_2, TOO_SHORT, TOO_SHORT | OVERLONG_3 | SURROGATE, TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+    const __m256i byte_1_low_table = _mm256_setr_epi8(CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, CARRY | OVERLONG_2, CARRY, CARRY, CARRY | TOO_LARGE, CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                                      CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                                      CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                                      CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                                      CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, CARRY | OVERLONG_2, CARRY, CARRY, CARRY | TOO_LARGE, CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                                      CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                                      CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                                      CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000);
+    const __m256i byte_2_high_table = _mm256_setr_epi8(TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                                                       TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4, TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+                                                       TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE, TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+                                                       TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                                                       TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4, TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+                                                       TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE, TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+                                                       TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+    // A lead byte in the last 3 positions of a block needs bytes from the next block
+    const __m256i incomplete_max = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+
+    __m256i prev_input = _mm256_setzero_si256();
+    __m256i prev_incomplete = _mm256_setzero_si256();
+    __m256i err = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        const __m256i input = _mm256_loadu_si256((const __m256i *)(p + i));
+        if (_mm256_movemask_epi8(input) == 0)
+        {
+            err = _mm256_or_si256(err, prev_incomplete);
+            prev_incomplete = _mm256_setzero_si256();
+        }
+        else
+        {
+            const __m256i prev1 = charutil_utf8_prev_avx2(input, prev_input, 1);
+            const __m256i byte_1_high = _mm256_shuffle_epi8(byte_1_high_table, charutil_utf8_high_nibble_avx2(prev1));
+            const __m256i byte_1_low = _mm256_shuffle_epi8(byte_1_low_table, _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)));
+            const __m256i byte_2_high = _mm256_shuffle_epi8(byte_2_high_table, charutil_utf8_high_nibble_avx2(input));
+            const __m256i special_cases = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+            // Third and fourth bytes of a sequence must be continuations, and nothing else may be
+            const __m256i is_third = _mm256_subs_epu8(charutil_utf8_prev_avx2(input, prev_input, 2), _mm256_set1_epi8(0xE0 - 0x80));
+            const __m256i is_fourth = _mm256_subs_epu8(charutil_utf8_prev_avx2(input, prev_input, 3), _mm256_set1_epi8((char)(0xF0 - 0x80)));
+            const __m256i must_be_continuation = _mm256_and_si256(_mm256_or_si256(is_third, is_fourth), _mm256_set1_epi8((char)0x80));
+
+            err = _mm256_or_si256(err, _mm256_xor_si256(must_be_continuation, special_cases));
+            prev_incomplete = _mm256_subs_epu8(input, incomplete_max);
+        }
+        prev_input = input;
+    }
+    *error |= !_mm256_testz_si256(err, err);
+    return charutil_utf8_block_resume(p, i);
+}
+#endif
+
+#if defined(CHARUTIL_HAVE_NEON) && defined(__aarch64__)
+/// charutil_utf8_validate_avx2() on 16 byte blocks, with vqtbl1q_u8 doing the nibble lookups
+static inline size_t charutil_utf8_validate_neon(const unsigned char *p, size_t n, uint8_t *error)
+{
+    enum
+    {
+        TOO_SHORT = 1 << 0,
+        TOO_LONG = 1 << 1,
+        OVERLONG_3 = 1 << 2,
+        TOO_LARGE = 1 << 3,
+        SURROGATE = 1 << 4,
+        OVERLONG_2 = 1 << 5,
+        TOO_LARGE_1000 = 1 << 6,
+        OVERLONG_4 = 1 << 6,
+        TWO_CONTS = 1 << 7,
+        CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS
+    };
+    static const uint8_t byte_1_high[16] = {TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+                                            TOO_SHORT | OVERLONG_2, TOO_SHORT, TOO_SHORT | OVERLONG_3 | SURROGATE, TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4};
+    static const uint8_t byte_1_low[16] = {CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, CARRY | OVERLONG_2, CARRY, CARRY, CARRY | TOO_LARGE, CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                           CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                           CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                           CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000};
+    static const uint8_t byte_2_high[16] = {TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                                            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4, TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+                                            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE, TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+                                            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT};
+    // A lead byte in the last 3 positions of a block needs bytes from the next block
+    static const uint8_t incomplete_max[16] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1};
+    const uint8x16_t byte_1_high_table = vld1q_u8(byte_1_high);
+    const uint8x16_t byte_1_low_table = vld1q_u8(byte_1_low);
+    const uint8x16_t byte_2_high_table = vld1q_u8(byte_2_high);
+    const uint8x16_t incomplete = vld1q_u8(incomplete_max);
+
+    uint8x16_t prev_input = vdupq_n_u8(0);
+    uint8x16_t prev_incomplete = vdupq_n_u8(0);
+    uint8x16_t err = vdupq_n_u8(0);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const uint8x16_t input = vld1q_u8(p + i);
+        if (vmaxvq_u8(input) < 0x80)
+        {
+            err = vorrq_u8(err, prev_incomplete);
+            prev_incomplete = vdupq_n_u8(0);
+        }
+        else
+        {
+            const uint8x16_t prev1 = vextq_u8(prev_input, input, 15);
+            const uint8x16_t byte_1_high_bits = vqtbl1q_u8(byte_1_high_table, vshrq_n_u8(prev1, 4));
+            const uint8x16_t byte_1_low_bits = vqtbl1q_u8(byte_1_low_table, vandq_u8(prev1, vdupq_n_u8(0x0F)));
+            const uint8x16_t byte_2_high_bits = vqtbl1q_u8(byte_2_high_table, vshrq_n_u8(input, 4));
+            const uint8x16_t special_cases = vandq_u8(vandq_u8(byte_1_high_bits, byte_1_low_bits), byte_2_high_bits);
+
+            const uint8x16_t is_third = vqsubq_u8(vextq_u8(prev_input, input, 14), vdupq_n_u8(0xE0 - 0x80));
+            const uint8x16_t is_fourth = vqsubq_u8(vextq_u8(prev_input, input, 13), vdupq_n_u8(0xF0 - 0x80));
+            const uint8x16_t must_be_continuation = vandq_u8(vorrq_u8(is_third, is_fourth), vdupq_n_u8(0x80));
+
+            err = vorrq_u8(err, veorq_u8(must_be_continuation, special_cases));
+            prev_incomplete = vqsubq_u8(input, incomplete);
+        }
+        prev_input = input;
+    }
+    *error |= vmaxvq_u8(err) != 0;
+    return charutil_utf8_block_resume(p, i);
+}
+#endif
+
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+static inline size_t charutil_dispatch_utf8_blocks(const unsigned char *p, size_t n, uint8_t *error);
+#endif
+
+/// Feeds a chunk. Returns 1 while everything seen so far is valid (possibly ending mid sequence), 0 once it is not.
+static inline int charutil_utf8_update(charutil_utf8_state_t *st, const void *data, size_t n)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    size_t i = 0;
+
+    // Finish a sequence carried over from the previous chunk
+    while (i < n && st->need)
+    {
+        charutil_utf8_step(st, p[i++]);
+    }
+
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+    if (n - i >= 64)
+    {
+        i += charutil_dispatch_utf8_blocks(p + i, n - i, &st->error);
+    }
+#elif defined(CHARUTIL_HAVE_AVX2)
+    if (n - i >= 64)
+    {
+        i += charutil_utf8_validate_avx2(p + i, n - i, &st->error);
+    }
+#elif defined(CHARUTIL_HAVE_NEON) && defined(__aarch64__)
+    if (n - i >= 64)
+    {
+        i += charutil_utf8_validate_neon(p + i, n - i, &st->error);
+    }
+#endif
+
+    while (i < n && !st->error)
+    {
+        if (!st->need)
+        {
+            // ASCII fast path
+#if defined(CHARUTIL_HAVE_SSE2)
+            while (i + 16 <= n && _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(p + i))) == 0)
+            {
+                i += 16;
+            }
+#endif
+            for (; i + 8 <= n; i += 8)
+            {
+                uint64_t w;
+                memcpy(&w, p + i, 8);
+                if (!charutil_swar_is_ascii(w))
+                {
+                    break;
+                }
+            }
+            if (i == n)
+            {
+                break;
+            }
+        }
+        charutil_utf8_step(st, p[i++]);
+    }
+    return !st->error;
+}
+
+/// Returns 1 if the stream fed so far is complete valid UTF-8 (no invalid or truncated sequence)
+static inline int charutil_utf8_finish(const charutil_utf8_state_t *st)
+{
+    return !st->error && !st->need;
+}
+
+/// One shot validation of a whole buffer
+static inline int charutil_utf8_validate(const void *data, size_t n)
+{
+    charutil_utf8_state_t st;
+    charutil_utf8_init(&st);
+    charutil_utf8_update(&st, data, n);
+    return charutil_utf8_finish(&st);
+}
+
+/* ==========================
+ * Runtime Dispatch
+ * ========================== */
+// With CHARUTIL_RUNTIME_DISPATCH defined, charutil_span_class(),
+// charutil_set_span(), charutil_case_buf(), charutil_hex_encode(),
+// charutil_hex_decode(), the base64 and class count block kernels and the
+// UTF-8 block validator call through a table of kernels picked on first use
+// from what the running CPU supports: AVX2 via cpuid on x86, NEON via
+// getauxval() on Linux ARM, otherwise SSE2 or the scalar path. Set the
+// CHARUTIL_TIER environment variable (scalar, sse2, avx2 or neon) or call
+// charutil_set_tier() to force a tier, e.g. to test or benchmark each one on a
+// single machine.
+// Each tier's kernels are a constant table, and the current one is published
+// through an atomic pointer, so threads racing on the first call just store
+// equivalent tables. That pointer is shared by every translation unit of the
+// program, so the tier is resolved once and charutil_set_tier() applies to all
+// of them. It must not run while other threads are calling the bulk functions.
+
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+#include <stdlib.h>
+#if defined(CHARUTIL_HAVE_AVX2) && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#if defined(CHARUTIL_HAVE_NEON) && defined(__linux__)
+#include <sys/auxv.h>
+#endif
+
+typedef enum
+{
+    CHARUTIL_TIER_SCALAR = 0,
+    CHARUTIL_TIER_SSE2 = 1,
+    CHARUTIL_TIER_AVX2 = 2,
+    CHARUTIL_TIER_NEON = 3,
+    CHARUTIL_TIER_COUNT
+} charutil_tier_t;
+
+typedef struct
+{
+    charutil_tier_t tier;
+    size_t (*span_class)(const char *p, size_t n, unsigned mask);
+    void (*case_buf)(char *dst, const char *src, size_t n, charutil_case_op_t op);
+    size_t (*hex_encode)(char *dst, const void *src, size_t n, charutil_hex_case_t hex_case);
+    size_t (*hex_decode)(void *dst, const char *src, size_t n, size_t *err_pos);
+    size_t (*utf8_blocks)(const unsigned char *p, size_t n, uint8_t *error);
+    size_t (*base64_encode)(char *dst, const unsigned char *src, size_t n, char c62, char c63);
+    size_t (*base64_decode)(unsigned char *dst, const char *src, size_t n, char c62, char c63);
+    size_t (*set_scan)(const char *p, size_t n, const charutil_set_t *set, int member);
+    size_t (*class_count)(const unsigned char *p, size_t n, uint64_t *classes);
+    void (*split_masks)(const char *p, size_t blocks, uint8_t quote, uint8_t delim, uint64_t *masks);
+} charutil_dispatch_t;
+
+// Acquire and release access to the current table, which also orders the first use of its kernels after the store
+#if defined(__GNUC__) || defined(__clang__)
+typedef const charutil_dispatch_t *charutil_dispatch_ptr_t;
+#define CHARUTIL_DISPATCH_LOAD(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define CHARUTIL_DISPATCH_STORE(p, table) __atomic_store_n((p), (table), __ATOMIC_RELEASE)
+#elif defined(_MSC_VER)
+#include <intrin.h>
+typedef const charutil_dispatch_t *volatile charutil_dispatch_ptr_t;
+#define CHARUTIL_DISPATCH_LOAD(p) ((const charutil_dispatch_t *)_InterlockedCompareExchangePointer((void *volatile *)(p), NULL, NULL))
+#define CHARUTIL_DISPATCH_STORE(p, table) ((void)_InterlockedExchangePointer((void *volatile *)(p), (void *)(table)))
+#else
+#include <stdatomic.h>
+typedef _Atomic(const charutil_dispatch_t *) charutil_dispatch_ptr_t;
+#define CHARUTIL_DISPATCH_LOAD(p) atomic_load_explicit((p), memory_order_acquire)
+#define CHARUTIL_DISPATCH_STORE(p, table) atomic_store_explicit((p), (table), memory_order_release)
+#endif
+
+// One pointer for the whole program, so charutil_set_tier() in any file switches every file. GCC and Clang emit a weak
+// and MSVC a selectany definition in each translation unit, which the linker merges into one. With other compilers
+// define CHARUTIL_DISPATCH_IMPLEMENTATION in exactly one file before including this header.
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((weak)) charutil_dispatch_ptr_t charutil_dispatch_current; ///< NULL until the first call resolves a tier
+#elif defined(_MSC_VER)
+__declspec(selectany) charutil_dispatch_ptr_t charutil_dispatch_current = NULL;
+#elif defined(CHARUTIL_DISPATCH_IMPLEMENTATION)
+charutil_dispatch_ptr_t charutil_dispatch_current;
+#else
+extern charutil_dispatch_ptr_t charutil_dispatch_current;
+#endif
+
+static const char *const charutil_tier_names[CHARUTIL_TIER_COUNT] = {"scalar", "sse2", "avx2", "neon"};
+
+static inline const char *charutil_tier_name(charutil_tier_t tier)
+{
+    return ((unsigned)tier < CHARUTIL_TIER_COUNT) ? charutil_tier_names[tier] : "unknown";
+}
+
+/// Tier matching a CHARUTIL_TIER value, or CHARUTIL_TIER_COUNT if the name is unknown
+static inline charutil_tier_t charutil_tier_from_name(const char *name)
+{
+    for (int tier = 0; tier < CHARUTIL_TIER_COUNT; tier++)
+    {
+        if (strcmp(name, charutil_tier_names[tier]) == 0)
+        {
+            return (charutil_tier_t)tier;
+        }
+    }
+    return CHARUTIL_TIER_COUNT;
+}
+
+#if defined(CHARUTIL_HAVE_AVX2)
+static inline int charutil_cpu_has_avx2(void)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#else
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7)
+    {
+        return 0;
+    }
+    // The OS must also save the YMM registers on a context switch
+    const int osxsave_avx = (1 << 27) | (1 << 28);
+    __cpuid(regs, 1);
+    if ((regs[2] & osxsave_avx) != osxsave_avx || (_xgetbv(0) & 6) != 6)
+    {
+        return 0;
+    }
+    __cpuidex(regs, 7, 0);
+    return (regs[1] >> 5) & 1;
+#endif
+}
+#endif
+
+#if defined(CHARUTIL_HAVE_NEON)
+/// NEON kernels are only built when the compiler targets NEON, so this mostly confirms it
+static inline int charutil_cpu_has_neon(void)
+{
+#if defined(__linux__) && defined(__aarch64__)
+    return (getauxval(AT_HWCAP) & (1ul << 1)) != 0; // HWCAP_ASIMD
+#elif defined(__linux__) && defined(__arm__)
+    return (getauxval(AT_HWCAP) & (1ul << 12)) != 0; // HWCAP_NEON
+#else
+    return 1;
+#endif
+}
+#endif
+
+/// Returns 1 if tier is compiled in and the running CPU supports it
+static inline int charutil_tier_supported(charutil_tier_t tier)
+{
+    switch (tier)
+    {
+        case CHARUTIL_TIER_SCALAR:
+            return 1;
+#if defined(CHARUTIL_HAVE_SSE2)
+        case CHARUTIL_TIER_SSE2:
+            return 1;
+#endif
+#if defined(CHARUTIL_HAVE_AVX2)
+        case CHARUTIL_TIER_AVX2:
+            return charutil_cpu_has_avx2();
+#endif
+#if defined(CHARUTIL_HAVE_NEON)
+        case CHARUTIL_TIER_NEON:
+            return charutil_cpu_has_neon();
+#endif
+        default:
+            return 0;
+    }
+}
+
+static inline charutil_tier_t charutil_best_tier(void)
+{
+    static const charutil_tier_t preference[] = {CHARUTIL_TIER_AVX2, CHARUTIL_TIER_SSE2, CHARUTIL_TIER_NEON};
+    for (size_t i = 0; i < sizeof(preference) / sizeof(preference[0]); i++)
+    {
+        if (charutil_tier_supported(preference[i]))
+        {
+            return preference[i];
+        }
+    }
+    return CHARUTIL_TIER_SCALAR;
+}
+
+/// Tiers without a block validator leave the whole buffer to the UTF-8 state machine
+static inline size_t charutil_utf8_validate_none(const unsigned char *p, size_t n, uint8_t *error)
+{
+    (void)p;
+    (void)n;
+    (void)error;
+    return 0;
+}
+
+/// Kernel table of a tier compiled in, else of the scalar tier
+static inline const charutil_dispatch_t *charutil_tier_table(charutil_tier_t tier)
+{
+    static const charutil_dispatch_t scalar = {CHARUTIL_TIER_SCALAR, charutil_span_class_scalar, charutil_case_buf_swar, charutil_hex_encode_scalar, charutil_hex_decode_swar,
+                                               charutil_utf8_validate_none, charutil_base64_encode_none, charutil_base64_decode_none, charutil_set_scan_scalar, charutil_class_count_none,
+                                               charutil_split_masks_scalar};
+    switch (tier)
+    {
+#if defined(CHARUTIL_HAVE_SSE2)
+        case CHARUTIL_TIER_SSE2:
+        {
+            static const charutil_dispatch_t sse2 = {CHARUTIL_TIER_SSE2, charutil_span_class_sse2, charutil_case_buf_sse2, charutil_hex_encode_sse2, charutil_hex_decode_sse2,
+                                                     charutil_utf8_validate_none, charutil_base64_encode_none, charutil_base64_decode_none, charutil_set_scan_scalar, charutil_class_count_sse2,
+                                                     charutil_split_masks_sse2};
+            return &sse2;
+        }
+#endif
+#if defined(CHARUTIL_HAVE_AVX2)
+        case CHARUTIL_TIER_AVX2:
+        {
+            static const charutil_dispatch_t avx2 = {CHARUTIL_TIER_AVX2, charutil_span_class_avx2, charutil_case_buf_avx2, charutil_hex_encode_avx2, charutil_hex_decode_avx2,
+                                                     charutil_utf8_validate_avx2, charutil_base64_encode_avx2, charutil_base64_decode_avx2, charutil_set_scan_avx2, charutil_class_count_avx2,
+                                                     charutil_split_masks_avx2};
+            return &avx2;
+        }
+#endif
+#if defined(CHARUTIL_HAVE_NEON) && defined(__aarch64__)
+        case CHARUTIL_TIER_NEON:
+        {
+            static const charutil_dispatch_t neon = {CHARUTIL_TIER_NEON, charutil_span_class_neon, charutil_case_buf_neon, charutil_hex_encode_neon, charutil_hex_decode_neon,
+                                                     charutil_utf8_validate_neon, charutil_base64_encode_neon, charutil_base64_decode_neon, charutil_set_scan_neon, charutil_class_count_neon,
+                                                     charutil_split_masks_neon};
+            return &neon;
+        }
+#elif defined(CHARUTIL_HAVE_NEON)
+        case CHARUTIL_TIER_NEON:
+        {
+            static const charutil_dispatch_t neon = {CHARUTIL_TIER_NEON, charutil_span_class_neon, charutil_case_buf_neon, charutil_hex_encode_neon, charutil_hex_decode_neon,
+                                                     charutil_utf8_validate_none, charutil_base64_encode_neon, charutil_base64_decode_neon, charutil_set_scan_scalar, charutil_class_count_neon,
+                                                     charutil_split_masks_scalar};
+            return &neon;
+        }
+#endif
+        default:
+            return &scalar;
+    }
+}
+
+/// Switches every dispatched function, in every translation unit, to tier. Returns 0 and changes nothing if the tier
+/// is not supported.
+/// Not safe to call while other threads are inside dispatched functions.
+static inline int charutil_set_tier(charutil_tier_t tier)
+{
+    if (!charutil_tier_supported(tier))
+    {
+        return 0;
+    }
+    CHARUTIL_DISPATCH_STORE(&charutil_dispatch_current, charutil_tier_table(tier));
+    return 1;
+}
+
+/// Resolves the table on first use: CHARUTIL_TIER from the environment if set and supported, otherwise the best tier
+static inline const charutil_dispatch_t *charutil_dispatch(void)
+{
+    const charutil_dispatch_t *table = CHARUTIL_DISPATCH_LOAD(&charutil_dispatch_current);
+    if (!table)
+    {
+        const char *env = getenv("CHARUTIL_TIER");
+        charutil_tier_t tier = env ? charutil_tier_from_name(env) : CHARUTIL_TIER_COUNT;
+        if (!charutil_tier_supported(tier))
+        {
+            tier = charutil_best_tier();
+        }
+        table = charutil_tier_table(tier);
+        CHARUTIL_DISPATCH_STORE(&charutil_dispatch_current, table);
+    }
+    return table;
+}
+
+static inline charutil_tier_t charutil_get_tier(void)
+{
+    return charutil_dispatch()->tier;
+}
+
+static inline size_t charutil_dispatch_span_class(const char *p, size_t n, unsigned mask)
+{
+    return charutil_dispatch()->span_class(p, n, mask);
+}
+
+static inline void charutil_dispatch_case_buf(char *dst, const char *src, size_t n, charutil_case_op_t op)
+{
+    charutil_dispatch()->case_buf(dst, src, n, op);
+}
+
+static inline size_t charutil_dispatch_hex_encode(char *dst, const void *src, size_t n, charutil_hex_case_t hex_case)
+{
+    return charutil_dispatch()->hex_encode(dst, src, n, hex_case);
+}
+
+static inline size_t charutil_dispatch_hex_decode(void *dst, const char *src, size_t n, size_t *err_pos)
+{
+    return charutil_dispatch()->hex_decode(dst, src, n, err_pos);
+}
+
+static inline size_t charutil_dispatch_utf8_blocks(const unsigned char *p, size_t n, uint8_t *error)
+{
+    return charutil_dispatch()->utf8_blocks(p, n, error);
+}
+
+static inline size_t charutil_dispatch_set_scan(const char *p, size_t n, const charutil_set_t *set, int member)
+{
+    return charutil_dispatch()->set_scan(p, n, set, member);
+}
+
+static inline size_t charutil_dispatch_class_count(const unsigned char *p, size_t n, uint64_t *classes)
+{
+    return charutil_dispatch()->class_count(p, n, classes);
+}
+
+static inline void charutil_dispatch_split_masks(const char *p, size_t blocks, uint8_t quote, uint8_t delim, uint64_t *masks)
+{
+    charutil_dispatch()->split_masks(p, blocks, quote, delim, masks);
+}
+
+static inline size_t charutil_dispatch_base64_encode(char *dst, const unsigned char *src, size_t n, char c62, char c63)
+{
+    return charutil_dispatch()->base64_encode(dst, src, n, c62, c63);
+}
+
+static inline size_t charutil_dispatch_base64_decode(unsigned char *dst, const char *src, size_t n, char c62, char c63)
+{
+    return charutil_dispatch()->base64_decode(dst, src, n, c62, c63);
+}
+#endif
+
+/* ==========================
+ * Parallel Bulk
+ * ========================== */
+// With CHARUTIL_PARALLEL defined (and -pthread), charutil_*_parallel() front
+// ends split very large buffers into CHARUTIL_PARALLEL_CHUNK sized pieces and
+// run the ordinary bulk function on each piece across a charutil_pool_t of
+// POSIX threads. The calling thread works too. Each chunk's output position is
+// known up front for the fixed ratio transforms (hex, case). The diagnostics
+// escaper sizes every chunk in a first pass and takes a prefix sum of the
+// lengths as the output offsets. Class counts are tallied per worker and summed.
+// Inputs under two chunks, or a NULL pool, run on the calling thread alone, so
+// the results always match the serial functions exactly. A pool runs one job
+// at a time: share it between threads only under a lock of your own.
+
+#if defined(CHARUTIL_PARALLEL)
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#ifndef CHARUTIL_PARALLEL_CHUNK
+#define CHARUTIL_PARALLEL_CHUNK (256u * 1024u) ///< Input bytes per task, sized to stay in a core's L2 cache. Must be even.
+#endif
+#if (CHARUTIL_PARALLEL_CHUNK) % 2 != 0 || (CHARUTIL_PARALLEL_CHUNK) <= 0
+#error "CHARUTIL_PARALLEL_CHUNK must be a positive even number, so that no chunk border splits a hex pair"
+#endif
+#define CHARUTIL_POOL_MAX_THREADS 64 ///< Most threads in a pool, counting the caller
+
+typedef struct charutil_pool
+{
+    pthread_mutex_t lock;
+    pthread_cond_t wake; ///< Workers sleep here until the generation changes
+    pthread_cond_t idle; ///< charutil_pool_run() waits here for busy workers
+    pthread_t threads[CHARUTIL_POOL_MAX_THREADS];
+    unsigned thread_count; ///< Worker threads, the caller is worker 0
+    unsigned started;      ///< Hands out worker numbers 1..thread_count
+    unsigned generation;   ///< Bumped for each job
+    unsigned busy;         ///< Workers inside the current job
+    int stop;
+    void (*run)(void *ctx, size_t task, unsigned worker);
+    void *ctx;
+    size_t tasks;
+    size_t next; ///< Next task to hand out
+} charutil_pool_t;
+
+/// Takes tasks of the current job until none are left. Called with the lock held.
+static inline void charutil_pool_drain(charutil_pool_t *pool, unsigned worker)
+{
+    while (pool->next < pool->tasks)
+    {
+        const size_t task = pool->next++;
+        void (*run)(void *, size_t, unsigned) = pool->run;
+        void *ctx = pool->ctx;
+        pthread_mutex_unlock(&pool->lock);
+        run(ctx, task, worker);
+        pthread_mutex_lock(&pool->lock);
+    }
+}
+
+static inline void *charutil_pool_worker(void *arg)
+{
+    charutil_pool_t *pool = (charutil_pool_t *)arg;
+    pthread_mutex_lock(&pool->lock);
+    const unsigned worker = ++pool->started;
+    unsigned seen = pool->generation;
+    for (;;)
+    {
+        while (!pool->stop && pool->generation == seen)
+        {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->stop)
+        {
+            break;
+        }
+        seen = pool->generation;
+        pool->busy++;
+        charutil_pool_drain(pool, worker);
+        if (--pool->busy == 0)
+        {
+            pthread_cond_signal(&pool->idle);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+/// Starts a pool of threads workers including the caller (0 for one per online CPU).
+/// Returns NULL if it cannot be set up; the *_parallel() functions accept NULL and run serially.
+static inline charutil_pool_t *charutil_pool_create(unsigned threads)
+{
+    if (threads == 0)
+    {
+        const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (cpus > 0) ? (unsigned)cpus : 1;
+    }
+    threads = (threads < CHARUTIL_POOL_MAX_THREADS) ? threads : CHARUTIL_POOL_MAX_THREADS;
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+    // Resolve the tier here, so the workers only ever read the published table
+    (void)charutil_dispatch();
+#endif
+
+    charutil_pool_t *pool = (charutil_pool_t *)calloc(1, sizeof(*pool));
+    if (!pool)
+    {
+        return NULL;
+    }
+    if (pthread_mutex_init(&pool->lock, NULL) != 0)
+    {
+        free(pool);
+        return NULL;
+    }
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+    // A thread that fails to start just leaves the pool smaller
+    while (pool->thread_count < threads - 1 && pthread_create(&pool->threads[pool->thread_count], NULL, charutil_pool_worker, pool) == 0)
+    {
+        pool->thread_count++;
+    }
+    return pool;
+}
+
+static inline void charutil_pool_destroy(charutil_pool_t *pool)
+{
+    if (!pool)
+    {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (unsigned i = 0; i < pool->thread_count; i++)
+    {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_cond_destroy(&pool->idle);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+/// Threads that take part in a job, counting the caller (1 for a NULL pool). Worker numbers are below this.
+static inline unsigned charutil_pool_size(const charutil_pool_t *pool)
+{
+    return pool ? pool->thread_count + 1 : 1;
+}
+
+/// Calls run(ctx, task, worker) for every task in 0..tasks-1 across the pool and returns when all are done
+static inline void charutil_pool_run(charutil_pool_t *pool, size_t tasks, void (*run)(void *ctx, size_t task, unsigned worker), void *ctx)
+{
+    if (!pool || pool->thread_count == 0 || tasks < 2)
+    {
+        for (size_t task = 0; task < tasks; task++)
+        {
+            run(ctx, task, 0);
+        }
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->run = run;
+    pool->ctx = ctx;
+    pool->tasks = tasks;
+    pool->next = 0;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    charutil_pool_drain(pool, 0);
+    while (pool->busy)
+    {
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/// Shared arguments of the *_parallel() jobs
+typedef struct
+{
+    const char *src;
+    char *dst;
+    size_t n;
+    size_t cap;
+    unsigned op;
+    size_t *offsets;                                ///< Diagnostics: chunk lengths, then output offsets
+    size_t err_task[CHARUTIL_POOL_MAX_THREADS];     ///< Hex decode: first failing chunk seen by each worker
+    size_t err_pos[CHARUTIL_POOL_MAX_THREADS];      ///< ... and the error position inside it
+    charutil_class_counts_t *counts;                ///< Class counts: one per worker
+    uint64_t *histograms;                           ///< ... and 256 bins per worker
+} charutil_parallel_job_t;
+
+static inline size_t charutil_parallel_tasks(size_t n)
+{
+    return (n + CHARUTIL_PARALLEL_CHUNK - 1) / CHARUTIL_PARALLEL_CHUNK;
+}
+
+/// Length of chunk task of an n byte input
+static inline size_t charutil_parallel_len(size_t n, size_t task)
+{
+    const size_t at = task * CHARUTIL_PARALLEL_CHUNK;
+    return (n - at < CHARUTIL_PARALLEL_CHUNK) ? n - at : CHARUTIL_PARALLEL_CHUNK;
+}
+
+static inline void charutil_parallel_hex_encode_task(void *ctx, size_t task, unsigned worker)
+{
+    const charutil_parallel_job_t *job = (const charutil_parallel_job_t *)ctx;
+    const size_t at = task * CHARUTIL_PARALLEL_CHUNK;
+    (void)worker;
+    charutil_hex_encode(job->dst + 2 * at, job->src + at, charutil_parallel_len(job->n, task), (charutil_hex_case_t)job->op);
+}
+
+/// charutil_hex_encode() split across pool
+static inline size_t charutil_hex_encode_parallel(charutil_pool_t *pool, char *dst, const void *src, size_t n, charutil_hex_case_t hex_case)
+{
+    charutil_parallel_job_t job;
+    job.src = (const char *)src;
+    job.dst = dst;
+    job.n = n;
+    job.op = (unsigned)hex_case;
+    charutil_pool_run(pool, charutil_parallel_tasks(n), charutil_parallel_hex_encode_task, &job);
+    return 2 * n;
+}
+
+static inline void charutil_parallel_hex_decode_task(void *ctx, size_t task, unsigned worker)
+{
+    charutil_parallel_job_t *job = (charutil_parallel_job_t *)ctx;
+    const size_t at = task * CHARUTIL_PARALLEL_CHUNK;
+    const size_t len = charutil_parallel_len(job->n, task);
+    size_t err_pos;
+    charutil_hex_decode(job->dst + at / 2, job->src + at, len, &err_pos);
+    // Tasks reach a worker in increasing order, so its first error is its lowest
+    if (err_pos < len && job->err_task[worker] == SIZE_MAX)
+    {
+        job->err_task[worker] = task;
+        job->err_pos[worker] = at + err_pos;
+    }
+}
+
+/// charutil_hex_decode() split across pool. Returns the same count and err_pos, but
+/// chunks after an error are still decoded, so dst past the returned count may be written.
+static inline size_t charutil_hex_decode_parallel(charutil_pool_t *pool, void *dst, const char *src, size_t n, size_t *err_pos)
+{
+    charutil_parallel_job_t job;
+    job.src = src;
+    job.dst = (char *)dst;
+    job.n = n;
+    for (unsigned w = 0; w < CHARUTIL_POOL_MAX_THREADS; w++)
+    {
+        job.err_task[w] = SIZE_MAX;
+    }
+    charutil_pool_run(pool, charutil_parallel_tasks(n), charutil_parallel_hex_decode_task, &job);
+
+    size_t first = n;
+    size_t first_task = SIZE_MAX;
+    for (unsigned w = 0; w < charutil_pool_size(pool); w++)
+    {
+        if (job.err_task[w] < first_task)
+        {
+            first_task = job.err_task[w];
+            first = job.err_pos[w];
+        }
+    }
+    if (err_pos)
+    {
+        *err_pos = first;
+    }
+    // Chunks are even, so the pairs before the error all decoded
+    return (first < n) ? first / 2 : n / 2;
+}
+
+static inline void charutil_parallel_case_task(void *ctx, size_t task, unsigned worker)
+{
+    const charutil_parallel_job_t *job = (const charutil_parallel_job_t *)ctx;
+    const size_t at = task * CHARUTIL_PARALLEL_CHUNK;
+    (void)worker;
+    charutil_case_buf(job->dst + at, job->src + at, charutil_parallel_len(job->n, task), (charutil_case_op_t)job->op);
+}
+
+/// charutil_case_buf() split across pool. dst may equal src.
+static inline void charutil_case_buf_parallel(charutil_pool_t *pool, char *dst, const char *src, size_t n, charutil_case_op_t op)
+{
+    charutil_parallel_job_t job;
+    job.src = src;
+    job.dst = dst;
+    job.n = n;
+    job.op = (unsigned)op;
+    charutil_pool_run(pool, charutil_parallel_tasks(n), charutil_parallel_case_task, &job);
+}
+
+static inline void charutil_parallel_class_counts_task(void *ctx, size_t task, unsigned worker)
+{
+    const charutil_parallel_job_t *job = (const charutil_parallel_job_t *)ctx;
+    const size_t at = task * CHARUTIL_PARALLEL_CHUNK;
+    charutil_class_counts_add(job->src + at, charutil_parallel_len(job->n, task), &job->counts[worker], job->histograms ? job->histograms + 256 * (size_t)worker : NULL);
+}
+
+/// charutil_class_counts() split across pool, each worker tallying its own counts and histogram
+static inline void charutil_class_counts_parallel(charutil_pool_t *pool, const void *src, size_t n, charutil_class_counts_t *counts, uint64_t *histogram)
+{
+    const unsigned workers = charutil_pool_size(pool);
+    charutil_class_counts_t worker_counts[CHARUTIL_POOL_MAX_THREADS];
+    uint64_t *histograms = histogram ? (uint64_t *)calloc(256 * (size_t)workers, sizeof(uint64_t)) : NULL;
+    if (workers == 1 || charutil_parallel_tasks(n) < 2 || (histogram && !histograms))
+    {
+        free(histograms);
+        charutil_class_counts(src, n, counts, histogram);
+        return;
+    }
+
+    charutil_parallel_job_t job;
+    memset(worker_counts, 0, workers * sizeof(worker_counts[0]));
+    job.src = (const char *)src;
+    job.n = n;
+    job.counts = worker_counts;
+    job.histograms = histograms;
+    charutil_pool_run(pool, charutil_parallel_tasks(n), charutil_parallel_class_counts_task, &job);
+
+    memset(counts, 0, sizeof(*counts));
+    for (unsigned w = 0; w < workers; w++)
+    {
+        counts->total += worker_counts[w].total;
+        for (int c = 0; c < CHARUTIL_CLASS_COUNT; c++)
+        {
+            counts->classes[c] += worker_counts[w].classes[c];
+        }
+    }
+    if (histogram)
+    {
+        for (int b = 0; b < 256; b++)
+        {
+            uint64_t sum = 0;
+            for (unsigned w = 0; w < workers; w++)
+            {
+                sum += histograms[256 * (size_t)w + b];
+            }
+            histogram[b] = sum;
+        }
+        free(histograms);
+    }
+}
+
+static inline void charutil_parallel_escape_size_task(void *ctx, size_t task, unsigned worker)
+{
+    const charutil_parallel_job_t *job = (const charutil_parallel_job_t *)ctx;
+    (void)worker;
+    job->offsets[task] = charutil_diagnostics_escape_at(NULL, 0, 0, job->src + task * CHARUTIL_PARALLEL_CHUNK, charutil_parallel_len(job->n, task));
+}
+
+static inline void charutil_parallel_escape_task(void *ctx, size_t task, unsigned worker)
+{
+    const charutil_parallel_job_t *job = (const charutil_parallel_job_t *)ctx;
+    (void)worker;
+    // Chunks whose output starts past the clip have nothing to write
+    if (job->offsets[task] + 1 < job->cap)
+    {
+        charutil_diagnostics_escape_at(job->dst, job->cap, job->offsets[task], job->src + task * CHARUTIL_PARALLEL_CHUNK, charutil_parallel_len(job->n, task));
+    }
+}
+
+/// charutil_diagnostics_escape() split across pool, with the same snprintf() style result and clipping
+static inline size_t charutil_diagnostics_escape_parallel(charutil_pool_t *pool, char *dst, size_t dst_cap, const void *src, size_t n)
+{
+    const size_t tasks = charutil_parallel_tasks(n);
+    size_t *offsets = (tasks >= 2 && charutil_pool_size(pool) > 1) ? (size_t *)malloc(tasks * sizeof(size_t)) : NULL;
+    if (!offsets)
+    {
+        return charutil_diagnostics_escape(dst, dst_cap, src, n);
+    }
+
+    charutil_parallel_job_t job;
+    job.src = (const char *)src;
+    job.dst = dst;
+    job.n = n;
+    job.cap = dst_cap;
+    job.offsets = offsets;
+    charutil_pool_run(pool, tasks, charutil_parallel_escape_size_task, &job);
+
+    // Exclusive prefix sum turns lengths into output offsets
+    size_t out = 0;
+    for (size_t task = 0; task < tasks; task++)
+    {
+        const size_t len = offsets[task];
+        offsets[task] = out;
+        out += len;
+    }
+    if (dst_cap > 0)
+    {
+        charutil_pool_run(pool, tasks, charutil_parallel_escape_task, &job);
+        dst[out < dst_cap ? out : dst_cap - 1] = '\0';
+    }
+    free(offsets);
+    return out;
 }
+#endif
 
 #endif // CHAR_UTILS_H
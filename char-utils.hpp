@@ -0,0 +1,594 @@
+/*
+    Char Utility C++ Wrapper
+    Author: Brian Khuu (2025)
+
+    # MIT License
+
+    Copyright (c) 2025 Brian Khuu
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+
+ */
+#ifndef CHAR_UTILS_HPP
+#define CHAR_UTILS_HPP
+
+/*
+ * C++17 wrapper over char-utils.h. Every macro becomes a constexpr function
+ * template that evaluates its argument once, so `charutil::is_hex_digit(*p++)`
+ * is safe, and the conversions that take a DEFAULT sentinel in C return a
+ * std::optional instead. The bodies expand the C macros on a local copy of
+ * the argument, so they compile to the same code and follow the
+ * CHARUTIL_USE_CLASS_TABLE setting.
+ *
+ * Single byte character types are read as unsigned char, so a byte above 0x7F
+ * is never negative. Wider types (int, wchar_t, char32_t, ...) are taken as
+ * their value, so EOF and code points above 0xFF belong to no class.
+ *
+ * The bulk functions take std::string_view (and std::span when built as
+ * C++20) and call the C kernels, so they use the same SIMD paths and runtime
+ * dispatch.
+ * */
+
+#include "char-utils.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#if __cplusplus >= 202002L
+#include <span>
+#endif
+
+namespace charutil
+{
+
+/* ==========================
+ * Character Type Checks
+ * ========================== */
+
+/// Restricts the per character templates to character and integer types, so strings go to the bulk overloads
+template <typename CharT>
+using if_char = std::enable_if_t<std::is_integral<CharT>::value, int>;
+
+/// Value of ch as the macros see it: single byte types as unsigned char, wider types as is
+template <typename CharT, if_char<CharT> = 0>
+constexpr std::uint32_t code(CharT ch) noexcept
+{
+    return (sizeof(CharT) == 1) ? static_cast<unsigned char>(ch) : static_cast<std::uint32_t>(ch);
+}
+
+#define CHARUTIL_HPP_DEFINE_CHECK(name, MACRO)                                                                                                                                                         \
+    template <typename CharT, if_char<CharT> = 0>                                                                                                                                                      \
+    constexpr bool name(CharT ch) noexcept                                                                                                                                                             \
+    {                                                                                                                                                                                                  \
+        const std::uint32_t c = charutil::code(ch);                                                                                                                                                    \
+        return MACRO(c);                                                                                                                                                                               \
+    }
+
+CHARUTIL_HPP_DEFINE_CHECK(is_binary, IS_BINARY)
+CHARUTIL_HPP_DEFINE_CHECK(is_octal, IS_OCTAL)
+CHARUTIL_HPP_DEFINE_CHECK(is_digit, IS_DIGIT)
+CHARUTIL_HPP_DEFINE_CHECK(is_lower, IS_LOWER)
+CHARUTIL_HPP_DEFINE_CHECK(is_upper, IS_UPPER)
+CHARUTIL_HPP_DEFINE_CHECK(is_alpha, IS_ALPHA)
+CHARUTIL_HPP_DEFINE_CHECK(is_alnum, IS_ALNUM)
+CHARUTIL_HPP_DEFINE_CHECK(is_hex_digit, IS_HEX_DIGIT)
+CHARUTIL_HPP_DEFINE_CHECK(is_printable, IS_PRINTABLE)
+CHARUTIL_HPP_DEFINE_CHECK(is_ascii, IS_ASCII)
+CHARUTIL_HPP_DEFINE_CHECK(is_extended_ascii, IS_EXTENDED_ASCII)
+CHARUTIL_HPP_DEFINE_CHECK(is_space, IS_SPACE)
+CHARUTIL_HPP_DEFINE_CHECK(is_punct, IS_PUNCT)
+CHARUTIL_HPP_DEFINE_CHECK(is_bracket, IS_BRACKET)
+CHARUTIL_HPP_DEFINE_CHECK(is_symbol, IS_SYMBOL)
+
+#undef CHARUTIL_HPP_DEFINE_CHECK
+
+/// True if ch belongs to any of the CHARUTIL_CLASS_* bits in mask
+template <typename CharT, if_char<CharT> = 0>
+constexpr bool is_class(CharT ch, unsigned mask) noexcept
+{
+    const std::uint32_t c = code(ch);
+    return CHARUTIL_IS_CLASS(c, mask);
+}
+
+/* ==========================
+ * Character Case Conversion
+ * ========================== */
+
+template <typename CharT, if_char<CharT> = 0>
+constexpr CharT to_upper(CharT ch) noexcept
+{
+    const std::uint32_t c = code(ch);
+    return IS_LOWER(c) ? static_cast<CharT>(c & ~(1u << 5)) : ch;
+}
+
+template <typename CharT, if_char<CharT> = 0>
+constexpr CharT to_lower(CharT ch) noexcept
+{
+    const std::uint32_t c = code(ch);
+    return IS_UPPER(c) ? static_cast<CharT>(c | (1u << 5)) : ch;
+}
+
+template <typename CharT, if_char<CharT> = 0>
+constexpr CharT toggle_case(CharT ch) noexcept
+{
+    const std::uint32_t c = code(ch);
+    return IS_ALPHA(c) ? static_cast<CharT>(c ^ (1u << 5)) : ch;
+}
+
+/* ==========================
+ * Digit & Hex Conversions
+ * ========================== */
+
+/// 0 or 1 for '0' or '1', else std::nullopt
+template <typename CharT, if_char<CharT> = 0>
+constexpr std::optional<std::uint8_t> ascii_to_binary(CharT ch) noexcept
+{
+    const std::uint32_t c = code(ch);
+    return IS_BINARY(c) ? std::optional<std::uint8_t>(static_cast<std::uint8_t>(FAST_ASCII_TO_BINARY(c))) : std::nullopt;
+}
+
+template <typename CharT, if_char<CharT> = 0>
+constexpr std::optional<std::uint8_t> ascii_to_octal(CharT ch) noexcept
+{
+    const std::uint32_t c = code(ch);
+    return IS_OCTAL(c) ? std::optional<std::uint8_t>(static_cast<std::uint8_t>(FAST_ASCII_TO_OCTAL(c))) : std::nullopt;
+}
+
+template <typename CharT, if_char<CharT> = 0>
+constexpr std::optional<std::uint8_t> ascii_to_digit(CharT ch) noexcept
+{
+    const std::uint32_t c = code(ch);
+    return IS_DIGIT(c) ? std::optional<std::uint8_t>(static_cast<std::uint8_t>(FAST_ASCII_TO_DIGIT(c))) : std::nullopt;
+}
+
+/// 0 to 15 for a hex digit of either case, else std::nullopt
+template <typename CharT, if_char<CharT> = 0>
+constexpr std::optional<std::uint8_t> hex_to_int(CharT ch) noexcept
+{
+    const std::uint32_t c = code(ch);
+    return IS_HEX_DIGIT(c) ? std::optional<std::uint8_t>(static_cast<std::uint8_t>(IS_DIGIT(c) ? c - '0' : (c | (1u << 5)) - 'a' + 10)) : std::nullopt;
+}
+
+constexpr std::optional<char> binary_to_ascii(unsigned num) noexcept
+{
+    return (num < 2) ? std::optional<char>(static_cast<char>(FAST_BINARY_TO_ASCII(num))) : std::nullopt;
+}
+
+constexpr std::optional<char> octal_to_ascii(unsigned num) noexcept
+{
+    return (num < 8) ? std::optional<char>(static_cast<char>(FAST_OCTAL_TO_ASCII(num))) : std::nullopt;
+}
+
+constexpr std::optional<char> digit_to_ascii(unsigned num) noexcept
+{
+    return (num < 10) ? std::optional<char>(static_cast<char>(FAST_DIGIT_TO_ASCII(num))) : std::nullopt;
+}
+
+constexpr std::optional<char> nibble_to_hex(unsigned nibble, charutil_hex_case_t hex_case = CHARUTIL_HEX_UPPERCASE) noexcept
+{
+    return (nibble < 16) ? std::optional<char>(static_cast<char>((hex_case == CHARUTIL_HEX_UPPERCASE) ? FAST_NIBBLE_TO_UPPERCASE_HEX(nibble) : FAST_NIBBLE_TO_LOWERCASE_HEX(nibble))) : std::nullopt;
+}
+
+constexpr std::uint8_t high_nibble(std::uint8_t byte) noexcept
+{
+    return static_cast<std::uint8_t>(HIGH_NIBBLE(byte));
+}
+
+constexpr std::uint8_t low_nibble(std::uint8_t byte) noexcept
+{
+    return static_cast<std::uint8_t>(LOW_NIBBLE(byte));
+}
+
+/* ==========================
+ * ASCII Diagnostic
+ * ========================== */
+
+constexpr std::string_view diagnostics(unsigned char ch) noexcept
+{
+    return charutil_diagnostics_slots[ch];
+}
+
+/* ==========================
+ * Compile Time Tables
+ * ========================== */
+// e.g. constexpr auto hex_values = charutil::make_table([](unsigned ch) { return charutil::hex_to_int(ch).value_or(0xFF); });
+
+/// 256 entry table holding fn(ch) for every byte value
+template <typename Fn>
+constexpr auto make_table(Fn fn) -> std::array<std::decay_t<decltype(fn(0u))>, 256>
+{
+    std::array<std::decay_t<decltype(fn(0u))>, 256> table{};
+    for (unsigned ch = 0; ch < 256; ch++)
+    {
+        table[ch] = fn(ch);
+    }
+    return table;
+}
+
+/// charutil_set_t of every byte value pred accepts
+template <typename Pred>
+constexpr charutil_set_t make_set_if(Pred pred) noexcept
+{
+    charutil_set_t set{};
+    for (unsigned ch = 0; ch < 256; ch++)
+    {
+        if (pred(ch))
+        {
+            set.rows[ch >> 7][ch & 0x0F] |= static_cast<std::uint8_t>(1u << CHARUTIL_SET_ROW_BIT(ch));
+        }
+    }
+    return set;
+}
+
+/// charutil_set_t of the bytes in chars, any length (CHARUTIL_SET_LITERAL() stops at 32)
+constexpr charutil_set_t make_set(std::string_view chars) noexcept
+{
+    charutil_set_t set{};
+    for (const char ch : chars)
+    {
+        const unsigned c = static_cast<unsigned char>(ch);
+        set.rows[c >> 7][c & 0x0F] |= static_cast<std::uint8_t>(1u << CHARUTIL_SET_ROW_BIT(c));
+    }
+    return set;
+}
+
+/// As charutil_set_contains(), but usable in constant expressions on a set built by make_set()
+constexpr bool contains(const charutil_set_t &set, unsigned char ch) noexcept
+{
+    return (set.rows[ch >> 7][ch & 0x0F] >> CHARUTIL_SET_ROW_BIT(ch)) & 1;
+}
+
+/* ==========================
+ * Bulk Buffer Functions
+ * ========================== */
+
+/// Length of the leading run of s in any of the CHARUTIL_CLASS_* bits in mask
+inline std::size_t span_class(std::string_view s, unsigned mask) noexcept
+{
+    return charutil_span_class(s.data(), s.size(), mask);
+}
+
+/// Length of the leading run of s in set
+inline std::size_t span(std::string_view s, const charutil_set_t &set) noexcept
+{
+    return charutil_set_span(s.data(), s.size(), &set);
+}
+
+/// Length of the leading run of s not in set, i.e. the index of the first member or s.size()
+inline std::size_t cspan(std::string_view s, const charutil_set_t &set) noexcept
+{
+    return charutil_set_cspan(s.data(), s.size(), &set);
+}
+
+inline std::string to_lower(std::string_view s)
+{
+    std::string out(s.size(), '\0');
+    charutil_to_lower_buf(&out[0], s.data(), s.size());
+    return out;
+}
+
+inline std::string to_upper(std::string_view s)
+{
+    std::string out(s.size(), '\0');
+    charutil_to_upper_buf(&out[0], s.data(), s.size());
+    return out;
+}
+
+inline std::string toggle_case(std::string_view s)
+{
+    std::string out(s.size(), '\0');
+    charutil_toggle_case_buf(&out[0], s.data(), s.size());
+    return out;
+}
+
+/// In place on any contiguous char buffer (std::string, std::vector<char>, std::span<char>, ...)
+template <typename Chars>
+inline void to_lower_inplace(Chars &&chars) noexcept
+{
+    static_assert(std::is_same<std::remove_reference_t<decltype(*std::data(chars))>, char>::value, "expects a contiguous range of char");
+    charutil_to_lower_inplace(std::data(chars), std::size(chars));
+}
+
+template <typename Chars>
+inline void to_upper_inplace(Chars &&chars) noexcept
+{
+    static_assert(std::is_same<std::remove_reference_t<decltype(*std::data(chars))>, char>::value, "expects a contiguous range of char");
+    charutil_to_upper_inplace(std::data(chars), std::size(chars));
+}
+
+/// ASCII case insensitive three way compare, shorter strings first on a common prefix
+inline int casecmp(std::string_view a, std::string_view b) noexcept
+{
+    const int cmp = charutil_casecmp(a.data(), b.data(), (a.size() < b.size()) ? a.size() : b.size());
+    return (cmp != 0) ? cmp : (a.size() < b.size()) ? -1 : (a.size() > b.size()) ? 1 : 0;
+}
+
+inline bool iequals(std::string_view a, std::string_view b) noexcept
+{
+    return a.size() == b.size() && charutil_casecmp(a.data(), b.data(), a.size()) == 0;
+}
+
+inline std::uint64_t casehash(std::string_view s) noexcept
+{
+    return charutil_casehash(s.data(), s.size());
+}
+
+/// Natural order three way compare, digit runs by value ("file9" < "file10")
+inline int natural_cmp(std::string_view a, std::string_view b, unsigned flags = CHARUTIL_NATURAL_DEFAULT) noexcept
+{
+    return charutil_natural_cmp(a.data(), a.size(), b.data(), b.size(), flags);
+}
+
+/// Binary key whose std::string ordering is natural_cmp() ordering, to build once per element before sorting
+inline std::string natural_sortkey(std::string_view s, unsigned flags = CHARUTIL_NATURAL_DEFAULT)
+{
+    std::string key(charutil_natural_sortkey(nullptr, 0, s.data(), s.size(), flags), '\0');
+    charutil_natural_sortkey(&key[0], key.size(), s.data(), s.size(), flags);
+    return key;
+}
+
+/// Value of the keyword matching s in any letter case, else std::nullopt
+inline std::optional<int> keyword_lookup(const charutil_keyword_table_t &table, std::string_view s) noexcept
+{
+    const int value = charutil_keyword_lookup(&table, s.data(), s.size());
+    return (value < 0) ? std::nullopt : std::optional<int>(value);
+}
+
+/// Field text without its quoting, "" inside quotes becoming one quote
+inline std::string field_unquote(std::string_view field, char quote = '"')
+{
+    std::string out(field.size(), '\0');
+    out.resize(charutil_field_unquote(&out[0], field.data(), field.size(), quote));
+    return out;
+}
+
+/// Value of s if it is entirely digits of base 2, 8, 10 or 16 and fits, else std::nullopt
+inline std::optional<std::uint64_t> parse_u64(std::string_view s, unsigned base = 10) noexcept
+{
+    std::uint64_t value = 0;
+    if (s.empty() || charutil_parse_u64(s.data(), s.size(), base, &value) != s.size())
+    {
+        return std::nullopt;
+    }
+    return value;
+}
+
+/// As parse_u64() with an optional leading '-' or '+'
+inline std::optional<std::int64_t> parse_i64(std::string_view s, unsigned base = 10) noexcept
+{
+    std::int64_t value = 0;
+    if (s.empty() || charutil_parse_i64(s.data(), s.size(), base, &value) != s.size())
+    {
+        return std::nullopt;
+    }
+    return value;
+}
+
+inline std::string to_hex(std::uint64_t v, charutil_hex_case_t hex_case = CHARUTIL_HEX_UPPERCASE)
+{
+    char buf[CHARUTIL_U64_HEX_MAX];
+    return std::string(buf, charutil_format_u64_hex(buf, v, hex_case));
+}
+
+/// Hex decode, std::nullopt if s has an odd length or a non hex character
+inline std::optional<std::string> hex_decode(std::string_view s)
+{
+    std::string out(s.size() / 2, '\0');
+    std::size_t err_pos = 0;
+    charutil_hex_decode(&out[0], s.data(), s.size(), &err_pos);
+    if (err_pos != s.size()) // A dangling odd digit stops at s.size() - 1 too
+    {
+        return std::nullopt;
+    }
+    return out;
+}
+
+/// Base64 decode (flags as charutil_base64_flags_t), std::nullopt on an invalid or truncated input
+inline std::optional<std::string> base64_decode(std::string_view s, unsigned flags = CHARUTIL_BASE64_STANDARD)
+{
+    std::string out(CHARUTIL_BASE64_DECODED_MAX(s.size()), '\0');
+    std::size_t err_pos = 0;
+    out.resize(charutil_base64_decode(&out[0], s.data(), s.size(), flags, &err_pos));
+    if (err_pos != s.size())
+    {
+        return std::nullopt;
+    }
+    return out;
+}
+
+inline std::string diagnostics_escape(std::string_view s)
+{
+    std::string out(charutil_diagnostics_escape(nullptr, 0, s.data(), s.size()), '\0');
+    charutil_diagnostics_escape(&out[0], out.size() + 1, s.data(), s.size());
+    return out;
+}
+
+inline std::string escape_c(std::string_view s)
+{
+    std::string out(charutil_escape_c(nullptr, 0, s.data(), s.size()), '\0');
+    charutil_escape_c(&out[0], out.size() + 1, s.data(), s.size());
+    return out;
+}
+
+inline std::string escape_json(std::string_view s)
+{
+    std::string out(charutil_escape_json(nullptr, 0, s.data(), s.size()), '\0');
+    charutil_escape_json(&out[0], out.size() + 1, s.data(), s.size());
+    return out;
+}
+
+/// keep may be nullptr for the RFC 3986 unreserved characters
+inline std::string percent_encode(std::string_view s, const charutil_set_t *keep = nullptr, unsigned flags = CHARUTIL_PERCENT_DEFAULT)
+{
+    std::string out(charutil_percent_encode(nullptr, 0, s.data(), s.size(), keep, flags), '\0');
+    charutil_percent_encode(&out[0], out.size() + 1, s.data(), s.size(), keep, flags);
+    return out;
+}
+
+inline std::optional<std::string> unescape_c(std::string_view s)
+{
+    std::string out(s.size(), '\0');
+    std::size_t err_pos = 0;
+    out.resize(charutil_unescape_c(&out[0], s.data(), s.size(), &err_pos));
+    if (err_pos != s.size())
+    {
+        return std::nullopt;
+    }
+    return out;
+}
+
+inline std::optional<std::string> unescape_json(std::string_view s)
+{
+    std::string out(s.size(), '\0');
+    std::size_t err_pos = 0;
+    out.resize(charutil_unescape_json(&out[0], s.data(), s.size(), &err_pos));
+    if (err_pos != s.size())
+    {
+        return std::nullopt;
+    }
+    return out;
+}
+
+inline std::optional<std::string> percent_decode(std::string_view s, unsigned flags = CHARUTIL_PERCENT_DEFAULT)
+{
+    std::string out(s.size(), '\0');
+    std::size_t err_pos = 0;
+    out.resize(charutil_percent_decode(&out[0], s.data(), s.size(), flags, &err_pos));
+    if (err_pos != s.size())
+    {
+        return std::nullopt;
+    }
+    return out;
+}
+
+// Functions over binary data take std::string_view, and std::span of bytes in C++20
+namespace detail
+{
+
+inline std::string hex_encode(const void *data, std::size_t n, charutil_hex_case_t hex_case)
+{
+    std::string out(2 * n, '\0');
+    charutil_hex_encode(&out[0], data, n, hex_case);
+    return out;
+}
+
+inline std::string base64_encode(const void *data, std::size_t n, unsigned flags)
+{
+    std::string out(CHARUTIL_BASE64_ENCODED_MAX(n), '\0');
+    out.resize(charutil_base64_encode(&out[0], data, n, flags));
+    return out;
+}
+
+inline std::string hexdump(const void *data, std::size_t n, const charutil_hexdump_opts_t *opts)
+{
+    std::string out(charutil_hexdump(nullptr, 0, data, n, opts), '\0');
+    charutil_hexdump(&out[0], out.size() + 1, data, n, opts);
+    return out;
+}
+
+inline charutil_class_counts_t class_counts(const void *data, std::size_t n, std::array<std::uint64_t, 256> *histogram) noexcept
+{
+    charutil_class_counts_t counts;
+    charutil_class_counts(data, n, &counts, histogram ? histogram->data() : nullptr);
+    return counts;
+}
+
+} // namespace detail
+
+inline bool utf8_validate(std::string_view s) noexcept
+{
+    return charutil_utf8_validate(s.data(), s.size()) != 0;
+}
+
+inline std::string hex_encode(std::string_view s, charutil_hex_case_t hex_case = CHARUTIL_HEX_LOWERCASE)
+{
+    return detail::hex_encode(s.data(), s.size(), hex_case);
+}
+
+inline std::string base64_encode(std::string_view s, unsigned flags = CHARUTIL_BASE64_STANDARD)
+{
+    return detail::base64_encode(s.data(), s.size(), flags);
+}
+
+/// xxd style dump, opts may be nullptr for the xxd layout
+inline std::string hexdump(std::string_view s, const charutil_hexdump_opts_t *opts = nullptr)
+{
+    return detail::hexdump(s.data(), s.size(), opts);
+}
+
+inline charutil_class_counts_t class_counts(std::string_view s, std::array<std::uint64_t, 256> *histogram = nullptr) noexcept
+{
+    return detail::class_counts(s.data(), s.size(), histogram);
+}
+
+#if defined(__cpp_lib_span)
+inline bool utf8_validate(std::span<const unsigned char> bytes) noexcept
+{
+    return charutil_utf8_validate(bytes.data(), bytes.size()) != 0;
+}
+
+inline std::string hex_encode(std::span<const unsigned char> bytes, charutil_hex_case_t hex_case = CHARUTIL_HEX_LOWERCASE)
+{
+    return detail::hex_encode(bytes.data(), bytes.size(), hex_case);
+}
+
+inline std::string hex_encode(std::span<const std::byte> bytes, charutil_hex_case_t hex_case = CHARUTIL_HEX_LOWERCASE)
+{
+    return detail::hex_encode(bytes.data(), bytes.size(), hex_case);
+}
+
+inline std::string base64_encode(std::span<const unsigned char> bytes, unsigned flags = CHARUTIL_BASE64_STANDARD)
+{
+    return detail::base64_encode(bytes.data(), bytes.size(), flags);
+}
+
+inline std::string base64_encode(std::span<const std::byte> bytes, unsigned flags = CHARUTIL_BASE64_STANDARD)
+{
+    return detail::base64_encode(bytes.data(), bytes.size(), flags);
+}
+
+inline std::string hexdump(std::span<const unsigned char> bytes, const charutil_hexdump_opts_t *opts = nullptr)
+{
+    return detail::hexdump(bytes.data(), bytes.size(), opts);
+}
+
+inline std::string hexdump(std::span<const std::byte> bytes, const charutil_hexdump_opts_t *opts = nullptr)
+{
+    return detail::hexdump(bytes.data(), bytes.size(), opts);
+}
+
+inline charutil_class_counts_t class_counts(std::span<const unsigned char> bytes, std::array<std::uint64_t, 256> *histogram = nullptr) noexcept
+{
+    return detail::class_counts(bytes.data(), bytes.size(), histogram);
+}
+
+inline charutil_class_counts_t class_counts(std::span<const std::byte> bytes, std::array<std::uint64_t, 256> *histogram = nullptr) noexcept
+{
+    return detail::class_counts(bytes.data(), bytes.size(), histogram);
+}
+#endif
+
+} // namespace charutil
+
+#endif // CHAR_UTILS_HPP
@@ -0,0 +1,873 @@
+#define _POSIX_C_SOURCE 200809L
+#include "char-utils.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/* Command line front end for the bulk buffer functions
+ *
+ * Usage: charutil <command> [options] [file...]
+ * Regular files are mapped whole (with a sequential access hint) and walked in
+ * CLI_BLOCK sized windows. Pipes and terminals are read() into a buffer. No file
+ * or "-" reads stdin. Output is gathered as a list of large blocks and written
+ * with writev(). Printable runs of `escape` are written straight from the
+ * mapping without being copied. `make charutil` builds it with runtime dispatch.
+ * `keywords` is the generator for the keyword lookup tables of char-utils.h. */
+
+#define CLI_BLOCK (1u << 20)                                     ///< Input bytes handed to a command at a time
+#define CLI_STAGING (4u * CLI_BLOCK + CHARUTIL_HEXDUMP_LINE_MAX) ///< Output bytes buffered before a writev()
+#define CLI_MAX_IOV 1024                                         ///< Most blocks per writev(), lowered to IOV_MAX
+#define CLI_ZERO_COPY_MIN 32                                     ///< Shorter input runs are copied rather than referenced
+#define CLI_KEYWORD_INDEX (1u << 20)                             ///< Largest index `keywords` tries
+
+/* ==========================
+ * Output
+ * ========================== */
+// Output is a list of iovecs pointing into either the staging buffer or the
+// input itself. Referenced input must stay valid until the next cli_flush():
+// mappings always do, the read() path flushes before it refills its buffer.
+
+static struct
+{
+    struct iovec iov[CLI_MAX_IOV];
+    int iov_count;
+    int iov_max;
+    char *staging;
+    size_t staged;
+    int failed;
+} cli_out;
+
+static int cli_flush(void)
+{
+    struct iovec *iov = cli_out.iov;
+    int count = cli_out.iov_count;
+    while (count > 0 && !cli_out.failed)
+    {
+        const ssize_t written = writev(STDOUT_FILENO, iov, count);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            fprintf(stderr, "charutil: write: %s\n", strerror(errno));
+            cli_out.failed = 1;
+            break;
+        }
+        // Skip what went out, partly written blocks included
+        size_t left = (size_t)written;
+        while (count > 0 && left >= iov->iov_len)
+        {
+            left -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0)
+        {
+            iov->iov_base = (char *)iov->iov_base + left;
+            iov->iov_len -= left;
+        }
+    }
+    cli_out.iov_count = 0;
+    cli_out.staged = 0;
+    return !cli_out.failed;
+}
+
+/// Queues len bytes at p, merging with the previous block when they are adjacent
+static void cli_out_ref(const void *p, size_t len)
+{
+    if (len == 0)
+    {
+        return;
+    }
+    if (cli_out.iov_count > 0)
+    {
+        struct iovec *last = &cli_out.iov[cli_out.iov_count - 1];
+        if ((const char *)last->iov_base + last->iov_len == (const char *)p)
+        {
+            last->iov_len += len;
+            return;
+        }
+    }
+    if (cli_out.iov_count == cli_out.iov_max)
+    {
+        cli_flush();
+    }
+    cli_out.iov[cli_out.iov_count].iov_base = (void *)p;
+    cli_out.iov[cli_out.iov_count].iov_len = len;
+    cli_out.iov_count++;
+}
+
+/// Room for len output bytes in the staging buffer, flushing first if it or the iovec list is full. cli_out_commit()
+/// then always has a free iovec, as a flush there would leave its block pointing at staging that gets reused.
+static char *cli_out_reserve(size_t len)
+{
+    if (cli_out.staged + len > CLI_STAGING || cli_out.iov_count == cli_out.iov_max)
+    {
+        cli_flush();
+    }
+    return cli_out.staging + cli_out.staged;
+}
+
+/// Queues the first len bytes of the last reservation
+static void cli_out_commit(size_t len)
+{
+    cli_out_ref(cli_out.staging + cli_out.staged, len);
+    cli_out.staged += len;
+}
+
+static void cli_out_copy(const void *p, size_t len)
+{
+    memcpy(cli_out_reserve(len), p, len);
+    cli_out_commit(len);
+}
+
+/* ==========================
+ * Commands
+ * ========================== */
+// Each command sees its input as a run of blocks. block() gets n bytes that
+// start offset bytes into the file and returns how many it used. Commands
+// working in groups (3 bytes per base64 quad, one hexdump line) leave a partial
+// group for the next call unless last is set. Decoders carry their own state,
+// set up by begin().
+
+typedef struct
+{
+    // Options
+    int upper;
+    int url;
+    int keep_lines;
+    int diagnostics_gutter;
+    size_t width;
+    size_t group;
+    // Per file state
+    const char *path;
+    int failed;
+    size_t written;
+    charutil_class_counts_t counts;
+    uint64_t histogram[256];
+    charutil_utf8_state_t utf8;
+    charutil_base_decoder_t decoder;
+    int nibble;
+    char (*keywords)[CHARUTIL_KEYWORD_MAX_LEN + 1];
+    size_t keyword_count;
+    size_t keyword_cap;
+} cli_state_t;
+
+typedef struct
+{
+    const char *name;
+    const char *help;
+    void (*begin)(cli_state_t *st);
+    size_t (*block)(cli_state_t *st, const unsigned char *p, size_t n, uint64_t offset, int last);
+    void (*finish)(cli_state_t *st);
+} cli_command_t;
+
+static const charutil_set_t cli_space = CHARUTIL_SET_LITERAL(" \t\n\v\f\r");
+
+static void cli_fail(cli_state_t *st, const char *what, uint64_t offset)
+{
+    fprintf(stderr, "charutil: %s: %s at offset %llu\n", st->path, what, (unsigned long long)offset);
+    st->failed = 1;
+}
+
+/* stats */
+
+static size_t cli_stats_block(cli_state_t *st, const unsigned char *p, size_t n, uint64_t offset, int last)
+{
+    (void)offset;
+    (void)last;
+    charutil_class_counts_add(p, n, &st->counts, st->histogram);
+    charutil_utf8_update(&st->utf8, p, n);
+    return n;
+}
+
+static void cli_stats_finish(cli_state_t *st)
+{
+    static const char *const names[CHARUTIL_CLASS_COUNT] = {"binary", "octal", "digit", "lower", "upper", "alpha", "alnum", "hex_digit", "printable", "space", "punct", "bracket", "symbol", "ascii"};
+    const uint64_t total = st->counts.total;
+    const double scale = total ? 100.0 / (double)total : 0.0;
+    uint64_t control = 0;
+    for (unsigned ch = 0; ch < 128; ch++)
+    {
+        control += (!IS_PRINTABLE(ch) && !IS_SPACE(ch)) ? st->histogram[ch] : 0;
+    }
+    const uint64_t non_ascii = total - charutil_class_count(&st->counts, CHARUTIL_CLASS_ASCII);
+    const int utf8 = charutil_utf8_finish(&st->utf8);
+    // Text: no NULs, valid UTF-8 and at most 1 in 100 bytes a control character
+    const char *kind = (st->histogram[0] == 0 && utf8 && control * 100 <= total) ? (non_ascii ? "utf-8 text" : "ascii text") : "binary";
+
+    char report[2048];
+    int len = snprintf(report, sizeof(report), "%.512s: %llu bytes, %s\n", st->path, (unsigned long long)total, kind);
+    for (unsigned c = 0; c < CHARUTIL_CLASS_COUNT; c++)
+    {
+        len += snprintf(report + len, sizeof(report) - (size_t)len, "  %-14s %14llu %7.2f%%\n", names[c], (unsigned long long)st->counts.classes[c], (double)st->counts.classes[c] * scale);
+    }
+    const uint64_t non_printable = total - charutil_class_count(&st->counts, CHARUTIL_CLASS_PRINTABLE);
+    len += snprintf(report + len, sizeof(report) - (size_t)len, "  %-14s %14llu %7.2f%%\n", "non_printable", (unsigned long long)non_printable, (double)non_printable * scale);
+    len += snprintf(report + len, sizeof(report) - (size_t)len, "  %-14s %14llu %7.2f%%\n", "control", (unsigned long long)control, (double)control * scale);
+    len += snprintf(report + len, sizeof(report) - (size_t)len, "  %-14s %14llu %7.2f%%\n", "nul", (unsigned long long)st->histogram[0], (double)st->histogram[0] * scale);
+    len += snprintf(report + len, sizeof(report) - (size_t)len, "  %-14s %14llu %7.2f%%\n", "non_ascii", (unsigned long long)non_ascii, (double)non_ascii * scale);
+    len += snprintf(report + len, sizeof(report) - (size_t)len, "  %-14s %14s\n", "utf-8", utf8 ? "valid" : "invalid");
+    cli_out_copy(report, (size_t)len);
+}
+
+/* escape */
+
+static size_t cli_escape_block(cli_state_t *st, const unsigned char *p, size_t n, uint64_t offset, int last)
+{
+    (void)st;
+    (void)offset;
+    (void)last;
+    size_t i = 0;
+    while (i < n)
+    {
+        const size_t run = charutil_span_class((const char *)p + i, n - i, CHARUTIL_CLASS_PRINTABLE);
+        if (run >= CLI_ZERO_COPY_MIN)
+        {
+            cli_out_ref(p + i, run);
+        }
+        else
+        {
+            cli_out_copy(p + i, run);
+        }
+        i += run;
+        if (i < n)
+        {
+            const char *token = ascii_to_diagnostics(p[i]);
+            cli_out_copy(token, strlen(token));
+            if (p[i] == '\n' && st->keep_lines)
+            {
+                cli_out_copy("\n", 1);
+            }
+            i++;
+        }
+    }
+    return n;
+}
+
+/* lower, upper, toggle */
+
+static size_t cli_case_block(cli_state_t *st, const unsigned char *p, size_t n, charutil_case_op_t op)
+{
+    (void)st;
+    charutil_case_buf(cli_out_reserve(n), (const char *)p, n, op);
+    cli_out_commit(n);
+    return n;
+}
+
+static size_t cli_lower_block(cli_state_t *st, const unsigned char *p, size_t n, uint64_t offset, int last)
+{
+    (void)offset;
+    (void)last;
+    return cli_case_block(st, p, n, CHARUTIL_CASE_LOWER);
+}
+
+static size_t cli_upper_block(cli_state_t *st, const unsigned char *p, size_t n, uint64_t offset, int last)
+{
+    (void)offset;
+    (void)last;
+    return cli_case_block(st, p, n, CHARUTIL_CASE_UPPER);
+}
+
+static size_t cli_toggle_block(cli_state_t *st, const unsigned char *p, size_t n, uint64_t offset, int last)
+{
+    (void)offset;
+    (void)last;
+    return cli_case_block(st, p, n, CHARUTIL_CASE_TOGGLE);
+}
+
+/* hex, base64, base32 */
+
+/// Ends encoded text with a newline, as base64(1) and xxd -p do
+static void cli_encode_finish(cli_state_t *st)
+{
+    if (st->written)
+    {
+        cli_out_copy("\n", 1);
+    }
+}
+
+static size_t cli_hex_block(cli_state_t *st, const unsigned char *p, size_t n, uint64_t offset, int last)
+{
+    (void)offset;
+    (void)last;
+    const size_t len = charutil_hex_encode(cli_out_reserve(2 * n), p, n, st->upper ? CHARUTIL_HEX_UPPERCASE : CHARUTIL_HEX_LOWERCASE);
+    cli_out_commit(len);
+    st->written += len;
+    return n;
+}
+
+static size_t cli_base64_block(cli_state_t *st, const unsigned char *p, size_t n, uint64_t offset, int last)
+{
+    (void)offset;
+    const size_t take = last ? n : n - n % 3;
+    const size_t len = charutil_base64_encode(cli_out_reserve(CHARUTIL_BASE64_ENCODED_MAX(take)), p, take, st->url ? CHARUTIL_BASE64_URL : CHARUTIL_BASE64_STANDARD);
+    cli_out_commit(len);
+    st->written += len;
+    return take;
+}
+
+static size_t cli_base32_block(cli_state_t *st, const unsigned char *p, size_t n, uint64_t offset, int last)
+{
+    (void)offset;
+    const size_t take = last ? n : n - n % 5;
+    const size_t len = charutil_base32_encode(cli_out_reserve(CHARUTIL_BASE32_ENCODED_MAX(take)), p, take, 1);
+    cli_out_commit(len);
+    st->written += len;
+    return take;
+}
+
+/* unhex, unbase64, unbase32: whitespace between digits is skipped */
+
+static size_t cli_unhex_block(cli_state_t *st, const unsigned char *p, size_t n, uint64_t offset, int last)
+{
+    (void)last;
+    size_t i = 0;
+    while (i < n && !st->failed)
+    {
+        i += charutil_set_span((const char *)p + i, n - i, &cli_space);
+        size_t run = charutil_set_cspan((const char *)p + i, n - i, &cli_space);
+        if (run && st->nibble >= 0)
+        {
+            // Second digit of a pair split by whitespace or a block edge
+            const int lo = HEX_TO_INT(p[i], -1);
+            if (lo < 0)
+            {
+                cli_fail(st, "invalid hex digit", offset + i);
+                break;
+            }
+            *cli_out_reserve(1) = (char)(st->nibble << 4 | lo);
+            cli_out_commit(1);
+            st->nibble = -1;
+            i++;
+            run--;
+        }
+        size_t err_pos;
+        const size_t even = run & ~(size_t)1;
+        const size_t len = charutil_hex_decode(cli_out_reserve(even / 2), (const char *)p + i, even, &err_pos);
+        cli_out_commit(len);
+        if (err_pos < even)
+        {
+            cli_fail(st, "invalid hex digit", offset + i + err_pos);
+            break;
+        }
+        if (run & 1)
+        {
+            st->nibble = HEX_TO_INT(p[i + even], -1);
+            if (st->nibble < 0)
+            {
+                cli_fail(st, "invalid hex digit", offset + i + even);
+                break;
+            }
+        }
+        i += run;
+    }
+    return n;
+}
+
+static void cli_unhex_finish(cli_state_t *st)
+{
+    if (!st->failed && st->nibble >= 0)
+    {
+        fprintf(stderr, "charutil: %s: odd number of hex digits\n", st->path);
+        st->failed = 1;
+    }
+}
+
+static size_t cli_unbase_block(cli_state_t *st, const unsigned char *p, size_t n, uint64_t offset, int base32)
+{
+    size_t i = 0;
+    while (i < n && !st->failed)
+    {
+        i += charutil_set_span((const char *)p + i, n - i, &cli_space);
+        const size_t run = charutil_set_cspan((const char *)p + i, n - i, &cli_space);
+        const size_t fed = st->decoder.pos;
+        // Each update writes at most 3 bytes per 4 digits (5 per 8 for base32) plus what the carried digits complete
+        char *dst = cli_out_reserve(CHARUTIL_BASE64_DECODED_MAX(run) + 5);
+        const size_t len = base32 ? charutil_base32_decode_update(&st->decoder, dst, (const char *)p + i, run) : charutil_base64_decode_update(&st->decoder, dst, (const char *)p + i, run);
+        cli_out_commit(len);
+        if (st->decoder.error)
+        {
+            cli_fail(st, base32 ? "invalid base32 digit" : "invalid base64 digit", offset + i + (st->decoder.err_pos - fed));
+        }
+        i += run;
+    }
+    return n;
+}
+
+static void cli_unbase64_begin(cli_state_t *st)
+{
+    charutil_base64_decode_init(&st->decoder, st->url ? CHARUTIL_BASE64_URL : CHARUTIL_BASE64_STANDARD);
+}
+
+static size_t cli_unbase64_block(cli_state_t *st, const unsigned char *p, size_t n, uint64_t offset, int last)
+{
+    (void)last;
+    return cli_unbase_block(st, p, n, offset, 0);
+}
+
+static void cli_unbase32_begin(cli_state_t *st)
+{
+    charutil_base32_decode_init(&st->decoder);
+}
+
+static size_t cli_unbase32_block(cli_state_t *st, const unsigned char *p, size_t n, uint64_t offset, int last)
+{
+    (void)last;
+    return cli_unbase_block(st, p, n, offset, 1);
+}
+
+static void cli_unbase_finish(cli_state_t *st, int valid)
+{
+    if (!st->failed && !valid)
+    {
+        fprintf(stderr, "charutil: %s: truncated final group\n", st->path);
+        st->failed = 1;
+    }
+}
+
+static void cli_unbase64_finish(cli_state_t *st)
+{
+    cli_unbase_finish(st, charutil_base64_decode_finish(&st->decoder));
+}
+
+static void cli_unbase32_finish(cli_state_t *st)
+{
+    cli_unbase_finish(st, charutil_base32_decode_finish(&st->decoder));
+}
+
+/* dump */
+
+static int cli_dump_line(const char *line, size_t len, void *user)
+{
+    (void)user;
+    cli_out_copy(line, len);
+    return 0;
+}
+
+static size_t cli_dump_block(cli_state_t *st, const unsigned char *p, size_t n, uint64_t offset, int last)
+{
+    const size_t take = last ? n : n - n % st->width;
+    const charutil_hexdump_opts_t opts = {st->width, st->group, st->upper ? CHARUTIL_HEX_UPPERCASE : CHARUTIL_HEX_LOWERCASE,
+                                          st->diagnostics_gutter ? CHARUTIL_HEXDUMP_GUTTER_DIAGNOSTICS : CHARUTIL_HEXDUMP_GUTTER_DOTS, offset};
+    charutil_hexdump_lines(p, take, &opts, cli_dump_line, NULL);
+    return take;
+}
+
+/* keywords: one keyword per line in, a perfect hash table header out */
+
+static size_t cli_keywords_block(cli_state_t *st, const unsigned char *p, size_t n, uint64_t offset, int last)
+{
+    size_t start = 0;
+    while (start < n && !st->failed)
+    {
+        const unsigned char *newline = (const unsigned char *)memchr(p + start, '\n', n - start);
+        if (!newline && !last && n - start < CLI_BLOCK)
+        {
+            break; // The rest of the line comes with the next block
+        }
+        const size_t end = newline ? (size_t)(newline - p) : n;
+        size_t first = start + charutil_set_span((const char *)p + start, end - start, &cli_space);
+        size_t stop = end;
+        while (stop > first && charutil_set_contains(&cli_space, p[stop - 1]))
+        {
+            stop--;
+        }
+        if (stop > first && p[first] != '#')
+        {
+            if (stop - first > CHARUTIL_KEYWORD_MAX_LEN)
+            {
+                cli_fail(st, "keyword too long", offset + first);
+                break;
+            }
+            if (st->keyword_count == st->keyword_cap)
+            {
+                const size_t cap = st->keyword_cap ? 2 * st->keyword_cap : 64;
+                char(*grown)[CHARUTIL_KEYWORD_MAX_LEN + 1] = realloc(st->keywords, cap * sizeof(*grown));
+                if (!grown)
+                {
+                    cli_fail(st, "out of memory", offset + first);
+                    break;
+                }
+                st->keywords = grown;
+                st->keyword_cap = cap;
+            }
+            memcpy(st->keywords[st->keyword_count], p + first, stop - first);
+            st->keywords[st->keyword_count][stop - first] = '\0';
+            st->keyword_count++;
+        }
+        start = newline ? end + 1 : n;
+    }
+    return start;
+}
+
+static void cli_keywords_begin(cli_state_t *st)
+{
+    st->keyword_count = 0;
+}
+
+/// C identifier from s, non alphanumeric characters as '_' and letters in the given case
+static void cli_identifier(char *dst, const char *s, size_t n, charutil_case_op_t op)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        const unsigned char ch = (unsigned char)s[i];
+        dst[i] = IS_ALNUM(ch) ? (char)(op == CHARUTIL_CASE_UPPER ? TO_UPPER(ch) : TO_LOWER(ch)) : '_';
+    }
+    dst[n] = '\0';
+}
+
+static void cli_keywords_finish(cli_state_t *st)
+{
+    // Names start from the file name up to its first '.', e.g. http_methods.txt gives HTTP_METHODS_GET and http_methods_keywords
+    const char *base = strrchr(st->path, '/') ? strrchr(st->path, '/') + 1 : st->path;
+    size_t base_len = strcspn(base, ".");
+    if (strcmp(st->path, "(stdin)") == 0 || base_len == 0 || base_len > 64 || IS_DIGIT((unsigned char)base[0]))
+    {
+        base = "keyword";
+        base_len = 7;
+    }
+    char upper[65];
+    char lower[65];
+    cli_identifier(upper, base, base_len, CHARUTIL_CASE_UPPER);
+    cli_identifier(lower, base, base_len, CHARUTIL_CASE_LOWER);
+
+    const size_t count = st->keyword_count;
+    char(*names)[CHARUTIL_KEYWORD_MAX_LEN + 1] = malloc((count ? count : 1) * sizeof(*names));
+    const char **keywords = malloc((count ? count : 1) * sizeof(*keywords));
+    charutil_keyword_slot_t *slots = malloc((count + 1) * sizeof(*slots));
+    uint16_t *index = malloc(CLI_KEYWORD_INDEX * sizeof(*index));
+    charutil_keyword_table_t table = {NULL, NULL, 0, 0};
+    if (!names || !keywords || !slots || !index)
+    {
+        cli_fail(st, "out of memory", 0);
+    }
+    for (size_t i = 0; i < count && !st->failed; i++)
+    {
+        keywords[i] = st->keywords[i];
+        cli_identifier(names[i], st->keywords[i], strlen(st->keywords[i]), CHARUTIL_CASE_UPPER);
+        for (size_t j = 0; j < i; j++)
+        {
+            if (strcmp(names[i], names[j]) == 0)
+            {
+                fprintf(stderr, "charutil: %s: \"%s\" and \"%s\" both name %s_%s\n", st->path, st->keywords[j], st->keywords[i], upper, names[i]);
+                st->failed = 1;
+            }
+        }
+    }
+    if (!st->failed && !charutil_keyword_build(&table, slots, index, CLI_KEYWORD_INDEX, keywords, NULL, count))
+    {
+        fprintf(stderr, "charutil: %s: no perfect hash table for these keywords\n", st->path);
+        st->failed = 1;
+    }
+
+    char line[512];
+    int len = 0;
+    if (!st->failed)
+    {
+        len = snprintf(line, sizeof(line), "// Generated by charutil keywords: perfect hash table for charutil_keyword_lookup()\n#ifndef %s_KEYWORDS_H\n#define %s_KEYWORDS_H\n\n#include \"char-utils.h\"\n\nenum\n{\n", upper, upper);
+        cli_out_copy(line, (size_t)len);
+    }
+    for (size_t i = 0; i < count && !st->failed; i++)
+    {
+        len = snprintf(line, sizeof(line), "    %s_%s = %zu,\n", upper, names[i], i);
+        cli_out_copy(line, (size_t)len);
+    }
+    if (!st->failed)
+    {
+        len = snprintf(line, sizeof(line), "    %s_COUNT = %zu\n};\n\nstatic const charutil_keyword_slot_t %s_slots[%zu] = {\n    {{0}, {0}, 0, 0},\n", upper, count, lower, count + 1);
+        cli_out_copy(line, (size_t)len);
+        for (size_t i = 0; i < count; i++)
+        {
+            const charutil_keyword_slot_t *slot = &table.slots[i + 1];
+            char quoted[4 * CHARUTIL_KEYWORD_MAX_LEN + 1];
+            charutil_escape_c(quoted, sizeof(quoted), keywords[i], slot->len);
+            len = snprintf(line, sizeof(line), "    {{0x%016llxull, 0x%016llxull, 0x%016llxull, 0x%016llxull}, {0x%016llxull, 0x%016llxull, 0x%016llxull, 0x%016llxull}, %u, %s_%s}, // \"%s\"\n",
+                           (unsigned long long)slot->text[0], (unsigned long long)slot->text[1], (unsigned long long)slot->text[2], (unsigned long long)slot->text[3], (unsigned long long)slot->fold[0],
+                           (unsigned long long)slot->fold[1], (unsigned long long)slot->fold[2], (unsigned long long)slot->fold[3], (unsigned)slot->len, upper, names[i], quoted);
+            cli_out_copy(line, (size_t)len);
+        }
+        len = snprintf(line, sizeof(line), "};\n\nstatic const uint16_t %s_index[%zu] = {", lower, (size_t)1 << table.bits);
+        cli_out_copy(line, (size_t)len);
+        for (size_t i = 0; i < ((size_t)1 << table.bits); i++)
+        {
+            len = snprintf(line, sizeof(line), "%s%u,", (i % 16) ? " " : "\n    ", (unsigned)table.index[i]);
+            cli_out_copy(line, (size_t)len);
+        }
+        len = snprintf(line, sizeof(line), "\n};\n\nstatic const charutil_keyword_table_t %s_keywords = {%s_slots, %s_index, 0x%016llxull, %u};\n\n#endif // %s_KEYWORDS_H\n", lower, lower, lower,
+                       (unsigned long long)table.seed, table.bits, upper);
+        cli_out_copy(line, (size_t)len);
+    }
+    free(names);
+    free(keywords);
+    free(slots);
+    free(index);
+}
+
+static const cli_command_t cli_commands[] = {
+    {"stats", "class counts, control/NUL/non-ASCII totals, UTF-8 validity and a text/binary verdict", NULL, cli_stats_block, cli_stats_finish},
+    {"escape", "ascii_to_diagnostics() escaping, e.g. [CR][LF] (-l keeps line breaks)", NULL, cli_escape_block, NULL},
+    {"lower", "ASCII lower case", NULL, cli_lower_block, NULL},
+    {"upper", "ASCII upper case", NULL, cli_upper_block, NULL},
+    {"toggle", "swap ASCII case", NULL, cli_toggle_block, NULL},
+    {"hex", "hex encode (-u upper case)", NULL, cli_hex_block, cli_encode_finish},
+    {"unhex", "hex decode, whitespace skipped", NULL, cli_unhex_block, cli_unhex_finish},
+    {"base64", "base64 encode (-U URL safe alphabet)", NULL, cli_base64_block, cli_encode_finish},
+    {"unbase64", "base64 decode, whitespace skipped (-U URL safe alphabet)", cli_unbase64_begin, cli_unbase64_block, cli_unbase64_finish},
+    {"base32", "base32 encode", NULL, cli_base32_block, cli_encode_finish},
+    {"unbase32", "base32 decode, whitespace skipped", cli_unbase32_begin, cli_unbase32_block, cli_unbase32_finish},
+    {"dump", "xxd style hex dump (-w width, -g group, -u upper case, -d diagnostic gutter)", NULL, cli_dump_block, NULL},
+    {"keywords", "C header with a charutil_keyword_lookup() table for the keywords, one per line", cli_keywords_begin, cli_keywords_block, cli_keywords_finish},
+};
+
+/* ==========================
+ * Input
+ * ========================== */
+
+/// Feeds p[0..n) to the command in CLI_BLOCK windows. offset is the file offset of p.
+/// Returns the bytes used; fewer than n only when more input is coming (more is set).
+static size_t cli_feed(const cli_command_t *cmd, cli_state_t *st, const unsigned char *p, size_t n, uint64_t offset, int more)
+{
+    size_t done = 0;
+    while (done < n && !st->failed)
+    {
+        const size_t len = (n - done < CLI_BLOCK) ? n - done : CLI_BLOCK;
+        const int last = !more && done + len == n;
+        const size_t used = cmd->block(st, p + done, len, offset + done, last);
+        done += used;
+        if (used < len && (len < CLI_BLOCK || last))
+        {
+            break; // A partial group waits for more input
+        }
+    }
+    return done;
+}
+
+/// Whole file through one mapping
+static int cli_run_mapped(const cli_command_t *cmd, cli_state_t *st, int fd, size_t size, uint64_t skip, uint64_t limit)
+{
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED)
+    {
+        return 0;
+    }
+    posix_madvise(map, size, POSIX_MADV_SEQUENTIAL);
+    const size_t start = (skip < size) ? (size_t)skip : size;
+    const size_t n = (size - start < limit) ? size - start : (size_t)limit;
+    cli_feed(cmd, st, (const unsigned char *)map + start, n, start, 0);
+    if (cmd->finish && !st->failed)
+    {
+        cmd->finish(st);
+    }
+    // Queued blocks may point into the mapping
+    cli_flush();
+    munmap(map, size);
+    return 1;
+}
+
+/// Pipes and anything else that cannot be mapped. The partial group left over by a block is moved to the front of the buffer.
+static void cli_run_stream(const cli_command_t *cmd, cli_state_t *st, int fd, uint64_t skip, uint64_t limit)
+{
+    static unsigned char buf[2 * CLI_BLOCK];
+    size_t have = 0;
+    uint64_t offset = 0; // File offset of buf[0]
+    int eof = 0;
+    while (!eof && !st->failed)
+    {
+        const ssize_t got = read(fd, buf + have, sizeof(buf) - have);
+        if (got < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            fprintf(stderr, "charutil: %s: %s\n", st->path, strerror(errno));
+            st->failed = 1;
+            break;
+        }
+        eof = (got == 0);
+        have += (size_t)got;
+
+        // Drop what -s skips and what -n leaves out
+        if (offset < skip)
+        {
+            const size_t drop = (skip - offset < have) ? (size_t)(skip - offset) : have;
+            memmove(buf, buf + drop, have - drop);
+            have -= drop;
+            offset += drop;
+        }
+        if (offset < skip)
+        {
+            continue;
+        }
+        if (offset - skip + have >= limit)
+        {
+            have = (size_t)(limit - (offset - skip));
+            eof = 1;
+        }
+        if (!eof && have == 0)
+        {
+            continue;
+        }
+
+        const size_t used = cli_feed(cmd, st, buf, have, offset, !eof);
+        // Queued blocks may point into buf
+        cli_flush();
+        memmove(buf, buf + used, have - used);
+        have -= used;
+        offset += used;
+    }
+    if (cmd->finish && !st->failed)
+    {
+        cmd->finish(st);
+    }
+    cli_flush();
+}
+
+static int cli_run(const cli_command_t *cmd, cli_state_t *st, const char *path, uint64_t skip, uint64_t limit)
+{
+    const int use_stdin = strcmp(path, "-") == 0;
+    const int fd = use_stdin ? STDIN_FILENO : open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "charutil: %s: %s\n", path, strerror(errno));
+        return 0;
+    }
+    st->path = use_stdin ? "(stdin)" : path;
+    st->failed = 0;
+    st->written = 0;
+    st->nibble = -1;
+    memset(&st->counts, 0, sizeof(st->counts));
+    memset(st->histogram, 0, sizeof(st->histogram));
+    charutil_utf8_init(&st->utf8);
+    if (cmd->begin)
+    {
+        cmd->begin(st);
+    }
+
+    struct stat info;
+    const int mappable = fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0 && (uint64_t)info.st_size <= SIZE_MAX;
+    if (!mappable || !cli_run_mapped(cmd, st, fd, (size_t)info.st_size, skip, limit))
+    {
+        cli_run_stream(cmd, st, fd, skip, limit);
+    }
+    if (!use_stdin)
+    {
+        close(fd);
+    }
+    return !st->failed && !cli_out.failed;
+}
+
+static void cli_usage(FILE *out)
+{
+    fprintf(out, "usage: charutil <command> [-s offset] [-n length] [options] [file...]\n\ncommands:\n");
+    for (size_t i = 0; i < sizeof(cli_commands) / sizeof(cli_commands[0]); i++)
+    {
+        fprintf(out, "  %-9s %s\n", cli_commands[i].name, cli_commands[i].help);
+    }
+    fprintf(out, "\n-s and -n limit every command to a region of each file. With no file, or -, stdin is read.\n");
+}
+
+int main(int argc, char **argv)
+{
+    static cli_state_t st;
+    uint64_t skip = 0;
+    uint64_t limit = UINT64_MAX;
+    const cli_command_t *cmd = NULL;
+
+    if (argc < 2 || strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0)
+    {
+        cli_usage(argc < 2 ? stderr : stdout);
+        return argc < 2 ? 2 : 0;
+    }
+    for (size_t i = 0; i < sizeof(cli_commands) / sizeof(cli_commands[0]); i++)
+    {
+        if (strcmp(argv[1], cli_commands[i].name) == 0)
+        {
+            cmd = &cli_commands[i];
+        }
+    }
+    if (!cmd)
+    {
+        fprintf(stderr, "charutil: unknown command '%s'\n", argv[1]);
+        cli_usage(stderr);
+        return 2;
+    }
+
+    st.width = 16;
+    st.group = 2;
+    int opt;
+    optind = 2;
+    while ((opt = getopt(argc, argv, "s:n:w:g:uUdl")) != -1)
+    {
+        char *end = NULL;
+        const unsigned long long value = optarg ? strtoull(optarg, &end, 0) : 0;
+        if (optarg && (*optarg == '\0' || *end != '\0'))
+        {
+            fprintf(stderr, "charutil: -%c needs a number\n", opt);
+            return 2;
+        }
+        switch (opt)
+        {
+            case 's':
+                skip = value;
+                break;
+            case 'n':
+                limit = value;
+                break;
+            case 'w':
+                st.width = (value > 0 && value <= CHARUTIL_HEXDUMP_MAX_WIDTH) ? (size_t)value : 16;
+                break;
+            case 'g':
+                st.group = (size_t)value;
+                break;
+            case 'u':
+                st.upper = 1;
+                break;
+            case 'U':
+                st.url = 1;
+                break;
+            case 'd':
+                st.diagnostics_gutter = 1;
+                break;
+            case 'l':
+                st.keep_lines = 1;
+                break;
+            default:
+                cli_usage(stderr);
+                return 2;
+        }
+    }
+
+    cli_out.staging = (char *)malloc(CLI_STAGING);
+    if (!cli_out.staging)
+    {
+        fprintf(stderr, "charutil: out of memory\n");
+        return 1;
+    }
+    cli_out.iov_max = CLI_MAX_IOV;
+#if defined(IOV_MAX)
+    cli_out.iov_max = (IOV_MAX < CLI_MAX_IOV) ? IOV_MAX : CLI_MAX_IOV;
+#endif
+
+    int ok = 1;
+    if (optind >= argc)
+    {
+        ok = cli_run(cmd, &st, "-", skip, limit);
+    }
+    for (int i = optind; i < argc && !cli_out.failed; i++)
+    {
+        ok &= cli_run(cmd, &st, argv[i], skip, limit);
+    }
+    free(cli_out.staging);
+    free(st.keywords);
+    return ok ? 0 : 1;
+}
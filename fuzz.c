@@ -0,0 +1,1383 @@
+#include "char-utils.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Differential harness: every bulk routine and SIMD/SWAR kernel is run against
+ * a byte at a time oracle built from the per character IS_* / TO_* /
+ * conversion macros and snprintf(): class spans, sets, case, hex, base64,
+ * base32, ascii85, hexdump, integer formatting, UUID / MAC parsing and the field
+ * splitter. Encoders and formatters are also round tripped through their
+ * decoders and parsers.
+ *
+ *   ./fuzz [iterations] [seed]
+ *
+ * First every buffer length 0..FUZZ_SWEEP_LEN is checked at every misalignment
+ * 0..FUZZ_ALIGN - 1 with several byte mixes (each covering all 256 values
+ * between them), then `iterations` random buffers. Built with
+ * CHARUTIL_RUNTIME_DISPATCH the public entry points are checked under every tier
+ * the CPU supports. Built with CHARUTIL_FUZZ_LIBFUZZER main() is left out and
+ * LLVMFuzzerTestOneInput() runs the same checks on each input (make libfuzzer).
+ * A mismatch prints what was being checked and aborts, so a fuzzer or a core
+ * dump keeps the failing buffer. */
+
+#define FUZZ_SWEEP_LEN 512 ///< Longest buffer of the exhaustive sweep
+#define FUZZ_ALIGN 32      ///< Misalignments checked, one AVX2 register
+#define FUZZ_MAX_LEN 4096  ///< Longest buffer checked, random and libFuzzer inputs are clipped to this
+
+static const char *fuzz_what = "";
+static size_t fuzz_len;
+static size_t fuzz_offset;
+
+static void fuzz_fail(const char *expr, int line)
+{
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+    const char *tier = charutil_tier_name(charutil_get_tier());
+#else
+    const char *tier = "static";
+#endif
+    fprintf(stderr, "fuzz.c:%d: %s: check `%s` failed (tier %s, n = %zu, misalignment %zu)\n", line, fuzz_what, expr, tier, fuzz_len, fuzz_offset);
+    abort();
+}
+
+#define FUZZ_CHECK(expr)                                                                                                                                                                               \
+    do                                                                                                                                                                                                 \
+    {                                                                                                                                                                                                  \
+        if (!(expr))                                                                                                                                                                                   \
+        {                                                                                                                                                                                              \
+            fuzz_fail(#expr, __LINE__);                                                                                                                                                                \
+        }                                                                                                                                                                                              \
+    } while (0)
+
+// With runtime dispatch the AVX2 kernels are built even if this CPU cannot run them
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+#define FUZZ_CPU_HAS_AVX2 charutil_tier_supported(CHARUTIL_TIER_AVX2)
+#else
+#define FUZZ_CPU_HAS_AVX2 1
+#endif
+
+// Output buffers with room for the widest expansion (6 byte diagnostic tokens)
+static unsigned char fuzz_in[FUZZ_MAX_LEN + FUZZ_ALIGN];
+static char fuzz_out[8 * FUZZ_MAX_LEN + 64];
+static char fuzz_expect[8 * FUZZ_MAX_LEN + 64];
+static char fuzz_back[8 * FUZZ_MAX_LEN + 64];
+
+/* ==========================
+ * Oracles
+ * ========================== */
+// Written from the macros alone, one byte at a time, without any of the
+// library's bulk helpers.
+
+static unsigned oracle_classes(unsigned ch)
+{
+    return (IS_BINARY(ch) ? CHARUTIL_CLASS_BINARY : 0) | (IS_OCTAL(ch) ? CHARUTIL_CLASS_OCTAL : 0) | (IS_DIGIT(ch) ? CHARUTIL_CLASS_DIGIT : 0) |
+           (IS_LOWER(ch) ? CHARUTIL_CLASS_LOWER : 0) | (IS_UPPER(ch) ? CHARUTIL_CLASS_UPPER : 0) | (IS_ALPHA(ch) ? CHARUTIL_CLASS_ALPHA : 0) |
+           (IS_ALNUM(ch) ? CHARUTIL_CLASS_ALNUM : 0) | (IS_HEX_DIGIT(ch) ? CHARUTIL_CLASS_HEX_DIGIT : 0) |
+           (IS_PRINTABLE(ch) ? CHARUTIL_CLASS_PRINTABLE : 0) | (IS_SPACE(ch) ? CHARUTIL_CLASS_SPACE : 0) | (IS_PUNCT(ch) ? CHARUTIL_CLASS_PUNCT : 0) |
+           (IS_BRACKET(ch) ? CHARUTIL_CLASS_BRACKET : 0) | (IS_SYMBOL(ch) ? CHARUTIL_CLASS_SYMBOL : 0) | (IS_ASCII(ch) ? CHARUTIL_CLASS_ASCII : 0);
+}
+
+static unsigned oracle_case(unsigned ch, charutil_case_op_t op)
+{
+    switch (op)
+    {
+        case CHARUTIL_CASE_LOWER:
+            return TO_LOWER(ch);
+        case CHARUTIL_CASE_UPPER:
+            return TO_UPPER(ch);
+        default:
+            return TOGGLE_CASE(ch);
+    }
+}
+
+static size_t oracle_span_class(const unsigned char *p, size_t n, unsigned mask)
+{
+    size_t i = 0;
+    while (i < n && (oracle_classes(p[i]) & mask))
+    {
+        i++;
+    }
+    return i;
+}
+
+static int oracle_casecmp(const unsigned char *a, const unsigned char *b, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        const int d = (int)TO_LOWER(a[i]) - (int)TO_LOWER(b[i]);
+        if (d)
+        {
+            return d;
+        }
+    }
+    return 0;
+}
+
+static void oracle_hex_encode(char *dst, const unsigned char *src, size_t n, charutil_hex_case_t hex_case)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        if (hex_case == CHARUTIL_HEX_LOWERCASE)
+        {
+            dst[2 * i] = (char)NIBBLE_TO_LOWERCASE_HEX(HIGH_NIBBLE(src[i]), '?');
+            dst[2 * i + 1] = (char)NIBBLE_TO_LOWERCASE_HEX(LOW_NIBBLE(src[i]), '?');
+        }
+        else
+        {
+            dst[2 * i] = (char)NIBBLE_TO_UPPERCASE_HEX(HIGH_NIBBLE(src[i]), '?');
+            dst[2 * i + 1] = (char)NIBBLE_TO_UPPERCASE_HEX(LOW_NIBBLE(src[i]), '?');
+        }
+    }
+}
+
+/// Pairwise decode; returns bytes written and sets *err_pos like charutil_hex_decode()
+static size_t oracle_hex_decode(unsigned char *dst, const unsigned char *src, size_t n, size_t *err_pos)
+{
+    size_t i = 0;
+    for (; i + 1 < n; i += 2)
+    {
+        const int hi = HEX_TO_INT((int)src[i], -1);
+        const int lo = HEX_TO_INT((int)src[i + 1], -1);
+        if (hi < 0 || lo < 0)
+        {
+            *err_pos = hi < 0 ? i : i + 1;
+            return i / 2;
+        }
+        dst[i / 2] = (unsigned char)(hi << 4 | lo);
+    }
+    *err_pos = (i < n) ? (HEX_TO_INT((int)src[i], -1) < 0 ? i : n - 1) : n;
+    return i / 2;
+}
+
+static size_t oracle_base64_encode(char *dst, const unsigned char *src, size_t n, unsigned flags)
+{
+    const char *alphabet = (flags & CHARUTIL_BASE64_URL) ? "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"
+                                                         : "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t out = 0;
+    for (size_t i = 0; i < n; i += 3)
+    {
+        const size_t take = (n - i < 3) ? n - i : 3;
+        uint32_t w = (uint32_t)src[i] << 16;
+        w |= (take > 1) ? (uint32_t)src[i + 1] << 8 : 0;
+        w |= (take > 2) ? (uint32_t)src[i + 2] : 0;
+        for (size_t k = 0; k < 4; k++)
+        {
+            if (k <= take)
+            {
+                dst[out++] = alphabet[(w >> (18 - 6 * k)) & 0x3F];
+            }
+            else if (!(flags & CHARUTIL_BASE64_NOPAD))
+            {
+                dst[out++] = '=';
+            }
+        }
+    }
+    return out;
+}
+
+/// RFC 3629 well formed UTF-8, byte by byte
+static bool oracle_utf8_valid(const unsigned char *p, size_t n)
+{
+    size_t i = 0;
+    while (i < n)
+    {
+        const unsigned ch = p[i];
+        size_t need;
+        unsigned lo = 0x80, hi = 0xBF;
+        if (IS_ASCII(ch))
+        {
+            i++;
+            continue;
+        }
+        else if (ch >= 0xC2 && ch <= 0xDF)
+        {
+            need = 1;
+        }
+        else if (ch >= 0xE0 && ch <= 0xEF)
+        {
+            need = 2;
+            lo = (ch == 0xE0) ? 0xA0 : 0x80;
+            hi = (ch == 0xED) ? 0x9F : 0xBF;
+        }
+        else if (ch >= 0xF0 && ch <= 0xF4)
+        {
+            need = 3;
+            lo = (ch == 0xF0) ? 0x90 : 0x80;
+            hi = (ch == 0xF4) ? 0x8F : 0xBF;
+        }
+        else
+        {
+            return false;
+        }
+        if (n - i <= need || p[i + 1] < lo || p[i + 1] > hi)
+        {
+            return false;
+        }
+        for (size_t k = 2; k <= need; k++)
+        {
+            if (p[i + k] < 0x80 || p[i + k] > 0xBF)
+            {
+                return false;
+            }
+        }
+        i += need + 1;
+    }
+    return true;
+}
+
+static size_t oracle_diagnostics_escape(char *dst, const unsigned char *src, size_t n)
+{
+    size_t out = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (IS_PRINTABLE(src[i]))
+        {
+            dst[out++] = (char)src[i];
+        }
+        else
+        {
+            const char *token = ascii_to_diagnostics(src[i]);
+            memcpy(dst + out, token, strlen(token));
+            out += strlen(token);
+        }
+    }
+    return out;
+}
+
+/// Digits accepted by charutil_parse_u64(), or 0 on no digits or overflow
+static size_t oracle_parse_u64(const unsigned char *p, size_t n, unsigned base, uint64_t *out)
+{
+    uint64_t value = 0;
+    size_t i = 0;
+    for (; i < n; i++)
+    {
+        const unsigned digit = (unsigned)((base == 16) ? HEX_TO_INT(p[i], 99) : (IS_DIGIT(p[i]) ? p[i] - '0' : 99));
+        if (digit >= base)
+        {
+            break;
+        }
+        if (value > (UINT64_MAX - digit) / base)
+        {
+            return 0;
+        }
+        value = value * base + digit;
+    }
+    if (i)
+    {
+        *out = value;
+    }
+    return i;
+}
+
+/// One 5 bit digit at a time from the bits of src, most significant first
+static size_t oracle_base32_encode(char *dst, const unsigned char *src, size_t n, int pad)
+{
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+    size_t out = 0;
+    for (size_t bit = 0; bit < 8 * n; bit += 5)
+    {
+        unsigned v = 0;
+        for (size_t k = bit; k < bit + 5; k++)
+        {
+            v = v << 1 | ((k < 8 * n) ? (src[k / 8] >> (7 - k % 8)) & 1u : 0u);
+        }
+        dst[out++] = alphabet[v];
+    }
+    while (pad && (out & 7))
+    {
+        dst[out++] = '=';
+    }
+    return out;
+}
+
+/// Btoa groups, digits by dividing by descending powers of 85
+static size_t oracle_ascii85_encode(char *dst, const unsigned char *src, size_t n)
+{
+    size_t out = 0;
+    for (size_t i = 0; i < n; i += 4)
+    {
+        const size_t take = (n - i < 4) ? n - i : 4;
+        uint32_t w = 0;
+        for (size_t k = 0; k < 4; k++)
+        {
+            w = w << 8 | ((k < take) ? src[i + k] : 0u);
+        }
+        if (take == 4 && w == 0)
+        {
+            dst[out++] = 'z';
+            continue;
+        }
+        uint32_t power = 85u * 85 * 85 * 85;
+        for (size_t k = 0; k <= take; k++, power /= 85)
+        {
+            dst[out++] = (char)('!' + w / power % 85);
+        }
+    }
+    return out;
+}
+
+/// xxd style lines, offsets from sprintf() and digits from oracle_hex_encode(), see charutil_hexdump()
+static size_t oracle_hexdump(char *dst, const unsigned char *src, size_t n, const charutil_hexdump_opts_t *opts)
+{
+    const size_t width = !opts->width ? 16 : (opts->width < CHARUTIL_HEXDUMP_MAX_WIDTH) ? opts->width : CHARUTIL_HEXDUMP_MAX_WIDTH;
+    const size_t group = (opts->group && opts->group < width) ? opts->group : width;
+    const bool upper = opts->hex_case == CHARUTIL_HEX_UPPERCASE;
+    const int digits = (opts->offset + n - 1 > 0xFFFFFFFFull) ? 16 : 8;
+    size_t out = 0;
+    for (size_t i = 0; i < n; i += width)
+    {
+        const size_t count = (n - i < width) ? n - i : width;
+        out += (size_t)sprintf(dst + out, upper ? "%0*llX: " : "%0*llx: ", digits, (unsigned long long)(opts->offset + i));
+        for (size_t k = 0; k < width; k++)
+        {
+            if (k && k % group == 0)
+            {
+                dst[out++] = ' ';
+            }
+            if (k < count)
+            {
+                oracle_hex_encode(dst + out, src + i + k, 1, opts->hex_case);
+                out += 2;
+            }
+            else
+            {
+                dst[out++] = ' ';
+                dst[out++] = ' ';
+            }
+        }
+        if (opts->gutter == CHARUTIL_HEXDUMP_GUTTER_NONE)
+        {
+            while (dst[out - 1] == ' ')
+            {
+                out--;
+            }
+        }
+        else
+        {
+            dst[out++] = ' ';
+            dst[out++] = ' ';
+            for (size_t k = 0; k < count; k++)
+            {
+                if (opts->gutter == CHARUTIL_HEXDUMP_GUTTER_DOTS)
+                {
+                    dst[out++] = IS_PRINTABLE(src[i + k]) ? (char)src[i + k] : '.';
+                }
+                else
+                {
+                    out += oracle_diagnostics_escape(dst + out, src + i + k, 1);
+                }
+            }
+        }
+        dst[out++] = '\n';
+    }
+    return out;
+}
+
+/// 1 and the bytes in uuid if text starts with the 8-4-4-4-12 form, else 0
+static int oracle_uuid_parse(uint8_t uuid[16], const char *text)
+{
+    size_t digit = 0;
+    for (size_t i = 0; i < CHARUTIL_UUID_TEXT_LEN; i++)
+    {
+        const int v = HEX_TO_INT((int)(unsigned char)text[i], -1);
+        if (i == 8 || i == 13 || i == 18 || i == 23)
+        {
+            if (text[i] != '-')
+            {
+                return 0;
+            }
+        }
+        else if (v < 0)
+        {
+            return 0;
+        }
+        else
+        {
+            uuid[digit / 2] = (digit & 1) ? (uint8_t)(uuid[digit / 2] | v) : (uint8_t)(v << 4);
+            digit++;
+        }
+    }
+    return 1;
+}
+
+/// 1 and the bytes in mac if text starts with 6 hex pairs split by all ':' or all '-', else 0
+static int oracle_mac_parse(uint8_t mac[6], const char *text)
+{
+    for (size_t i = 0; i < 6; i++)
+    {
+        const int hi = HEX_TO_INT((int)(unsigned char)text[3 * i], -1);
+        const int lo = HEX_TO_INT((int)(unsigned char)text[3 * i + 1], -1);
+        if (hi < 0 || lo < 0 || (i < 5 && text[3 * i + 2] != text[2]))
+        {
+            return 0;
+        }
+        mac[i] = (uint8_t)(hi << 4 | lo);
+    }
+    return text[2] == ':' || text[2] == '-';
+}
+
+/// Byte at a time tokenizer, fields as one charutil_split_finish() call over all of p would return them
+static size_t oracle_split(const unsigned char *p, size_t n, unsigned char delim, int quote, unsigned flags, charutil_field_t *fields)
+{
+    size_t count = 0;
+    size_t start = 0;
+    bool in_quotes = false;
+    bool quoted = false;
+    bool record_open = false;
+    for (size_t i = 0; i < n; i++)
+    {
+        const bool newline = p[i] == '\n';
+        if (quote != CHARUTIL_SPLIT_NO_QUOTE && p[i] == (unsigned char)quote)
+        {
+            in_quotes = !in_quotes;
+            quoted = true;
+        }
+        else if (!in_quotes && (p[i] == delim || newline))
+        {
+            const size_t end = (newline && i > start && p[i - 1] == '\r') ? i - 1 : i;
+            if (!((flags & CHARUTIL_SPLIT_SKIP_BLANK_LINES) && newline && end == start && !record_open))
+            {
+                fields[count].offset = start;
+                fields[count].len = end - start;
+                fields[count++].flags = (newline ? CHARUTIL_FIELD_END_RECORD : 0) | (quoted ? CHARUTIL_FIELD_QUOTED : 0);
+                record_open = !newline;
+            }
+            start = i + 1;
+            quoted = false;
+        }
+    }
+    if (record_open || start < n)
+    {
+        fields[count].offset = start;
+        fields[count].len = n - start;
+        fields[count++].flags = CHARUTIL_FIELD_END_RECORD | (quoted ? CHARUTIL_FIELD_QUOTED : 0);
+    }
+    return count;
+}
+
+/* ==========================
+ * Kernels
+ * ========================== */
+// Every kernel compiled into this build. The AVX2 ones are only checked when
+// the CPU can run them.
+
+typedef size_t (*span_fn)(const char *p, size_t n, unsigned mask);
+typedef size_t (*set_scan_fn)(const char *p, size_t n, const charutil_set_t *set, int member);
+typedef void (*case_buf_fn)(char *dst, const char *src, size_t n, charutil_case_op_t op);
+typedef size_t (*hex_encode_fn)(char *dst, const void *src, size_t n, charutil_hex_case_t hex_case);
+typedef size_t (*hex_decode_fn)(void *dst, const char *src, size_t n, size_t *err_pos);
+typedef size_t (*uuid_format_fn)(char *dst, const uint8_t uuid[16], charutil_hex_case_t hex_case);
+typedef int (*uuid_parse_fn)(uint8_t uuid[16], const char *src);
+typedef int (*mac_parse_fn)(uint8_t mac[6], const char *src);
+typedef void (*split_masks_fn)(const char *p, size_t blocks, uint8_t quote, uint8_t delim, uint64_t *masks);
+
+#define FUZZ_MAX_KERNELS 8
+
+static struct
+{
+    span_fn span[FUZZ_MAX_KERNELS];
+    set_scan_fn set_scan[FUZZ_MAX_KERNELS];
+    case_buf_fn case_buf[FUZZ_MAX_KERNELS];
+    hex_encode_fn hex_encode[FUZZ_MAX_KERNELS];
+    hex_decode_fn hex_decode[FUZZ_MAX_KERNELS];
+    uuid_format_fn uuid_format[FUZZ_MAX_KERNELS];
+    uuid_parse_fn uuid_parse[FUZZ_MAX_KERNELS];
+    mac_parse_fn mac_parse[FUZZ_MAX_KERNELS];
+    split_masks_fn split_masks[FUZZ_MAX_KERNELS];
+    size_t span_count, set_scan_count, case_buf_count, hex_encode_count, hex_decode_count;
+    size_t uuid_format_count, uuid_parse_count, mac_parse_count, split_masks_count;
+} fuzz_kernels;
+
+#define FUZZ_ADD_KERNEL(kind, fn) (fuzz_kernels.kind[fuzz_kernels.kind##_count++] = (fn))
+
+// Set while repeating the checks under another dispatch tier: the kernels
+// themselves do not change with the tier, only the public entry points do
+static bool fuzz_public_only;
+
+/// Index of the first kernel to check in a list of count (the public entry point is last)
+static size_t fuzz_first_kernel(size_t count)
+{
+    return fuzz_public_only ? count - 1 : 0;
+}
+
+// The UUID and MAC parsers take a length, so they join the kernel lists through these
+static int fuzz_uuid_parse(uint8_t uuid[16], const char *src)
+{
+    return charutil_uuid_parse(uuid, src, CHARUTIL_UUID_TEXT_LEN) == CHARUTIL_UUID_TEXT_LEN;
+}
+
+static int fuzz_mac_parse(uint8_t mac[6], const char *src)
+{
+    return charutil_mac_parse(mac, src, CHARUTIL_MAC_TEXT_LEN) == CHARUTIL_MAC_TEXT_LEN;
+}
+
+static void fuzz_init_kernels(void)
+{
+    if (fuzz_kernels.span_count)
+    {
+        return;
+    }
+    FUZZ_ADD_KERNEL(span, charutil_span_class_scalar);
+    FUZZ_ADD_KERNEL(set_scan, charutil_set_scan_scalar);
+    FUZZ_ADD_KERNEL(case_buf, charutil_case_buf_scalar);
+    FUZZ_ADD_KERNEL(case_buf, charutil_case_buf_swar);
+    FUZZ_ADD_KERNEL(hex_encode, charutil_hex_encode_scalar);
+    FUZZ_ADD_KERNEL(hex_decode, charutil_hex_decode_scalar);
+    FUZZ_ADD_KERNEL(hex_decode, charutil_hex_decode_swar);
+    FUZZ_ADD_KERNEL(uuid_format, charutil_uuid_format_scalar);
+    FUZZ_ADD_KERNEL(uuid_parse, charutil_uuid_parse_swar);
+    FUZZ_ADD_KERNEL(mac_parse, charutil_mac_parse_swar);
+    FUZZ_ADD_KERNEL(split_masks, charutil_split_masks_scalar);
+#if defined(CHARUTIL_HAVE_SSE2)
+    FUZZ_ADD_KERNEL(span, charutil_span_class_sse2);
+    FUZZ_ADD_KERNEL(case_buf, charutil_case_buf_sse2);
+    FUZZ_ADD_KERNEL(hex_encode, charutil_hex_encode_sse2);
+    FUZZ_ADD_KERNEL(hex_decode, charutil_hex_decode_sse2);
+    FUZZ_ADD_KERNEL(uuid_format, charutil_uuid_format_sse2);
+    FUZZ_ADD_KERNEL(uuid_parse, charutil_uuid_parse_sse2);
+    FUZZ_ADD_KERNEL(mac_parse, charutil_mac_parse_sse2);
+    FUZZ_ADD_KERNEL(split_masks, charutil_split_masks_sse2);
+#endif
+#if defined(CHARUTIL_HAVE_AVX2)
+    if (FUZZ_CPU_HAS_AVX2)
+    {
+        FUZZ_ADD_KERNEL(span, charutil_span_class_avx2);
+        FUZZ_ADD_KERNEL(set_scan, charutil_set_scan_avx2);
+        FUZZ_ADD_KERNEL(case_buf, charutil_case_buf_avx2);
+        FUZZ_ADD_KERNEL(hex_encode, charutil_hex_encode_avx2);
+        FUZZ_ADD_KERNEL(hex_decode, charutil_hex_decode_avx2);
+        FUZZ_ADD_KERNEL(split_masks, charutil_split_masks_avx2);
+    }
+#endif
+#if defined(CHARUTIL_HAVE_NEON)
+    FUZZ_ADD_KERNEL(span, charutil_span_class_neon);
+    FUZZ_ADD_KERNEL(set_scan, charutil_set_scan_neon);
+    FUZZ_ADD_KERNEL(case_buf, charutil_case_buf_neon);
+    FUZZ_ADD_KERNEL(hex_encode, charutil_hex_encode_neon);
+    FUZZ_ADD_KERNEL(hex_decode, charutil_hex_decode_neon);
+    FUZZ_ADD_KERNEL(uuid_format, charutil_uuid_format_neon);
+    FUZZ_ADD_KERNEL(uuid_parse, charutil_uuid_parse_neon);
+    FUZZ_ADD_KERNEL(mac_parse, charutil_mac_parse_neon);
+#endif
+#if defined(CHARUTIL_HAVE_NEON) && defined(__aarch64__)
+    FUZZ_ADD_KERNEL(split_masks, charutil_split_masks_neon);
+#endif
+    // The public entry points last, so a failure in a kernel is reported first
+    FUZZ_ADD_KERNEL(span, charutil_span_class);
+    FUZZ_ADD_KERNEL(set_scan, charutil_set_scan);
+    FUZZ_ADD_KERNEL(case_buf, charutil_case_buf);
+    FUZZ_ADD_KERNEL(hex_encode, charutil_hex_encode);
+    FUZZ_ADD_KERNEL(hex_decode, charutil_hex_decode);
+    FUZZ_ADD_KERNEL(uuid_format, charutil_uuid_format);
+    FUZZ_ADD_KERNEL(uuid_parse, fuzz_uuid_parse);
+    FUZZ_ADD_KERNEL(mac_parse, fuzz_mac_parse);
+    FUZZ_ADD_KERNEL(split_masks, charutil_split_masks);
+}
+
+/* ==========================
+ * Checks
+ * ========================== */
+// Each check takes the buffer under test, p[0..n), and compares every
+// implementation with its oracle. Outputs are written into buffers poisoned
+// past the expected end to catch overruns.
+
+static void check_span(const unsigned char *p, size_t n)
+{
+    static const unsigned masks[] = {
+        CHARUTIL_CLASS_BINARY,
+        CHARUTIL_CLASS_OCTAL,
+        CHARUTIL_CLASS_DIGIT,
+        CHARUTIL_CLASS_LOWER,
+        CHARUTIL_CLASS_UPPER,
+        CHARUTIL_CLASS_ALPHA,
+        CHARUTIL_CLASS_ALNUM,
+        CHARUTIL_CLASS_HEX_DIGIT,
+        CHARUTIL_CLASS_PRINTABLE,
+        CHARUTIL_CLASS_SPACE,
+        CHARUTIL_CLASS_PUNCT,
+        CHARUTIL_CLASS_BRACKET,
+        CHARUTIL_CLASS_SYMBOL,
+        CHARUTIL_CLASS_ASCII,
+        CHARUTIL_CLASS_DIGIT | CHARUTIL_CLASS_SPACE,
+        CHARUTIL_CLASS_ALPHA | CHARUTIL_CLASS_PUNCT,
+        CHARUTIL_CLASS_UPPER | CHARUTIL_CLASS_BRACKET | CHARUTIL_CLASS_SYMBOL,
+        (1u << CHARUTIL_CLASS_COUNT) - 1,
+    };
+    fuzz_what = "span_class";
+    for (size_t m = 0; m < sizeof(masks) / sizeof(masks[0]); m++)
+    {
+        const size_t expect = oracle_span_class(p, n, masks[m]);
+        for (size_t k = fuzz_first_kernel(fuzz_kernels.span_count); k < fuzz_kernels.span_count; k++)
+        {
+            FUZZ_CHECK(fuzz_kernels.span[k]((const char *)p, n, masks[m]) == expect);
+        }
+    }
+}
+
+static void check_sets(const unsigned char *p, size_t n)
+{
+    // Sets drawn from the buffer itself, so spans are long rather than ending at the first byte
+    bool member[256];
+    charutil_set_t set;
+    fuzz_what = "set_scan";
+    for (int round = 0; round < 2; round++)
+    {
+        memset(member, 0, sizeof(member));
+        charutil_set_clear(&set);
+        const size_t take = round ? (n < 4 ? n : 4) : n / 2;
+        for (size_t i = 0; i < take; i++)
+        {
+            member[p[i]] = true;
+            charutil_set_add(&set, p[i]);
+        }
+
+        for (int want = 0; want < 2; want++)
+        {
+            size_t expect = 0;
+            while (expect < n && member[p[expect]] == (bool)want)
+            {
+                expect++;
+            }
+            for (size_t k = fuzz_first_kernel(fuzz_kernels.set_scan_count); k < fuzz_kernels.set_scan_count; k++)
+            {
+                FUZZ_CHECK(fuzz_kernels.set_scan[k]((const char *)p, n, &set, want) == expect);
+            }
+            FUZZ_CHECK((want ? charutil_set_span : charutil_set_cspan)((const char *)p, n, &set) == expect);
+        }
+        for (unsigned ch = 0; ch < 256; ch++)
+        {
+            FUZZ_CHECK(charutil_set_contains(&set, (unsigned char)ch) == member[ch]);
+        }
+    }
+}
+
+static void check_case(const unsigned char *p, size_t n)
+{
+    static const charutil_case_op_t ops[] = {CHARUTIL_CASE_LOWER, CHARUTIL_CASE_UPPER, CHARUTIL_CASE_TOGGLE};
+    fuzz_what = "case_buf";
+    for (size_t o = 0; o < 3; o++)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            fuzz_expect[i] = (char)oracle_case(p[i], ops[o]);
+        }
+        for (size_t k = fuzz_first_kernel(fuzz_kernels.case_buf_count); k < fuzz_kernels.case_buf_count; k++)
+        {
+            memset(fuzz_out, 0x5A, n + 32);
+            fuzz_kernels.case_buf[k](fuzz_out, (const char *)p, n, ops[o]);
+            FUZZ_CHECK(memcmp(fuzz_out, fuzz_expect, n) == 0);
+            FUZZ_CHECK(fuzz_out[n] == 0x5A && fuzz_out[n + 31] == 0x5A);
+
+            // In place
+            memcpy(fuzz_out, p, n);
+            fuzz_kernels.case_buf[k](fuzz_out, fuzz_out, n, ops[o]);
+            FUZZ_CHECK(memcmp(fuzz_out, fuzz_expect, n) == 0);
+        }
+    }
+
+    fuzz_what = "casecmp";
+    // Toggled copy compares equal and hashes alike; then one byte replaced
+    for (size_t i = 0; i < n; i++)
+    {
+        fuzz_out[i] = (char)TOGGLE_CASE(p[i]);
+    }
+    FUZZ_CHECK(charutil_casecmp((const char *)p, fuzz_out, n) == 0);
+    FUZZ_CHECK(charutil_casehash((const char *)p, n) == charutil_casehash(fuzz_out, n));
+    if (n)
+    {
+        const size_t at = (n * 7) / 11;
+        fuzz_out[at] = (char)(p[n - 1] ^ (n & 0xFF));
+        const int expect = oracle_casecmp(p, (const unsigned char *)fuzz_out, n);
+        const int got = charutil_casecmp((const char *)p, fuzz_out, n);
+        FUZZ_CHECK((expect < 0) == (got < 0) && (expect > 0) == (got > 0));
+    }
+}
+
+static void check_hex(const unsigned char *p, size_t n)
+{
+    static unsigned char decoded[FUZZ_MAX_LEN + 64];
+    size_t err_pos;
+    size_t expect_err;
+
+    fuzz_what = "hex_encode";
+    for (int upper = 0; upper < 2; upper++)
+    {
+        const charutil_hex_case_t hex_case = upper ? CHARUTIL_HEX_UPPERCASE : CHARUTIL_HEX_LOWERCASE;
+        oracle_hex_encode(fuzz_expect, p, n, hex_case);
+        for (size_t k = fuzz_first_kernel(fuzz_kernels.hex_encode_count); k < fuzz_kernels.hex_encode_count; k++)
+        {
+            memset(fuzz_out, 0x5A, 2 * n + 32);
+            FUZZ_CHECK(fuzz_kernels.hex_encode[k](fuzz_out, p, n, hex_case) == 2 * n);
+            FUZZ_CHECK(memcmp(fuzz_out, fuzz_expect, 2 * n) == 0);
+            FUZZ_CHECK(fuzz_out[2 * n] == 0x5A && fuzz_out[2 * n + 31] == 0x5A);
+        }
+    }
+
+    fuzz_what = "hex_decode round trip";
+    // Mixed case digits decode back to p
+    for (size_t i = 0; i < 2 * n; i++)
+    {
+        fuzz_expect[i] = (char)((i % 3) ? TO_UPPER(fuzz_expect[i]) : TO_LOWER(fuzz_expect[i]));
+    }
+    for (size_t k = fuzz_first_kernel(fuzz_kernels.hex_decode_count); k < fuzz_kernels.hex_decode_count; k++)
+    {
+        memset(decoded, 0x5A, n + 32);
+        FUZZ_CHECK(fuzz_kernels.hex_decode[k](decoded, fuzz_expect, 2 * n, &err_pos) == n);
+        FUZZ_CHECK(err_pos == 2 * n && memcmp(decoded, p, n) == 0);
+        FUZZ_CHECK(decoded[n] == 0x5A && decoded[n + 31] == 0x5A);
+    }
+
+    fuzz_what = "hex_decode";
+    // p itself as hex text, valid or not
+    const size_t expect = oracle_hex_decode((unsigned char *)fuzz_back, p, n, &expect_err);
+    for (size_t k = fuzz_first_kernel(fuzz_kernels.hex_decode_count); k < fuzz_kernels.hex_decode_count; k++)
+    {
+        memset(decoded, 0x5A, n / 2 + 32);
+        FUZZ_CHECK(fuzz_kernels.hex_decode[k](decoded, (const char *)p, n, &err_pos) == expect);
+        FUZZ_CHECK(err_pos == expect_err && memcmp(decoded, fuzz_back, expect) == 0);
+        FUZZ_CHECK(decoded[n / 2] == 0x5A && decoded[n / 2 + 31] == 0x5A);
+    }
+
+    fuzz_what = "hex_decode_u64";
+    for (size_t i = 0; i + 16 <= n && i < 64; i++)
+    {
+        uint64_t err = 0;
+        uint64_t want = 0;
+        bool bad = false;
+        for (size_t k = 0; k < 16; k++)
+        {
+            const int v = HEX_TO_INT((int)p[i + k], -1);
+            bad |= v < 0;
+            want = want << 4 | (uint64_t)(v & 0xF);
+        }
+        const uint64_t got = charutil_hex_decode_u64((const char *)p + i, &err);
+        FUZZ_CHECK((err != 0) == bad);
+        FUZZ_CHECK(bad || got == want);
+
+        err = 0;
+        const uint8_t pair = charutil_hex_pair_to_byte((const char *)p + i, &err);
+        const int hi = HEX_TO_INT((int)p[i], -1);
+        const int lo = HEX_TO_INT((int)p[i + 1], -1);
+        FUZZ_CHECK((err != 0) == (hi < 0 || lo < 0));
+        FUZZ_CHECK(err || pair == (hi << 4 | lo));
+    }
+}
+
+static void check_base64(const unsigned char *p, size_t n)
+{
+    static const unsigned flag_sets[] = {CHARUTIL_BASE64_STANDARD, CHARUTIL_BASE64_URL | CHARUTIL_BASE64_NOPAD};
+    static unsigned char decoded[FUZZ_MAX_LEN + 64];
+    size_t err_pos;
+
+    fuzz_what = "base64";
+    for (size_t f = 0; f < 2; f++)
+    {
+        const size_t len = oracle_base64_encode(fuzz_expect, p, n, flag_sets[f]);
+        memset(fuzz_out, 0x5A, len + 32);
+        FUZZ_CHECK(charutil_base64_encode(fuzz_out, p, n, flag_sets[f]) == len);
+        FUZZ_CHECK(memcmp(fuzz_out, fuzz_expect, len) == 0 && fuzz_out[len] == 0x5A);
+
+        memset(decoded, 0x5A, n + 32);
+        FUZZ_CHECK(charutil_base64_decode(decoded, fuzz_out, len, flag_sets[f], &err_pos) == n);
+        FUZZ_CHECK(err_pos == len && memcmp(decoded, p, n) == 0 && decoded[n] == 0x5A);
+
+        // A character outside both alphabets is reported where it is
+        if (len)
+        {
+            const size_t at = (n * 13) % len;
+            fuzz_out[at] = '!';
+            charutil_base64_decode(decoded, fuzz_out, len, flag_sets[f], &err_pos);
+            FUZZ_CHECK(err_pos == at);
+        }
+    }
+}
+
+static void check_base32(const unsigned char *p, size_t n)
+{
+    static unsigned char decoded[FUZZ_MAX_LEN + 64];
+    charutil_base_decoder_t st;
+    size_t err_pos;
+
+    fuzz_what = "base32";
+    for (int pad = 0; pad < 2; pad++)
+    {
+        const size_t len = oracle_base32_encode(fuzz_expect, p, n, pad);
+        memset(fuzz_out, 0x5A, len + 32);
+        FUZZ_CHECK(charutil_base32_encode(fuzz_out, p, n, pad) == len);
+        FUZZ_CHECK(memcmp(fuzz_out, fuzz_expect, len) == 0 && fuzz_out[len] == 0x5A);
+
+        // Either case decodes back to p, in one call and in three chunks
+        for (size_t i = 0; i < len; i += 3)
+        {
+            fuzz_out[i] = (char)TO_LOWER(fuzz_out[i]);
+        }
+        memset(decoded, 0x5A, n + 32);
+        FUZZ_CHECK(charutil_base32_decode(decoded, fuzz_out, len, &err_pos) == n);
+        FUZZ_CHECK(err_pos == len && memcmp(decoded, p, n) == 0 && decoded[n] == 0x5A);
+        const size_t a = len / 3, b = len - len / 5;
+        charutil_base32_decode_init(&st);
+        size_t written = charutil_base32_decode_update(&st, decoded, fuzz_out, a);
+        written += charutil_base32_decode_update(&st, decoded + written, fuzz_out + a, b - a);
+        written += charutil_base32_decode_update(&st, decoded + written, fuzz_out + b, len - b);
+        FUZZ_CHECK(charutil_base32_decode_finish(&st) && written == n && memcmp(decoded, p, n) == 0);
+
+        // A character outside the alphabet is reported where it is
+        if (len)
+        {
+            const size_t at = (n * 13) % len;
+            fuzz_out[at] = '!';
+            charutil_base32_decode(decoded, fuzz_out, len, &err_pos);
+            FUZZ_CHECK(err_pos == at);
+        }
+    }
+}
+
+static void check_ascii85(const unsigned char *p, size_t n)
+{
+    static unsigned char decoded[FUZZ_MAX_LEN + 64];
+    charutil_ascii85_decoder_t st;
+    size_t err_pos, tail;
+
+    fuzz_what = "ascii85";
+    const size_t len = oracle_ascii85_encode(fuzz_expect, p, n);
+    memset(fuzz_out, 0x5A, len + 32);
+    FUZZ_CHECK(charutil_ascii85_encode(fuzz_out, p, n) == len && len <= CHARUTIL_ASCII85_ENCODED_MAX(n));
+    FUZZ_CHECK(memcmp(fuzz_out, fuzz_expect, len) == 0 && fuzz_out[len] == 0x5A);
+
+    memset(decoded, 0x5A, n + 32);
+    FUZZ_CHECK(charutil_ascii85_decode(decoded, fuzz_out, len, &err_pos) == n);
+    FUZZ_CHECK(err_pos == len && memcmp(decoded, p, n) == 0 && decoded[n] == 0x5A);
+    const size_t a = len / 3, b = len - len / 5;
+    charutil_ascii85_decode_init(&st);
+    size_t written = charutil_ascii85_decode_update(&st, decoded, fuzz_out, a);
+    written += charutil_ascii85_decode_update(&st, decoded + written, fuzz_out + a, b - a);
+    written += charutil_ascii85_decode_update(&st, decoded + written, fuzz_out + b, len - b);
+    FUZZ_CHECK(charutil_ascii85_decode_finish(&st, decoded + written, &tail) && written + tail == n && memcmp(decoded, p, n) == 0);
+
+    if (len)
+    {
+        const size_t at = (n * 13) % len;
+        fuzz_out[at] = '~';
+        charutil_ascii85_decode(decoded, fuzz_out, len, &err_pos);
+        FUZZ_CHECK(err_pos == at);
+    }
+}
+
+static void check_hexdump(const unsigned char *p, size_t n)
+{
+    static const charutil_hexdump_opts_t layouts[] = {
+        CHARUTIL_HEXDUMP_DEFAULTS,
+        {7, 3, CHARUTIL_HEX_UPPERCASE, CHARUTIL_HEXDUMP_GUTTER_NONE, 0xFFFFFF00ull},
+        {100, 0, CHARUTIL_HEX_LOWERCASE, CHARUTIL_HEXDUMP_GUTTER_DIAGNOSTICS, 0x123},
+    };
+    // Every row takes the same path, so a prefix is enough and keeps the checks quick
+    const size_t take = (n < 256) ? n : 256;
+
+    fuzz_what = "hexdump";
+    for (size_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); l++)
+    {
+        const size_t len = oracle_hexdump(fuzz_expect, p, take, &layouts[l]);
+        FUZZ_CHECK(charutil_hexdump(NULL, 0, p, take, &layouts[l]) == len);
+        memset(fuzz_out, 0x5A, len + 32);
+        FUZZ_CHECK(charutil_hexdump(fuzz_out, len + 1, p, take, &layouts[l]) == len);
+        FUZZ_CHECK(memcmp(fuzz_out, fuzz_expect, len) == 0 && fuzz_out[len] == '\0' && fuzz_out[len + 1] == 0x5A);
+
+        // Clipped like snprintf(): as much as fits, then a NUL
+        const size_t cap = len / 3 + 1;
+        memset(fuzz_out, 0x5A, len + 32);
+        FUZZ_CHECK(charutil_hexdump(fuzz_out, cap, p, take, &layouts[l]) == len);
+        FUZZ_CHECK(memcmp(fuzz_out, fuzz_expect, cap - 1) == 0 && fuzz_out[cap - 1] == '\0' && fuzz_out[cap] == 0x5A);
+    }
+}
+
+/// Every formatter against snprintf(), then back through the parsers
+static void check_integer(uint64_t v)
+{
+    char text[80];
+    char want[80];
+    uint64_t u = 0;
+    int64_t s = 0;
+    size_t len;
+
+    fuzz_what = "format_u64";
+    static const char *const formats[] = {"%llu", "%llx", "%llX", "%llo"};
+    static const unsigned bases[] = {10, 16, 16, 8};
+    for (size_t f = 0; f < 4; f++)
+    {
+        memset(text, 0x5A, sizeof(text));
+        len = (f == 0) ? charutil_format_u64_dec(text, v) : (f == 3) ? charutil_format_u64_oct(text, v) : charutil_format_u64_hex(text, v, (f == 1) ? CHARUTIL_HEX_LOWERCASE : CHARUTIL_HEX_UPPERCASE);
+        FUZZ_CHECK(len == (size_t)snprintf(want, sizeof(want), formats[f], (unsigned long long)v) && memcmp(text, want, len) == 0 && text[len] == 0x5A);
+        FUZZ_CHECK(charutil_parse_u64(text, len, bases[f], &u) == len && u == v);
+    }
+    memset(text, 0x5A, sizeof(text));
+    len = charutil_format_u64_bin(text, v);
+    FUZZ_CHECK(len <= CHARUTIL_U64_BIN_MAX && text[len] == 0x5A && (len == 1 || text[0] == '1'));
+    for (size_t i = 0; i < len; i++)
+    {
+        FUZZ_CHECK(text[i] == (char)('0' + ((v >> (len - 1 - i)) & 1)));
+    }
+    FUZZ_CHECK(charutil_parse_u64(text, len, 2, &u) == len && u == v);
+
+    fuzz_what = "format_i64";
+    memset(text, 0x5A, sizeof(text));
+    len = charutil_format_i64_dec(text, (int64_t)v);
+    FUZZ_CHECK(len == (size_t)snprintf(want, sizeof(want), "%lld", (long long)(int64_t)v) && memcmp(text, want, len) == 0 && text[len] == 0x5A);
+    FUZZ_CHECK(charutil_parse_i64(text, len, 10, &s) == len && s == (int64_t)v);
+}
+
+static void check_integers(const unsigned char *p, size_t n)
+{
+    static const uint64_t edges[] = {0, 1, 9, 10, 99, 100, UINT32_MAX, (uint64_t)INT64_MAX, (uint64_t)INT64_MAX + 1, UINT64_MAX};
+    for (size_t e = 0; e < sizeof(edges) / sizeof(edges[0]) && n < 2; e++)
+    {
+        check_integer(edges[e]);
+    }
+    // Words from the buffer, shifted by one of their bytes so every digit count comes up
+    for (size_t i = 0; i < n && i < 16; i++)
+    {
+        uint64_t w = 0;
+        memcpy(&w, p + i, (n - i < 8) ? n - i : 8);
+        check_integer(w >> (p[i] % 64));
+        check_integer(w);
+    }
+}
+
+static void check_addresses(const unsigned char *p, size_t n)
+{
+    char text[CHARUTIL_UUID_TEXT_LEN];
+    char expect_text[CHARUTIL_UUID_TEXT_LEN + 16];
+    uint8_t bytes[16], want[16], got[16];
+    if (n == 0)
+    {
+        return;
+    }
+    for (size_t k = 0; k < 16; k++)
+    {
+        bytes[k] = p[(k * 7) % n];
+    }
+
+    fuzz_what = "uuid_format";
+    for (int upper = 0; upper < 2; upper++)
+    {
+        const charutil_hex_case_t hex_case = upper ? CHARUTIL_HEX_UPPERCASE : CHARUTIL_HEX_LOWERCASE;
+        oracle_hex_encode(expect_text, bytes, 4, hex_case);
+        oracle_hex_encode(expect_text + 9, bytes + 4, 2, hex_case);
+        oracle_hex_encode(expect_text + 14, bytes + 6, 2, hex_case);
+        oracle_hex_encode(expect_text + 19, bytes + 8, 2, hex_case);
+        oracle_hex_encode(expect_text + 24, bytes + 10, 6, hex_case);
+        expect_text[8] = expect_text[13] = expect_text[18] = expect_text[23] = '-';
+        for (size_t k = fuzz_first_kernel(fuzz_kernels.uuid_format_count); k < fuzz_kernels.uuid_format_count; k++)
+        {
+            memset(fuzz_out, 0x5A, CHARUTIL_UUID_TEXT_LEN + 32);
+            FUZZ_CHECK(fuzz_kernels.uuid_format[k](fuzz_out, bytes, hex_case) == CHARUTIL_UUID_TEXT_LEN);
+            FUZZ_CHECK(memcmp(fuzz_out, expect_text, CHARUTIL_UUID_TEXT_LEN) == 0 && fuzz_out[CHARUTIL_UUID_TEXT_LEN] == 0x5A);
+        }
+    }
+
+    // The formatted text in mixed case, then with each character in turn replaced by a byte of p
+    fuzz_what = "uuid_parse";
+    for (size_t i = 0; i < CHARUTIL_UUID_TEXT_LEN; i++)
+    {
+        expect_text[i] = (char)((i % 3) ? TO_UPPER(expect_text[i]) : TO_LOWER(expect_text[i]));
+    }
+    for (size_t at = 0; at <= CHARUTIL_UUID_TEXT_LEN; at++)
+    {
+        memcpy(text, expect_text, CHARUTIL_UUID_TEXT_LEN);
+        if (at < CHARUTIL_UUID_TEXT_LEN)
+        {
+            text[at] = (char)p[(at * 5) % n];
+        }
+        const int ok = oracle_uuid_parse(want, text);
+        FUZZ_CHECK(!ok || at == CHARUTIL_UUID_TEXT_LEN || text[at] == expect_text[at] || IS_HEX_DIGIT(text[at]));
+        for (size_t k = fuzz_first_kernel(fuzz_kernels.uuid_parse_count); k < fuzz_kernels.uuid_parse_count; k++)
+        {
+            memset(got, 0x5A, sizeof(got));
+            FUZZ_CHECK(fuzz_kernels.uuid_parse[k](got, text) == ok);
+            FUZZ_CHECK(ok ? memcmp(got, want, 16) == 0 : got[0] == 0x5A && got[15] == 0x5A);
+        }
+    }
+    // And p itself, valid or not
+    for (size_t i = 0; i + CHARUTIL_UUID_TEXT_LEN <= n && i < 8; i++)
+    {
+        const int ok = oracle_uuid_parse(want, (const char *)p + i);
+        for (size_t k = fuzz_first_kernel(fuzz_kernels.uuid_parse_count); k < fuzz_kernels.uuid_parse_count; k++)
+        {
+            FUZZ_CHECK(fuzz_kernels.uuid_parse[k](got, (const char *)p + i) == ok && (!ok || memcmp(got, want, 16) == 0));
+        }
+    }
+
+    fuzz_what = "mac_parse";
+    const char sep = (p[0] & 1) ? ':' : '-';
+    charutil_mac_format_scalar(expect_text, bytes, sep, (p[0] & 2) ? CHARUTIL_HEX_UPPERCASE : CHARUTIL_HEX_LOWERCASE);
+    for (size_t at = 0; at <= CHARUTIL_MAC_TEXT_LEN; at++)
+    {
+        memcpy(text, expect_text, CHARUTIL_MAC_TEXT_LEN);
+        if (at < CHARUTIL_MAC_TEXT_LEN)
+        {
+            text[at] = (char)p[(at * 5) % n];
+        }
+        const int ok = oracle_mac_parse(want, text);
+        for (size_t k = fuzz_first_kernel(fuzz_kernels.mac_parse_count); k < fuzz_kernels.mac_parse_count; k++)
+        {
+            memset(got, 0x5A, sizeof(got));
+            FUZZ_CHECK(fuzz_kernels.mac_parse[k](got, text) == ok);
+            FUZZ_CHECK(ok ? memcmp(got, want, 6) == 0 : got[0] == 0x5A && got[5] == 0x5A);
+        }
+    }
+    for (size_t i = 0; i + CHARUTIL_MAC_TEXT_LEN <= n && i < 8; i++)
+    {
+        const int ok = oracle_mac_parse(want, (const char *)p + i);
+        for (size_t k = fuzz_first_kernel(fuzz_kernels.mac_parse_count); k < fuzz_kernels.mac_parse_count; k++)
+        {
+            FUZZ_CHECK(fuzz_kernels.mac_parse[k](got, (const char *)p + i) == ok && (!ok || memcmp(got, want, 6) == 0));
+        }
+    }
+}
+
+static void check_split(const unsigned char *p, size_t n)
+{
+    static charutil_field_t expect[FUZZ_MAX_LEN + 1];
+    static charutil_field_t fields[FUZZ_MAX_LEN + 1];
+    uint64_t masks[3 * (FUZZ_MAX_LEN / 64)];
+    uint64_t expect_masks[3 * (FUZZ_MAX_LEN / 64)];
+    charutil_split_t st;
+    size_t used;
+
+    fuzz_what = "split_masks";
+    const size_t blocks = n / 64;
+    const uint8_t quote = '"';
+    const uint8_t delim = n ? p[n / 2] : ',';
+    charutil_split_masks_scalar((const char *)p, blocks, quote, delim, expect_masks);
+    for (size_t k = fuzz_first_kernel(fuzz_kernels.split_masks_count); k < fuzz_kernels.split_masks_count; k++)
+    {
+        fuzz_kernels.split_masks[k]((const char *)p, blocks, quote, delim, masks);
+        FUZZ_CHECK(memcmp(masks, expect_masks, 3 * blocks * sizeof(uint64_t)) == 0);
+    }
+
+    // ',' with quoting, then a byte of p as the delimiter without, each with and without blank lines
+    fuzz_what = "split";
+    for (int round = 0; round < 4; round++)
+    {
+        const unsigned char d = (round & 1) ? delim : ',';
+        const int q = (round & 1) ? CHARUTIL_SPLIT_NO_QUOTE : '"';
+        const unsigned flags = (round & 2) ? CHARUTIL_SPLIT_SKIP_BLANK_LINES : CHARUTIL_SPLIT_DEFAULT;
+        if (q != CHARUTIL_SPLIT_NO_QUOTE && d == (unsigned char)q)
+        {
+            continue;
+        }
+        const size_t count = oracle_split(p, n, d, q, flags, expect);
+
+        charutil_split_init(&st, (char)d, q, flags);
+        FUZZ_CHECK(charutil_split_finish(&st, (const char *)p, n, fields, FUZZ_MAX_LEN + 1, &used) == count && used == n);
+        FUZZ_CHECK(memcmp(fields, expect, count * sizeof(fields[0])) == 0);
+
+        // Three chunks with the unused bytes carried over, fragments joined into whole fields
+        const size_t cuts[3] = {n / 3, n - n / 5, n};
+        size_t pos = 0;
+        size_t whole = 0;
+        size_t field_start = 0;
+        bool in_field = false;
+        charutil_split_init(&st, (char)d, q, flags);
+        for (int c = 0; c < 4; c++)
+        {
+            const size_t end = (c < 3) ? cuts[c] : n;
+            const size_t got = (c < 3) ? charutil_split_update(&st, (const char *)p + pos, end - pos, fields, FUZZ_MAX_LEN + 1, &used)
+                                       : charutil_split_finish(&st, (const char *)p + pos, end - pos, fields, FUZZ_MAX_LEN + 1, &used);
+            FUZZ_CHECK(used == end - pos || (c < 3 && used == end - pos - 1 && p[pos + used] == '\r'));
+            for (size_t f = 0; f < got; f++)
+            {
+                if (!in_field)
+                {
+                    field_start = pos + fields[f].offset;
+                }
+                FUZZ_CHECK(whole < count && pos + fields[f].offset + fields[f].len <= expect[whole].offset + expect[whole].len);
+                in_field = (fields[f].flags & CHARUTIL_FIELD_PARTIAL) != 0;
+                if (!in_field)
+                {
+                    const size_t len = pos + fields[f].offset + fields[f].len - field_start;
+                    FUZZ_CHECK(field_start == expect[whole].offset && len == expect[whole].len && fields[f].flags == expect[whole].flags);
+                    whole++;
+                }
+            }
+            pos += used;
+        }
+        FUZZ_CHECK(pos == n && whole == count && !in_field);
+    }
+}
+
+static void check_class_counts(const unsigned char *p, size_t n)
+{
+    uint64_t expect[CHARUTIL_CLASS_COUNT] = {0};
+    uint64_t expect_histogram[256] = {0};
+    uint64_t histogram[256];
+    charutil_class_counts_t counts;
+
+    fuzz_what = "class_counts";
+    for (size_t i = 0; i < n; i++)
+    {
+        const unsigned classes = oracle_classes(p[i]);
+        for (unsigned c = 0; c < CHARUTIL_CLASS_COUNT; c++)
+        {
+            expect[c] += (classes >> c) & 1;
+        }
+        expect_histogram[p[i]]++;
+    }
+    for (int with_histogram = 0; with_histogram < 2; with_histogram++)
+    {
+        charutil_class_counts(p, n, &counts, with_histogram ? histogram : NULL);
+        FUZZ_CHECK(counts.total == n);
+        FUZZ_CHECK(memcmp(counts.classes, expect, sizeof(expect)) == 0);
+    }
+    FUZZ_CHECK(memcmp(histogram, expect_histogram, sizeof(histogram)) == 0);
+}
+
+static void check_utf8(const unsigned char *p, size_t n)
+{
+    charutil_utf8_state_t st;
+    const bool expect = oracle_utf8_valid(p, n);
+
+    fuzz_what = "utf8_validate";
+    FUZZ_CHECK((charutil_utf8_validate(p, n) != 0) == expect);
+
+    // Same stream fed in three chunks, splitting sequences wherever the cuts land
+    const size_t a = n / 3, b = n - n / 5;
+    charutil_utf8_init(&st);
+    charutil_utf8_update(&st, p, a);
+    charutil_utf8_update(&st, p + a, b - a);
+    charutil_utf8_update(&st, p + b, n - b);
+    FUZZ_CHECK((charutil_utf8_finish(&st) != 0) == expect);
+}
+
+static void check_text(const unsigned char *p, size_t n)
+{
+    size_t len, err_pos;
+
+    fuzz_what = "diagnostics_escape";
+    len = oracle_diagnostics_escape(fuzz_expect, p, n);
+    FUZZ_CHECK(charutil_diagnostics_escape(NULL, 0, p, n) == len);
+    FUZZ_CHECK(charutil_diagnostics_escape(fuzz_out, len + 1, p, n) == len);
+    FUZZ_CHECK(memcmp(fuzz_out, fuzz_expect, len) == 0 && fuzz_out[len] == '\0');
+
+    // Escapers only emit printable ASCII and their decoders restore the input
+    fuzz_what = "escape_c";
+    len = charutil_escape_c(fuzz_out, sizeof(fuzz_out), p, n);
+    FUZZ_CHECK(charutil_escape_c(NULL, 0, p, n) == len && oracle_span_class((const unsigned char *)fuzz_out, len, CHARUTIL_CLASS_PRINTABLE) == len);
+    FUZZ_CHECK(charutil_unescape_c(fuzz_back, fuzz_out, len, &err_pos) == n && err_pos == len && memcmp(fuzz_back, p, n) == 0);
+
+    fuzz_what = "escape_json";
+    if (oracle_utf8_valid(p, n))
+    {
+        len = charutil_escape_json(fuzz_out, sizeof(fuzz_out), p, n);
+        FUZZ_CHECK(charutil_escape_json(NULL, 0, p, n) == len);
+        FUZZ_CHECK(charutil_unescape_json(fuzz_back, fuzz_out, len, &err_pos) == n && err_pos == len && memcmp(fuzz_back, p, n) == 0);
+    }
+
+    fuzz_what = "percent_encode";
+    for (unsigned flags = 0; flags < 2; flags++)
+    {
+        len = charutil_percent_encode(fuzz_out, sizeof(fuzz_out), p, n, NULL, flags);
+        FUZZ_CHECK(charutil_percent_encode(NULL, 0, p, n, NULL, flags) == len);
+        for (size_t i = 0; i < len; i++)
+        {
+            FUZZ_CHECK(IS_ALNUM(fuzz_out[i]) || strchr("-._~%+", fuzz_out[i]) != NULL);
+        }
+        FUZZ_CHECK(charutil_percent_decode(fuzz_back, fuzz_out, len, flags, &err_pos) == n && err_pos == len && memcmp(fuzz_back, p, n) == 0);
+    }
+
+    fuzz_what = "parse_u64";
+    static const unsigned bases[] = {10, 16};
+    for (size_t b = 0; b < 2; b++)
+    {
+        // From the start and from the first digit, so long digit runs reach the SWAR paths
+        size_t from = 0;
+        while (from < n && !IS_HEX_DIGIT(p[from]))
+        {
+            from++;
+        }
+        for (size_t start = 0; start <= from && start < n; start += from ? from : 1)
+        {
+            uint64_t want = 0x5A5A, got = 0x5A5A;
+            const size_t used = oracle_parse_u64(p + start, n - start, bases[b], &want);
+            FUZZ_CHECK(charutil_parse_u64((const char *)p + start, n - start, bases[b], &got) == used);
+            FUZZ_CHECK(got == want);
+        }
+    }
+}
+
+/// Kernels are checked once; the public entry points under every tier in dispatch builds
+static void fuzz_check(const unsigned char *p, size_t n, size_t offset)
+{
+    fuzz_len = n;
+    fuzz_offset = offset;
+    fuzz_init_kernels();
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+    const charutil_tier_t initial = charutil_get_tier();
+    for (int t = 0; t < CHARUTIL_TIER_COUNT; t++)
+    {
+        if (!charutil_set_tier((charutil_tier_t)t))
+        {
+            continue;
+        }
+        fuzz_public_only = t > 0;
+#endif
+        check_span(p, n);
+        check_sets(p, n);
+        check_case(p, n);
+        check_hex(p, n);
+        check_base64(p, n);
+        check_base32(p, n);
+        check_ascii85(p, n);
+        check_class_counts(p, n);
+        check_utf8(p, n);
+        check_text(p, n);
+        check_hexdump(p, n);
+        check_split(p, n);
+        // Formatting, parsing and addresses do not go through the dispatch table
+        if (!fuzz_public_only)
+        {
+            check_integers(p, n);
+            check_addresses(p, n);
+        }
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+    }
+    fuzz_public_only = false;
+    charutil_set_tier(initial);
+#endif
+}
+
+#if defined(CHARUTIL_FUZZ_LIBFUZZER)
+/// First byte picks the misalignment, the rest is the buffer
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size == 0)
+    {
+        fuzz_check(fuzz_in, 0, 0);
+        return 0;
+    }
+    const size_t offset = data[0] % FUZZ_ALIGN;
+    const size_t n = (size - 1 < FUZZ_MAX_LEN) ? size - 1 : FUZZ_MAX_LEN;
+    memcpy(fuzz_in + offset, data + 1, n);
+    fuzz_check(fuzz_in + offset, n, offset);
+    return 0;
+}
+#else
+
+static uint64_t fuzz_rand_state = 0x2545F4914F6CDD1Dull;
+static uint64_t fuzz_rand(void)
+{
+    fuzz_rand_state ^= fuzz_rand_state << 13;
+    fuzz_rand_state ^= fuzz_rand_state >> 7;
+    fuzz_rand_state ^= fuzz_rand_state << 17;
+    return fuzz_rand_state;
+}
+
+/* ==========================
+ * Buffer Mixes
+ * ========================== */
+
+enum
+{
+    FUZZ_MIX_BYTES,   ///< Every byte value in turn
+    FUZZ_MIX_TEXT,    ///< Printable ASCII with one poison byte
+    FUZZ_MIX_HEX,     ///< Hex digits with one poison byte
+    FUZZ_MIX_UTF8,    ///< Multibyte UTF-8 with one poison byte
+    FUZZ_MIX_COUNT
+};
+
+static void fuzz_fill(unsigned char *p, size_t n, int mix, uint64_t seed)
+{
+    static const char text[] = "The quick brown fox jumps over the lazy dog 0123456789 ({[<>]}) !?#$%&*+,-./:;=@\\^_`|~'\"";
+    static const char hex[] = "0123456789abcdefABCDEF";
+    static const char utf8[] = "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80z\xED\x9F\xBF\xF4\x8F\xBF\xBF";
+    for (size_t i = 0; i < n; i++)
+    {
+        const size_t k = i + (size_t)seed;
+        switch (mix)
+        {
+            case FUZZ_MIX_BYTES:
+                p[i] = (unsigned char)(k * 167 + (seed >> 8));
+                break;
+            case FUZZ_MIX_TEXT:
+                p[i] = (unsigned char)text[k % (sizeof(text) - 1)];
+                break;
+            case FUZZ_MIX_HEX:
+                p[i] = (unsigned char)hex[k % (sizeof(hex) - 1)];
+                break;
+            default:
+                p[i] = (unsigned char)utf8[k % (sizeof(utf8) - 1)];
+                break;
+        }
+    }
+    // One byte from the far end of the table, somewhere or nowhere
+    const size_t at = (size_t)(seed * 31) % (n + 1);
+    if (mix != FUZZ_MIX_BYTES && at < n)
+    {
+        p[at] = (unsigned char)(0x80 + (seed & 0x7F) - (seed & 1) * 0x80);
+    }
+}
+
+/// Every length 0..FUZZ_SWEEP_LEN at every misalignment
+static void fuzz_sweep(void)
+{
+    for (size_t n = 0; n <= FUZZ_SWEEP_LEN; n++)
+    {
+        for (size_t offset = 0; offset < FUZZ_ALIGN; offset++)
+        {
+            // Mixes take turns so that each length meets each mix at a quarter of the misalignments
+            const int mix = (int)((n + offset) % FUZZ_MIX_COUNT);
+            unsigned char *p = fuzz_in + offset;
+            fuzz_fill(p, n, mix, n * FUZZ_ALIGN + offset);
+            fuzz_check(p, n, offset);
+        }
+    }
+    printf("Sweep of lengths 0..%d at %d misalignments passed!\n", FUZZ_SWEEP_LEN, FUZZ_ALIGN);
+}
+
+/// Random lengths, misalignments and mixes, including raw random bytes
+static void fuzz_random(unsigned long iterations)
+{
+    for (unsigned long it = 0; it < iterations; it++)
+    {
+        const uint64_t r = fuzz_rand();
+        const size_t n = (r & 7) ? (size_t)(r >> 8) % 600 : (size_t)(r >> 8) % (FUZZ_MAX_LEN + 1);
+        const size_t offset = (size_t)(r >> 40) % FUZZ_ALIGN;
+        const int mix = (int)((r >> 48) % (FUZZ_MIX_COUNT + 1));
+        unsigned char *p = fuzz_in + offset;
+        if (mix == FUZZ_MIX_COUNT)
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                p[i] = (unsigned char)fuzz_rand();
+            }
+        }
+        else
+        {
+            fuzz_fill(p, n, mix, fuzz_rand());
+            // Sprinkle a few random bytes over the mix
+            for (size_t k = (r >> 56) % 4; k > 0 && n; k--)
+            {
+                p[fuzz_rand() % n] = (unsigned char)fuzz_rand();
+            }
+        }
+        fuzz_check(p, n, offset);
+    }
+    printf("%lu random buffers passed!\n", iterations);
+}
+
+int main(int argc, char **argv)
+{
+    const unsigned long iterations = (argc > 1) ? strtoul(argv[1], NULL, 0) : 5000;
+    if (argc > 2)
+    {
+        fuzz_rand_state = strtoull(argv[2], NULL, 0) | 1;
+    }
+    printf("Random seed 0x%llx\n", (unsigned long long)fuzz_rand_state);
+
+    fuzz_sweep();
+    fuzz_random(iterations);
+
+    printf("All differential tests passed successfully!\n");
+    return 0;
+}
+#endif
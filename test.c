@@ -1,7 +1,9 @@
 #include "char-utils.h"
 #include <assert.h>
 #include <stdbool.h>
+#include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 static_assert(CHARUTIL_BINARY_COUNT == CHARUTIL_BINARY_COUNT_GROKKABLE);
@@ -140,6 +142,41 @@ void test_character_checks(void)
     printf("Character checks passed!\n");
 }
 
+void test_class_table(void)
+{
+    // Every table entry must match the arithmetic macros bit for bit (run without CHARUTIL_USE_CLASS_TABLE)
+    for (int ch = -0x1FF; ch < 0x1FF; ch++)
+    {
+        assert(CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_BINARY) == IS_BINARY(ch));
+        assert(CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_OCTAL) == IS_OCTAL(ch));
+        assert(CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_DIGIT) == IS_DIGIT(ch));
+        assert(CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_LOWER) == IS_LOWER(ch));
+        assert(CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_UPPER) == IS_UPPER(ch));
+        assert(CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_ALPHA) == IS_ALPHA(ch));
+        assert(CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_ALNUM) == IS_ALNUM(ch));
+        assert(CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_HEX_DIGIT) == IS_HEX_DIGIT(ch));
+        assert(CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_PRINTABLE) == IS_PRINTABLE(ch));
+        assert(CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_SPACE) == IS_SPACE(ch));
+        assert(CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_PUNCT) == IS_PUNCT(ch));
+        assert(CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_BRACKET) == IS_BRACKET(ch));
+        assert(CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_SYMBOL) == IS_SYMBOL(ch));
+        assert(CHARUTIL_IS_CLASS(ch, CHARUTIL_CLASS_ASCII) == IS_ASCII(ch));
+    }
+
+    // Also through signed and unsigned char, as a tokenizer would pass them
+    for (int i = 0; i < 256; i++)
+    {
+        const char sc = (char)i;
+        const unsigned char uc = (unsigned char)i;
+        assert(CHARUTIL_IS_CLASS(sc, CHARUTIL_CLASS_PUNCT) == IS_PUNCT(sc));
+        assert(CHARUTIL_IS_CLASS(uc, CHARUTIL_CLASS_PUNCT) == IS_PUNCT(uc));
+        assert(CHARUTIL_IS_CLASS(sc, CHARUTIL_CLASS_SPACE) == IS_SPACE(sc));
+        assert(CHARUTIL_IS_CLASS(uc, CHARUTIL_CLASS_SPACE) == IS_SPACE(uc));
+    }
+
+    printf("Class table checks passed!\n");
+}
+
 void test_case_conversion(void)
 {
     // Test safe conversions (non alphabet characters are passed through)
@@ -446,11 +483,2652 @@ void test_conversions(void)
     printf("Conversion tests passed!\n");
 }
 
-int main()
+/// Small deterministic generator so test runs are repeatable
+static uint64_t test_rand_state = 0x2545F4914F6CDD1Dull;
+static uint64_t test_rand(void)
+{
+    test_rand_state ^= test_rand_state << 13;
+    test_rand_state ^= test_rand_state >> 7;
+    test_rand_state ^= test_rand_state << 17;
+    return test_rand_state;
+}
+
+// With runtime dispatch the AVX2 kernels are built even if this CPU cannot run them
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+#define TEST_CPU_HAS_AVX2 charutil_tier_supported(CHARUTIL_TIER_AVX2)
+#else
+#define TEST_CPU_HAS_AVX2 1
+#endif
+
+typedef size_t (*span_fn)(const char *p, size_t n, unsigned mask);
+
+void test_span_kernel(span_fn span)
+{
+    static const unsigned classes[] = {
+        CHARUTIL_CLASS_BINARY,
+        CHARUTIL_CLASS_OCTAL,
+        CHARUTIL_CLASS_DIGIT,
+        CHARUTIL_CLASS_LOWER,
+        CHARUTIL_CLASS_UPPER,
+        CHARUTIL_CLASS_ALPHA,
+        CHARUTIL_CLASS_ALNUM,
+        CHARUTIL_CLASS_HEX_DIGIT,
+        CHARUTIL_CLASS_PRINTABLE,
+        CHARUTIL_CLASS_SPACE,
+        CHARUTIL_CLASS_PUNCT,
+        CHARUTIL_CLASS_BRACKET,
+        CHARUTIL_CLASS_SYMBOL,
+        CHARUTIL_CLASS_ASCII,
+        CHARUTIL_CLASS_DIGIT | CHARUTIL_CLASS_SPACE,
+    };
+    char buf[67];
+
+    for (size_t c = 0; c < sizeof(classes) / sizeof(classes[0]); c++)
+    {
+        const unsigned mask = classes[c];
+        int member = 0;
+        while (!CHARUTIL_IS_CLASS(member, mask))
+        {
+            member++;
+        }
+
+        // Plant every byte value at every position of an otherwise matching buffer
+        for (int ch = 0; ch < 256; ch++)
+        {
+            for (size_t pos = 0; pos < sizeof(buf); pos++)
+            {
+                memset(buf, member, sizeof(buf));
+                buf[pos] = (char)ch;
+                const size_t expected = CHARUTIL_IS_CLASS(ch, mask) ? sizeof(buf) : pos;
+                assert(span(buf, sizeof(buf), mask) == expected);
+                assert(span(buf, pos, mask) == pos);
+            }
+        }
+    }
+}
+
+void test_span(void)
+{
+    test_span_kernel(charutil_span_class_scalar);
+#if defined(CHARUTIL_HAVE_SSE2)
+    test_span_kernel(charutil_span_class_sse2);
+#endif
+#if defined(CHARUTIL_HAVE_AVX2)
+    if (TEST_CPU_HAS_AVX2)
+    {
+        test_span_kernel(charutil_span_class_avx2);
+    }
+#endif
+#if defined(CHARUTIL_HAVE_NEON)
+    test_span_kernel(charutil_span_class_neon);
+#endif
+    test_span_kernel(charutil_span_class);
+
+    {
+        const char line[] = "  \t\n12345abcXYZ  ({[]})!?";
+        const size_t n = sizeof(line) - 1;
+        const char *p = charutil_find_first_not_space(line, n);
+        assert(p == line + 4);
+        assert(charutil_span_digit(p, n - 4) == 5);
+        assert(charutil_span_alnum(p, n - 4) == 11);
+        assert(charutil_span_hex_digit(p, n - 4) == 8);
+        assert(charutil_span_bracket(line + 17, n - 17) == 6);
+        assert(charutil_span_symbol(line + 23, n - 23) == 2);
+        assert(charutil_span_punct(line + 17, n - 17) == 8);
+        assert(charutil_span_printable(line, n) == 2);
+        assert(charutil_span_ascii(line, n) == n);
+    }
+
+    printf("Span tests passed!\n");
+}
+
+typedef size_t (*set_scan_fn)(const char *p, size_t n, const charutil_set_t *set, int member);
+
+void test_set_kernel(set_scan_fn scan)
+{
+    char buf[67];
+
+    for (int round = 0; round < 64; round++)
+    {
+        // Random sets of every density, always with one member and one non member
+        charutil_set_t set;
+        bool expected[256];
+        charutil_set_clear(&set);
+        for (int ch = 0; ch < 256; ch++)
+        {
+            expected[ch] = (ch == 'a') || (ch != 'b' && (int)(test_rand() % 64) < round);
+            if (expected[ch])
+            {
+                charutil_set_add(&set, (unsigned char)ch);
+            }
+        }
+        for (int ch = 0; ch < 256; ch++)
+        {
+            assert(charutil_set_contains(&set, (unsigned char)ch) == expected[ch]);
+        }
+
+        // Plant every byte value at every position of a run of members, then of non members
+        for (int member = 0; member < 2; member++)
+        {
+            const char fill = member ? 'a' : 'b';
+            for (int ch = 0; ch < 256; ch++)
+            {
+                for (size_t pos = 0; pos < sizeof(buf); pos += (round % 8 == 0) ? 1 : 5)
+                {
+                    memset(buf, fill, sizeof(buf));
+                    buf[pos] = (char)ch;
+                    assert(scan(buf, sizeof(buf), &set, member) == ((expected[ch] == (bool)member) ? sizeof(buf) : pos));
+                    assert(scan(buf, pos, &set, member) == pos);
+                }
+            }
+        }
+    }
+}
+
+static const charutil_set_t test_url_unreserved = CHARUTIL_SET_LITERAL("-._~");
+
+void test_char_sets(void)
+{
+    test_set_kernel(charutil_set_scan_scalar);
+#if defined(CHARUTIL_HAVE_AVX2)
+    if (TEST_CPU_HAS_AVX2)
+    {
+        test_set_kernel(charutil_set_scan_avx2);
+    }
+#endif
+#if defined(CHARUTIL_HAVE_NEON) && defined(__aarch64__)
+    test_set_kernel(charutil_set_scan_neon);
+#endif
+    test_set_kernel(charutil_set_scan);
+
+    // Constant initializers match sets built at run time
+    {
+        static const char *const literals[] = {"", "-._~", "{}[]:,\"", " \t\r\n", "\x01\x7F\x80\xFF", "0123456789ABCDEFGHIJKLMNOPQRSTUV"};
+        const charutil_set_t built[] = {
+            CHARUTIL_SET_LITERAL(""),
+            CHARUTIL_SET_LITERAL("-._~"),
+            CHARUTIL_SET_LITERAL("{}[]:,\""),
+            CHARUTIL_SET_LITERAL(" \t\r\n"),
+            CHARUTIL_SET_LITERAL("\x01\x7F\x80\xFF"),
+            CHARUTIL_SET_LITERAL("0123456789ABCDEFGHIJKLMNOPQRSTUV"),
+        };
+        for (size_t i = 0; i < sizeof(literals) / sizeof(literals[0]); i++)
+        {
+            charutil_set_t set;
+            charutil_set_clear(&set);
+            charutil_set_add_chars(&set, literals[i], strlen(literals[i]));
+            assert(memcmp(&set, &built[i], sizeof(set)) == 0);
+        }
+        for (int ch = 0; ch < 256; ch++)
+        {
+            assert(charutil_set_contains(&test_url_unreserved, (unsigned char)ch) == (ch != 0 && strchr("-._~", ch) != NULL));
+        }
+    }
+
+    // Class, range and inversion builders
+    for (unsigned bit = 0; bit < 14; bit++)
+    {
+        charutil_set_t set;
+        charutil_set_clear(&set);
+        charutil_set_add_class(&set, 1u << bit);
+        for (int ch = 0; ch < 256; ch++)
+        {
+            assert(charutil_set_contains(&set, (unsigned char)ch) == CHARUTIL_IS_CLASS(ch, 1u << bit));
+        }
+    }
+    {
+        charutil_set_t set;
+        charutil_set_clear(&set);
+        charutil_set_add_range(&set, 0x7E, 0xFF);
+        charutil_set_invert(&set);
+        for (int ch = 0; ch < 256; ch++)
+        {
+            assert(charutil_set_contains(&set, (unsigned char)ch) == (ch < 0x7E));
+        }
+    }
+
+    {
+        static const charutil_set_t json_structural = CHARUTIL_SET_LITERAL("{}[]:,");
+        const char json[] = "  {\"key\": [1, 2]}";
+        const size_t n = sizeof(json) - 1;
+        assert(charutil_set_find(json, n, &json_structural) == json + 2);
+        assert(charutil_set_cspan(json + 3, n - 3, &json_structural) == 5);
+        assert(charutil_set_span(json + 2, n - 2, &json_structural) == 1);
+        assert(charutil_set_find(json, 2, &json_structural) == json + 2);
+    }
+
+    printf("Character set tests passed!\n");
+}
+
+typedef size_t (*class_count_fn)(const unsigned char *p, size_t n, uint64_t *classes);
+
+void reference_class_counts(const unsigned char *p, size_t n, uint64_t *classes)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        const unsigned ch = p[i];
+        const bool member[CHARUTIL_CLASS_COUNT] = {IS_BINARY(ch), IS_OCTAL(ch), IS_DIGIT(ch), IS_LOWER(ch), IS_UPPER(ch), IS_ALPHA(ch), IS_ALNUM(ch),
+                                                   IS_HEX_DIGIT(ch), IS_PRINTABLE(ch), IS_SPACE(ch), IS_PUNCT(ch), IS_BRACKET(ch), IS_SYMBOL(ch), IS_ASCII(ch)};
+        for (int k = 0; k < CHARUTIL_CLASS_COUNT; k++)
+        {
+            classes[k] += member[k];
+        }
+    }
+}
+
+void test_class_count_kernel(class_count_fn count)
+{
+    static unsigned char buf[20000];
+    for (int round = 0; round < 4; round++)
+    {
+        // Random bytes, printable text, and a single repeated byte that fills every lane counter
+        for (size_t i = 0; i < sizeof(buf); i++)
+        {
+            buf[i] = (round == 0) ? (unsigned char)test_rand() : (round == 1) ? (unsigned char)(' ' + test_rand() % 95) : (round == 2) ? 'a' : 0xFF;
+        }
+        for (size_t n = 0; n <= sizeof(buf); n += (n < 100) ? 1 : 997)
+        {
+            uint64_t expected[CHARUTIL_CLASS_COUNT] = {0};
+            uint64_t classes[CHARUTIL_CLASS_COUNT] = {0};
+            reference_class_counts(buf, n, expected);
+            const size_t done = count(buf, n, classes);
+            assert(done <= n);
+            reference_class_counts(buf + done, n - done, classes);
+            assert(memcmp(classes, expected, sizeof(expected)) == 0);
+        }
+    }
+}
+
+void test_class_counts(void)
+{
+    test_class_count_kernel(charutil_class_count_none);
+#if defined(CHARUTIL_HAVE_SSE2)
+    test_class_count_kernel(charutil_class_count_sse2);
+#endif
+#if defined(CHARUTIL_HAVE_AVX2)
+    if (TEST_CPU_HAS_AVX2)
+    {
+        test_class_count_kernel(charutil_class_count_avx2);
+    }
+#endif
+#if defined(CHARUTIL_HAVE_NEON)
+    test_class_count_kernel(charutil_class_count_neon);
+#endif
+    test_class_count_kernel(charutil_class_count_blocks);
+
+    static unsigned char buf[5000];
+    for (size_t i = 0; i < sizeof(buf); i++)
+    {
+        buf[i] = (i < 256) ? (unsigned char)i : (test_rand() % 4) ? (unsigned char)(' ' + test_rand() % 95) : (unsigned char)test_rand();
+    }
+    for (size_t n = 0; n <= sizeof(buf); n += (n < 300) ? 1 : 211)
+    {
+        uint64_t expected[CHARUTIL_CLASS_COUNT] = {0};
+        uint64_t expected_histogram[256] = {0};
+        reference_class_counts(buf, n, expected);
+        for (size_t i = 0; i < n; i++)
+        {
+            expected_histogram[buf[i]]++;
+        }
+
+        charutil_class_counts_t counts;
+        uint64_t histogram[256];
+        memset(histogram, 0x55, sizeof(histogram));
+        charutil_class_counts(buf, n, &counts, histogram);
+        assert(counts.total == n);
+        assert(memcmp(counts.classes, expected, sizeof(expected)) == 0);
+        assert(memcmp(histogram, expected_histogram, sizeof(histogram)) == 0);
+
+        charutil_class_counts(buf, n, &counts, NULL);
+        assert(counts.total == n);
+        assert(memcmp(counts.classes, expected, sizeof(expected)) == 0);
+
+        // Chunked input adds up to the same counts
+        const size_t split = n / 3;
+        charutil_class_counts(buf, split, &counts, histogram);
+        charutil_class_counts_add(buf + split, n - split, &counts, histogram);
+        assert(counts.total == n);
+        assert(memcmp(counts.classes, expected, sizeof(expected)) == 0);
+        assert(memcmp(histogram, expected_histogram, sizeof(histogram)) == 0);
+        charutil_class_counts(buf, split, &counts, NULL);
+        charutil_class_counts_add(buf + split, n - split, &counts, NULL);
+        assert(counts.total == n);
+        assert(memcmp(counts.classes, expected, sizeof(expected)) == 0);
+    }
+
+    {
+        charutil_class_counts_t counts;
+        charutil_class_counts("Hex 0xBEEF;\n", 12, &counts, NULL);
+        assert(charutil_class_count(&counts, CHARUTIL_CLASS_HEX_DIGIT) == 6);
+        assert(charutil_class_count(&counts, CHARUTIL_CLASS_UPPER) == 5);
+        assert(charutil_class_count(&counts, CHARUTIL_CLASS_SPACE) == 2);
+        assert(charutil_class_count(&counts, CHARUTIL_CLASS_PRINTABLE) == 11);
+        assert(charutil_class_count(&counts, CHARUTIL_CLASS_SYMBOL) == 1);
+    }
+
+    printf("Class count tests passed!\n");
+}
+
+typedef void (*case_buf_fn)(char *dst, const char *src, size_t n, charutil_case_op_t op);
+
+void test_case_buf_kernel(case_buf_fn convert)
+{
+    char src[300];
+    char dst[300];
+
+    for (size_t i = 0; i < sizeof(src); i++)
+    {
+        src[i] = (char)(i * 37 + 11);
+    }
+
+    for (int op = CHARUTIL_CASE_LOWER; op <= CHARUTIL_CASE_TOGGLE; op++)
+    {
+        for (size_t offset = 0; offset < 8; offset++)
+        {
+            for (size_t n = 0; n + offset <= 72; n++)
+            {
+                memset(dst, 0x55, sizeof(dst));
+                convert(dst + offset, src + offset, n, (charutil_case_op_t)op);
+                for (size_t i = 0; i < n; i++)
+                {
+                    const unsigned char ch = (unsigned char)src[offset + i];
+                    const int expected = (op == CHARUTIL_CASE_LOWER) ? TO_LOWER(ch) : (op == CHARUTIL_CASE_UPPER) ? TO_UPPER(ch) : TOGGLE_CASE(ch);
+                    assert((unsigned char)dst[offset + i] == expected);
+                }
+                assert(dst[offset + n] == 0x55);
+            }
+        }
+
+        // In place over every byte value
+        memcpy(dst, src, sizeof(src));
+        convert(dst, dst, sizeof(dst), (charutil_case_op_t)op);
+        for (size_t i = 0; i < sizeof(src); i++)
+        {
+            assert(dst[i] == (char)charutil_case_byte((unsigned char)src[i], (charutil_case_op_t)op));
+        }
+    }
+}
+
+void test_case_buf(void)
+{
+    test_case_buf_kernel(charutil_case_buf_scalar);
+    test_case_buf_kernel(charutil_case_buf_swar);
+#if defined(CHARUTIL_HAVE_SSE2)
+    test_case_buf_kernel(charutil_case_buf_sse2);
+#endif
+#if defined(CHARUTIL_HAVE_AVX2)
+    if (TEST_CPU_HAS_AVX2)
+    {
+        test_case_buf_kernel(charutil_case_buf_avx2);
+    }
+#endif
+#if defined(CHARUTIL_HAVE_NEON)
+    test_case_buf_kernel(charutil_case_buf_neon);
+#endif
+    test_case_buf_kernel(charutil_case_buf);
+
+    {
+        char header[] = "Content-Type: Text/HTML; charset=UTF-8";
+        charutil_to_lower_inplace(header, sizeof(header) - 1);
+        assert(strcmp(header, "content-type: text/html; charset=utf-8") == 0);
+        charutil_to_upper_inplace(header, sizeof(header) - 1);
+        assert(strcmp(header, "CONTENT-TYPE: TEXT/HTML; CHARSET=UTF-8") == 0);
+        charutil_toggle_case_inplace(header, 7);
+        assert(strcmp(header, "content-TYPE: TEXT/HTML; CHARSET=UTF-8") == 0);
+    }
+
+    {
+        const char a[] = "X-Forwarded-For: 10.0.0.1, Proxy-Authorization [\xC9]";
+        const char b[] = "x-forwarded-for: 10.0.0.1, PROXY-AUTHORIZATION [\xC9]";
+        const char c[] = "x-forwarded-for: 10.0.0.1, PROXY-AUTHORIZATION [\xE9]";
+        assert(charutil_casecmp(a, b, sizeof(a) - 1) == 0);
+        assert(charutil_casehash(a, sizeof(a) - 1) == charutil_casehash(b, sizeof(b) - 1));
+        assert(charutil_casecmp(a, c, sizeof(a) - 1) < 0);
+        assert(charutil_casecmp(c, a, sizeof(a) - 1) > 0);
+        assert(charutil_casecmp("abc[", "ABC{", 4) < 0);
+        for (size_t n = 0; n < sizeof(a) - 1; n++)
+        {
+            assert(charutil_casehash(a, n) == charutil_casehash(b, n));
+            assert(charutil_casehash(a, n) != charutil_casehash(a, n + 1));
+        }
+    }
+
+    printf("Bulk case conversion tests passed!\n");
+}
+
+static int sign_of(int v)
+{
+    return (v > 0) - (v < 0);
+}
+
+static int natural_key_cmp(const unsigned char *a, size_t an, const unsigned char *b, size_t bn)
+{
+    return memcmp(a, b, an < bn ? an : bn);
+}
+
+static int natural_qsort_cmp(const void *a, const void *b)
+{
+    const char *sa = *(const char *const *)a;
+    const char *sb = *(const char *const *)b;
+    return charutil_natural_cmp(sa, strlen(sa), sb, strlen(sb), CHARUTIL_NATURAL_FOLD_CASE);
+}
+
+void test_natural_sort(void)
+{
+    {
+        const char *names[] = {"v1.10", "file10", "File9", "file09", "file9", "v1.2.10", "v1.2.9", "file", "v1.9", "", "file0", "file00", "file_1", "file1b"};
+        const char *sorted[] = {"", "file", "file0", "file00", "file1b", "File9", "file9", "file09", "file10", "file_1", "v1.2.9", "v1.2.10", "v1.9", "v1.10"};
+        const size_t count = sizeof(names) / sizeof(names[0]);
+        qsort(names, count, sizeof(names[0]), natural_qsort_cmp);
+        for (size_t i = 0; i < count; i++)
+        {
+            // "File9" and "file9" tie when folded, qsort may put either first
+            assert(charutil_casecmp(names[i], sorted[i], strlen(sorted[i]) + 1) == 0);
+        }
+        assert(charutil_natural_cmp("File9", 5, "file9", 5, CHARUTIL_NATURAL_DEFAULT) < 0);
+        assert(charutil_natural_cmp("a1", 2, "a:", 2, CHARUTIL_NATURAL_DEFAULT) < 0);
+        assert(charutil_natural_cmp("a1", 2, "a/", 2, CHARUTIL_NATURAL_DEFAULT) > 0);
+    }
+
+    {
+        // The key of "x007y" with every field spelled out
+        const unsigned char expected[] = {'x' + 1, '0' + 1, 1, 0x70, 2, 'y' + 1, 0};
+        unsigned char key[CHARUTIL_NATURAL_SORTKEY_MAX(5)];
+        assert(charutil_natural_sortkey(NULL, 0, "x007y", 5, 0) == sizeof(expected));
+        assert(charutil_natural_sortkey(key, sizeof(key), "x007y", 5, 0) == sizeof(expected));
+        assert(memcmp(key, expected, sizeof(expected)) == 0);
+    }
+
+    {
+        // Digit runs of 255 or more significant digits or zeros take the long count form
+        static char a[700];
+        static char b[700];
+        static unsigned char ka[CHARUTIL_NATURAL_SORTKEY_MAX(700)];
+        static unsigned char kb[CHARUTIL_NATURAL_SORTKEY_MAX(700)];
+        memset(a, '9', 300);
+        memset(b, '0', 400);
+        b[400] = '1';
+        memset(b + 401, '0', 299);
+        const size_t ka_len = charutil_natural_sortkey(ka, sizeof(ka), a, 300, 0);
+        const size_t kb_len = charutil_natural_sortkey(kb, sizeof(kb), b, 700, 0);
+        assert(ka_len == 1 + 9 + 150 + 1 + 1 && kb_len == 1 + 9 + 150 + 9 + 1);
+        assert(charutil_natural_cmp(a, 300, b, 700, 0) > 0 && natural_key_cmp(ka, ka_len, kb, kb_len) > 0);
+        memset(b + 400, '9', 300); // Same value, more leading zeros
+        assert(charutil_natural_cmp(a, 300, b, 700, 0) < 0);
+        assert(natural_key_cmp(ka, ka_len, kb, charutil_natural_sortkey(kb, sizeof(kb), b, 700, 0)) < 0);
+    }
+
+    // Random strings: key order matches charutil_natural_cmp() for every pair, and sorting by it leaves the keys in order
+    static const char alphabet[] = "0012399aAzZ./:_\xFE\xFF";
+    enum
+    {
+        COUNT = 300,
+        MAX_LEN = 16
+    };
+    static char text[COUNT][MAX_LEN];
+    static size_t len[COUNT];
+    static unsigned char key[COUNT][CHARUTIL_NATURAL_SORTKEY_MAX(MAX_LEN)];
+    static size_t key_len[COUNT];
+    for (unsigned flags = 0; flags < 2; flags++)
+    {
+        for (size_t i = 0; i < COUNT; i++)
+        {
+            len[i] = test_rand() % MAX_LEN;
+            for (size_t k = 0; k < len[i]; k++)
+            {
+                text[i][k] = alphabet[test_rand() % (sizeof(alphabet) - 1)];
+            }
+            key_len[i] = charutil_natural_sortkey(key[i], sizeof(key[i]), text[i], len[i], flags);
+            assert(key_len[i] <= CHARUTIL_NATURAL_SORTKEY_MAX(len[i]) && key[i][key_len[i] - 1] == 0);
+            assert(charutil_natural_sortkey(NULL, 0, text[i], len[i], flags) == key_len[i]);
+            unsigned char clipped[CHARUTIL_NATURAL_SORTKEY_MAX(MAX_LEN)];
+            const size_t cap = test_rand() % key_len[i];
+            memset(clipped, 0xAA, sizeof(clipped));
+            assert(charutil_natural_sortkey(clipped, cap, text[i], len[i], flags) == key_len[i]);
+            assert(memcmp(clipped, key[i], cap) == 0 && clipped[cap] == 0xAA);
+        }
+        for (size_t i = 0; i < COUNT; i++)
+        {
+            for (size_t j = 0; j < COUNT; j++)
+            {
+                const int order = sign_of(charutil_natural_cmp(text[i], len[i], text[j], len[j], flags));
+                assert(order == sign_of(natural_key_cmp(key[i], key_len[i], key[j], key_len[j])));
+                assert(order == -sign_of(charutil_natural_cmp(text[j], len[j], text[i], len[i], flags)));
+                assert((order == 0) == (key_len[i] == key_len[j] && memcmp(key[i], key[j], key_len[i]) == 0));
+            }
+        }
+    }
+
+    printf("Natural sort tests passed!\n");
+}
+
+typedef size_t (*hex_encode_fn)(char *dst, const void *src, size_t n, charutil_hex_case_t hex_case);
+typedef size_t (*hex_decode_fn)(void *dst, const char *src, size_t n, size_t *err_pos);
+
+void test_hex_bulk_kernel(hex_encode_fn encode, hex_decode_fn decode)
+{
+    unsigned char bytes[300];
+    unsigned char decoded[300];
+    char hex[600];
+
+    for (int i = 0; i < (int)sizeof(bytes); i++)
+    {
+        bytes[i] = (unsigned char)(i * 7 + 3);
+    }
+
+    for (size_t n = 0; n <= sizeof(bytes); n++)
+    {
+        assert(encode(hex, bytes, n, CHARUTIL_HEX_UPPERCASE) == 2 * n);
+        for (size_t i = 0; i < n; i++)
+        {
+            assert(hex[2 * i] == NIBBLE_TO_UPPERCASE_HEX(HIGH_NIBBLE(bytes[i]), -1));
+            assert(hex[2 * i + 1] == NIBBLE_TO_UPPERCASE_HEX(LOW_NIBBLE(bytes[i]), -1));
+        }
+
+        size_t err_pos = 0;
+        memset(decoded, 0, sizeof(decoded));
+        assert(decode(decoded, hex, 2 * n, &err_pos) == n);
+        assert(err_pos == 2 * n);
+        assert(memcmp(decoded, bytes, n) == 0);
+
+        assert(encode(hex, bytes, n, CHARUTIL_HEX_LOWERCASE) == 2 * n);
+        for (size_t i = 0; i < n; i++)
+        {
+            assert(hex[2 * i] == NIBBLE_TO_LOWERCASE_HEX(HIGH_NIBBLE(bytes[i]), -1));
+            assert(hex[2 * i + 1] == NIBBLE_TO_LOWERCASE_HEX(LOW_NIBBLE(bytes[i]), -1));
+        }
+    }
+
+    // Every byte value through the decoder, in both nibble positions
+    for (int ch = 0; ch < 256; ch++)
+    {
+        char pair[64];
+        memset(pair, '0', sizeof(pair));
+        for (size_t pos = 0; pos < sizeof(pair); pos++)
+        {
+            size_t err_pos = 0;
+            pair[pos] = (char)ch;
+            const size_t written = decode(decoded, pair, sizeof(pair), &err_pos);
+            if (HEX_TO_INT(ch, -1) >= 0)
+            {
+                assert(written == sizeof(pair) / 2);
+                assert(err_pos == sizeof(pair));
+                assert(decoded[pos / 2] == ((pos & 1) ? HEX_TO_INT(ch, -1) : HEX_TO_INT(ch, -1) << 4));
+            }
+            else
+            {
+                assert(written == pos / 2);
+                assert(err_pos == pos);
+            }
+            pair[pos] = '0';
+        }
+    }
+
+    // Dangling nibble: err_pos is the last index with a hex digit there, unlike a bad last character
+    {
+        size_t err_pos = 0;
+        assert(decode(decoded, "ABC", 3, &err_pos) == 1);
+        assert(decoded[0] == 0xAB);
+        assert(err_pos == 2 && IS_HEX_DIGIT("ABC"[err_pos]));
+        assert(decode(decoded, "ABx", 3, &err_pos) == 1 && err_pos == 2 && !IS_HEX_DIGIT("ABx"[err_pos]));
+        assert(decode(decoded, "AxC", 3, &err_pos) == 0 && err_pos == 1);
+        assert(decode(decoded, "ABCx", 4, &err_pos) == 1 && err_pos == 3 && !IS_HEX_DIGIT("ABCx"[err_pos]));
+        memcpy(hex, "0123456789abcdef0123456789abcdef0", 33);
+        assert(decode(decoded, hex, 33, &err_pos) == 16 && err_pos == 32 && IS_HEX_DIGIT(hex[err_pos]));
+    }
+}
+
+void test_hex_bulk(void)
+{
+    test_hex_bulk_kernel(charutil_hex_encode_scalar, charutil_hex_decode_scalar);
+    test_hex_bulk_kernel(charutil_hex_encode_scalar, charutil_hex_decode_swar);
+#if defined(CHARUTIL_HAVE_SSE2)
+    test_hex_bulk_kernel(charutil_hex_encode_sse2, charutil_hex_decode_sse2);
+#endif
+#if defined(CHARUTIL_HAVE_AVX2)
+    if (TEST_CPU_HAS_AVX2)
+    {
+        test_hex_bulk_kernel(charutil_hex_encode_avx2, charutil_hex_decode_avx2);
+    }
+#endif
+#if defined(CHARUTIL_HAVE_NEON)
+    test_hex_bulk_kernel(charutil_hex_encode_neon, charutil_hex_decode_neon);
+#endif
+    test_hex_bulk_kernel(charutil_hex_encode, charutil_hex_decode);
+
+    printf("Bulk hex tests passed!\n");
+}
+
+void test_hex_fused(void)
+{
+    // Every pair of bytes against HEX_TO_INT
+    for (unsigned a = 0; a < 256; a++)
+    {
+        for (unsigned b = 0; b < 256; b++)
+        {
+            const char pair[2] = {(char)a, (char)b};
+            const int hi = HEX_TO_INT((int)a, -1);
+            const int lo = HEX_TO_INT((int)b, -1);
+            uint64_t err = 0;
+            const uint8_t value = charutil_hex_pair_to_byte(pair, &err);
+            assert((err != 0) == (hi < 0 || lo < 0));
+            assert(err || value == ((hi << 4) | lo));
+        }
+    }
+
+    {
+        uint64_t err = 0;
+        assert(charutil_hex_decode_u32("DeadBeef", &err) == 0xDEADBEEFu && err == 0);
+        assert(charutil_hex_decode_u64("0123456789abcdef", &err) == 0x0123456789ABCDEFull && err == 0);
+        assert(charutil_hex_decode_u64("FEDCBA9876543210", &err) == 0xFEDCBA9876543210ull && err == 0);
+        charutil_hex_decode_u32("0000000g", &err);
+        assert(err != 0);
+        // The mask accumulates across calls
+        charutil_hex_decode_u32("00000000", &err);
+        assert(err != 0);
+    }
+
+    // Random words, with one character replaced by every byte value in turn
+    for (int round = 0; round < 2000; round++)
+    {
+        static const char digits[] = "0123456789abcdefABCDEF";
+        char text[17];
+        uint64_t expected = 0;
+        for (int k = 0; k < 16; k++)
+        {
+            text[k] = digits[test_rand() % 22];
+            expected = (expected << 4) | (uint64_t)HEX_TO_INT(text[k], 0);
+        }
+        text[16] = '\0';
+        uint64_t err = 0;
+        assert(charutil_hex_decode_u64(text, &err) == expected && err == 0);
+        assert(charutil_hex_decode_u32(text + 8, &err) == (uint32_t)expected && err == 0);
+
+        const int pos = (int)(test_rand() % 16);
+        for (unsigned ch = 0; ch < 256; ch++)
+        {
+            text[pos] = (char)ch;
+            err = 0;
+            charutil_hex_decode_u64(text, &err);
+            assert((err != 0) == (HEX_TO_INT((int)ch, -1) < 0));
+        }
+    }
+
+    printf("Fused hex decode tests passed!\n");
+}
+
+void test_parse_against_strtoull(const char *text, unsigned base)
+{
+    char *end = NULL;
+    uint64_t value = 0xDEADBEEF;
+    errno = 0;
+    const unsigned long long expected = strtoull(text, &end, (int)base);
+    const size_t used = charutil_parse_u64(text, strlen(text), base, &value);
+    if (end == text || errno == ERANGE)
+    {
+        assert(used == 0);
+        assert(value == 0xDEADBEEF);
+    }
+    else
+    {
+        assert(used == (size_t)(end - text));
+        assert(value == expected);
+    }
+}
+
+void test_integer_parsing(void)
+{
+    static const unsigned bases[] = {2, 8, 10, 16};
+    static const char digits[] = "0123456789abcdefABCDEF";
+
+    for (size_t b = 0; b < sizeof(bases) / sizeof(bases[0]); b++)
+    {
+        const unsigned base = bases[b];
+        for (int round = 0; round < 20000; round++)
+        {
+            char text[80];
+            const size_t len = test_rand() % 70;
+            for (size_t i = 0; i < len; i++)
+            {
+                const uint64_t r = test_rand();
+                // Mostly valid digits with the occasional out of base character
+                text[i] = (r % 64 == 0) ? (char)(r >> 8) : digits[(r >> 8) % (base == 16 ? 22 : base)];
+            }
+            text[len] = '\0';
+            // Avoid strtoull's own whitespace, sign and "0x"/"0b" prefix handling
+            if (len > 0 && (IS_SPACE(text[0]) || text[0] == '-' || text[0] == '+'))
+            {
+                text[0] = '1';
+            }
+            if (len > 1 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X' || text[1] == 'b' || text[1] == 'B'))
+            {
+                text[0] = '1';
+            }
+            test_parse_against_strtoull(text, base);
+        }
+    }
+
+    // Boundaries
+    test_parse_against_strtoull("18446744073709551615", 10);
+    test_parse_against_strtoull("18446744073709551616", 10);
+    test_parse_against_strtoull("99999999999999999999", 10);
+    test_parse_against_strtoull("00000000000000000000000000000018446744073709551615", 10);
+    test_parse_against_strtoull("FFFFFFFFFFFFFFFF", 16);
+    test_parse_against_strtoull("10000000000000000", 16);
+    test_parse_against_strtoull("0000000000000000fFfFfFfFfFfFfFfF", 16);
+    test_parse_against_strtoull("0000000100000000000000000", 16);
+    test_parse_against_strtoull("1777777777777777777777", 8);
+    test_parse_against_strtoull("2000000000000000000000", 8);
+    test_parse_against_strtoull("1111111111111111111111111111111111111111111111111111111111111111", 2);
+    test_parse_against_strtoull("11111111111111111111111111111111111111111111111111111111111111110", 2);
+
+    {
+        uint64_t u = 0;
+        assert(charutil_parse_u64("12345678x", 9, 10, &u) == 8 && u == 12345678);
+        assert(charutil_parse_u64("1234567890123", 5, 10, &u) == 5 && u == 12345);
+        assert(charutil_parse_u64("", 0, 10, &u) == 0);
+        assert(charutil_parse_u64("123", 3, 7, &u) == 0);
+        assert(charutil_parse_u64("10110011", 8, 2, &u) == 8 && u == 0xB3);
+    }
+
+    {
+        int64_t v = 0;
+        assert(charutil_parse_i64("-9223372036854775808", 20, 10, &v) == 20 && v == INT64_MIN);
+        assert(charutil_parse_i64("9223372036854775807", 19, 10, &v) == 19 && v == INT64_MAX);
+        assert(charutil_parse_i64("+9223372036854775807", 20, 10, &v) == 20 && v == INT64_MAX);
+        assert(charutil_parse_i64("9223372036854775808", 19, 10, &v) == 0);
+        assert(charutil_parse_i64("-9223372036854775809", 20, 10, &v) == 0);
+        assert(charutil_parse_i64("-ff,", 4, 16, &v) == 3 && v == -255);
+        assert(charutil_parse_i64("-0", 2, 10, &v) == 2 && v == 0);
+        assert(charutil_parse_i64("-", 1, 10, &v) == 0);
+    }
+
+    printf("Integer parsing tests passed!\n");
+}
+
+void test_format_value(uint64_t v)
+{
+    char text[CHARUTIL_U64_BIN_MAX + 1];
+    char expected[CHARUTIL_U64_BIN_MAX + 1];
+    uint64_t parsed = 0;
+    size_t len;
+
+    len = charutil_format_u64_dec(text, v);
+    snprintf(expected, sizeof(expected), "%llu", (unsigned long long)v);
+    assert(len == strlen(expected) && memcmp(text, expected, len) == 0);
+    assert(charutil_parse_u64(text, len, 10, &parsed) == len && parsed == v);
+
+    len = charutil_format_u64_hex(text, v, CHARUTIL_HEX_LOWERCASE);
+    snprintf(expected, sizeof(expected), "%llx", (unsigned long long)v);
+    assert(len == strlen(expected) && memcmp(text, expected, len) == 0);
+    assert(charutil_parse_u64(text, len, 16, &parsed) == len && parsed == v);
+
+    len = charutil_format_u64_hex(text, v, CHARUTIL_HEX_UPPERCASE);
+    snprintf(expected, sizeof(expected), "%llX", (unsigned long long)v);
+    assert(len == strlen(expected) && memcmp(text, expected, len) == 0);
+    assert(charutil_parse_u64(text, len, 16, &parsed) == len && parsed == v);
+
+    len = charutil_format_u64_oct(text, v);
+    snprintf(expected, sizeof(expected), "%llo", (unsigned long long)v);
+    assert(len == strlen(expected) && memcmp(text, expected, len) == 0);
+    assert(charutil_parse_u64(text, len, 8, &parsed) == len && parsed == v);
+
+    len = charutil_format_u64_bin(text, v);
+    assert(len <= CHARUTIL_U64_BIN_MAX);
+    assert(charutil_parse_u64(text, len, 2, &parsed) == len && parsed == v);
+    assert(text[0] == '1' || (v == 0 && len == 1 && text[0] == '0'));
+
+    {
+        int64_t signed_parsed = 0;
+        len = charutil_format_i64_dec(text, (int64_t)v);
+        snprintf(expected, sizeof(expected), "%lld", (long long)(int64_t)v);
+        assert(len == strlen(expected) && memcmp(text, expected, len) == 0);
+        assert(charutil_parse_i64(text, len, 10, &signed_parsed) == len && signed_parsed == (int64_t)v);
+    }
+}
+
+void test_integer_formatting(void)
 {
+    // Every power of two and ten, and their neighbours, covers every length boundary
+    for (int bit = 0; bit < 64; bit++)
+    {
+        const uint64_t v = 1ull << bit;
+        test_format_value(v - 1);
+        test_format_value(v);
+        test_format_value(v + 1);
+    }
+    for (uint64_t v = 1; v <= 10000000000000000000ull; v *= 10)
+    {
+        test_format_value(v - 1);
+        test_format_value(v);
+        test_format_value(v + 1);
+        if (v == 10000000000000000000ull)
+        {
+            break;
+        }
+    }
+    test_format_value(UINT64_MAX);
+    test_format_value((uint64_t)INT64_MIN);
+    for (uint64_t v = 0; v < 100000; v++)
+    {
+        test_format_value(v);
+    }
+    for (int round = 0; round < 100000; round++)
+    {
+        // Vary the bit length so short values are as common as long ones
+        test_format_value(test_rand() >> (test_rand() % 64));
+    }
+
+    printf("Integer formatting tests passed!\n");
+}
+
+void test_diagnostics_table(void)
+{
+    static const char *control_names[32] = {"NUL", "SOH", "STX", "ETX", "EOT", "ENQ", "ACK", "BEL", "BS",  "TAB", "LF", "VT", "FF", "CR", "SO", "SI",
+                                            "DLE", "DC1", "DC2", "DC3", "DC4", "NAK", "SYN", "ETB", "CAN", "EM",  "SUB", "ESC", "FS", "GS", "RS", "US"};
+    size_t pointer_table_size = 256 * sizeof(const char *);
+
+    for (int ch = 0; ch < 256; ch++)
+    {
+        char expected[8];
+        if (ch < 32)
+        {
+            snprintf(expected, sizeof(expected), "[%s]", control_names[ch]);
+        }
+        else if (ch == 127)
+        {
+            snprintf(expected, sizeof(expected), "[DEL]");
+        }
+        else if (ch > 127)
+        {
+            snprintf(expected, sizeof(expected), "[0x%02X]", ch);
+        }
+        else
+        {
+            snprintf(expected, sizeof(expected), "%c", ch);
+        }
+        assert(strcmp(ascii_to_diagnostics(ch), expected) == 0);
+        pointer_table_size += strlen(expected) + 1;
+    }
+
+    // Fixed slots must beat an array of pointers to separately stored literals
+    assert(sizeof(charutil_diagnostics_slots) < pointer_table_size);
+    printf("Diagnostics table: %zu bytes in slots vs %zu bytes as pointers + literals\n", sizeof(charutil_diagnostics_slots), pointer_table_size);
+}
+
+void test_diagnostics_escape(void)
+{
+    unsigned char src[600];
+    char expected[600 * 6 + 1];
+    char out[600 * 6 + 1];
+
+    for (size_t i = 0; i < sizeof(src); i++)
+    {
+        // Every byte value, then mostly printable text with the odd control byte
+        src[i] = (i < 256) ? (unsigned char)i : (test_rand() % 16 == 0) ? (unsigned char)test_rand() : (unsigned char)(' ' + test_rand() % 95);
+    }
+
+    for (size_t n = 0; n <= sizeof(src); n += (n < 80) ? 1 : 37)
+    {
+        expected[0] = '\0';
+        for (size_t i = 0; i < n; i++)
+        {
+            strcat(expected, ascii_to_diagnostics(src[i]));
+        }
+        const size_t expected_len = strlen(expected);
+
+        assert(charutil_diagnostics_escape(NULL, 0, src, n) == expected_len);
+        memset(out, 0x55, sizeof(out));
+        assert(charutil_diagnostics_escape(out, sizeof(out), src, n) == expected_len);
+        assert(strcmp(out, expected) == 0);
+
+        // Truncated output is a NUL terminated prefix
+        for (size_t cap = 1; cap < 40; cap++)
+        {
+            memset(out, 0x55, sizeof(out));
+            assert(charutil_diagnostics_escape(out, cap, src, n) == expected_len);
+            const size_t kept = expected_len < cap - 1 ? expected_len : cap - 1;
+            assert(strlen(out) == kept);
+            assert(memcmp(out, expected, kept) == 0);
+            assert(out[cap] == 0x55);
+        }
+    }
+
+    {
+        const char line[] = "OK\r\n\x80";
+        char buf[32];
+        assert(charutil_diagnostics_escape(buf, sizeof(buf), line, sizeof(line) - 1) == 16);
+        assert(strcmp(buf, "OK[CR][LF][0x80]") == 0);
+    }
+
+    printf("Diagnostics escape tests passed!\n");
+}
+
+/// Straightforward reference: decode each sequence and check the code point range
+bool reference_utf8_valid(const unsigned char *p, size_t n)
+{
+    size_t i = 0;
+    while (i < n)
+    {
+        const unsigned char b = p[i];
+        size_t len;
+        uint32_t cp;
+        if (b < 0x80)
+        {
+            i++;
+            continue;
+        }
+        else if ((b & 0xE0) == 0xC0)
+        {
+            len = 2;
+            cp = b & 0x1F;
+        }
+        else if ((b & 0xF0) == 0xE0)
+        {
+            len = 3;
+            cp = b & 0x0F;
+        }
+        else if ((b & 0xF8) == 0xF0)
+        {
+            len = 4;
+            cp = b & 0x07;
+        }
+        else
+        {
+            return false;
+        }
+        if (i + len > n)
+        {
+            return false;
+        }
+        for (size_t k = 1; k < len; k++)
+        {
+            if ((p[i + k] & 0xC0) != 0x80)
+            {
+                return false;
+            }
+            cp = (cp << 6) | (p[i + k] & 0x3F);
+        }
+        const uint32_t min_cp[5] = {0, 0, 0x80, 0x800, 0x10000};
+        if (cp < min_cp[len] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+        {
+            return false;
+        }
+        i += len;
+    }
+    return true;
+}
+
+size_t encode_utf8(unsigned char *out, uint32_t cp)
+{
+    if (cp < 0x80)
+    {
+        out[0] = (unsigned char)cp;
+        return 1;
+    }
+    if (cp < 0x800)
+    {
+        out[0] = (unsigned char)(0xC0 | (cp >> 6));
+        out[1] = (unsigned char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000)
+    {
+        out[0] = (unsigned char)(0xE0 | (cp >> 12));
+        out[1] = (unsigned char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (unsigned char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (unsigned char)(0xF0 | (cp >> 18));
+    out[1] = (unsigned char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (unsigned char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (unsigned char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+/// Checks one shot validation and every two way chunk split against the reference
+void check_utf8(const unsigned char *p, size_t n, bool all_splits)
+{
+    const bool expected = reference_utf8_valid(p, n);
+    assert(charutil_utf8_validate(p, n) == expected);
+    for (size_t split = 0; split <= n; split += all_splits ? 1 : 13)
+    {
+        charutil_utf8_state_t st;
+        charutil_utf8_init(&st);
+        charutil_utf8_update(&st, p, split);
+        charutil_utf8_update(&st, p + split, n - split);
+        assert(charutil_utf8_finish(&st) == expected);
+    }
+}
+
+void test_utf8_validation(void)
+{
+    unsigned char buf[256];
+
+    // Every code point and every surrogate, alone and after an ASCII prefix that pushes it across block edges
+    for (uint32_t cp = 0; cp <= 0x10FFFF; cp++)
+    {
+        size_t prefix = cp % 67;
+        memset(buf, 'a', prefix);
+        size_t len = prefix + encode_utf8(buf + prefix, cp);
+        assert(charutil_utf8_validate(buf, len) == !(cp >= 0xD800 && cp <= 0xDFFF));
+    }
+
+    // Every 1 and 2 byte input, every 3 byte input with a valid or invalid leading byte
+    for (int a = 0; a < 256; a++)
+    {
+        buf[0] = (unsigned char)a;
+        check_utf8(buf, 1, true);
+        for (int b = 0; b < 256; b++)
+        {
+            buf[1] = (unsigned char)b;
+            check_utf8(buf, 2, true);
+            for (int c = 0x70; c < 0xD0; c += 7)
+            {
+                buf[2] = (unsigned char)c;
+                assert(charutil_utf8_validate(buf, 3) == reference_utf8_valid(buf, 3));
+            }
+        }
+    }
+
+    // Mutated multilingual text of many lengths
+    for (int round = 0; round < 20000; round++)
+    {
+        size_t len = 0;
+        const size_t target = test_rand() % 200;
+        while (len + 4 <= target)
+        {
+            const uint64_t r = test_rand();
+            const uint32_t ranges[4] = {0x7F, 0x7FF, 0xFFFF, 0x10FFFF};
+            uint32_t cp = (uint32_t)(r >> 8) % (ranges[r % 4] + 1);
+            if (r % 3 == 0)
+            {
+                cp &= 0x7F; // Keep plenty of ASCII runs
+            }
+            if (cp >= 0xD800 && cp <= 0xDFFF)
+            {
+                cp = 'x';
+            }
+            len += encode_utf8(buf + len, cp);
+        }
+        if (len > 0 && test_rand() % 2)
+        {
+            buf[test_rand() % len] = (unsigned char)test_rand();
+        }
+        check_utf8(buf, len, round < 2000);
+    }
+
+    {
+        const char text[] = "plain ascii then caf\xC3\xA9, \xE2\x82\xAC and \xF0\x9F\x98\x80";
+        assert(charutil_utf8_validate(text, sizeof(text) - 1));
+        assert(!charutil_utf8_validate(text, sizeof(text) - 2));     // truncated emoji
+        assert(!charutil_utf8_validate("\xC0\xAF", 2));              // overlong '/'
+        assert(!charutil_utf8_validate("\xED\xA0\x80", 3));          // surrogate
+        assert(!charutil_utf8_validate("\xF4\x90\x80\x80", 4));      // > U+10FFFF
+    }
+
+    printf("UTF-8 validation tests passed!\n");
+}
+
+/// Table driven reference encoder, independent of the arithmetic digit mapping
+size_t reference_base64_encode(char *dst, const unsigned char *s, size_t n, unsigned flags)
+{
+    const char *alphabet = (flags & CHARUTIL_BASE64_URL) ? "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_" : "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t out = 0;
+    for (size_t i = 0; i < n; i += 3)
+    {
+        const size_t rest = (n - i < 3) ? n - i : 3;
+        uint32_t w = 0;
+        for (size_t k = 0; k < 3; k++)
+        {
+            w = (w << 8) | ((k < rest) ? s[i + k] : 0u);
+        }
+        for (size_t k = 0; k <= rest; k++)
+        {
+            dst[out++] = alphabet[(w >> (18 - 6 * k)) & 0x3F];
+        }
+        for (size_t k = rest; k < 3 && !(flags & CHARUTIL_BASE64_NOPAD); k++)
+        {
+            dst[out++] = '=';
+        }
+    }
+    return out;
+}
+
+/// Encodes and decodes one buffer with every codec, decoding in one shot and in two chunks split at every position
+void check_base_codecs(const unsigned char *bytes, size_t n, bool all_splits)
+{
+    static char text[700];
+    static char expected[700];
+    static unsigned char decoded[700];
+    size_t err_pos;
+
+    for (unsigned flags = 0; flags < 4; flags++)
+    {
+        const size_t len = charutil_base64_encode(text, bytes, n, flags);
+        assert(len == reference_base64_encode(expected, bytes, n, flags));
+        assert(memcmp(text, expected, len) == 0);
+        assert(len <= CHARUTIL_BASE64_ENCODED_MAX(n));
+        assert(charutil_base64_decode(decoded, text, len, flags, &err_pos) == n);
+        assert(err_pos == len);
+        assert(memcmp(decoded, bytes, n) == 0);
+        for (size_t split = 0; split <= len; split += all_splits ? 1 : 7)
+        {
+            charutil_base_decoder_t st;
+            charutil_base64_decode_init(&st, flags);
+            size_t written = charutil_base64_decode_update(&st, decoded, text, split);
+            assert(written <= CHARUTIL_BASE64_DECODED_MAX(split));
+            written += charutil_base64_decode_update(&st, decoded + written, text + split, len - split);
+            assert(charutil_base64_decode_finish(&st));
+            assert(written == n && memcmp(decoded, bytes, n) == 0);
+        }
+    }
+
+    for (int pad = 0; pad < 2; pad++)
+    {
+        const size_t len = charutil_base32_encode(text, bytes, n, pad);
+        assert(len == (pad ? CHARUTIL_BASE32_ENCODED_MAX(n) : (n * 8 + 4) / 5));
+        assert(charutil_base32_decode(decoded, text, len, &err_pos) == n);
+        assert(err_pos == len);
+        assert(memcmp(decoded, bytes, n) == 0);
+        for (size_t split = 0; split <= len; split += all_splits ? 1 : 7)
+        {
+            charutil_base_decoder_t st;
+            charutil_base32_decode_init(&st);
+            size_t written = charutil_base32_decode_update(&st, decoded, text, split);
+            written += charutil_base32_decode_update(&st, decoded + written, text + split, len - split);
+            assert(charutil_base32_decode_finish(&st));
+            assert(written == n && memcmp(decoded, bytes, n) == 0);
+        }
+    }
+
+    {
+        const size_t len = charutil_ascii85_encode(text, bytes, n);
+        assert(len <= CHARUTIL_ASCII85_ENCODED_MAX(n));
+        assert(charutil_ascii85_decode(decoded, text, len, &err_pos) == n);
+        assert(err_pos == len);
+        assert(memcmp(decoded, bytes, n) == 0);
+        for (size_t split = 0; split <= len; split += all_splits ? 1 : 7)
+        {
+            charutil_ascii85_decoder_t st;
+            size_t tail = 0;
+            charutil_ascii85_decode_init(&st);
+            size_t written = charutil_ascii85_decode_update(&st, decoded, text, split);
+            written += charutil_ascii85_decode_update(&st, decoded + written, text + split, len - split);
+            assert(charutil_ascii85_decode_finish(&st, decoded + written, &tail));
+            assert(written + tail == n && memcmp(decoded, bytes, n) == 0);
+        }
+    }
+}
+
+void test_base_codecs(void)
+{
+    static const char *const plain[] = {"", "f", "fo", "foo", "foob", "fooba", "foobar"};
+    static const char *const base64[] = {"", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy"};
+    static const char *const base32[] = {"", "MY======", "MZXQ====", "MZXW6===", "MZXW6YQ=", "MZXW6YTB", "MZXW6YTBOI======"};
+    char text[128];
+    unsigned char decoded[160];
+    size_t err_pos;
+
+    // RFC 4648 test vectors
+    for (size_t i = 0; i < sizeof(plain) / sizeof(plain[0]); i++)
+    {
+        const size_t n = strlen(plain[i]);
+        assert(charutil_base64_encode(text, plain[i], n, CHARUTIL_BASE64_STANDARD) == strlen(base64[i]));
+        assert(memcmp(text, base64[i], strlen(base64[i])) == 0);
+        assert(charutil_base32_encode(text, plain[i], n, 1) == strlen(base32[i]));
+        assert(memcmp(text, base32[i], strlen(base32[i])) == 0);
+    }
+
+    {
+        const char man[] = "Man is distinguished";
+        const char expected[] = "9jqo^BlbD-BleB1DJ+*+F(f,q";
+        assert(charutil_ascii85_encode(text, man, sizeof(man) - 1) == sizeof(expected) - 1);
+        assert(memcmp(text, expected, sizeof(expected) - 1) == 0);
+        const unsigned char zeros[9] = {0};
+        assert(charutil_ascii85_encode(text, zeros, 9) == 4);
+        assert(memcmp(text, "zz!!", 4) == 0);
+    }
+
+    // URL safe alphabet and case insensitive base32
+    {
+        const unsigned char bytes[] = {0xFB, 0xFF, 0xBF};
+        assert(charutil_base64_encode(text, bytes, 3, CHARUTIL_BASE64_STANDARD) == 4 && memcmp(text, "+/+/", 4) == 0);
+        assert(charutil_base64_encode(text, bytes, 3, CHARUTIL_BASE64_URL) == 4 && memcmp(text, "-_-_", 4) == 0);
+        assert(charutil_base64_decode(decoded, "+/+/", 4, CHARUTIL_BASE64_URL, &err_pos) == 0 && err_pos == 0);
+        assert(charutil_base64_encode(text, bytes, 1, CHARUTIL_BASE64_URL | CHARUTIL_BASE64_NOPAD) == 2);
+        assert(charutil_base32_decode(decoded, "mzxw6ytboi", 10, &err_pos) == 6 && err_pos == 10);
+        assert(memcmp(decoded, "foobar", 6) == 0);
+    }
+
+    // Malformed input reports where it went wrong
+    {
+        assert(charutil_base64_decode(decoded, "Zm9v!mFy", 8, 0, &err_pos) == 3 && err_pos == 4);
+        assert(charutil_base64_decode(decoded, "Zm9vY", 5, 0, &err_pos) == 3 && err_pos == 4); // one digit is never a group
+        assert(charutil_base64_decode(decoded, "Zg=", 3, 0, &err_pos) == 1 && err_pos == 0);   // incomplete padding
+        assert(charutil_base64_decode(decoded, "Z===", 4, 0, &err_pos) == 0 && err_pos == 1);
+        assert(charutil_base64_decode(decoded, "Zg==Zg==", 8, 0, &err_pos) == 1 && err_pos == 4);
+        assert(charutil_base64_decode(decoded, "Zm8", 3, 0, &err_pos) == 2 && err_pos == 3); // unpadded is fine
+        // Unused low bits of a final partial group must be zero, so each byte string has one encoding
+        assert(charutil_base64_decode(decoded, "QQ==", 4, 0, &err_pos) == 1 && err_pos == 4);
+        assert(charutil_base64_decode(decoded, "QR==", 4, 0, &err_pos) == 1 && err_pos == 1);
+        assert(charutil_base64_decode(decoded, "QUI=", 4, 0, &err_pos) == 2 && err_pos == 4);
+        assert(charutil_base64_decode(decoded, "QUJ=", 4, 0, &err_pos) == 2 && err_pos == 2);
+        assert(charutil_base64_decode(decoded, "QUJ", 3, 0, &err_pos) == 2 && err_pos == 2);
+        assert(charutil_base64_decode(decoded, "QR", 2, 0, &err_pos) == 1 && err_pos == 1);
+        assert(charutil_base32_decode(decoded, "MZXW6===", 8, &err_pos) == 3 && err_pos == 8);
+        assert(charutil_base32_decode(decoded, "MZX=====", 8, &err_pos) == 1 && err_pos == 3); // 3 digits is never a group
+        assert(charutil_base32_decode(decoded, "MZ1W6YTB", 8, &err_pos) == 1 && err_pos == 2);
+        assert(charutil_base32_decode(decoded, "MY======", 8, &err_pos) == 1 && err_pos == 8);
+        assert(charutil_base32_decode(decoded, "MZ======", 8, &err_pos) == 1 && err_pos == 1);
+        assert(charutil_base32_decode(decoded, "MZXW7", 5, &err_pos) == 3 && err_pos == 4);
+        assert(charutil_ascii85_decode(decoded, "9jqo^Bl", 7, &err_pos) == 5 && err_pos == 7);
+        assert(charutil_ascii85_decode(decoded, "9jqo^B", 6, &err_pos) == 4 && err_pos == 5); // one digit is never a group
+        assert(charutil_ascii85_decode(decoded, "s8W-\"", 5, &err_pos) == 0 && err_pos == 4); // above 2^32 - 1
+        assert(charutil_ascii85_decode(decoded, "9jzqo^", 6, &err_pos) == 0 && err_pos == 2);  // 'z' inside a group
+        assert(charutil_ascii85_decode(decoded, "9j v", 4, &err_pos) == 0 && err_pos == 2);
+    }
+
+    // Every byte value planted at every position of a long base64 text, so SIMD blocks see it too
+    {
+        unsigned char bytes[150];
+        char encoded[200];
+        for (size_t i = 0; i < sizeof(bytes); i++)
+        {
+            bytes[i] = (unsigned char)(i * 29 + 7);
+        }
+        const size_t len = charutil_base64_encode(encoded, bytes, sizeof(bytes), CHARUTIL_BASE64_STANDARD);
+        for (int ch = 0; ch < 256; ch++)
+        {
+            if (charutil_base64_value((unsigned char)ch, '+', '/') >= 0)
+            {
+                continue;
+            }
+            for (size_t pos = 0; pos < len; pos += 3)
+            {
+                const char saved = encoded[pos];
+                encoded[pos] = (char)ch;
+                const size_t written = charutil_base64_decode(decoded, encoded, len, 0, &err_pos);
+                // '=' after 2 or 3 digits starts padding, so the digit after it is the error, unless the digit
+                // before it has low bits set that the padding would drop
+                const bool pads = (ch == '=') && pos % 4 >= 2;
+                const int last = charutil_base64_value((unsigned char)encoded[pos - (pos > 0)], '+', '/');
+                const bool stray = pads && (last & ((pos % 4 == 2) ? 0x0F : 0x03));
+                assert(err_pos == (stray ? pos - 1 : pads ? pos + 1 : pos));
+                assert(written == pos / 4 * 3 + (pos % 4 ? pos % 4 - 1 : 0));
+                assert(memcmp(decoded, bytes, written) == 0);
+                encoded[pos] = saved;
+            }
+        }
+    }
+
+    // Every length up to a few SIMD blocks, then random buffers
+    {
+        unsigned char bytes[300];
+        for (size_t n = 0; n <= 200; n++)
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                bytes[i] = (unsigned char)test_rand();
+            }
+            check_base_codecs(bytes, n, n < 40);
+        }
+        for (int round = 0; round < 200; round++)
+        {
+            const size_t n = test_rand() % sizeof(bytes);
+            for (size_t i = 0; i < n; i++)
+            {
+                bytes[i] = (test_rand() % 4) ? (unsigned char)test_rand() : 0;
+            }
+            check_base_codecs(bytes, n, false);
+        }
+    }
+
+    printf("Base64/Base32/Ascii85 tests passed!\n");
+}
+
+// Reference dump built with snprintf()
+size_t reference_hexdump(char *out, const unsigned char *src, size_t n, const charutil_hexdump_opts_t *opts)
+{
+    const size_t width = !opts->width ? 16 : (opts->width < CHARUTIL_HEXDUMP_MAX_WIDTH) ? opts->width : CHARUTIL_HEXDUMP_MAX_WIDTH;
+    const size_t group = (opts->group && opts->group < width) ? opts->group : width;
+    const bool upper = opts->hex_case == CHARUTIL_HEX_UPPERCASE;
+    const bool wide = n && opts->offset + n - 1 > 0xFFFFFFFFull;
+    size_t out_len = 0;
+    for (size_t i = 0; i < n; i += width)
+    {
+        char *line = out + out_len;
+        size_t len = (size_t)sprintf(line, upper ? (wide ? "%016llX: " : "%08llX: ") : (wide ? "%016llx: " : "%08llx: "), (unsigned long long)(opts->offset + i));
+        for (size_t j = 0; j < width; j++)
+        {
+            if (j && j % group == 0)
+            {
+                line[len++] = ' ';
+            }
+            len += (i + j < n) ? (size_t)sprintf(line + len, upper ? "%02X" : "%02x", src[i + j]) : (size_t)sprintf(line + len, "  ");
+        }
+        for (size_t j = i; j < n && j < i + width; j++)
+        {
+            if (j == i && opts->gutter != CHARUTIL_HEXDUMP_GUTTER_NONE)
+            {
+                len += (size_t)sprintf(line + len, "  ");
+            }
+            if (opts->gutter == CHARUTIL_HEXDUMP_GUTTER_DOTS)
+            {
+                line[len++] = (src[j] >= 0x20 && src[j] < 0x7F) ? (char)src[j] : '.';
+            }
+            else if (opts->gutter == CHARUTIL_HEXDUMP_GUTTER_DIAGNOSTICS)
+            {
+                len += (size_t)sprintf(line + len, "%s", ascii_to_diagnostics(src[j]));
+            }
+        }
+        while (opts->gutter == CHARUTIL_HEXDUMP_GUTTER_NONE && line[len - 1] == ' ')
+        {
+            len--;
+        }
+        line[len++] = '\n';
+        out_len += len;
+    }
+    out[out_len] = '\0';
+    return out_len;
+}
+
+static int collect_hexdump_line(const char *line, size_t len, void *user)
+{
+    char *out = (char *)user;
+    assert(len <= CHARUTIL_HEXDUMP_LINE_MAX && line[len - 1] == '\n' && memchr(line, '\n', len - 1) == NULL);
+    strncat(out, line, len);
+    return 0;
+}
+
+static int stop_after_two_lines(const char *line, size_t len, void *user)
+{
+    (void)line;
+    (void)len;
+    return ++*(int *)user == 2 ? 42 : 0;
+}
+
+void test_hexdump(void)
+{
+    static char expected[64 * 1024];
+    static char out[64 * 1024];
+    unsigned char src[300];
+
+    {
+        const char text[] = "The quick brown fox jumps over the lazy dog\n";
+        const char xxd[] = "00000000: 5468 6520 7175 6963 6b20 6272 6f77 6e20  The quick brown \n"
+                           "00000010: 666f 7820 6a75 6d70 7320 6f76 6572 2074  fox jumps over t\n"
+                           "00000020: 6865 206c 617a 7920 646f 670a            he lazy dog.\n";
+        assert(charutil_hexdump(out, sizeof(out), text, sizeof(text) - 1, NULL) == sizeof(xxd) - 1);
+        assert(strcmp(out, xxd) == 0);
+        assert(charutil_hexdump(NULL, 0, text, sizeof(text) - 1, NULL) == sizeof(xxd) - 1);
+        assert(charutil_hexdump(out, sizeof(out), text, 0, NULL) == 0 && out[0] == '\0');
+    }
+    {
+        const charutil_hexdump_opts_t opts = {8, 4, CHARUTIL_HEX_UPPERCASE, CHARUTIL_HEXDUMP_GUTTER_DIAGNOSTICS, 0xFFFFFFFCull};
+        assert(charutil_hexdump(out, sizeof(out), "OK\r\n\xFF", 5, &opts) == 54);
+        assert(strcmp(out, "00000000FFFFFFFC: 4F4B0D0A FF        OK[CR][LF][0xFF]\n") == 0);
+    }
+
+    for (size_t i = 0; i < sizeof(src); i++)
+    {
+        src[i] = (i < 256) ? (unsigned char)i : (unsigned char)test_rand();
+    }
+
+    const size_t widths[] = {0, 1, 3, 8, 16, 32, 64, 100};
+    const size_t groups[] = {0, 1, 2, 4, 5, 16};
+    for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++)
+    {
+        for (size_t g = 0; g < sizeof(groups) / sizeof(groups[0]); g++)
+        {
+            for (int gutter = CHARUTIL_HEXDUMP_GUTTER_NONE; gutter <= CHARUTIL_HEXDUMP_GUTTER_DIAGNOSTICS; gutter++)
+            {
+                const charutil_hexdump_opts_t opts = {widths[w], groups[g], (charutil_hex_case_t)(gutter & 1), (charutil_hexdump_gutter_t)gutter, (g & 1) ? 0xFFFFFF80ull : (uint64_t)w * 7};
+                for (size_t n = 0; n <= sizeof(src); n += (n < 40) ? 1 : 53)
+                {
+                    const size_t expected_len = reference_hexdump(expected, src, n, &opts);
+
+                    memset(out, 0x55, sizeof(out));
+                    assert(charutil_hexdump(out, sizeof(out), src, n, &opts) == expected_len);
+                    assert(strcmp(out, expected) == 0);
+
+                    out[0] = '\0';
+                    assert(charutil_hexdump_lines(src, n, &opts, collect_hexdump_line, out) == 0);
+                    assert(strcmp(out, expected) == 0);
+
+                    // Truncated output is a NUL terminated prefix
+                    for (size_t cap = 1; cap < expected_len + 2; cap += 1 + cap / 3)
+                    {
+                        memset(out, 0x55, sizeof(out));
+                        assert(charutil_hexdump(out, cap, src, n, &opts) == expected_len);
+                        const size_t kept = expected_len < cap - 1 ? expected_len : cap - 1;
+                        assert(strlen(out) == kept);
+                        assert(memcmp(out, expected, kept) == 0);
+                        assert(out[cap] == 0x55);
+                    }
+                }
+            }
+        }
+    }
+
+    {
+        int lines = 0;
+        assert(charutil_hexdump_lines(src, sizeof(src), NULL, stop_after_two_lines, &lines) == 42);
+        assert(lines == 2);
+    }
+
+    printf("Hex dump tests passed!\n");
+}
+
+// Reference escapers, one byte at a time with sprintf()
+size_t reference_escape_c(char *out, const unsigned char *src, size_t n)
+{
+    size_t len = 0;
+    bool after_hex = false;
+    for (size_t i = 0; i < n; i++)
+    {
+        const unsigned char ch = src[i];
+        const char *simple = strchr("\a\b\f\n\r\t\v", ch);
+        if (ch && simple)
+        {
+            len += (size_t)sprintf(out + len, "\\%c", "abfnrtv"[simple - "\a\b\f\n\r\t\v"]);
+        }
+        else if (ch == '\\' || ch == '"')
+        {
+            len += (size_t)sprintf(out + len, "\\%c", ch);
+        }
+        else if (ch < 0x20 || ch >= 0x7F || (after_hex && strchr("0123456789abcdefABCDEF", ch)))
+        {
+            len += (size_t)sprintf(out + len, "\\x%02x", ch);
+            after_hex = true;
+            continue;
+        }
+        else
+        {
+            out[len++] = (char)ch;
+        }
+        after_hex = false;
+    }
+    out[len] = '\0';
+    return len;
+}
+
+size_t reference_escape_json(char *out, const unsigned char *src, size_t n)
+{
+    size_t len = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        const unsigned char ch = src[i];
+        const char *simple = strchr("\b\f\n\r\t", ch);
+        if (ch && simple)
+        {
+            len += (size_t)sprintf(out + len, "\\%c", "bfnrt"[simple - "\b\f\n\r\t"]);
+        }
+        else if (ch == '\\' || ch == '"')
+        {
+            len += (size_t)sprintf(out + len, "\\%c", ch);
+        }
+        else if (ch < 0x20)
+        {
+            len += (size_t)sprintf(out + len, "\\u%04x", ch);
+        }
+        else
+        {
+            out[len++] = (char)ch;
+        }
+    }
+    out[len] = '\0';
+    return len;
+}
+
+size_t reference_percent_encode(char *out, const unsigned char *src, size_t n, bool plus)
+{
+    size_t len = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        const unsigned char ch = src[i];
+        if ((ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z') || (ch >= '0' && ch <= '9') || (ch && strchr("-._~", ch)))
+        {
+            out[len++] = (char)ch;
+        }
+        else if (plus && ch == ' ')
+        {
+            out[len++] = '+';
+        }
+        else
+        {
+            len += (size_t)sprintf(out + len, "%%%02X", ch);
+        }
+    }
+    out[len] = '\0';
+    return len;
+}
+
+typedef size_t (*escape_fn)(char *dst, size_t dst_cap, const void *src, size_t n);
+
+static size_t percent_encode_default(char *dst, size_t dst_cap, const void *src, size_t n)
+{
+    return charutil_percent_encode(dst, dst_cap, src, n, NULL, CHARUTIL_PERCENT_DEFAULT);
+}
+
+static size_t percent_encode_plus(char *dst, size_t dst_cap, const void *src, size_t n)
+{
+    return charutil_percent_encode(dst, dst_cap, src, n, NULL, CHARUTIL_PERCENT_PLUS_SPACE);
+}
+
+// Encodes against the expected text, checks sizing and truncation, then decodes it back
+void test_escape_round_trip(escape_fn encode, const char *expected, size_t expected_len, const unsigned char *src, size_t n, int kind)
+{
+    static char out[8192];
+    static char back[8192];
+    memset(out, 0x55, sizeof(out));
+    assert(encode(out, sizeof(out), src, n) == expected_len);
+    assert(strcmp(out, expected) == 0);
+    assert(encode(NULL, 0, src, n) == expected_len);
+    for (size_t cap = 1; cap < expected_len + 2; cap += 1 + cap / 2)
+    {
+        memset(out, 0x55, sizeof(out));
+        assert(encode(out, cap, src, n) == expected_len);
+        const size_t kept = expected_len < cap - 1 ? expected_len : cap - 1;
+        assert(strlen(out) == kept && memcmp(out, expected, kept) == 0 && out[cap] == 0x55);
+    }
+
+    size_t err = 0;
+    size_t back_len = 0;
+    memcpy(out, expected, expected_len);
+    switch (kind)
+    {
+        case 0:
+            back_len = charutil_unescape_c(back, expected, expected_len, &err);
+            assert(charutil_unescape_c(out, out, expected_len, NULL) == n);
+            break;
+        case 1:
+            back_len = charutil_unescape_json(back, expected, expected_len, &err);
+            assert(charutil_unescape_json(out, out, expected_len, NULL) == n);
+            break;
+        default:
+            back_len = charutil_percent_decode(back, expected, expected_len, (unsigned)(kind - 2), &err);
+            assert(charutil_percent_decode(out, out, expected_len, (unsigned)(kind - 2), NULL) == n);
+            break;
+    }
+    assert(err == expected_len && back_len == n && memcmp(back, src, n) == 0);
+    assert(memcmp(out, src, n) == 0);
+}
+
+void test_escaping(void)
+{
+    static char expected[8192];
+    unsigned char src[1000];
+    char out[256];
+    size_t err;
+
+    // The constant sets match sets built at run time
+    {
+        charutil_set_t c_set, json_set, unreserved;
+        charutil_set_clear(&c_set);
+        charutil_set_add_range(&c_set, 0x00, 0x1F);
+        charutil_set_add_range(&c_set, 0x7F, 0xFF);
+        charutil_set_add_chars(&c_set, "\"\\", 2);
+        charutil_set_clear(&json_set);
+        charutil_set_add_range(&json_set, 0x00, 0x1F);
+        charutil_set_add_chars(&json_set, "\"\\", 2);
+        charutil_set_clear(&unreserved);
+        charutil_set_add_range(&unreserved, 'A', 'Z');
+        charutil_set_add_range(&unreserved, 'a', 'z');
+        charutil_set_add_range(&unreserved, '0', '9');
+        charutil_set_add_chars(&unreserved, "-._~", 4);
+        assert(memcmp(&unreserved, &charutil_url_unreserved, sizeof(unreserved)) == 0);
+        for (unsigned ch = 0; ch < 256; ch++)
+        {
+            char one = (char)ch;
+            assert((charutil_escape_c(NULL, 0, &one, 1) != 1) == charutil_set_contains(&c_set, (unsigned char)ch));
+            assert((charutil_escape_json(NULL, 0, &one, 1) != 1) == charutil_set_contains(&json_set, (unsigned char)ch));
+        }
+    }
+
+    // Known vectors
+    assert(charutil_escape_c(out, sizeof(out), "say \"hi\"\n\t\x01\x7F\xC3\xA9" "ag\\", 17) == 37);
+    assert(strcmp(out, "say \\\"hi\\\"\\n\\t\\x01\\x7f\\xc3\\xa9\\x61g\\\\") == 0);
+    assert(charutil_escape_json(out, sizeof(out), "a\"b\\c\x1F\b\x7F\xC3\xA9", 10) == 18);
+    assert(strcmp(out, "a\\\"b\\\\c\\u001f\\b\x7F\xC3\xA9") == 0);
+    assert(charutil_percent_encode(out, sizeof(out), "a b/c?d=\xE2\x82\xAC~", 12, NULL, CHARUTIL_PERCENT_DEFAULT) == 26);
+    assert(strcmp(out, "a%20b%2Fc%3Fd%3D%E2%82%AC~") == 0);
+    assert(charutil_percent_encode(out, sizeof(out), "a b+c", 5, NULL, CHARUTIL_PERCENT_PLUS_SPACE) == 7 && strcmp(out, "a+b%2Bc") == 0);
+    {
+        charutil_set_t path = charutil_url_unreserved;
+        charutil_set_add_chars(&path, "/", 1);
+        assert(charutil_percent_encode(out, sizeof(out), "/a b/", 5, &path, 0) == 7 && strcmp(out, "/a%20b/") == 0);
+    }
+
+    // Decoders
+    assert(charutil_unescape_c(out, "\\'\\?\\0\\101\\x4a\\x4Bz\\377", 23, &err) == 8 && err == 23);
+    assert(memcmp(out, "'?\0AJKz\xFF", 8) == 0);
+    assert(charutil_unescape_c(out, "ab\\x123", 7, &err) == 2 && err == 2);
+    assert(charutil_unescape_c(out, "ab\\400", 6, &err) == 2 && err == 2);
+    assert(charutil_unescape_c(out, "ab\\q", 4, &err) == 2 && err == 2);
+    assert(charutil_unescape_c(out, "ab\\x", 4, &err) == 2 && err == 2);
+    assert(charutil_unescape_c(out, "ab\\", 3, &err) == 2 && err == 2);
+    assert(charutil_unescape_json(out, "\\u00e9\\/\\uD83D\\uDE00!", 21, &err) == 8 && err == 21);
+    assert(memcmp(out, "\xC3\xA9/\xF0\x9F\x98\x80!", 8) == 0);
+    assert(charutil_unescape_json(out, "\\u20AC", 6, &err) == 3 && memcmp(out, "\xE2\x82\xAC", 3) == 0);
+    assert(charutil_unescape_json(out, "x\\uD83D", 7, &err) == 1 && err == 1);
+    assert(charutil_unescape_json(out, "x\\uD83D\\u0041", 13, &err) == 1 && err == 1);
+    assert(charutil_unescape_json(out, "x\\uDE00", 7, &err) == 1 && err == 1);
+    assert(charutil_unescape_json(out, "x\\u12G4", 7, &err) == 1 && err == 1);
+    assert(charutil_unescape_json(out, "ab\"", 3, &err) == 2 && err == 2);
+    assert(charutil_unescape_json(out, "ab\n", 3, &err) == 2 && err == 2);
+    assert(charutil_unescape_json(out, "ab\\x", 4, &err) == 2 && err == 2);
+    assert(charutil_percent_decode(out, "a%2fb%2F+c", 10, 0, &err) == 6 && err == 10 && memcmp(out, "a/b/+c", 6) == 0);
+    assert(charutil_percent_decode(out, "a+b%20c", 7, CHARUTIL_PERCENT_PLUS_SPACE, &err) == 5 && memcmp(out, "a b c", 5) == 0);
+    assert(charutil_percent_decode(out, "abc%4", 5, 0, &err) == 3 && err == 3);
+    assert(charutil_percent_decode(out, "abc%g0", 6, 0, &err) == 3 && err == 3);
+    assert(charutil_unescape_c(out, "", 0, NULL) == 0);
+
+    // Random input against the reference escapers, from all ASCII to all binary
+    for (int round = 0; round < 4; round++)
+    {
+        for (size_t n = 0; n <= sizeof(src); n += (n < 80) ? 1 : 97)
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                const uint64_t r = test_rand();
+                src[i] = (r % 4 < (unsigned)round) ? (unsigned char)(r >> 8) : (r % 8 == 0) ? "\"\\ \n+%0a"[(r >> 8) % 8] : (unsigned char)(' ' + (r >> 8) % 95);
+            }
+            size_t len = reference_escape_c(expected, src, n);
+            test_escape_round_trip(charutil_escape_c, expected, len, src, n, 0);
+            len = reference_escape_json(expected, src, n);
+            test_escape_round_trip(charutil_escape_json, expected, len, src, n, 1);
+            len = reference_percent_encode(expected, src, n, false);
+            test_escape_round_trip(percent_encode_default, expected, len, src, n, 2);
+            len = reference_percent_encode(expected, src, n, true);
+            test_escape_round_trip(percent_encode_plus, expected, len, src, n, 2 + CHARUTIL_PERCENT_PLUS_SPACE);
+        }
+    }
+
+    printf("Escaping tests passed!\n");
+}
+
+// Reference parsers, one character at a time against a template ('x' is a hex digit, anything else must match)
+static bool reference_template_parse(uint8_t *out, const char *src, const char *layout)
+{
+    size_t nibbles = 0;
+    for (size_t i = 0; layout[i]; i++)
+    {
+        if (layout[i] != 'x')
+        {
+            if (src[i] != layout[i])
+            {
+                return false;
+            }
+            continue;
+        }
+        const int digit = HEX_TO_INT(src[i], -1);
+        if (digit < 0)
+        {
+            return false;
+        }
+        out[nibbles / 2] = (uint8_t)((nibbles % 2) ? (out[nibbles / 2] | digit) : (digit << 4));
+        nibbles++;
+    }
+    return true;
+}
+
+// Greedy dotted quad using strtoul() on each octet
+static size_t reference_ipv4_parse(uint8_t out[4], const char *src, size_t n)
+{
+    char text[64];
+    const size_t len = n < sizeof(text) - 1 ? n : sizeof(text) - 1;
+    memcpy(text, src, len);
+    text[len] = '\0';
+    uint8_t quad[4];
+    size_t pos = 0;
+    for (int k = 0; k < 4; k++)
+    {
+        if (k > 0)
+        {
+            if (text[pos] != '.')
+            {
+                return 0;
+            }
+            pos++;
+        }
+        if (text[pos] < '0' || text[pos] > '9')
+        {
+            return 0;
+        }
+        char *end = NULL;
+        const unsigned long v = strtoul(text + pos, &end, 10);
+        char canonical[8];
+        const size_t digits = (size_t)(end - (text + pos));
+        snprintf(canonical, sizeof(canonical), "%lu", v);
+        if (digits > 3 || v > 255 || strlen(canonical) != digits)
+        {
+            return 0;
+        }
+        quad[k] = (uint8_t)v;
+        pos += digits;
+    }
+    memcpy(out, quad, 4);
+    return pos;
+}
+
+// Greedy RFC 4291 text form: hex groups, one "::" and an optional dotted quad tail
+static size_t reference_ipv6_parse(uint8_t out[16], const char *src, size_t n)
+{
+    unsigned groups[8];
+    int count = 0;
+    int gap = -1;
+    size_t pos = 0;
+    if (n >= 2 && memcmp(src, "::", 2) == 0)
+    {
+        gap = 0;
+        pos = 2;
+    }
+    while (count < 8)
+    {
+        size_t run = 0;
+        bool dotted = false;
+        while (pos + run < n && (IS_HEX_DIGIT(src[pos + run]) || src[pos + run] == '.'))
+        {
+            dotted |= src[pos + run] == '.';
+            run++;
+        }
+        if (run == 0 || src[pos] == '.')
+        {
+            break;
+        }
+        if (dotted)
+        {
+            uint8_t quad[4];
+            const size_t used = (count <= 6) ? reference_ipv4_parse(quad, src + pos, n - pos) : 0;
+            if (!used)
+            {
+                return 0;
+            }
+            groups[count++] = ((unsigned)quad[0] << 8) | quad[1];
+            groups[count++] = ((unsigned)quad[2] << 8) | quad[3];
+            pos += used;
+            break;
+        }
+        if (run > 4)
+        {
+            return 0;
+        }
+        char hex[5] = {0};
+        memcpy(hex, src + pos, run);
+        groups[count++] = (unsigned)strtoul(hex, NULL, 16);
+        pos += run;
+        if (count < 8 && gap < 0 && n - pos >= 2 && memcmp(src + pos, "::", 2) == 0)
+        {
+            gap = count;
+            pos += 2;
+        }
+        else if (count < 8 && n - pos >= 2 && src[pos] == ':' && IS_HEX_DIGIT(src[pos + 1]))
+        {
+            pos++;
+        }
+        else
+        {
+            break;
+        }
+    }
+    if ((gap < 0 && count != 8) || (gap >= 0 && count > 7))
+    {
+        return 0;
+    }
+    int k = 0;
+    for (int g = 0; g < 8; g++)
+    {
+        const bool zero_fill = gap >= 0 && g >= gap && g < gap + 8 - count;
+        const unsigned value = zero_fill ? 0 : groups[k++];
+        out[2 * g] = (uint8_t)(value >> 8);
+        out[2 * g + 1] = (uint8_t)value;
+    }
+    return pos;
+}
+
+// RFC 5952 by brute force: try every zero run and keep the longest, first on a tie
+static size_t reference_ipv6_format(char *out, const uint8_t addr[16])
+{
+    unsigned groups[8];
+    for (int g = 0; g < 8; g++)
+    {
+        groups[g] = ((unsigned)addr[2 * g] << 8) | addr[2 * g + 1];
+    }
+    if (!groups[0] && !groups[1] && !groups[2] && !groups[3] && !groups[4] && groups[5] == 0xFFFF)
+    {
+        return (size_t)sprintf(out, "::ffff:%u.%u.%u.%u", addr[12], addr[13], addr[14], addr[15]);
+    }
+    int best = -1;
+    int best_len = 0;
+    for (int start = 0; start < 8; start++)
+    {
+        for (int len = 2; start + len <= 8; len++)
+        {
+            bool zero = true;
+            for (int g = start; g < start + len; g++)
+            {
+                zero &= groups[g] == 0;
+            }
+            if (zero && len > best_len)
+            {
+                best = start;
+                best_len = len;
+            }
+        }
+    }
+    size_t len = 0;
+    for (int g = 0; g < 8; g++)
+    {
+        if (g == best)
+        {
+            len += (size_t)sprintf(out + len, "::");
+            g += best_len - 1;
+            continue;
+        }
+        len += (size_t)sprintf(out + len, (g == 0 || g == best + best_len) ? "%x" : ":%x", groups[g]);
+    }
+    return len;
+}
+
+typedef int (*uuid_parse_fn)(uint8_t uuid[16], const char *src);
+typedef size_t (*uuid_format_fn)(char *dst, const uint8_t uuid[16], charutil_hex_case_t hex_case);
+typedef int (*mac_parse_fn)(uint8_t mac[6], const char *src);
+
+void test_uuid_kernel(uuid_parse_fn parse, uuid_format_fn format)
+{
+    static const char layout[] = "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx";
+    for (int round = 0; round < 300; round++)
+    {
+        uint8_t uuid[16];
+        uint8_t parsed[16];
+        uint8_t expected[16];
+        char text[CHARUTIL_UUID_TEXT_LEN + 1];
+        char reference[CHARUTIL_UUID_TEXT_LEN + 1];
+        for (int i = 0; i < 16; i++)
+        {
+            uuid[i] = (uint8_t)test_rand();
+        }
+        const charutil_hex_case_t hex_case = (charutil_hex_case_t)(round & 1);
+        for (int i = 0, len = 0; i < 16; i++)
+        {
+            len += sprintf(reference + len, (i == 4 || i == 6 || i == 8 || i == 10) ? (hex_case ? "-%02X" : "-%02x") : (hex_case ? "%02X" : "%02x"), uuid[i]);
+        }
+        memset(text, 0x55, sizeof(text));
+        assert(format(text, uuid, hex_case) == CHARUTIL_UUID_TEXT_LEN && memcmp(text, reference, CHARUTIL_UUID_TEXT_LEN) == 0 && text[CHARUTIL_UUID_TEXT_LEN] == 0x55);
+        assert(parse(parsed, text) && memcmp(parsed, uuid, 16) == 0);
+
+        // Every byte value at one position
+        const size_t pos = (size_t)(test_rand() % CHARUTIL_UUID_TEXT_LEN);
+        for (unsigned ch = 0; ch < 256; ch++)
+        {
+            text[pos] = (char)ch;
+            memset(parsed, 0xAA, sizeof(parsed));
+            const bool ok = reference_template_parse(expected, text, layout);
+            assert((parse(parsed, text) != 0) == ok);
+            assert(ok ? memcmp(parsed, expected, 16) == 0 : parsed[0] == 0xAA);
+        }
+    }
+}
+
+void test_mac_kernel(mac_parse_fn parse)
+{
+    for (int round = 0; round < 300; round++)
+    {
+        uint8_t mac[6];
+        uint8_t parsed[6];
+        uint8_t expected[6];
+        char text[CHARUTIL_MAC_TEXT_LEN + 1];
+        const char sep = (round & 2) ? '-' : ':';
+        for (int i = 0; i < 6; i++)
+        {
+            mac[i] = (uint8_t)test_rand();
+        }
+        sprintf(text, (round & 1) ? "%02X%c%02X%c%02X%c%02X%c%02X%c%02X" : "%02x%c%02x%c%02x%c%02x%c%02x%c%02x", mac[0], sep, mac[1], sep, mac[2], sep, mac[3], sep, mac[4], sep, mac[5]);
+        assert(parse(parsed, text) && memcmp(parsed, mac, 6) == 0);
+
+        const size_t pos = (size_t)(test_rand() % CHARUTIL_MAC_TEXT_LEN);
+        for (unsigned ch = 0; ch < 256; ch++)
+        {
+            text[pos] = (char)ch;
+            memset(parsed, 0xAA, sizeof(parsed));
+            const bool ok = reference_template_parse(expected, text, "xx:xx:xx:xx:xx:xx") || reference_template_parse(expected, text, "xx-xx-xx-xx-xx-xx");
+            assert((parse(parsed, text) != 0) == ok);
+            assert(ok ? memcmp(parsed, expected, 6) == 0 : parsed[0] == 0xAA);
+        }
+    }
+}
+
+/// Calls check on every string of up to max_len characters from alphabet
+static void test_all_strings(const char *alphabet, size_t max_len, void (*check)(const char *text, size_t n))
+{
+    const size_t k = strlen(alphabet);
+    char text[16];
+    for (size_t len = 0; len <= max_len; len++)
+    {
+        size_t combos = 1;
+        for (size_t i = 0; i < len; i++)
+        {
+            combos *= k;
+        }
+        for (size_t c = 0; c < combos; c++)
+        {
+            size_t rest = c;
+            for (size_t i = 0; i < len; i++)
+            {
+                text[i] = alphabet[rest % k];
+                rest /= k;
+            }
+            check(text, len);
+        }
+    }
+}
+
+static void check_ipv4_parse(const char *text, size_t n)
+{
+    uint8_t got[4] = {0};
+    uint8_t want[4] = {0};
+    const size_t used = charutil_ipv4_parse(got, text, n);
+    assert(used == reference_ipv4_parse(want, text, n));
+    assert(memcmp(got, want, 4) == 0);
+}
+
+static void check_ipv6_parse(const char *text, size_t n)
+{
+    uint8_t got[16] = {0};
+    uint8_t want[16] = {0};
+    const size_t used = charutil_ipv6_parse(got, text, n);
+    assert(used == reference_ipv6_parse(want, text, n));
+    assert(memcmp(got, want, 16) == 0);
+}
+
+void test_addresses(void)
+{
+    uint8_t bytes[16];
+    char text[64];
+
+    test_uuid_kernel(charutil_uuid_parse_swar, charutil_uuid_format_scalar);
+#if defined(CHARUTIL_HAVE_SSE2)
+    test_uuid_kernel(charutil_uuid_parse_sse2, charutil_uuid_format_sse2);
+#endif
+#if defined(CHARUTIL_HAVE_NEON)
+    test_uuid_kernel(charutil_uuid_parse_neon, charutil_uuid_format_neon);
+#endif
+    test_mac_kernel(charutil_mac_parse_swar);
+#if defined(CHARUTIL_HAVE_SSE2)
+    test_mac_kernel(charutil_mac_parse_sse2);
+#endif
+#if defined(CHARUTIL_HAVE_NEON)
+    test_mac_kernel(charutil_mac_parse_neon);
+#endif
+
+    // Known values through the public entry points
+    {
+        static const uint8_t uuid[16] = {0x12, 0x3e, 0x45, 0x67, 0xe8, 0x9b, 0x12, 0xd3, 0xa4, 0x56, 0x42, 0x66, 0x14, 0x17, 0x40, 0x00};
+        assert(charutil_uuid_format(text, uuid, CHARUTIL_HEX_LOWERCASE) == 36 && memcmp(text, "123e4567-e89b-12d3-a456-426614174000", 36) == 0);
+        assert(charutil_uuid_parse(bytes, "123E4567-E89B-12D3-A456-426614174000}", 37) == 36 && memcmp(bytes, uuid, 16) == 0);
+        assert(charutil_uuid_parse(bytes, "123e4567-e89b-12d3-a456-42661417400", 35) == 0);
+        assert(charutil_uuid_parse(bytes, "123e4567e89b12d3a456426614174000____", 36) == 0);
+
+        static const uint8_t mac[6] = {0x00, 0x1A, 0x2b, 0x3C, 0xd4, 0xFF};
+        assert(charutil_mac_format(text, mac, ':', CHARUTIL_HEX_UPPERCASE) == 17 && memcmp(text, "00:1A:2B:3C:D4:FF", 17) == 0);
+        assert(charutil_mac_format(text, mac, '-', CHARUTIL_HEX_LOWERCASE) == 17 && memcmp(text, "00-1a-2b-3c-d4-ff", 17) == 0);
+        assert(charutil_mac_parse(bytes, "00-1a-2B-3c-D4-ff", 17) == 17 && memcmp(bytes, mac, 6) == 0);
+        assert(charutil_mac_parse(bytes, "00:1a:2B-3c:D4:ff", 17) == 0);
+        assert(charutil_mac_parse(bytes, "00.1a.2B.3c.D4.ff", 17) == 0);
+        assert(charutil_mac_parse(bytes, "00:1a:2B:3c:D4:f", 16) == 0);
+    }
+    {
+        assert(charutil_ipv4_parse(bytes, "192.168.0.1:8080", 16) == 11 && memcmp(bytes, "\xC0\xA8\x00\x01", 4) == 0);
+        assert(charutil_ipv4_parse(bytes, "1.2.3.456", 9) == 0);
+        assert(charutil_ipv4_parse(bytes, "1.2.03.4", 8) == 0);
+        assert(charutil_ipv4_parse(bytes, "1.2.3", 5) == 0);
+        assert(charutil_ipv4_parse(bytes, "1.2.3.4", 6) == 0);
+        static const uint8_t edge[4] = {255, 0, 10, 100};
+        assert(charutil_ipv4_format(text, edge) == 12 && memcmp(text, "255.0.10.100", 12) == 0);
+
+        static const struct
+        {
+            const char *text;
+            const char *canonical;
+        } v6[] = {
+            {"::", "::"},
+            {"::1", "::1"},
+            {"1::", "1::"},
+            {"2001:DB8:0:0:0:0:2:1", "2001:db8::2:1"},
+            {"2001:db8:0000:1:1:1:1:1", "2001:db8:0:1:1:1:1:1"},
+            {"2001:0:0:1:0:0:0:1", "2001:0:0:1::1"},
+            {"2001:db8:0:0:1:0:0:1", "2001:db8::1:0:0:1"},
+            {"::ffff:192.0.2.128", "::ffff:192.0.2.128"},
+            {"::FFFF:c000:0280", "::ffff:192.0.2.128"},
+            {"64:ff9b::192.0.2.33", "64:ff9b::c000:221"},
+            {"1:2:3:4:5:6:7:8", "1:2:3:4:5:6:7:8"},
+            {"1:2:3:4:5:6:1.2.3.4", "1:2:3:4:5:6:102:304"},
+        };
+        for (size_t i = 0; i < sizeof(v6) / sizeof(v6[0]); i++)
+        {
+            const size_t n = strlen(v6[i].text);
+            assert(charutil_ipv6_parse(bytes, v6[i].text, n) == n);
+            assert(charutil_ipv6_format(text, bytes) == strlen(v6[i].canonical) && memcmp(text, v6[i].canonical, strlen(v6[i].canonical)) == 0);
+        }
+        static const char *const bad[] = {":", ":1::", "1:2:3:4:5:6:7", "1:2:3:4:5:6:7:8::", "12345::", "1::2::3x", "1:2:3:4:5:6:7:1.2.3.4", "::1.2.3", "g::"};
+        for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+        {
+            const size_t n = strlen(bad[i]);
+            assert(charutil_ipv6_parse(bytes, bad[i], n) != n);
+        }
+        assert(charutil_ipv6_parse(bytes, "fe80::1%eth0", 12) == 7);
+        assert(charutil_ipv6_parse(bytes, "[::1]:443" + 1, 8) == 3);
+    }
+
+    // Every short string over the characters that matter to each grammar
+    test_all_strings("0125.9a", 7, check_ipv4_parse);
+    test_all_strings("01fF:.g", 7, check_ipv6_parse);
+
+    // Random addresses with long zero runs format like the reference and parse back
+    for (int round = 0; round < 20000; round++)
+    {
+        char reference[64];
+        uint8_t parsed[16];
+        for (int g = 0; g < 8; g++)
+        {
+            const uint64_t r = test_rand();
+            const unsigned value = (r % 3) ? 0 : (r % 5 == 0) ? 0xFFFF : (unsigned)(r >> 16) >> (4 * ((r >> 8) % 4));
+            bytes[2 * g] = (uint8_t)(value >> 8);
+            bytes[2 * g + 1] = (uint8_t)value;
+        }
+        const size_t len = charutil_ipv6_format(text, bytes);
+        assert(len <= CHARUTIL_IPV6_TEXT_MAX);
+        assert(len == reference_ipv6_format(reference, bytes) && memcmp(text, reference, len) == 0);
+        assert(charutil_ipv6_parse(parsed, text, len) == len && memcmp(parsed, bytes, 16) == 0);
+        check_ipv6_parse(text, len);
+
+        const size_t v4_len = charutil_ipv4_format(text, bytes);
+        assert(v4_len <= CHARUTIL_IPV4_TEXT_MAX);
+        sprintf(reference, "%u.%u.%u.%u", bytes[0], bytes[1], bytes[2], bytes[3]);
+        assert(v4_len == strlen(reference) && memcmp(text, reference, v4_len) == 0);
+        assert(charutil_ipv4_parse(parsed, text, v4_len) == v4_len && memcmp(parsed, bytes, 4) == 0);
+    }
+
+    printf("UUID, MAC and IP address tests passed!\n");
+}
+
+/// Linear search reference for charutil_keyword_lookup()
+static int reference_keyword_lookup(const char *const *keywords, size_t count, const char *p, size_t n)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (strlen(keywords[i]) == n && charutil_casecmp(keywords[i], p, n) == 0)
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+void test_keywords(void)
+{
+    static const char *const keywords[] = {"GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH", "Host", "Accept", "Accept-Encoding",
+                                           "Accept-Language", "Content-Length", "Content-Type", "Transfer-Encoding", "Connection", "Upgrade", "User-Agent", "Cookie",
+                                           "Set-Cookie", "Authorization", "Cache-Control", "If-None-Match", "If-Modified-Since", "X-Forwarded-For", "Sec-WebSocket-Key", "Access-Control-Allow-Origin",
+                                           "0", "a.b", "a_b", "[section]"};
+    const size_t count = sizeof(keywords) / sizeof(keywords[0]);
+    static charutil_keyword_slot_t slots[sizeof(keywords) / sizeof(keywords[0]) + 1];
+    static uint16_t index[4096];
+    charutil_keyword_table_t table;
+    assert(charutil_keyword_build(&table, slots, index, 4096, keywords, NULL, count));
+    assert(((size_t)1 << table.bits) >= 2 * count);
+
+    char token[CHARUTIL_KEYWORD_MAX_LEN + 2];
+    for (size_t i = 0; i < count; i++)
+    {
+        const size_t n = strlen(keywords[i]);
+        memcpy(token, keywords[i], n);
+        assert(charutil_keyword_lookup(&table, token, n) == (int)i);
+        charutil_to_lower_inplace(token, n);
+        assert(charutil_keyword_lookup(&table, token, n) == (int)i);
+        charutil_toggle_case_inplace(token, n / 2);
+        assert(charutil_keyword_lookup(&table, token, n) == (int)i);
+        assert(charutil_keyword_lookup(&table, token, n - 1) == reference_keyword_lookup(keywords, count, token, n - 1));
+        token[n] = 'x';
+        assert(charutil_keyword_lookup(&table, token, n + 1) == -1);
+
+        // Every byte value at every position, bit 5 twins of non letters ('-' and '\r') included
+        for (size_t pos = 0; pos < n; pos++)
+        {
+            const char saved = token[pos];
+            for (unsigned ch = 0; ch < 256; ch++)
+            {
+                token[pos] = (char)ch;
+                assert(charutil_keyword_lookup(&table, token, n) == reference_keyword_lookup(keywords, count, token, n));
+            }
+            token[pos] = saved;
+        }
+    }
+    assert(charutil_keyword_lookup(&table, "", 0) == -1);
+    assert(charutil_keyword_lookup(&table, "content\rlength", 14) == -1);
+    assert(charutil_keyword_lookup(&table, "ACCESS-CONTROL-ALLOW-ORIGIN", 27) == 27);
+
+    // Random tokens
+    for (int round = 0; round < 20000; round++)
+    {
+        const size_t n = test_rand() % (CHARUTIL_KEYWORD_MAX_LEN + 2);
+        for (size_t k = 0; k < n; k++)
+        {
+            token[k] = "abcdeGHNOPST-_.0[]\r"[test_rand() % 19];
+        }
+        assert(charutil_keyword_lookup(&table, token, n) == reference_keyword_lookup(keywords, count, token, n));
+    }
+
+    {
+        // Own values, and an index exactly as large as asked
+        static const char *const methods[] = {"get", "put"};
+        static const int32_t values[] = {100, -7};
+        charutil_keyword_slot_t small[3];
+        uint16_t small_index[4];
+        assert(charutil_keyword_build(&table, small, small_index, 4, methods, values, 2));
+        assert(table.bits == 2 && charutil_keyword_lookup(&table, "GeT", 3) == 100 && charutil_keyword_lookup(&table, "PUT", 3) == -7);
+    }
+
+    {
+        // Keywords a table cannot hold
+        static const char *const duplicate[] = {"Host", "Accept", "HOST"};
+        static const char *const empty[] = {"Host", ""};
+        static const char *const too_long[] = {"0123456789abcdef0123456789abcdefX"};
+        assert(!charutil_keyword_build(&table, slots, index, 4096, duplicate, NULL, 3));
+        assert(!charutil_keyword_build(&table, slots, index, 4096, empty, NULL, 2));
+        assert(!charutil_keyword_build(&table, slots, index, 4096, too_long, NULL, 1));
+        assert(!charutil_keyword_build(&table, slots, index, 8, keywords, NULL, count));
+        assert(charutil_keyword_build(&table, slots, index, 4096, too_long, NULL, 0) && charutil_keyword_lookup(&table, "x", 1) == -1);
+    }
+
+    printf("Keyword lookup tests passed!\n");
+}
+
+typedef void (*split_masks_fn)(const char *p, size_t blocks, uint8_t quote, uint8_t delim, uint64_t *masks);
+
+void test_split_kernel(split_masks_fn masks_fn)
+{
+    char buf[64 * 5];
+    uint64_t expected[3 * 5];
+    uint64_t actual[3 * 5];
+    for (int round = 0; round < 2000; round++)
+    {
+        for (size_t k = 0; k < sizeof(buf); k++)
+        {
+            buf[k] = (round & 1) ? (char)test_rand() : ",;\"'\n\r\ta\x80\xFF"[test_rand() % 11];
+        }
+        const uint8_t quote = (round & 2) ? '"' : (uint8_t)test_rand();
+        const uint8_t delim = (round & 4) ? ',' : (uint8_t)test_rand();
+        const size_t blocks = 1 + test_rand() % 5;
+        charutil_split_masks_scalar(buf, blocks, quote, delim, expected);
+        masks_fn(buf, blocks, quote, delim, actual);
+        assert(memcmp(expected, actual, 3 * blocks * sizeof(uint64_t)) == 0);
+    }
+}
+
+/// Appends a field to out as a flags byte, a 4 byte length and its bytes. Returns the new length of out.
+static size_t split_record_field(unsigned char *out, size_t len, const char *field, size_t n, unsigned flags)
+{
+    out[len++] = (unsigned char)flags;
+    memcpy(out + len, &(uint32_t){(uint32_t)n}, 4);
+    memcpy(out + len + 4, field, n);
+    return len + 4 + n;
+}
+
+/// Byte at a time tokenizer with the same rules as charutil_split_update(), recording whole fields
+size_t reference_split(const char *p, size_t n, char delim, int quote, unsigned flags, unsigned char *out)
+{
+    size_t len = 0;
+    size_t start = 0;
+    int in_quotes = 0;
+    int quoted = 0;
+    int record_open = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        const int end_record = p[i] == '\n';
+        if (quote != CHARUTIL_SPLIT_NO_QUOTE && p[i] == (char)quote)
+        {
+            in_quotes = !in_quotes;
+            quoted = 1;
+        }
+        else if (!in_quotes && (p[i] == delim || end_record))
+        {
+            const size_t end = (end_record && i > start && p[i - 1] == '\r') ? i - 1 : i;
+            if (!((flags & CHARUTIL_SPLIT_SKIP_BLANK_LINES) && end_record && end == start && !record_open))
+            {
+                len = split_record_field(out, len, p + start, end - start, (end_record ? CHARUTIL_FIELD_END_RECORD : 0) | (quoted ? CHARUTIL_FIELD_QUOTED : 0));
+                record_open = !end_record;
+            }
+            start = i + 1;
+            quoted = 0;
+        }
+    }
+    if (record_open || start < n)
+    {
+        len = split_record_field(out, len, p + start, n - start, CHARUTIL_FIELD_END_RECORD | (quoted ? CHARUTIL_FIELD_QUOTED : 0));
+    }
+    return len;
+}
+
+/// Joins the count fields of chunk p onto joined and records each whole one to out. Returns the new length of out.
+static size_t chunked_split_record(const char *p, size_t used, const charutil_field_t *fields, size_t count, unsigned char *out, size_t len, char *joined, size_t *joined_len)
+{
+    for (size_t f = 0; f < count; f++)
+    {
+        assert(fields[f].offset + fields[f].len <= used);
+        memcpy(joined + *joined_len, p + fields[f].offset, fields[f].len);
+        *joined_len += fields[f].len;
+        if (fields[f].flags & CHARUTIL_FIELD_PARTIAL)
+        {
+            assert(f == count - 1 && fields[f].offset + fields[f].len == used && fields[f].len > 0);
+            continue;
+        }
+        len = split_record_field(out, len, joined, *joined_len, fields[f].flags);
+        *joined_len = 0;
+    }
+    return len;
+}
+
+/// Feeds p to charutil_split_update() in random chunks, joins fragments and records whole fields like reference_split()
+size_t chunked_split(const char *p, size_t n, char delim, int quote, unsigned flags, unsigned char *out, char *joined)
+{
+    charutil_split_t st;
+    charutil_field_t fields[8];
+    size_t len = 0;
+    size_t joined_len = 0;
+    size_t pos = 0;
+    size_t count;
+    size_t used;
+    charutil_split_init(&st, delim, quote, flags);
+    // Bytes left unused go at the front of the next chunk, as a reader would move them before its next read
+    while (pos < n)
+    {
+        size_t chunk = (test_rand() & 1) ? 1 + test_rand() % 200 : 1 + test_rand() % 2000;
+        chunk = (chunk < n - pos) ? chunk : n - pos;
+        const int last_read = pos + chunk == n;
+        const size_t max_fields = (test_rand() & 1) ? 1 + test_rand() % 3 : sizeof(fields) / sizeof(fields[0]);
+        count = charutil_split_update(&st, p + pos, chunk, fields, max_fields, &used);
+        assert(count <= max_fields && used <= chunk);
+        assert(count == max_fields || used == chunk || (used == chunk - 1 && p[pos + used] == '\r'));
+        len = chunked_split_record(p + pos, used, fields, count, out, len, joined, &joined_len);
+        pos += used;
+        if (last_read && count < max_fields)
+        {
+            break;
+        }
+    }
+    size_t max_fields;
+    do
+    {
+        max_fields = (test_rand() & 1) ? 1 + test_rand() % 3 : sizeof(fields) / sizeof(fields[0]);
+        count = charutil_split_finish(&st, p + pos, n - pos, fields, max_fields, &used);
+        assert(count <= max_fields && used <= n - pos && (count == max_fields || used == n - pos));
+        len = chunked_split_record(p + pos, used, fields, count, out, len, joined, &joined_len);
+        pos += used;
+    } while (count == max_fields);
+    assert(pos == n && joined_len == 0);
+    assert(charutil_split_finish(&st, p + n, 0, fields, 8, &used) == 0 && used == 0);
+    return len;
+}
+
+void test_split(void)
+{
+    test_split_kernel(charutil_split_masks_scalar);
+#if defined(CHARUTIL_HAVE_SSE2)
+    test_split_kernel(charutil_split_masks_sse2);
+#endif
+#if defined(CHARUTIL_HAVE_AVX2)
+    if (TEST_CPU_HAS_AVX2)
+    {
+        test_split_kernel(charutil_split_masks_avx2);
+    }
+#endif
+#if defined(CHARUTIL_HAVE_NEON) && defined(__aarch64__)
+    test_split_kernel(charutil_split_masks_neon);
+#endif
+    test_split_kernel(charutil_split_masks);
+
+    for (int k = 0; k < 64; k++)
+    {
+        const uint64_t x = test_rand();
+        uint64_t expected = 0;
+        int parity = 0;
+        for (unsigned bit = 0; bit < 64; bit++)
+        {
+            parity ^= (x >> bit) & 1;
+            expected |= (uint64_t)parity << bit;
+        }
+        assert(charutil_prefix_xor(x) == expected);
+    }
+
+    {
+        // RFC 4180 quoting in one chunk
+        const char csv[] = "id,name,note\r\n1,\"Smith, J\",\"said \"\"hi\"\"\"\r\n\n2,,\"two\nlines\"";
+        const size_t n = sizeof(csv) - 1;
+        charutil_split_t st;
+        charutil_field_t fields[16];
+        size_t used;
+        charutil_split_init(&st, ',', '"', CHARUTIL_SPLIT_DEFAULT);
+        size_t count = charutil_split_update(&st, csv, n, fields, 16, &used);
+        assert(used == n && count == 10);
+        count += charutil_split_finish(&st, csv + n, 0, fields + count, 6, &used);
+        assert(count == 11 && used == 0);
+        static const char *const text[] = {"id", "name", "note", "1", "\"Smith, J\"", "\"said \"\"hi\"\"\"", "", "2", "", "\"two\nlines\"", ""};
+        static const unsigned flags[] = {0, 0, CHARUTIL_FIELD_END_RECORD, 0, CHARUTIL_FIELD_QUOTED, CHARUTIL_FIELD_QUOTED | CHARUTIL_FIELD_END_RECORD, CHARUTIL_FIELD_END_RECORD, 0, 0,
+                                         CHARUTIL_FIELD_QUOTED | CHARUTIL_FIELD_PARTIAL, CHARUTIL_FIELD_QUOTED | CHARUTIL_FIELD_END_RECORD};
+        for (size_t f = 0; f < 10; f++)
+        {
+            assert(fields[f].len == strlen(text[f]) && memcmp(csv + fields[f].offset, text[f], fields[f].len) == 0);
+            assert(fields[f].flags == flags[f]);
+        }
+        assert(fields[10].len == 0 && fields[10].flags == flags[10]);
+
+        char unquoted[32];
+        assert(charutil_field_unquote(unquoted, csv + fields[5].offset, fields[5].len, '"') == 9 && memcmp(unquoted, "said \"hi\"", 9) == 0);
+        memcpy(unquoted, "\"a\"\"\"b\"\"", 9);
+        assert(charutil_field_unquote(unquoted, unquoted, 8, '"') == 3 && memcmp(unquoted, "a\"b", 3) == 0);
+        assert(charutil_field_unquote(unquoted, "plain", 5, '"') == 5 && memcmp(unquoted, "plain", 5) == 0);
+    }
+
+    {
+        // Tab separated without quoting, a stop after each field, and an input ending in a newline
+        const char tsv[] = "a\t\"b\t\"\nc\r\n";
+        charutil_split_t st;
+        charutil_field_t field;
+        size_t used;
+        size_t pos = 0;
+        charutil_split_init(&st, '\t', CHARUTIL_SPLIT_NO_QUOTE, CHARUTIL_SPLIT_DEFAULT);
+        assert(charutil_split_update(&st, tsv, 10, &field, 0, &used) == 0 && used == 0);
+        static const char *const text[] = {"a", "\"b", "\"", "c"};
+        for (size_t f = 0; f < 4; f++)
+        {
+            assert(charutil_split_update(&st, tsv + pos, 10 - pos, &field, 1, &used) == 1);
+            assert(field.len == strlen(text[f]) && memcmp(tsv + pos + field.offset, text[f], field.len) == 0 && field.flags == ((f >= 2) ? CHARUTIL_FIELD_END_RECORD : 0));
+            pos += used;
+        }
+        assert(charutil_split_update(&st, tsv + pos, 10 - pos, &field, 1, &used) == 0 && pos + used == 10);
+        assert(charutil_split_finish(&st, tsv + 10, 0, &field, 1, &used) == 0 && used == 0);
+    }
+
+    {
+        // An empty line is a record of one empty field, unless blank lines are skipped
+        const char lines[] = "a\n\nb\n";
+        charutil_split_t st;
+        charutil_field_t fields[4];
+        size_t used;
+        charutil_split_init(&st, ',', '"', CHARUTIL_SPLIT_DEFAULT);
+        assert(charutil_split_finish(&st, lines, 5, fields, 4, &used) == 3 && used == 5);
+        assert(fields[0].offset == 0 && fields[0].len == 1 && fields[1].offset == 2 && fields[1].len == 0 && fields[2].offset == 3 && fields[2].len == 1);
+        assert(fields[0].flags == CHARUTIL_FIELD_END_RECORD && fields[1].flags == CHARUTIL_FIELD_END_RECORD && fields[2].flags == CHARUTIL_FIELD_END_RECORD);
+        charutil_split_init(&st, ',', '"', CHARUTIL_SPLIT_SKIP_BLANK_LINES);
+        assert(charutil_split_finish(&st, lines, 5, fields, 4, &used) == 2 && used == 5);
+        assert(fields[0].offset == 0 && fields[0].len == 1 && fields[1].offset == 3 && fields[1].len == 1);
+    }
+
+    {
+        // Only "\r\n" drops its '\r'. Any other '\r' is data, and a final one waits for the next chunk.
+        const char crlf[] = "a\rb,c\r\n\r\nd\r";
+        charutil_split_t st;
+        charutil_field_t fields[8];
+        size_t used;
+        charutil_split_init(&st, ',', '"', CHARUTIL_SPLIT_DEFAULT);
+        assert(charutil_split_update(&st, crlf, 11, fields, 8, &used) == 4 && used == 10);
+        assert(fields[0].offset == 0 && fields[0].len == 3 && fields[0].flags == 0);
+        assert(fields[1].offset == 4 && fields[1].len == 1 && fields[1].flags == CHARUTIL_FIELD_END_RECORD);
+        assert(fields[2].offset == 7 && fields[2].len == 0 && fields[2].flags == CHARUTIL_FIELD_END_RECORD);
+        assert(fields[3].offset == 9 && fields[3].len == 1 && fields[3].flags == CHARUTIL_FIELD_PARTIAL);
+        assert(charutil_split_finish(&st, crlf + 10, 1, fields, 8, &used) == 1 && used == 1);
+        assert(fields[0].offset == 0 && fields[0].len == 1 && fields[0].flags == CHARUTIL_FIELD_END_RECORD);
+
+        // A "\r\n" cut between two chunks
+        const char split[] = "x\r\ny";
+        charutil_split_init(&st, ',', '"', CHARUTIL_SPLIT_DEFAULT);
+        assert(charutil_split_update(&st, split, 2, fields, 8, &used) == 1 && used == 1);
+        assert(fields[0].offset == 0 && fields[0].len == 1 && fields[0].flags == CHARUTIL_FIELD_PARTIAL);
+        assert(charutil_split_update(&st, split + 1, 3, fields, 8, &used) == 2 && used == 3);
+        assert(fields[0].len == 0 && fields[0].flags == CHARUTIL_FIELD_END_RECORD);
+        assert(fields[1].offset == 2 && fields[1].len == 1 && fields[1].flags == CHARUTIL_FIELD_PARTIAL);
+        assert(charutil_split_finish(&st, split + 4, 0, fields, 8, &used) == 1 && fields[0].len == 0 && fields[0].flags == CHARUTIL_FIELD_END_RECORD);
+
+        // A '\r' delimiter at the end of a chunk is used like any other
+        charutil_split_init(&st, '\r', CHARUTIL_SPLIT_NO_QUOTE, CHARUTIL_SPLIT_DEFAULT);
+        assert(charutil_split_update(&st, "a\r", 2, fields, 8, &used) == 1 && used == 2 && fields[0].len == 1 && fields[0].flags == 0);
+    }
+
+    // Random text fed in random chunks, against the byte at a time tokenizer
+    static char text[5000];
+    static char joined[5000];
+    static unsigned char expected[5 * 5000 + 5];
+    static unsigned char actual[5 * 5000 + 5];
+    for (int round = 0; round < 3000; round++)
+    {
+        const size_t n = (round & 1) ? test_rand() % 200 : test_rand() % sizeof(text);
+        const char *alphabet = (round & 2) ? "ab,\"\n\r" : "abcdefgh ,,\"\n";
+        const size_t alphabet_len = strlen(alphabet);
+        for (size_t k = 0; k < n; k++)
+        {
+            text[k] = alphabet[test_rand() % alphabet_len];
+        }
+        const int quote = (round & 4) ? CHARUTIL_SPLIT_NO_QUOTE : '"';
+        const unsigned flags = (round & 8) ? CHARUTIL_SPLIT_SKIP_BLANK_LINES : CHARUTIL_SPLIT_DEFAULT;
+        const size_t expected_len = reference_split(text, n, ',', quote, flags, expected);
+        assert(chunked_split(text, n, ',', quote, flags, actual, joined) == expected_len);
+        assert(memcmp(expected, actual, expected_len) == 0);
+    }
+
+    printf("Field splitting tests passed!\n");
+}
+
+#if defined(CHARUTIL_PARALLEL)
+static void count_task(void *ctx, size_t task, unsigned worker)
+{
+    uint64_t *sums = (uint64_t *)ctx;
+    sums[worker] += task + 1;
+}
+
+void test_parallel(void)
+{
+    // Several chunks plus an odd tail, mostly text with some control and high bytes
+    const size_t n = 5 * CHARUTIL_PARALLEL_CHUNK + 12345;
+    char *src = (char *)malloc(n);
+    char *expected = (char *)malloc(6 * n + 1);
+    char *actual = (char *)malloc(6 * n + 1);
+    assert(src && expected && actual);
+    for (size_t i = 0; i < n; i++)
+    {
+        const uint64_t r = test_rand();
+        src[i] = (char)((r % 16) ? ' ' + (r >> 8) % 95 : (r >> 8));
+    }
+
+    // The serial NULL pool goes last, so under runtime dispatch the workers make the first kernel calls
+    charutil_pool_t *pools[] = {charutil_pool_create(4), charutil_pool_create(1), charutil_pool_create(0), NULL};
+    const size_t pool_count = sizeof(pools) / sizeof(pools[0]);
+    for (size_t p = 0; p < pool_count; p++)
+    {
+        charutil_pool_t *pool = pools[p];
+        assert(p == pool_count - 1 || pool);
+        assert(charutil_pool_size(pool) >= 1 && charutil_pool_size(pool) <= CHARUTIL_POOL_MAX_THREADS);
+
+        // Every task runs exactly once, on a valid worker
+        uint64_t sums[CHARUTIL_POOL_MAX_THREADS] = {0};
+        uint64_t total = 0;
+        charutil_pool_run(pool, 1000, count_task, sums);
+        for (unsigned w = 0; w < CHARUTIL_POOL_MAX_THREADS; w++)
+        {
+            assert(w < charutil_pool_size(pool) || sums[w] == 0);
+            total += sums[w];
+        }
+        assert(total == 1000 * 1001 / 2);
+
+        // Hex encode and decode, lengths cutting the chunks at odd places
+        for (size_t len = n; len > 0; len -= len / 2 + 1)
+        {
+            assert(charutil_hex_encode_parallel(pool, actual, src, len, CHARUTIL_HEX_LOWERCASE) == 2 * len);
+            charutil_hex_encode(expected, src, len, CHARUTIL_HEX_LOWERCASE);
+            assert(memcmp(actual, expected, 2 * len) == 0);
+        }
+        charutil_hex_encode(expected, src, n, CHARUTIL_HEX_UPPERCASE);
+        size_t err_pos;
+        assert(charutil_hex_decode_parallel(pool, actual, expected, 2 * n, &err_pos) == n && err_pos == 2 * n);
+        assert(memcmp(actual, src, n) == 0);
+        assert(charutil_hex_decode_parallel(pool, actual, expected, 2 * n - 1, &err_pos) == n - 1 && err_pos == 2 * n - 2);
+        // Bad digits in two chunks, the earlier one wins
+        const size_t bad[] = {3 * CHARUTIL_PARALLEL_CHUNK + 7, 2 * CHARUTIL_PARALLEL_CHUNK - 1};
+        for (size_t b = 0; b < 2; b++)
+        {
+            expected[bad[b]] = 'x';
+            assert(charutil_hex_decode_parallel(pool, actual, expected, 2 * n, &err_pos) == bad[b] / 2 && err_pos == bad[b]);
+            assert(memcmp(actual, src, bad[b] / 2) == 0);
+        }
+
+        // Case conversion, also in place
+        charutil_case_buf(expected, src, n, CHARUTIL_CASE_TOGGLE);
+        charutil_case_buf_parallel(pool, actual, src, n, CHARUTIL_CASE_TOGGLE);
+        assert(memcmp(actual, expected, n) == 0);
+        charutil_case_buf_parallel(pool, actual, actual, n, CHARUTIL_CASE_TOGGLE);
+        assert(memcmp(actual, src, n) == 0);
+
+        // Class counts and histogram
+        charutil_class_counts_t counts, serial;
+        uint64_t histogram[256], serial_histogram[256];
+        charutil_class_counts(src, n, &serial, serial_histogram);
+        charutil_class_counts_parallel(pool, src, n, &counts, histogram);
+        assert(memcmp(&counts, &serial, sizeof(counts)) == 0 && memcmp(histogram, serial_histogram, sizeof(histogram)) == 0);
+        charutil_class_counts_parallel(pool, src, n, &counts, NULL);
+        assert(memcmp(&counts, &serial, sizeof(counts)) == 0);
+
+        // Diagnostics escape, whole and clipped inside, at and before chunk outputs
+        const size_t len = charutil_diagnostics_escape(expected, 6 * n + 1, src, n);
+        assert(charutil_diagnostics_escape_parallel(pool, NULL, 0, src, n) == len);
+        const size_t caps[] = {6 * n + 1, len + 1, len, len / 2 + 3, 1};
+        for (size_t c = 0; c < sizeof(caps) / sizeof(caps[0]); c++)
+        {
+            charutil_diagnostics_escape(expected, caps[c], src, n);
+            memset(actual, '#', caps[c]);
+            assert(charutil_diagnostics_escape_parallel(pool, actual, caps[c], src, n) == len);
+            assert(memcmp(actual, expected, caps[c] < len + 1 ? caps[c] : len + 1) == 0);
+        }
+
+        charutil_pool_destroy(pool);
+    }
+
+    free(src);
+    free(expected);
+    free(actual);
+    printf("Parallel bulk tests passed!\n");
+}
+#endif
+
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+#if defined(TEST_SECOND_UNIT)
+// test_unit.c, built into the same program
+charutil_tier_t test_unit_tier(void);
+size_t test_unit_hex_encode(char *dst, const void *src, size_t n);
+#endif
+
+void test_runtime_dispatch(void)
+{
+    // The first call resolves from CHARUTIL_TIER when it names a supported tier
+    const char *env = getenv("CHARUTIL_TIER");
+    const charutil_tier_t initial = charutil_get_tier();
+    if (env && charutil_tier_supported(charutil_tier_from_name(env)))
+    {
+        assert(initial == charutil_tier_from_name(env));
+    }
+    else
+    {
+        assert(initial == charutil_best_tier());
+    }
+    assert(charutil_tier_supported(CHARUTIL_TIER_SCALAR));
+    assert(!charutil_tier_supported(CHARUTIL_TIER_COUNT));
+    assert(charutil_tier_from_name("bogus") == CHARUTIL_TIER_COUNT);
+    assert(!charutil_set_tier(CHARUTIL_TIER_COUNT));
+    assert(charutil_get_tier() == initial);
+#if defined(TEST_SECOND_UNIT)
+    assert(test_unit_tier() == initial);
+#endif
+
+    // Every supported tier through the public entry points
+    for (int t = 0; t < CHARUTIL_TIER_COUNT; t++)
+    {
+        const charutil_tier_t tier = (charutil_tier_t)t;
+        assert(charutil_tier_from_name(charutil_tier_name(tier)) == tier);
+        if (!charutil_set_tier(tier))
+        {
+            continue;
+        }
+        assert(charutil_get_tier() == tier);
+#if defined(TEST_SECOND_UNIT)
+        // Set here, seen there, and its kernels still produce the same output
+        assert(test_unit_tier() == tier);
+        char unit_hex[9];
+        assert(test_unit_hex_encode(unit_hex, "\x01\xAB\xCD\xEF", 4) == 8 && memcmp(unit_hex, "01abcdef", 8) == 0);
+#endif
+        test_span_kernel(charutil_span_class);
+        test_set_kernel(charutil_set_scan);
+        test_class_count_kernel(charutil_class_count_blocks);
+        test_case_buf_kernel(charutil_case_buf);
+        test_hex_bulk_kernel(charutil_hex_encode, charutil_hex_decode);
+
+        unsigned char buf[300];
+        for (int round = 0; round < 2000; round++)
+        {
+            size_t len = 0;
+            while (len + 4 <= sizeof(buf))
+            {
+                const uint64_t r = test_rand();
+                len += encode_utf8(buf + len, (r % 4) ? (uint32_t)(r >> 8) % 0x80 : (uint32_t)(r >> 8) % 0xD800);
+            }
+            buf[test_rand() % len] = (unsigned char)test_rand();
+            check_utf8(buf, len, false);
+        }
+        for (size_t n = 0; n < sizeof(buf); n += 37)
+        {
+            check_base_codecs(buf, n, false);
+        }
+        printf("Runtime dispatch tier %s passed!\n", charutil_tier_name(tier));
+    }
+    charutil_set_tier(initial);
+}
+#endif
+
+int main()
+{
+#if defined(CHARUTIL_PARALLEL)
+    // First, so the thread pool rather than a serial test resolves the runtime dispatch tier
+    test_parallel();
+#if defined(TEST_PARALLEL_ONLY)
+    // The ThreadSanitizer build, where the serial tests would only add minutes
+    printf("Parallel tests passed successfully!\n");
+    return 0;
+#endif
+#endif
     test_character_checks();
+    test_class_table();
     test_case_conversion();
     test_conversions();
+    test_span();
+    test_char_sets();
+    test_class_counts();
+    test_case_buf();
+    test_natural_sort();
+    test_hex_bulk();
+    test_hex_fused();
+    test_integer_parsing();
+    test_integer_formatting();
+    test_diagnostics_table();
+    test_diagnostics_escape();
+    test_utf8_validation();
+    test_base_codecs();
+    test_hexdump();
+    test_escaping();
+    test_addresses();
+    test_keywords();
+    test_split();
+#if defined(CHARUTIL_RUNTIME_DISPATCH)
+    test_runtime_dispatch();
+#endif
 
     for (int i = 0; i < 256; i++)
     {
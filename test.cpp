@@ -0,0 +1,190 @@
+#include "char-utils.hpp"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+// Compile time checks
+static_assert(charutil::is_hex_digit('F') && !charutil::is_hex_digit('g'), "");
+static_assert(charutil::is_digit(U'7') && !charutil::is_digit(U'\uFF17'), "wide code points are never ASCII digits");
+static_assert(!charutil::is_space(-1), "EOF is in no class");
+static_assert(charutil::is_extended_ascii(static_cast<char>(0xFF)), "char is read as unsigned char");
+static_assert(charutil::to_upper('q') == 'Q' && charutil::to_lower(u'Q') == u'q' && charutil::toggle_case('!') == '!', "");
+static_assert(*charutil::hex_to_int('c') == 12 && !charutil::hex_to_int('x'), "");
+static_assert(charutil::ascii_to_digit('9').value_or(0xFF) == 9 && !charutil::ascii_to_octal('8'), "");
+static_assert(*charutil::nibble_to_hex(11) == 'B' && *charutil::nibble_to_hex(11, CHARUTIL_HEX_LOWERCASE) == 'b' && !charutil::nibble_to_hex(16), "");
+static_assert(charutil::high_nibble(0xA5) == 0xA && charutil::low_nibble(0xA5) == 0x5, "");
+static_assert(charutil::diagnostics('\t') == "[TAB]" && charutil::diagnostics(0x80) == "[0x80]", "");
+
+static constexpr auto hex_values = charutil::make_table([](unsigned ch) { return charutil::hex_to_int(ch).value_or(0xFF); });
+static_assert(hex_values['0'] == 0 && hex_values['a'] == 10 && hex_values['F'] == 15 && hex_values['G'] == 0xFF, "");
+
+static constexpr charutil_set_t json_structural = charutil::make_set("{}[]:,\"");
+static constexpr charutil_set_t identifier = charutil::make_set_if([](unsigned ch) { return charutil::is_alnum(ch) || ch == '_'; });
+static_assert(charutil::contains(json_structural, ':') && !charutil::contains(json_structural, 'a'), "");
+static_assert(charutil::contains(identifier, '_') && !charutil::contains(identifier, '-'), "");
+
+// Each check against its macro for every value a caller might pass
+template <typename CharT>
+void test_checks_for(void)
+{
+    for (int v = -300; v < 600; v++)
+    {
+        const CharT ch = static_cast<CharT>(v);
+        const unsigned c = (sizeof(CharT) == 1) ? static_cast<unsigned char>(ch) : static_cast<unsigned>(ch);
+        assert(charutil::is_binary(ch) == IS_BINARY(c));
+        assert(charutil::is_octal(ch) == IS_OCTAL(c));
+        assert(charutil::is_digit(ch) == IS_DIGIT(c));
+        assert(charutil::is_lower(ch) == IS_LOWER(c));
+        assert(charutil::is_upper(ch) == IS_UPPER(c));
+        assert(charutil::is_alpha(ch) == IS_ALPHA(c));
+        assert(charutil::is_alnum(ch) == IS_ALNUM(c));
+        assert(charutil::is_hex_digit(ch) == IS_HEX_DIGIT(c));
+        assert(charutil::is_printable(ch) == IS_PRINTABLE(c));
+        assert(charutil::is_ascii(ch) == IS_ASCII(c));
+        assert(charutil::is_extended_ascii(ch) == IS_EXTENDED_ASCII(c));
+        assert(charutil::is_space(ch) == IS_SPACE(c));
+        assert(charutil::is_punct(ch) == IS_PUNCT(c));
+        assert(charutil::is_bracket(ch) == IS_BRACKET(c));
+        assert(charutil::is_symbol(ch) == IS_SYMBOL(c));
+        assert(charutil::is_class(ch, CHARUTIL_CLASS_PUNCT | CHARUTIL_CLASS_DIGIT) == (IS_PUNCT(c) || IS_DIGIT(c)));
+
+        assert(static_cast<unsigned>(charutil::code(charutil::to_upper(ch))) == static_cast<unsigned>(TO_UPPER(c)));
+        assert(static_cast<unsigned>(charutil::code(charutil::to_lower(ch))) == static_cast<unsigned>(TO_LOWER(c)));
+        assert(static_cast<unsigned>(charutil::code(charutil::toggle_case(ch))) == static_cast<unsigned>(TOGGLE_CASE(c)));
+
+        assert(charutil::ascii_to_binary(ch).value_or(0xFF) == ASCII_TO_BINARY(c, 0xFFu));
+        assert(charutil::ascii_to_octal(ch).value_or(0xFF) == ASCII_TO_OCTAL(c, 0xFFu));
+        assert(charutil::ascii_to_digit(ch).value_or(0xFF) == (IS_DIGIT(c) ? c - '0' : 0xFFu));
+        assert(charutil::hex_to_int(ch).value_or(0xFF) == HEX_TO_INT(c, 0xFFu));
+    }
+}
+
+void test_character_functions(void)
+{
+    test_checks_for<char>();
+    test_checks_for<signed char>();
+    test_checks_for<unsigned char>();
+    test_checks_for<int>();
+    test_checks_for<char32_t>();
+    test_checks_for<wchar_t>();
+
+    for (unsigned n = 0; n < 20; n++)
+    {
+        assert(charutil::binary_to_ascii(n).value_or('?') == static_cast<char>(BINARY_TO_ASCII(n, '?')));
+        assert(charutil::octal_to_ascii(n).value_or('?') == static_cast<char>(OCTAL_TO_ASCII(n, '?')));
+        assert(charutil::digit_to_ascii(n).value_or('?') == static_cast<char>(DIGIT_TO_ASCII(n, '?')));
+        assert(charutil::nibble_to_hex(n).value_or('?') == static_cast<char>(NIBBLE_TO_UPPERCASE_HEX(n, '?')));
+        assert(charutil::nibble_to_hex(n, CHARUTIL_HEX_LOWERCASE).value_or('?') == static_cast<char>(NIBBLE_TO_LOWERCASE_HEX(n, '?')));
+    }
+
+    // The argument is evaluated once
+    const char *text = "9f";
+    const char *p = text;
+    assert(charutil::is_hex_digit(*p++) && p == text + 1);
+    assert(charutil::hex_to_int(*p++).value_or(0xFF) == 15 && p == text + 2);
+
+    // Tables built at compile time match the run time versions
+    for (unsigned ch = 0; ch < 256; ch++)
+    {
+        assert(hex_values[ch] == HEX_TO_INT(ch, 0xFFu));
+        assert(charutil::contains(identifier, static_cast<unsigned char>(ch)) == charutil_set_contains(&identifier, static_cast<unsigned char>(ch)));
+    }
+    charutil_set_t long_set;
+    const char long_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789\x80\xFF";
+    charutil_set_clear(&long_set);
+    charutil_set_add_chars(&long_set, long_chars, sizeof(long_chars) - 1);
+    const charutil_set_t built = charutil::make_set(long_chars);
+    assert(memcmp(&built, &long_set, sizeof(built)) == 0);
+    assert(charutil::diagnostics('\n') == "[LF]");
+
+    printf("C++ character function tests passed!\n");
+}
+
+void test_bulk_functions(void)
+{
+    assert(charutil::to_lower("Hello, World!") == "hello, world!");
+    assert(charutil::to_upper(std::string_view("abc\0xyz", 7)) == std::string("ABC\0XYZ", 7));
+    assert(charutil::toggle_case("aBc") == "AbC");
+    std::string shout = "Quiet Please";
+    charutil::to_upper_inplace(shout);
+    assert(shout == "QUIET PLEASE");
+    std::vector<char> chars = {'M', 'i', 'X'};
+    charutil::to_lower_inplace(chars);
+    assert(chars[0] == 'm' && chars[1] == 'i' && chars[2] == 'x');
+
+    assert(charutil::casecmp("Content-Length", "content-length") == 0);
+    assert(charutil::casecmp("abc", "ABCD") < 0 && charutil::casecmp("abd", "ABC") > 0);
+    assert(charutil::iequals("HOST", "host") && !charutil::iequals("host", "hosts"));
+    assert(charutil::casehash("Accept") == charutil::casehash("aCCEPT"));
+    assert(charutil::natural_cmp("file9", "file10") < 0 && charutil::natural_cmp("v1.2.10", "v1.2.9") > 0);
+    assert(charutil::natural_sortkey("File10", CHARUTIL_NATURAL_FOLD_CASE) > charutil::natural_sortkey("file9", CHARUTIL_NATURAL_FOLD_CASE));
+    assert(charutil::natural_sortkey("img12") < charutil::natural_sortkey("img012") && charutil::natural_sortkey("a") < charutil::natural_sortkey("a0"));
+
+    const char *const headers[] = {"Host", "Content-Length", "Accept"};
+    charutil_keyword_slot_t slots[4];
+    std::uint16_t index[64];
+    charutil_keyword_table_t table;
+    assert(charutil_keyword_build(&table, slots, index, 64, headers, nullptr, 3));
+    assert(charutil::keyword_lookup(table, "content-LENGTH") == 1 && !charutil::keyword_lookup(table, "Content_Length"));
+    assert(charutil::field_unquote("\"say \"\"hi\"\"\"") == "say \"hi\"" && charutil::field_unquote("'a'b", '\'') == "ab" && charutil::field_unquote("").empty());
+
+    assert(charutil::span_class("12345abc", CHARUTIL_CLASS_DIGIT) == 5);
+    assert(charutil::cspan("key: value", json_structural) == 3);
+    assert(charutil::span("foo_bar9-x", identifier) == 8);
+
+    assert(charutil::parse_u64("18446744073709551615") == UINT64_MAX);
+    assert(!charutil::parse_u64("18446744073709551616") && !charutil::parse_u64("12a") && !charutil::parse_u64(""));
+    assert(charutil::parse_u64("ff", 16) == 255u);
+    assert(charutil::parse_i64("-42") == -42);
+    assert(charutil::to_hex(0xBEEF) == "BEEF" && charutil::to_hex(0, CHARUTIL_HEX_LOWERCASE) == "0");
+
+    const std::string binary("\x00\x01\xFE\xFFhi", 6);
+    assert(charutil::hex_encode(binary) == "0001feff6869");
+    assert(charutil::hex_decode("0001FEff6869") == binary);
+    assert(!charutil::hex_decode("abc") && !charutil::hex_decode("abx") && !charutil::hex_decode("zz"));
+    assert(charutil::base64_encode("foobar") == "Zm9vYmFy");
+    assert(charutil::base64_encode(binary, CHARUTIL_BASE64_URL | CHARUTIL_BASE64_NOPAD) == "AAH-_2hp");
+    assert(charutil::base64_decode("AAH-_2hp", CHARUTIL_BASE64_URL) == binary);
+    assert(!charutil::base64_decode("Zm9v!mFy"));
+
+    assert(charutil::utf8_validate("caf\xC3\xA9") && !charutil::utf8_validate("\xC3("));
+    assert(charutil::diagnostics_escape("OK\r\n") == "OK[CR][LF]");
+    assert(charutil::escape_c("tab\there\x01") == "tab\\there\\x01");
+    assert(charutil::escape_json("\"q\"\n") == "\\\"q\\\"\\n");
+    assert(charutil::percent_encode("a b&c") == "a%20b%26c" && charutil::percent_encode("a b", nullptr, CHARUTIL_PERCENT_PLUS_SPACE) == "a+b");
+    assert(charutil::unescape_c("\\x41\\102") == "AB" && !charutil::unescape_c("\\q"));
+    assert(charutil::unescape_json("\\u00e9") == "\xC3\xA9" && !charutil::unescape_json("\\uD800"));
+    assert(charutil::percent_decode("a%20b") == "a b" && !charutil::percent_decode("%2"));
+    char dump[128];
+    charutil_hexdump(dump, sizeof(dump), "hi", 2, NULL);
+    assert(charutil::hexdump("hi") == dump);
+
+    std::array<std::uint64_t, 256> histogram;
+    const charutil_class_counts_t counts = charutil::class_counts("Hex 0xBEEF;\n", &histogram);
+    assert(counts.total == 12 && charutil_class_count(&counts, CHARUTIL_CLASS_HEX_DIGIT) == 6 && histogram['E'] == 2);
+
+#if defined(__cpp_lib_span)
+    const unsigned char raw[] = {0xDE, 0xAD, 0xBE, 0xEF};
+    const std::byte bytes[] = {std::byte{0x66}, std::byte{0x6F}, std::byte{0x6F}};
+    assert(charutil::hex_encode(std::span<const unsigned char>(raw), CHARUTIL_HEX_UPPERCASE) == "DEADBEEF");
+    assert(charutil::base64_encode(std::span<const std::byte>(bytes)) == "Zm9v");
+    assert(charutil::utf8_validate(std::span<const unsigned char>(raw)) == false);
+    assert(charutil::class_counts(std::span<const std::byte>(bytes)).classes[3] == 3);
+    charutil_hexdump(dump, sizeof(dump), "A", 1, NULL);
+    assert(charutil::hexdump(std::vector<unsigned char>{0x41}) == dump);
+    char span_chars[] = {'U', 'p'};
+    charutil::to_lower_inplace(std::span<char>(span_chars));
+    assert(span_chars[0] == 'u');
+#endif
+
+    printf("C++ bulk function tests passed!\n");
+}
+
+int main()
+{
+    test_character_functions();
+    test_bulk_functions();
+    printf("All C++ tests passed successfully!\n");
+    return 0;
+}
@@ -0,0 +1,15 @@
+// Second translation unit of test_dispatch: the runtime dispatch tier is shared by every file including the header
+#include "char-utils.h"
+
+charutil_tier_t test_unit_tier(void);
+size_t test_unit_hex_encode(char *dst, const void *src, size_t n);
+
+charutil_tier_t test_unit_tier(void)
+{
+    return charutil_get_tier();
+}
+
+size_t test_unit_hex_encode(char *dst, const void *src, size_t n)
+{
+    return charutil_hex_encode(dst, src, n, CHARUTIL_HEX_LOWERCASE);
+}